@@ -20,6 +20,7 @@ namespace
         std::string _filename;
         size_t      _mesh = 0;
         bool        _setDefaultMaterial = false;
+        bool        _quantize = false;
         bool        _showHelp = false;
     };
 
@@ -30,6 +31,7 @@ namespace
         static constexpr char const * kFilename = "filename";
         static constexpr char const * kMesh = "mesh";
         static constexpr char const * kSetDefaultMaterial = "set-default-material";
+        static constexpr char const * kQuantize = "quantize";
         static constexpr char const * kHelp = "help";
 
     public:
@@ -49,6 +51,9 @@ namespace
                 (kSetDefaultMaterial,
                     po::value<bool>()->default_value(false),
                     "set default material for material-less meshes")
+                (kQuantize,
+                    po::value<bool>()->default_value(false),
+                    "quantize vertices on import")
                 (kHelp,
                     "print this message");
 
@@ -66,6 +71,7 @@ namespace
             _result._filename = vm.count(kFilename) ? vm[kFilename].as<std::string>() : "";
             _result._mesh = vm[kMesh].as<size_t>();
             _result._setDefaultMaterial = vm[kSetDefaultMaterial].as<bool>();
+            _result._quantize = vm[kQuantize].as<bool>();
             _result._showHelp = vm.count(kHelp) != 0;
         }
 
@@ -167,7 +173,8 @@ int main(int argc, char ** argv)
                 ._meshIndex = arguments._mesh,
                 ._defaultMaterial = arguments._setDefaultMaterial
                     ? std::make_shared<minire::models::PbrMaterial>()
-                    : minire::material::Model::Sptr()
+                    : minire::material::Model::Sptr(),
+                ._quantized = arguments._quantize,
             });
 
         minire::content::Manager manager;
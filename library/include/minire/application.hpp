@@ -6,6 +6,7 @@
 #include <minire/events/application.hpp>
 #include <minire/events/controller.hpp>
 #include <minire/models/fps-camera.hpp>
+#include <minire/models/warmup-manifest.hpp>
 #include <minire/sdl/gl-application.hpp>
 
 // private headers
@@ -45,6 +46,12 @@ namespace minire
             _controller = std::move(controller);
             return static_cast<Controller &>(*_controller);
         }
+
+        // Content of the manifest is decoded in background and uploaded
+        // by slices of frames, controller's events aren't handled until
+        // it's done, so the first interactive frame loads nothing
+        void warmup(models::WarmupManifest const &);
+
     private:
         void onResize(size_t width, size_t height) override;
         void onRender() override;
@@ -81,6 +88,9 @@ namespace minire
         void handle(events::controller::SetSymbolLabel const &);
         void handle(events::controller::UnsetCharLabel const &);
         void handle(events::controller::SetStringLabel const &);
+        void handle(events::controller::SetLabelRegion const &);
+        void handle(events::controller::ScrollLabel const &);
+        void handle(events::controller::SetLabelPalette const &);
         void handle(events::controller::SetLabelCursor const &);
         void handle(events::controller::UnsetLabelCursor const &);
         void handle(events::controller::SetLabelVisible const &);
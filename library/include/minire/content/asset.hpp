@@ -4,10 +4,13 @@
 #include <minire/formats/bdf.hpp>
 #include <minire/formats/gltf.hpp>
 #include <minire/formats/obj.hpp>
+#include <minire/models/blob.hpp>
+#include <minire/models/compressed-image.hpp>
 #include <minire/models/font.hpp>
 #include <minire/models/image.hpp>
 #include <minire/models/scene-model.hpp>
 
+#include <memory>
 #include <variant>
 
 namespace minire::content
@@ -18,8 +21,14 @@ namespace minire::content
                                formats::Obj, // TODO: why not Sptr?
                                formats::GltfModelSptr,
                                models::Image::Sptr,
+                               models::CompressedImage::Sptr,
                                models::Font,
-                               models::SceneModel>;
+                               models::SceneModel,
+                               models::Blob::Sptr>;
+
+    // Assets are immutable once they're loaded, so readers and
+    // the content::Manager share them instead of copying
+    using AssetSptr = std::shared_ptr<Asset const>;
 
     std::string demangle(Asset const &);
 
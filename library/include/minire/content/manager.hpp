@@ -3,20 +3,33 @@
 #include <minire/content/asset.hpp>
 #include <minire/content/id.hpp>
 #include <minire/errors.hpp>
+#include <minire/formats/pack.hpp>
 #include <minire/utils/demangle.hpp>
 
+#include <array>
+#include <atomic>
 #include <cassert>
+#include <exception>
+#include <filesystem>
+#include <functional>
 #include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
+#include <vector>
+
+namespace minire::utils { class MappedFile; class ThreadPool; }
 
 namespace minire::content
 {
     class Lease;
 
-    // TODO: cover with tests
-
     class Reader
     {
     public:
@@ -24,22 +37,87 @@ namespace minire::content
 
         virtual ~Reader() = default;
 
-        virtual Asset load(Id const & id) const = 0;
+        // NOTE: it's called concurrently by Manager::borrowAsync;
+        //       nullptr if the reader doesn't have the asset
+        virtual AssetSptr load(Id const & id) const = 0;
+
+        virtual bool contains(Id const & id) const = 0;
+
+        // A hash of the content an id is loaded from (see Manager::hash),
+        // std::nullopt if the reader can't tell it w/o loading the asset
+        virtual std::optional<uint64_t> hash(Id const &) const { return std::nullopt; }
+
+        // The content an id is loaded from as it is (see Manager::raw),
+        // nullptr if the reader doesn't keep it as bytes
+        virtual models::Blob::Sptr raw(Id const &) const { return nullptr; }
     };
 
+    // NOTE: borrow(), upload() and Leases are thread-safe, the store is split
+    //       into shards w/ a lock each; borrowAsync() and poll() are called
+    //       by the Manager's thread (i.e. the render one), and setReader()
+    //       before anything is loaded.
     class Manager
     {
+        struct AssetBlock;
+
+        // unused assets of a shard, the least recently used one is the first
+        using Garbage = std::list<AssetBlock *>;
+
         struct AssetBlock
         {
-            Asset  _asset;
-            size_t _usage = 0;
-            size_t _size = 0; // bytes
+            Id                const _id;
+            AssetSptr         const _asset;     // shared w/ the reader, if it keeps it
+            Manager                & _manager;
+            size_t            const _shard;
+            size_t            const _size;      // bytes
+            std::atomic<size_t>     _usage = 0; // drops to 0 under the shard's lock
+            Garbage::iterator       _garbage{}; // valid if _usage is 0
+            uint64_t                _unusedSince = 0; // see Manager::_clock
         };
 
+        // NOTE: AssetBlocks are referred by Leases, and nodes of an unordered_map
+        //       (unlike its iterators) are stable across rehashing
         using Store = std::unordered_map<Id, AssetBlock>;
 
+        struct Shard
+        {
+            std::mutex _mutex;
+            Store      _store;
+            Garbage    _garbage;
+        };
+
+        static constexpr size_t kShards = 16;
+
+    public:
+        struct Stats
+        {
+            size_t _hits = 0;      // borrowed assets which were resident
+            size_t _misses = 0;    // borrowed assets which were read
+            size_t _evictions = 0; // unused assets dropped to fit the limit
+            size_t _size = 0;      // bytes taken by resident assets
+            size_t _unused = 0;    // bytes taken by unused resident assets
+        };
+
     public:
-        explicit Manager(size_t sizeLimit = 0);
+        // Called on the Manager's thread (see poll) with a Lease,
+        // or with an empty one and an error if the asset failed to load
+        using Ready = std::function<void(Lease, std::exception_ptr)>;
+
+        // Called on the Manager's thread (see poll) with a hash (see hash),
+        // std::nullopt if it can't be told or failed
+        using Hashed = std::function<void(std::optional<uint64_t>)>;
+
+        // A request of borrowAsync (see below)
+        class Pending;
+
+        using PendingSptr = std::shared_ptr<Pending>;
+
+    public:
+        // sizeLimit is a soft limit in bytes (0 is unlimited), only unused
+        // assets are evicted to fit it, the least recently used go first;
+        // loaders are threads of borrowAsync (0 is a thread per core)
+        explicit Manager(size_t sizeLimit = 0,
+                         size_t loaders = 0);
 
         virtual ~Manager();
 
@@ -50,53 +128,170 @@ namespace minire::content
                  typename... Args>
         T & setReader(Args && ... args)
         {
+            std::scoped_lock lock(_inFlightMutex);
+            MINIRE_INVARIANT(_inFlight.empty(), "can't set a reader while loading");
             _reader = std::make_unique<T>(std::forward<Args>(args)...);
             return static_cast<T &>(*_reader);
         }
 
-        std::unique_ptr<Lease> borrow(Id const &);
+        // waits for the asset if it's in flight; concurrent borrows
+        // of a missing asset might read it more than once
+        Lease borrow(Id const &);
+
+        // borrows a stored asset w/o reading it, the Lease is empty
+        // if the asset isn't stored (or it's still in flight)
+        Lease tryBorrow(Id const &);
+
+        // Reads and decodes the asset on loader threads unless it's stored
+        // or in flight already, ready is called by poll() in any case
+        std::shared_ptr<Pending const> borrowAsync(Id const &, Ready ready = {});
+
+        // Stores assets loaded since the last call and calls their Ready
+        // callbacks, returns the number of finished requests
+        size_t poll();
 
     public:
         // TODO: add "shadow" flag into a Store key to avoid Id's namespace cluttering
-        std::unique_ptr<Lease> upload(Id const &, Asset);
+        Lease upload(Id const &, Asset);
+
+    public:
+        // a snapshot, counters are updated concurrently
+        Stats stats() const;
+
+        size_t sizeLimit() const { return _sizeLimit; }
+
+    public:
+        // Keys data derived from an asset (i.e. see rasterizer::MeshCache),
+        // it changes whenever the content the asset is loaded from does
+        std::optional<uint64_t> hash(Id const &) const;
+
+        // The same on loader threads, since it may read the whole content;
+        // hashed is called by poll()
+        void hashAsync(Id const &, Hashed hashed);
+
+        // Bytes of an asset w/o decoding them, i.e. to convert them right
+        // into GPU data; nothing is stored, so it's read on every call
+        models::Blob::Sptr raw(Id const &) const;
+
+        // A directory to keep derived data in between runs, it's empty
+        // (the default) if it isn't kept
+        void setCacheDir(std::string);
+
+        std::string const & cacheDir() const { return _cacheDir; }
+
+    private:
+        Shard & shardOf(Id const &);
+
+        // NOTE: the shard's lock is held by callers of the following ones
+
+        // returns a stored one if it's there already
+        AssetBlock & insert(Shard &, Id const &, AssetSptr);
+
+        AssetBlock * find(Shard &, Id const &);
+
+        void erase(Shard &, AssetBlock &) noexcept;
+
+        Lease lease(AssetBlock &);
 
     private:
-        void incUsage(Store::iterator it) noexcept;
+        // NOTE: the usage is increased under the shard's lock, unless
+        //       a Lease of the asset is held by the caller
+        void incUsage(AssetBlock &) noexcept;
+
+        void decUsage(AssetBlock &) noexcept;
+
+        // evicts unused assets while the size is over the limit,
+        // the least recently used one across all the shards first
+        void cleanup() noexcept;
+
+        // moves a loaded asset into the store unless it's there already,
+        // it's empty if the request is finished and released the asset
+        Lease adopt(Pending &);
 
-        void decUsage(Store::iterator) noexcept;
+        void finish(PendingSptr const &);
 
-        void cleanup();
+        utils::ThreadPool & pool(); // NOTE: under _inFlightMutex
 
     private:
+        using InFlight = std::unordered_map<Id, PendingSptr>;
+        using Shards = std::array<Shard, kShards>;
+
+        struct Counters
+        {
+            std::atomic<size_t> _hits = 0;
+            std::atomic<size_t> _misses = 0;
+            std::atomic<size_t> _evictions = 0;
+            std::atomic<size_t> _size = 0;
+            std::atomic<size_t> _unused = 0;
+        };
+
         Reader::Uptr _reader;
+        std::string  _cacheDir;
         size_t const _sizeLimit = 0;
-        size_t       _sizeCurrent = 0;
-        Store        _store;
-        Store        _garbage;
+        Counters     _stats;
+        Shards       _shards;
+        std::mutex            _cleanupMutex; // one cleanup() at a time
+        std::atomic<uint64_t> _clock = 0;    // orders assets becoming unused
+
+        // async loading
+        size_t const                       _loaders = 0;
+        std::unique_ptr<utils::ThreadPool> _pool;      // lazily started
+        std::mutex                         _inFlightMutex;
+        InFlight                           _inFlight;
+        std::mutex                         _finishedMutex;
+        std::vector<PendingSptr>           _finished;  // by loaders
+        std::vector<std::function<void()>> _hashed;    // by loaders, under _finishedMutex
 
         friend class Lease;
     };
 
+    // A handle of a borrowed asset, the asset isn't evicted while
+    // any of its Leases is alive. It's an intrusive reference counter
+    // (see Manager::AssetBlock::_usage), so it's a single pointer which
+    // is copied and moved w/o allocations. An empty Lease is moved-from
+    // or default constructed.
     class Lease
     {
-        Lease(Lease const &) = delete;
-        Lease(Lease &&) = delete;
-        Lease& operator=(Lease const &) = delete;
-        Lease& operator=(Lease &&) = delete;
+    public:
+        Lease() noexcept = default;
+
+        Lease(Lease const & other) noexcept
+            : _block(other._block)
+        {
+            // the other one keeps it used, so no shard's lock is needed
+            if (_block) _block->_manager.incUsage(*_block);
+        }
+
+        Lease(Lease && other) noexcept
+            : _block(std::exchange(other._block, nullptr))
+        {}
+
+        Lease & operator=(Lease other) noexcept
+        {
+            std::swap(_block, other._block);
+            return *this;
+        }
+
+        ~Lease()
+        {
+            if (_block) _block->_manager.decUsage(*_block);
+        }
 
     public:
+        explicit operator bool() const { return nullptr != _block; }
+
         Id const & id() const
         {
-            assert(_asset != _manager._store.cend());
-            assert(_asset->second._usage != 0);
-            return _asset->first;
+            assert(_block);
+            assert(_block->_usage.load(std::memory_order_relaxed) != 0);
+            return _block->_id;
         }
 
         Asset const & operator*() const
         {
-            assert(_asset != _manager._store.cend());
-            assert(_asset->second._usage != 0);
-            return _asset->second._asset;
+            assert(_block);
+            assert(_block->_usage.load(std::memory_order_relaxed) != 0);
+            return *_block->_asset;
         }
 
         template<typename T>
@@ -120,29 +315,49 @@ namespace minire::content
         }
 
         template<typename Visitor>
-        constexpr auto visit(Visitor && visitor)
+        constexpr auto visit(Visitor && visitor) const
         {
             Asset const & asset = operator*();
             return std::visit(std::forward<Visitor>(visitor), asset);
         }
 
-        ~Lease()
-        {
-            _manager.decUsage(_asset);
-        }
+    private:
+        // NOTE: the usage is increased by the caller (see Manager::lease)
+        explicit Lease(Manager::AssetBlock & block) noexcept
+            : _block(&block)
+        {}
 
     private:
-        Lease(Manager::Store::iterator asset,
-              Manager & manager)
-            : _asset(asset)
-            , _manager(manager)
-        {
-            _manager.incUsage(_asset);
-        }
+        Manager::AssetBlock * _block = nullptr;
+
+        friend class Manager;
+    };
+
+    static_assert(sizeof(Lease) == sizeof(void *));
+
+    // A request of borrowAsync, it's shared by all the requests
+    // of the same asset which are in flight at the same time
+    class Manager::Pending
+    {
+    public:
+        explicit Pending(Id id) : _id(std::move(id)) {}
+
+        Id const & id() const { return _id; }
+
+        // it's read (or failed) but it isn't in the Manager until poll
+        bool loaded() const { return _loaded.load(std::memory_order_acquire); }
+
+        void wait() const { _loaded.wait(false, std::memory_order_acquire); }
 
     private:
-        Manager::Store::iterator _asset;
-        Manager                & _manager;
+        Id const           _id;
+        AssetSptr          _asset;
+        std::exception_ptr _error;
+        std::atomic<bool>  _loaded = false;
+        std::vector<Ready> _ready;  // guarded by Manager::_inFlightMutex
+        std::mutex         _mutex;  // guards adoption of the asset
+        bool               _adopted = false;
+        Lease              _lease;  // keeps a stored asset till poll
 
         friend class Manager;
     };
@@ -161,15 +376,16 @@ namespace minire::content::readers
     public:
         void remove(content::Id const &);
 
-        bool contains(content::Id const &) const;
-
         void store(content::Id const &, content::Asset);
 
     public:
-        Asset load(Id const &) const override;
+        // the stored asset itself, it's never copied
+        AssetSptr load(Id const &) const override;
+
+        bool contains(Id const &) const override;
 
     private:
-        std::unordered_map<content::Id, content::Asset> _store;
+        std::unordered_map<content::Id, content::AssetSptr> _store;
     };
 }
 
@@ -177,25 +393,89 @@ namespace minire::content::readers
 
 namespace minire::content::readers
 {
+    // NOTE: missing files aren't loaded, so readers::Chained falls through them
     class Filesystem : public Reader
     {
     public:
         explicit Filesystem(std::string prefix);
 
     public:
-        Asset load(Id const &) const override;
+        AssetSptr load(Id const &) const override;
+
+        bool contains(Id const &) const override;
+
+        std::optional<uint64_t> hash(Id const &) const override;
+
+        models::Blob::Sptr raw(Id const &) const override;
+
+    private:
+        std::filesystem::path path(Id const &) const;
+
+        Asset decode(std::filesystem::path const &) const;
 
     private:
         std::string _prefix;
     };
 }
 
+namespace minire::content::readers
+{
+    // Assets of a pack (see formats/pack.hpp) which is mapped into memory,
+    // uncompressed blobs are decoded right from the mapping. Ids which
+    // aren't in the pack aren't loaded, so readers::Chained falls through
+    // them: chain a Filesystem before an Archive to patch it w/ loose files.
+    class Archive : public Reader
+    {
+    public:
+        explicit Archive(std::string filename);
+
+        ~Archive() override;
+
+    public:
+        AssetSptr load(Id const &) const override;
+
+        bool contains(Id const &) const override;
+
+        std::optional<uint64_t> hash(Id const &) const override;
+
+        // uncompressed blobs are referred right in the mapping
+        models::Blob::Sptr raw(Id const &) const override;
+
+        size_t size() const { return _entries.size(); }
+
+    private:
+        formats::pack::Entry const * find(std::string_view) const;
+
+        Asset decode(Id const &, formats::pack::Entry const &) const;
+
+        // bytes of a blob as they are in the pack
+        models::Blob::Bytes stored(formats::pack::Entry const &) const;
+
+        models::Blob::Sptr blob(formats::pack::Entry const &) const;
+
+    private:
+        using Entries = std::span<formats::pack::Entry const>;
+
+        std::string                              _filename;
+        std::shared_ptr<utils::MappedFile const> _file;
+        Entries                                  _entries;
+        std::string_view                         _names;
+    };
+}
+
 namespace minire::content::readers
 {
     class Chained : public Reader
     {
     public:
-        Asset load(Id const &) const override;
+        AssetSptr load(Id const &) const override;
+
+        bool contains(Id const &) const override;
+
+        // of the first reader which contains the id, as load() does
+        std::optional<uint64_t> hash(Id const &) const override;
+
+        models::Blob::Sptr raw(Id const &) const override;
 
         Chained & append(Reader::Uptr);
 
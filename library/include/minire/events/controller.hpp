@@ -29,6 +29,9 @@ namespace minire::events
                                     controller::SetSymbolLabel,
                                     controller::UnsetCharLabel,
                                     controller::SetStringLabel,
+                                    controller::SetLabelRegion,
+                                    controller::ScrollLabel,
+                                    controller::SetLabelPalette,
                                     controller::SetLabelCursor,
                                     controller::UnsetLabelCursor,
                                     controller::SetLabelVisible,
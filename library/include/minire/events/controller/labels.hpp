@@ -1,10 +1,12 @@
 #pragma once
 
 #include <minire/text/formatted-string.hpp>
+#include <minire/text/packed-symbol.hpp>
 #include <minire/text/symbol.hpp>
 #include <minire/text/text-format.hpp>
 
 #include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
 
 #include <string>
 #include <vector>
@@ -65,6 +67,33 @@ namespace minire::events::controller
         size_t                _col;
     };
 
+    // A block of symbols (row-major, _cols wide) at (_row, _col), colors
+    // of the symbols are to be indices of the palette (see SetLabelPalette)
+    struct SetLabelRegion
+    {
+        std::string                     _id;
+        size_t                          _row;
+        size_t                          _col;
+        size_t                          _cols;
+        std::vector<text::PackedSymbol> _symbols;
+    };
+
+    // Colors of palette entries from _first, for text::PackedSymbol
+    struct SetLabelPalette
+    {
+        std::string            _id;
+        size_t                 _first;
+        std::vector<glm::vec4> _colors;
+    };
+
+    // Moves symbols by _rows towards the row 0 (backwards if negative),
+    // only the exposed rows are to be set after that
+    struct ScrollLabel
+    {
+        std::string _id;
+        int         _rows;
+    };
+
     struct SetLabelCursor
     {
         std::string _id;
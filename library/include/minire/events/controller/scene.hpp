@@ -18,11 +18,14 @@ namespace minire::events::controller
 
     // Ctors
 
+    // The model is loaded in background, the placeholder (if any)
+    // is loaded at once and drawn instead of the model until then
     struct SceneEmergeModel
     {
         size_t                _id;
         content::Id           _model;
         models::ModelPosition _position;
+        content::MaybeId      _placeholder = std::nullopt;
     };
 
     struct SceneEmergePointLight
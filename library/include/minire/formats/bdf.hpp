@@ -6,6 +6,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 // TODO: cover with tests
@@ -28,7 +29,7 @@ namespace minire::formats
         {
             friend class Bdf;
 
-            using BitLines = std::vector<size_t>;
+            using Bitmap = std::vector<uint8_t>;
 
             std::string _name;
             size_t      _encoding = 0;
@@ -41,45 +42,27 @@ namespace minire::formats
             int         _dwx1 = 0;
             int         _dwy1 = 0;
             BBox        _bbx;
-            size_t      _bits = 0;
+            size_t      _stride = 0; // bytes per row
             bool        _loaded = false;
-            BitLines    _bitLines;
-
-            void reset();
+            Bitmap      _bitmap;     // rows as in a file, MSB is the left pixel
 
         public:
             bool         loaded() const { return _loaded; }
+            size_t       encoding() const { return _encoding; }
             BBox const & bbox() const   { return _bbx; }
+            size_t       stride() const { return _stride; }
 
-            size_t const & bitLine(size_t y) const
+            uint8_t const * row(size_t y) const
             {
-                assert(y < _bitLines.size());
-                return _bitLines[y];
+                assert(y < _bbx._h);
+                return _bitmap.data() + y * _stride;
             }
 
             bool test(size_t x, size_t y) const
             {
-                assert(_bitLines.size() == _bbx._h);
                 return x < _bbx._w &&
-                       y < _bitLines.size() && (
-                        _bitLines[y] & (size_t(1) << (_bits - x - 1)));
-            }
-
-            template<typename Pixel, Pixel kOn, Pixel kOff>
-            void render(Pixel * buffer,
-                               size_t bufWidth,
-                               size_t /*bufHeight*/,
-                               size_t stX,
-                               size_t stY) const
-            {
-                for(size_t y = 0; y < _bbx._h; ++y)
-                {
-                    for(size_t x = 0; x < _bbx._w; ++x)
-                    {
-                        buffer[(stX + x) + (stY + y) * bufWidth] =
-                            test(x, y) ? kOn : kOff;
-                    }
-                }
+                       y < _bbx._h &&
+                       (row(y)[x / 8] & (0x80 >> (x % 8)));
             }
         };
 
@@ -95,53 +78,38 @@ namespace minire::formats
         BBox const & bbox() const { return _bbx; }
 
     public:
-        Char const & find(size_t encoding) const
-        {
-            static Char kNotFound;
-            return encoding < _chars.size() ? _chars[encoding]
-                                            : kNotFound;
-        }
+        Char const & find(size_t encoding) const;
 
         void fillChar(size_t encoding, size_t value);
 
-        size_t maxEncoding() const { return _chars.size() - 1; }
-        size_t loadedChars() const { return _loadedChars; }
+        // loaded chars only, sorted by encodings
+        auto const & chars() const { return _chars; }
+
+        size_t loadedChars() const { return _chars.size(); }
+
+        // memory taken by chars, in bytes
+        size_t bytes() const;
 
         auto const & filename() const { return _filename; }
 
     private:
-        static std::string::const_iterator parseNonSpace(
-            std::string::const_iterator const & begin,
-            std::string::const_iterator const & end,
-            std::string & token);
-
-        void load(std::istream &);
+        class Parser;
 
-        void parse(std::string::const_iterator const & begin,
-                   std::string::const_iterator const & end);
+        void load(std::string_view);
 
-        std::string location(void) const;
+        void loadChars(std::string_view, size_t begin);
 
     private:
         using Chars = std::vector<Char>;
 
-        bool        _fontStarted = false;
-        bool        _propertiesStarted = false;
         std::string _version;
         std::string _fontName;
-        size_t      _loadedChars = 0;
         size_t      _pointSize = 0;
         size_t      _xRes = 0;
         size_t      _yRes = 0;
         BBox        _bbx;
         Chars       _chars;
         Properties  _properties;
-
-        Char        _current;
-        bool        _haveCurrent = false;
-        bool        _haveBitmap = false;
-
-        size_t      _lineNumber = 0;
         std::string _filename;
     };
 }
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <minire/models/blob.hpp>
+
+#include <string>
+
+namespace minire::formats
+{
+    // Maps a file into memory as is, w/o reading it
+    models::Blob::Sptr loadBlob(std::string const &);
+}
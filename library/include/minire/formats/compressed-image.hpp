@@ -0,0 +1,23 @@
+#pragma once
+
+#include <minire/models/blob.hpp>
+#include <minire/models/compressed-image.hpp>
+
+#include <string>
+
+namespace minire::formats
+{
+    // KTX2 (w/o supercompression) and DDS files of BCn or ETC2 blocks,
+    // sRGB formats are loaded as linear ones, since shaders decode gamma
+    // themselves; the filename is for messages
+    models::CompressedImage::Sptr loadKtx2(models::Blob::Sptr const &,
+                                           std::string const & filename);
+
+    models::CompressedImage::Sptr loadDds(models::Blob::Sptr const &,
+                                          std::string const & filename);
+
+    // by magic numbers (i.e. for images of packs)
+    bool isKtx2(models::Blob::Bytes);
+
+    bool isDds(models::Blob::Bytes);
+}
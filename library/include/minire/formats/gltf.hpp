@@ -1,11 +1,17 @@
 #pragma once
 
+#include <minire/models/blob.hpp>
+
 #define TINYGLTF_NO_INCLUDE_JSON
 #define TINYGLTF_NO_INCLUDE_STB_IMAGE
 #define TINYGLTF_NO_STB_IMAGE_WRITE
 #include <tinygltf/tiny_gltf.h>
 
+#include <cstddef>
+#include <functional>
 #include <memory>
+#include <span>
+#include <string>
 
 namespace minire::formats
 {
@@ -13,4 +19,20 @@ namespace minire::formats
 
     GltfModelSptr loadGltf(std::string const & filename);
     GltfModelSptr loadGlb(std::string const & filename);
+
+    // Reads files a .gltf refers (buffers and images) by their paths
+    // relative to the .gltf's one, an empty pointer if there is no file
+    using GltfFiles = std::function<models::Blob::Sptr(std::string const &)>;
+
+    GltfModelSptr loadGltf(models::Blob::Sptr const & blob,
+                           std::string const & filename,
+                           GltfFiles const & files);
+
+    // The BIN chunk isn't copied into the model's buffer, but it's referred
+    // in the blob by the model (see gltfBuffer)
+    GltfModelSptr loadGlb(models::Blob::Sptr const & blob,
+                          std::string const & filename);
+
+    // Bytes of a buffer of a model, use it instead of Buffer::data
+    std::span<std::byte const> gltfBuffer(GltfModelSptr const &, size_t buffer);
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <minire/models/blob.hpp>
 #include <minire/models/image.hpp>
 
 #include <string>
@@ -8,4 +9,8 @@
 namespace minire::formats
 {
     models::Image::Sptr loadImage(std::string const &);
+
+    // decodes an image file's content, the filename is for messages
+    models::Image::Sptr loadImage(models::Blob::Sptr const &,
+                                  std::string const & filename);
 }
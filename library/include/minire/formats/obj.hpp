@@ -4,6 +4,7 @@
 #include <glm/vec3.hpp>
 
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <vector>
 
@@ -62,8 +63,11 @@ namespace minire::formats
      *       - v, vn, vt, f, #
      *       - 3d v and vn
      *       - 2d vt
-     *       - unlimited amount of point for a face
+     *       - unlimited amount of point for a face (triangulated as a fan)
+     *       - negative (relative) indices
+     * \note Big texts are parsed by chunks in parallel.
      */
+    Obj parseObj(std::string_view text, std::string const & filename);
     Obj loadObj(std::string const &);
     Obj loadObj(std::istream &);
     
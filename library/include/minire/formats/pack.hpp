@@ -0,0 +1,93 @@
+#pragma once
+
+#include <boost/algorithm/string.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+// A pack is a single file of many assets (see readers::Archive and
+// the minire-pack tool), laid out as:
+//
+//   Header
+//   Entry[_count]    sorted by (_hash, name)
+//   names            content ids of entries, not terminated
+//   blobs            each one is aligned to kAlignment
+//
+// All the integers are little-endian as well as all the supported platforms.
+namespace minire::formats::pack
+{
+    constexpr uint32_t kMagic     = 0x4B50524D; // "MRPK"
+    constexpr uint32_t kVersion   = 1;
+    constexpr size_t   kAlignment = 64;
+
+    // how a blob is decoded into a content::Asset
+    enum class Type : uint8_t
+    {
+        kBlob,
+        kImage,
+        kObj,
+        kGltf,
+        kGlb,
+    };
+
+    enum class Compression : uint8_t
+    {
+        kNone,
+        kZlib, // RFC 1950 stream
+    };
+
+    struct Header
+    {
+        uint32_t _magic;
+        uint32_t _version;
+        uint64_t _count;       // of entries
+        uint64_t _namesOffset;
+        uint64_t _namesSize;
+    };
+
+    struct Entry
+    {
+        uint64_t    _hash;       // of the name (see hash())
+        uint64_t    _offset;     // of the blob, from the beginning of the pack
+        uint64_t    _size;       // of the blob as stored
+        uint64_t    _rawSize;    // of the blob after decompression
+        uint32_t    _nameOffset; // from Header::_namesOffset
+        uint32_t    _nameSize;
+        Type        _type;
+        Compression _compression;
+        uint8_t     _reserved[6];
+    };
+
+    static_assert(sizeof(Header) == 32);
+    static_assert(sizeof(Entry) == 48);
+
+    // FNV-1a, stable across platforms unlike std::hash
+    constexpr uint64_t hash(std::string_view name)
+    {
+        uint64_t result = 0xcbf29ce484222325ull;
+        for(char c : name)
+        {
+            result ^= static_cast<uint8_t>(c);
+            result *= 0x100000001b3ull;
+        }
+        return result;
+    }
+
+    // the same way readers::Filesystem tells content types
+    inline Type typeOf(std::string_view filename)
+    {
+        std::string ext = std::filesystem::path(filename).extension();
+        boost::algorithm::to_lower(ext);
+
+        if (".png" == ext || ".jpg" == ext || ".jpeg" == ext || ".tga" == ext ||
+            ".ktx2" == ext || ".dds" == ext)
+            return Type::kImage;
+        if (".obj" == ext) return Type::kObj;
+        if (".gltf" == ext) return Type::kGltf;
+        if (".glb" == ext) return Type::kGlb;
+        return Type::kBlob;
+    }
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
 
 #include <cstddef>
 #include <memory>
@@ -66,6 +67,12 @@ namespace minire::material
                                     glm::mat4 const & modelTransform,
                                     float const colorFactor) const = 0;
 
+        // Called after prepareDrawing before each primitive is drawn,
+        // positions are decoded as offset + position * scale (i.e. ones
+        // quantized relative to an AABB)
+        virtual void preparePrimitive(glm::vec3 const & positionScale,
+                                      glm::vec3 const & positionOffset) const = 0;
+
         virtual opengl::Program const & glProgram() const = 0;
 
         // TODO: assert int == GLint
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+
+namespace minire::models
+{
+    // Raw bytes of a file (i.e. mapped by readers::Filesystem),
+    // the bytes are valid as long as the Blob is alive, so while
+    // a content::Lease of it is held
+    struct Blob
+    {
+        using Sptr = std::shared_ptr<Blob const>;
+
+        using Bytes = std::span<std::byte const>;
+
+        virtual ~Blob() = 0;
+
+        virtual Bytes bytes() const = 0;
+    };
+
+    inline Blob::~Blob() {}
+}
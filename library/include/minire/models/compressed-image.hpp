@@ -0,0 +1,74 @@
+#pragma once
+
+#include <minire/errors.hpp>
+#include <minire/models/blob.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace minire::models
+{
+    // An image of 4x4 blocks compressed for GPUs w/ prebuilt mips, blocks
+    // are kept as they're in a file (see formats::loadKtx2 and loadDds)
+    struct CompressedImage
+    {
+        using Sptr = std::shared_ptr<CompressedImage const>;
+
+        enum class Format
+        {
+            kBc1       = 0, // RGB (DXT1)
+            kBc1Alpha  = 1, // RGB w/ 1-bit alpha
+            kBc3       = 2, // RGBA (DXT5)
+            kBc4       = 3, // R
+            kBc5       = 4, // RG
+            kBc7       = 5, // RGBA
+            kEtc2      = 6, // RGB
+            kEtc2Alpha = 7, // RGBA
+        };
+
+        struct Level
+        {
+            size_t      _width = 0;
+            size_t      _height = 0;
+            Blob::Bytes _bytes;
+        };
+
+        size_t             _width = 0;
+        size_t             _height = 0;
+        Format             _format = Format::kBc1;
+        std::vector<Level> _levels; // the base one first
+        Blob::Sptr         _blob;   // keeps the bytes of levels
+
+        static size_t bytesInBlock(Format format)
+        {
+            switch(format)
+            {
+                case Format::kBc1:
+                case Format::kBc1Alpha:
+                case Format::kBc4:
+                case Format::kEtc2:
+                    return 8;
+                case Format::kBc3:
+                case Format::kBc5:
+                case Format::kBc7:
+                case Format::kEtc2Alpha:
+                    return 16;
+            }
+            MINIRE_THROW("unknown compressed format: {}", static_cast<int>(format));
+        }
+
+        // of a level of the size
+        static size_t bytesInLevel(Format format, size_t width, size_t height)
+        {
+            return ((width + 3) / 4) * ((height + 3) / 4) * bytesInBlock(format);
+        }
+
+        size_t bytes() const
+        {
+            size_t result = 0;
+            for(Level const & level : _levels) result += level._bytes.size();
+            return result;
+        }
+    };
+}
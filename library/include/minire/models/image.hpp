@@ -37,6 +37,10 @@ namespace minire::models
 
         virtual ~Image() = 0;
 
+        // false if pixels are kept by another asset (e.g. a glTF model),
+        // so they aren't counted twice against the content::Manager's limit
+        virtual bool ownsData() const { return true; }
+
         size_t bytesInComponent() const
         {
             switch(_depth)
@@ -11,10 +11,12 @@ namespace minire::models
     public:
         explicit MeshFeatures(bool const hasUv,
                               bool const hasNormal,
-                              bool const hasTangent)
+                              bool const hasTangent,
+                              bool const quantized = false)
             : _hasUv(hasUv)
             , _hasNormal(hasNormal)
             , _hasTangent(hasTangent)
+            , _quantized(quantized)
         {}
 
     public:
@@ -22,18 +24,23 @@ namespace minire::models
         bool hasNormal() const  { return _hasNormal; }
         bool hasTangent() const { return _hasTangent; }
 
+        // normals and tangents are octahedral-encoded (see utils::quantize)
+        bool quantized() const  { return _quantized; }
+
     public:
         bool operator==(MeshFeatures const & o) const
         {
             return _hasUv == o._hasUv
                 && _hasNormal == o._hasNormal
-                && _hasTangent == o._hasTangent;
+                && _hasTangent == o._hasTangent
+                && _quantized == o._quantized;
         }
 
     private:
         bool const _hasUv;
         bool const _hasNormal;
         bool const _hasTangent;
+        bool const _quantized;
     };
 }
 
@@ -48,6 +55,7 @@ namespace std
             boost::hash_combine(result, std::hash<bool>{}(v.hasUv()));
             boost::hash_combine(result, std::hash<bool>{}(v.hasNormal()));
             boost::hash_combine(result, std::hash<bool>{}(v.hasTangent()));
+            boost::hash_combine(result, std::hash<bool>{}(v.quantized()));
             return result;
         }
     };
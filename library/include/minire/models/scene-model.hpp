@@ -15,5 +15,9 @@ namespace minire::models
         content::Id           _source;
         size_t                _meshIndex = kNoIndex;
         material::Model::Sptr _defaultMaterial;
+
+        // vertices are quantized on import: positions are 16-bit relative
+        // to the AABB, normals and tangents are octahedral, UVs are halves
+        bool                  _quantized = false;
     };
 }
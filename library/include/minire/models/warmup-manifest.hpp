@@ -0,0 +1,42 @@
+#pragma once
+
+#include <minire/content/id.hpp>
+#include <minire/material.hpp>
+#include <minire/models/mesh-features.hpp>
+#include <minire/models/sampler.hpp>
+
+#include <vector>
+
+namespace minire::models
+{
+    // Content to be ready by the first interactive frame (see Application::warmup)
+    struct WarmupManifest
+    {
+        struct Texture
+        {
+            content::Id _id;
+            Sampler     _sampler;
+            bool        _atlased = false; // as sprites use it
+        };
+
+        // a program of a material which is built w/o any mesh
+        struct Material
+        {
+            material::Model::Sptr _model;
+            MeshFeatures          _features;
+        };
+
+        // groups of a higher priority are requested and uploaded first,
+        // the ones of the same priority are merged
+        struct Group
+        {
+            int                   _priority = 0;
+            content::Ids          _meshes;    // of SceneModels
+            std::vector<Texture>  _textures;
+            content::Ids          _fonts;     // of BDFs
+            std::vector<Material> _materials;
+        };
+
+        std::vector<Group> _groups;
+    };
+}
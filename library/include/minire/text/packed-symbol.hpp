@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+
+namespace minire::text
+{
+    // A compact symbol of a label: a code point, style flags and colors
+    // as indices. Indices below kPaletteSize are entries of a label's
+    // palette (see SetLabelPalette), the rest are true colors that
+    // the label interns for symbols set as text::Symbol. Such indices
+    // are private to the label, so symbols written as a region (see
+    // SetLabelRegion) may only use palette indices.
+    class PackedSymbol
+    {
+        static constexpr uint32_t kCodePointMask = (1u << 21) - 1;
+
+        static constexpr uint32_t kBlank        = (1u << 21);
+        static constexpr uint32_t kBold         = (1u << 22);
+        static constexpr uint32_t kItalic       = (1u << 23);
+        static constexpr uint32_t kUnderline    = (1u << 24);
+        static constexpr uint32_t kStrikeout    = (1u << 25);
+        static constexpr uint32_t kInvertColors = (1u << 26);
+
+    public:
+        static constexpr uint32_t kMaxCodePoint = kCodePointMask;
+        static constexpr uint16_t kPaletteSize  = 256;
+
+        // of the default palette (xterm's)
+        static constexpr uint16_t kWhite        = 15;
+        static constexpr uint16_t kBlack        = 0;
+
+    public:
+        PackedSymbol() = default;
+
+        PackedSymbol(wchar_t c, uint16_t foreground, uint16_t background)
+            : _code(static_cast<uint32_t>(c) & kCodePointMask)
+            , _foreground(foreground)
+            , _background(background)
+        {}
+
+    public:
+        void unset() { blank(true); }
+
+        void set(wchar_t c)
+        {
+            _code = (_code & ~kCodePointMask)
+                  | (static_cast<uint32_t>(c) & kCodePointMask);
+            blank(false);
+        }
+
+    public:
+        wchar_t codePoint() const { return _code & kCodePointMask; }
+
+        bool blank() const { return _code & kBlank; }
+        bool bold() const { return _code & kBold; }
+        bool italic() const { return _code & kItalic; }
+        bool underline() const { return _code & kUnderline; }
+        bool strikeout() const { return _code & kStrikeout; }
+        bool invertColors() const { return _code & kInvertColors; }
+
+        uint16_t foreground() const { return _foreground; }
+        uint16_t background() const { return _background; }
+
+    public:
+        PackedSymbol & blank(bool v)        { return _s(v, kBlank); }
+        PackedSymbol & bold(bool v)         { return _s(v, kBold); }
+        PackedSymbol & italic(bool v)       { return _s(v, kItalic); }
+        PackedSymbol & underline(bool v)    { return _s(v, kUnderline); }
+        PackedSymbol & strikeout(bool v)    { return _s(v, kStrikeout); }
+        PackedSymbol & invertColors(bool v) { return _s(v, kInvertColors); }
+
+        PackedSymbol & foreground(uint16_t v)
+        {
+            _foreground = v;
+            return *this;
+        }
+
+        PackedSymbol & background(uint16_t v)
+        {
+            _background = v;
+            return *this;
+        }
+
+    public:
+        bool operator==(PackedSymbol const & other) const
+        {
+            return _code == other._code
+                && _foreground == other._foreground
+                && _background == other._background;
+        }
+
+        bool operator!=(PackedSymbol const & other) const
+        {
+            return !operator==(other);
+        }
+
+    private:
+        PackedSymbol & _s(bool val, uint32_t flag)
+        {
+            if (val)
+            {
+                _code |= flag;
+            }
+            else
+            {
+                _code &= ~flag;
+            }
+            return *this;
+        }
+
+    private:
+        uint32_t _code       = kBlank; // code point and flags
+        uint16_t _foreground = kWhite;
+        uint16_t _background = kBlack;
+    };
+
+    static_assert(sizeof(PackedSymbol) == 8);
+}
@@ -1,5 +1,6 @@
 #include <minire/application.hpp>
 
+#include <minire/content/manager.hpp>
 #include <minire/logging.hpp>
 #include <minire/utils/unow.hpp>
 #include <opengl.hpp>
@@ -11,6 +12,7 @@ namespace minire
     // TODO: move them into parameters
     static const float kNear = 0.1f;
     static const float kFar = 100.0f;
+    static const size_t kWarmupSlice = 8000; // microseconds of a frame
 
     Application::Application(int width, int height,
                              std::string const & title,
@@ -54,6 +56,11 @@ namespace minire
         }
     }
 
+    void Application::warmup(models::WarmupManifest const & manifest)
+    {
+        _rasterizer.warmup(manifest);
+    }
+
     template<typename Event, typename... Args>
     void Application::postEvent(Args && ... args)
     {
@@ -243,8 +250,7 @@ namespace minire
         _rasterizer
             .labels()
             .get(e._id)
-            .at(e._row, e._col)
-            .set(e._format, e._char);
+            .set(e._row, e._col, e._format, e._char);
     }
 
     void Application::handle(events::controller::SetSymbolLabel const & e)
@@ -252,7 +258,7 @@ namespace minire
         _rasterizer
             .labels()
             .get(e._id)
-            .at(e._row, e._col) = e._symbol;
+            .set(e._row, e._col, e._symbol);
     }
     
     void Application::handle(events::controller::UnsetCharLabel const & e)
@@ -260,8 +266,7 @@ namespace minire
         _rasterizer
             .labels()
             .get(e._id)
-            .at(e._row, e._col)
-            .unset();
+            .unset(e._row, e._col);
     }
 
     void Application::handle(events::controller::SetStringLabel const & e)
@@ -269,6 +274,24 @@ namespace minire
         _rasterizer.labels().get(e._id).set(e._row, e._col, e._string);
     }
 
+    void Application::handle(events::controller::SetLabelRegion const & e)
+    {
+        _rasterizer
+            .labels()
+            .get(e._id)
+            .setRegion(e._row, e._col, e._cols, e._symbols);
+    }
+
+    void Application::handle(events::controller::ScrollLabel const & e)
+    {
+        _rasterizer.labels().get(e._id).scroll(e._rows);
+    }
+
+    void Application::handle(events::controller::SetLabelPalette const & e)
+    {
+        _rasterizer.labels().get(e._id).setPalette(e._first, e._colors);
+    }
+
     void Application::handle(events::controller::SetLabelCursor const & e)
     {
         _rasterizer.labels().get(e._id).setCursor(e._col, e._row);
@@ -380,6 +403,19 @@ namespace minire
     {
         assert(_controller);
 
+        // finish assets loaded in background
+        _contentManager.poll();
+
+        // frames of a warmup keep the window alive, but they aren't interactive
+        if (!_rasterizer.warmupStep(kWarmupSlice))
+        {
+            MINIRE_GL(glClear, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            ::SDL_GL_SwapWindow(window());
+
+            _frameBegin = utils::uNow();
+            return;
+        }
+
         // notify logic thread about new events
         _controller->push(std::move(_applicationEvents));
         _applicationEvents.clear();
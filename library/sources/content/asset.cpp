@@ -2,7 +2,10 @@
 
 #include <minire/utils/demangle.hpp>
 
+#include <utils/overloaded.hpp>
+
 #include <type_traits>
+#include <vector>
 
 namespace minire::content
 {
@@ -17,10 +20,87 @@ namespace minire::content
             asset);
     }
 
-    // TODO: implement it
-    size_t sizeOf(Asset const &)
+    namespace
+    {
+        template<typename T>
+        size_t bytesOf(std::vector<T> const & items)
+        {
+            return items.capacity() * sizeof(T);
+        }
+
+        size_t bytesOf(formats::Obj const & obj)
+        {
+            return bytesOf(obj._vertices)
+                 + bytesOf(obj._normals)
+                 + bytesOf(obj._uvs)
+                 + bytesOf(obj._faceVertices)
+                 + bytesOf(obj._faceNormals)
+                 + bytesOf(obj._faceUvs);
+        }
+
+        // only bulk data is counted, the rest of a model is negligible
+        size_t bytesOf(formats::GltfModelSptr const & model)
+        {
+            size_t bytes = 0;
+            for(size_t i = 0; i < model->buffers.size(); ++i)
+            {
+                bytes += formats::gltfBuffer(model, i).size();
+            }
+            for(auto const & image : model->images) bytes += bytesOf(image.image);
+            return bytes;
+        }
+
+        size_t bytesOf(models::Image const & image)
+        {
+            if (!image._data) return 0;
+            return image.bytesInLine() * image._height;
+        }
+    }
+
+    size_t sizeOf(Asset const & asset)
     {
-        return 0;
+        return std::visit(
+            utils::Overloaded
+            {
+                [](std::monostate) -> size_t { return 0; },
+                [](std::string const & string) -> size_t
+                {
+                    return sizeof(string) + string.capacity();
+                },
+                [](formats::Bdf::Sptr const & bdf) -> size_t
+                {
+                    return bdf ? sizeof(*bdf) + bdf->bytes() : 0;
+                },
+                [](formats::Obj const & obj) -> size_t
+                {
+                    return sizeof(obj) + bytesOf(obj);
+                },
+                [](formats::GltfModelSptr const & model) -> size_t
+                {
+                    return model ? sizeof(*model) + bytesOf(model) : 0;
+                },
+                [](models::Image::Sptr const & image) -> size_t
+                {
+                    if (!image) return 0;
+                    return sizeof(*image) + (image->ownsData() ? bytesOf(*image) : 0);
+                },
+                [](models::CompressedImage::Sptr const & image) -> size_t
+                {
+                    // blocks are bytes of a blob, which is counted
+                    // here, since the image is the only one using it
+                    return image ? sizeof(*image) + image->_blob->bytes().size() : 0;
+                },
+                [](models::Blob::Sptr const & blob) -> size_t
+                {
+                    // mapped pages are resident as well
+                    return blob ? sizeof(*blob) + blob->bytes().size() : 0;
+                },
+                [](auto const & item) -> size_t
+                {
+                    return sizeof(item); // a model referring other assets
+                },
+            },
+            asset);
     }
 
     bool hasData(Asset const & asset)
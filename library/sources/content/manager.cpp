@@ -1,35 +1,56 @@
 #include <minire/content/manager.hpp>
 
 #include <minire/errors.hpp>
+#include <minire/formats/blob.hpp>
+#include <minire/formats/compressed-image.hpp>
 #include <minire/formats/gltf.hpp>
 #include <minire/formats/image.hpp>
 #include <minire/formats/obj.hpp>
 #include <minire/logging.hpp>
 
+#include <utils/hash-bytes.hpp>
+#include <utils/mapped-file.hpp>
+#include <utils/thread-pool.hpp>
+
 #include <boost/algorithm/string.hpp>
+#include <stb/stb_image.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib> // for std::abort
+#include <cstring>
 #include <filesystem>
+#include <limits>
+#include <vector>
 
 namespace minire::content
 {
-    Manager::Manager(size_t sizeLimit)
+    Manager::Manager(size_t sizeLimit,
+                     size_t loaders)
         : _sizeLimit(sizeLimit)
-        , _sizeCurrent(0)
+        , _loaders(loaders)
     {}
 
     Manager::~Manager()
     {
+        // loaders refer the Manager, and pending requests hold Leases
+        _pool.reset();
+        _finished.clear();
+        _hashed.clear();
+        _inFlight.clear();
+
         bool fatal = false;
-        for(auto & [id, assetBlock] : _store)
+        for(Shard & shard : _shards)
         {
-            if (assetBlock._usage != 0)
+            for(auto & [id, assetBlock] : shard._store)
             {
-                // not throwing because it is a dtor
-                MINIRE_ERROR("Some Leases have outlived their Manager for \"{}\"! "
-                             "This is very bad and some terrible things are likely to happen :(", id);
-                fatal = true;
+                if (assetBlock._usage.load() != 0)
+                {
+                    // not throwing because it is a dtor
+                    MINIRE_ERROR("Some Leases have outlived their Manager for \"{}\"! "
+                                 "This is very bad and some terrible things are likely to happen :(", id);
+                    fatal = true;
+                }
             }
         }
 
@@ -39,101 +60,482 @@ namespace minire::content
             MINIRE_ERROR("The program will be terminated due voilations of critical invariants.");
             std::abort();
         }
+
+        MINIRE_DEBUG("content::Manager: {} hits, {} misses, {} evictions",
+                     _stats._hits.load(), _stats._misses.load(), _stats._evictions.load());
     }
 
     void Manager::setReader(Reader::Uptr reader)
     {
+        std::scoped_lock lock(_inFlightMutex);
+        MINIRE_INVARIANT(_inFlight.empty(), "can't set a reader while loading");
         _reader = std::move(reader);
     }
 
-    std::unique_ptr<Lease> Manager::borrow(Id const & id)
+    std::optional<uint64_t> Manager::hash(Id const & id) const
     {
-        auto it = _store.find(id);
+        MINIRE_INVARIANT(_reader, "can't hash an asset, no reader set: {}", id);
+        return _reader->hash(id);
+    }
+
+    models::Blob::Sptr Manager::raw(Id const & id) const
+    {
+        MINIRE_INVARIANT(_reader, "can't read an asset, no reader set: {}", id);
+        return _reader->raw(id);
+    }
+
+    void Manager::setCacheDir(std::string directory)
+    {
+        if (!directory.empty())
+        {
+            std::filesystem::create_directories(directory);
+            MINIRE_INFO("content::Manager cache: {}", directory);
+        }
+        _cacheDir = std::move(directory);
+    }
 
-        if (it == _store.cend())
+    Manager::Stats Manager::stats() const
+    {
+        return Stats
+        {
+            _stats._hits.load(std::memory_order_relaxed),
+            _stats._misses.load(std::memory_order_relaxed),
+            _stats._evictions.load(std::memory_order_relaxed),
+            _stats._size.load(std::memory_order_relaxed),
+            _stats._unused.load(std::memory_order_relaxed),
+        };
+    }
+
+    Lease Manager::borrow(Id const & id)
+    {
+        Shard & shard = shardOf(id);
+        while(true)
         {
-            if (auto garbage = _garbage.find(id);
-                garbage != _garbage.cend())
             {
-                auto recovery = _garbage.extract(garbage);
-                auto irt = _store.insert(std::move(recovery));
-                MINIRE_INVARIANT(irt.inserted,
-                                 "failed to restore an Asset from garbage: {}", id);
-                it = irt.position;
-                assert(it->first == id);
-                assert(it->second._usage == 0);
+                std::lock_guard lock(shard._mutex);
+                if (AssetBlock * block = find(shard, id))
+                {
+                    ++_stats._hits;
+                    return lease(*block);
+                }
             }
-            else
+
+            PendingSptr pending;
             {
-                MINIRE_INVARIANT(_reader, "can't load an asset, no reader set: {}", id);
-                auto asset = _reader->load(id);
-                MINIRE_INVARIANT(hasData(asset), "failed to load asset: {}", id);
-                auto result = _store.emplace(id, AssetBlock{std::move(asset), 0, sizeOf(asset)});
-                MINIRE_INVARIANT(result.second, "failed to insert an AssetBlock: {}", id);
+                std::lock_guard lock(_inFlightMutex);
+                if (auto it = _inFlight.find(id); it != _inFlight.end())
+                {
+                    pending = it->second;
+                }
+            }
+
+            if (!pending) break;
 
-                it = result.first;
+            // its callbacks are still called by poll()
+            pending->wait();
+            if (pending->_error) std::rethrow_exception(pending->_error);
+
+            if (Lease result = adopt(*pending))
+            {
+                return result;
             }
+            // finished and released meanwhile, so it's stored or evicted
+        }
+
+        MINIRE_INVARIANT(_reader, "can't load an asset, no reader set: {}", id);
+        AssetSptr asset = _reader->load(id);
+        MINIRE_INVARIANT(asset && hasData(*asset), "failed to load asset: {}", id);
 
-            assert(it != _store.cend());
-            _sizeCurrent += it->second._size;
-            cleanup();
+        Lease result;
+        {
+            std::lock_guard lock(shard._mutex);
+            ++_stats._misses;
+            result = lease(insert(shard, id, std::move(asset)));
         }
+        cleanup();
+        return result;
+    }
 
-        assert(it != _store.cend());
-        assert(it->first == id);
+    Lease Manager::tryBorrow(Id const & id)
+    {
+        Shard & shard = shardOf(id);
+        std::lock_guard lock(shard._mutex);
+        if (AssetBlock * block = find(shard, id))
+        {
+            ++_stats._hits;
+            return lease(*block);
+        }
+        return {};
+    }
 
-        // My deep condolences on the usage of a "new" operator,
-        // but I have to do it since Lease::Lease is private and
-        // std::make_unique won't be able to call.
-        return std::unique_ptr<Lease>(new Lease(it, *this));
+    std::shared_ptr<Manager::Pending const> Manager::borrowAsync(Id const & id, Ready ready)
+    {
+        {
+            std::lock_guard lock(_inFlightMutex);
+            if (auto it = _inFlight.find(id); it != _inFlight.end())
+            {
+                ++_stats._hits;
+                if (ready) it->second->_ready.push_back(std::move(ready));
+                return it->second;
+            }
+        }
+
+        auto request = std::make_shared<Pending>(id);
+        if (ready) request->_ready.push_back(std::move(ready));
+
+        {
+            Shard & shard = shardOf(id);
+            std::lock_guard lock(shard._mutex);
+            if (AssetBlock * block = find(shard, id))
+            {
+                ++_stats._hits;
+                request->_lease = lease(*block);
+                request->_adopted = true;
+            }
+        }
+
+        if (request->_adopted)
+        {
+            // it's already here, just deferred till poll(); not put in
+            // flight, so nobody else can see the request before it's loaded
+            request->_loaded.store(true, std::memory_order_release);
+
+            std::lock_guard lock(_finishedMutex);
+            _finished.push_back(request);
+        }
+        else
+        {
+            MINIRE_INVARIANT(_reader, "can't load an asset, no reader set: {}", id);
+
+            std::lock_guard lock(_inFlightMutex);
+            auto const [it, inserted] = _inFlight.emplace(id, request);
+            if (!inserted)
+            {
+                // requested concurrently since the check above
+                ++_stats._hits;
+                for(Ready & callback : request->_ready)
+                {
+                    it->second->_ready.push_back(std::move(callback));
+                }
+                return it->second;
+            }
+
+            pool().submit(
+                [this, request]
+                {
+                    try
+                    {
+                        request->_asset = _reader->load(request->_id);
+                        MINIRE_INVARIANT(request->_asset && hasData(*request->_asset),
+                                         "failed to load asset: {}", request->_id);
+                    }
+                    catch(...)
+                    {
+                        request->_error = std::current_exception();
+                    }
+
+                    request->_loaded.store(true, std::memory_order_release);
+                    request->_loaded.notify_all();
+
+                    std::lock_guard lock(_finishedMutex);
+                    _finished.push_back(request);
+                });
+        }
+
+        return request;
     }
 
-    std::unique_ptr<Lease> Manager::upload(Id const & id, Asset asset)
+    void Manager::hashAsync(Id const & id, Hashed hashed)
     {
-        auto [it, inserted] = _store.emplace(id, AssetBlock{std::move(asset), 0, sizeOf(asset)});
-        MINIRE_INVARIANT(inserted, "failed to upload raw asset: {}", id);
-        return std::unique_ptr<Lease>(new Lease(it, *this));
+        MINIRE_INVARIANT(_reader, "can't hash an asset, no reader set: {}", id);
+
+        std::lock_guard lock(_inFlightMutex);
+        pool().submit(
+            [this, id, hashed = std::move(hashed)]
+            {
+                std::optional<uint64_t> hash;
+                try
+                {
+                    hash = _reader->hash(id);
+                }
+                catch(std::exception const & e)
+                {
+                    MINIRE_WARNING("failed to hash asset {}: {}", id, e.what());
+                }
+
+                std::lock_guard lock(_finishedMutex);
+                _hashed.push_back([hashed, hash] { hashed(hash); });
+            });
+    }
+
+    size_t Manager::poll()
+    {
+        std::vector<PendingSptr> finished;
+        std::vector<std::function<void()>> hashed;
+        {
+            std::lock_guard lock(_finishedMutex);
+            finished.swap(_finished);
+            hashed.swap(_hashed);
+        }
+
+        for(PendingSptr const & request : finished)
+        {
+            finish(request);
+        }
+        for(auto const & callback : hashed)
+        {
+            callback();
+        }
+        return finished.size() + hashed.size();
     }
 
-    void Manager::cleanup()
+    utils::ThreadPool & Manager::pool()
+    {
+        if (!_pool) _pool = std::make_unique<utils::ThreadPool>(_loaders);
+        return *_pool;
+    }
+
+    Lease Manager::adopt(Pending & request)
+    {
+        assert(request.loaded());
+        assert(!request._error);
+
+        Lease result;
+        {
+            std::lock_guard lock(request._mutex);
+            if (!request._lease)
+            {
+                if (request._adopted) return {};
+
+                Shard & shard = shardOf(request._id);
+                std::lock_guard shardLock(shard._mutex);
+                ++_stats._misses;
+                request._lease = lease(insert(shard, request._id, std::move(request._asset)));
+                request._adopted = true;
+            }
+
+            result = request._lease;
+        }
+        cleanup();
+        return result;
+    }
+
+    void Manager::finish(PendingSptr const & request)
+    {
+        std::vector<Ready> ready;
+        {
+            std::lock_guard lock(_inFlightMutex);
+            // stored ones aren't put in flight (see borrowAsync)
+            auto it = _inFlight.find(request->_id);
+            if (it != _inFlight.end() && it->second == request)
+            {
+                // new requests of the same asset start over from now
+                _inFlight.erase(it);
+            }
+            ready.swap(request->_ready);
+        }
+
+        Lease lease;
+        if (!request->_error)
+        {
+            {
+                std::lock_guard lock(request->_mutex);
+                Shard & shard = shardOf(request->_id);
+                std::lock_guard shardLock(shard._mutex);
+                if (AssetBlock * stored = find(shard, request->_id);
+                    !request->_adopted && stored)
+                {
+                    // uploaded while it was in flight, the upload wins
+                    request->_lease = this->lease(*stored);
+                    request->_adopted = true;
+                }
+            }
+            lease = adopt(*request);
+            assert(lease); // only finish() releases it
+        }
+
+        for(Ready & callback : ready)
+        {
+            callback(lease, request->_error);
+        }
+
+        // it becomes garbage unless callbacks kept Leases
+        Lease released;
+        {
+            std::lock_guard lock(request->_mutex);
+            released = std::move(request->_lease);
+        }
+    }
+
+    Lease Manager::upload(Id const & id, Asset asset)
+    {
+        auto shared = std::make_shared<Asset const>(std::move(asset));
+
+        Shard & shard = shardOf(id);
+        Lease result;
+        {
+            std::lock_guard lock(shard._mutex);
+            if (AssetBlock * block = find(shard, id))
+            {
+                // an unused one might be just not evicted yet
+                MINIRE_INVARIANT(0 == block->_usage.load(),
+                                 "failed to upload raw asset, it's in use: {}", id);
+                erase(shard, *block);
+            }
+            result = lease(insert(shard, id, std::move(shared)));
+        }
+        cleanup();
+        return result;
+    }
+
+    Manager::Shard & Manager::shardOf(Id const & id)
+    {
+        return _shards[std::hash<Id>{}(id) % kShards];
+    }
+
+    Manager::AssetBlock & Manager::insert(Shard & shard, Id const & id, AssetSptr asset)
+    {
+        // i.e. read by concurrent borrows of a missing asset
+        if (AssetBlock * stored = find(shard, id))
+        {
+            return *stored;
+        }
+
+        size_t const index = &shard - _shards.data();
+        size_t const size = sizeOf(*asset);
+        auto [it, inserted] = shard._store.try_emplace(id, id, std::move(asset), *this, index, size);
+        MINIRE_INVARIANT(inserted, "failed to insert an AssetBlock: {}", id);
+        it->second._garbage = shard._garbage.end();
+
+        // NOTE: a new asset isn't in the garbage, so it can't be evicted
+        //       until its Lease is released
+        _stats._size += size;
+
+        return it->second;
+    }
+
+    Manager::AssetBlock * Manager::find(Shard & shard, Id const & id)
+    {
+        auto it = shard._store.find(id);
+        return it != shard._store.end() ? &it->second : nullptr;
+    }
+
+    void Manager::erase(Shard & shard, AssetBlock & block) noexcept
+    {
+        assert(0 == block._usage.load());
+
+        if (block._garbage != shard._garbage.end())
+        {
+            assert(block._size <= _stats._unused);
+            _stats._unused -= block._size;
+            shard._garbage.erase(block._garbage);
+        }
+        _stats._size -= block._size;
+
+        // NOTE: the key mustn't refer the node which is erased
+        shard._store.erase(shard._store.find(block._id));
+    }
+
+    Lease Manager::lease(AssetBlock & block)
+    {
+        incUsage(block);
+        return Lease(block);
+    }
+
+    void Manager::cleanup() noexcept
     {
         if (0 == _sizeLimit) return;
 
-        while(_sizeCurrent > _sizeLimit &&
-              !_garbage.empty())
+        // the one which is running evicts enough for both
+        std::unique_lock cleanupLock(_cleanupMutex, std::try_to_lock);
+        if (!cleanupLock) return;
+
+        while(_stats._size.load() > _sizeLimit)
         {
-            auto it = _garbage.begin();
-            assert(it != _garbage.end());
-            assert(it->second._usage == 0);
-            assert(it->second._size <= _sizeCurrent);
+            // the oldest of the least recently used ones of shards,
+            // locks are taken one at a time to never wait for each other
+            Shard * oldest = nullptr;
+            uint64_t since = std::numeric_limits<uint64_t>::max();
+            for(Shard & shard : _shards)
+            {
+                std::lock_guard lock(shard._mutex);
+                if (!shard._garbage.empty() &&
+                    shard._garbage.front()->_unusedSince < since)
+                {
+                    oldest = &shard;
+                    since = shard._garbage.front()->_unusedSince;
+                }
+            }
 
-            _sizeCurrent -= it->second._size;
-            _garbage.erase(it);
+            if (!oldest) return; // everything is used
+
+            std::lock_guard lock(oldest->_mutex);
+            if (oldest->_garbage.empty() ||
+                oldest->_garbage.front()->_unusedSince != since)
+            {
+                continue; // borrowed meanwhile
+            }
+
+            AssetBlock * victim = oldest->_garbage.front();
+            assert(victim->_usage.load() == 0);
+            ++_stats._evictions;
+            erase(*oldest, *victim);
         }
     }
 
-    void Manager::incUsage(Store::iterator it) noexcept
+    void Manager::incUsage(AssetBlock & block) noexcept
     {
-        assert(it != _store.cend());
-        assert(it->second._usage != std::numeric_limits<size_t>::max());
-        it->second._usage++;
+        size_t const usage = block._usage.fetch_add(1, std::memory_order_acq_rel);
+        assert(usage != std::numeric_limits<size_t>::max());
+
+        Shard & shard = _shards[block._shard];
+        if (0 == usage &&
+            block._garbage != shard._garbage.end())
+        {
+            shard._garbage.erase(block._garbage);
+            block._garbage = shard._garbage.end();
+            _stats._unused -= block._size;
+        }
     }
 
-    void Manager::decUsage(Store::iterator it) noexcept
+    void Manager::decUsage(AssetBlock & block) noexcept
     {
-        assert(it != _store.cend());
-        assert(it->second._usage != 0);
-        it->second._usage--;
+        // not the last Lease, so it can't become garbage
+        size_t usage = block._usage.load(std::memory_order_relaxed);
+        while(usage > 1)
+        {
+            if (block._usage.compare_exchange_weak(usage, usage - 1,
+                                                   std::memory_order_acq_rel))
+            {
+                return;
+            }
+        }
+        assert(usage != 0);
 
-        if (it->second._usage == 0)
         {
-            auto misfit = _store.extract(it);
-            auto res = _garbage.insert(std::move(misfit));
-            if (!res.inserted)
+            Shard & shard = _shards[block._shard];
+            std::lock_guard lock(shard._mutex);
+
+            // it might be borrowed again meanwhile
+            if (1 != block._usage.fetch_sub(1, std::memory_order_acq_rel))
+            {
+                return;
+            }
+
+            try
             {
-                MINIRE_WARNING("failed to garbage an AssetBlock");
+                block._garbage = shard._garbage.insert(shard._garbage.end(), &block);
+                block._unusedSince = _clock.fetch_add(1, std::memory_order_relaxed);
             }
+            catch(...)
+            {
+                // it's never reclaimed then, but the Manager stays consistent
+                MINIRE_WARNING("failed to garbage an AssetBlock: {}", block._id);
+                return;
+            }
+            _stats._unused += block._size;
         }
+        cleanup();
     }
 }
 
@@ -152,14 +554,13 @@ namespace minire::content::readers
     void InMemory::store(content::Id const & id,
                          content::Asset asset)
     {
-        _store[id] = std::move(asset);
+        _store[id] = std::make_shared<Asset const>(std::move(asset));
     }
 
-    Asset InMemory::load(Id const & id) const
+    AssetSptr InMemory::load(Id const & id) const
     {
         auto it = _store.find(id);
-        return it != _store.cend() ? it->second
-                                   : Asset(std::monostate());
+        return it != _store.cend() ? it->second : nullptr;
     }
 }
 
@@ -173,45 +574,291 @@ namespace minire::content::readers
         MINIRE_INFO("readers::Filesystem prefix: {}", _prefix);
     }
 
-    Asset Filesystem::load(Id const & id) const
+    std::filesystem::path Filesystem::path(Id const & id) const
+    {
+        std::filesystem::path result(_prefix);
+        result /= id; // TODO: this is pretty dangerous due possible ".."'s
+                      // TODO: it won't work on non-Posix OS (i.e. *indows)
+        return result;
+    }
+
+    bool Filesystem::contains(Id const & id) const
+    {
+        return std::filesystem::exists(path(id));
+    }
+
+    std::optional<uint64_t> Filesystem::hash(Id const & id) const
+    {
+        if (!contains(id)) return std::nullopt;
+        return utils::hashBytes(utils::MappedFile(path(id)).bytes());
+    }
+
+    models::Blob::Sptr Filesystem::raw(Id const & id) const
+    {
+        if (!contains(id)) return nullptr;
+        return formats::loadBlob(path(id));
+    }
+
+    AssetSptr Filesystem::load(Id const & id) const
+    {
+        std::filesystem::path const path = this->path(id);
+        if (!std::filesystem::exists(path))
+        {
+            MINIRE_DEBUG("file doesn't exist: {}", path.string());
+            return nullptr;
+        }
+
+        return std::make_shared<Asset const>(decode(path));
+    }
+
+    Asset Filesystem::decode(std::filesystem::path const & path) const
     {
-        std::filesystem::path path(_prefix);
-        path /= id; // TODO: this is pretty dangerous due possible ".."'s
-                    // TODO: it won't work on non-Posix OS (i.e. *indows)
-        MINIRE_INVARIANT(std::filesystem::exists(path),
-                         "file doesn't exist: {}", path.string());
-        
         std::string ext = path.extension();
         boost::algorithm::to_lower(ext);
 
         MINIRE_INFO("Loading asset: {}", path.string());
+        if (".obj"  == ext)
+        {
+            return formats::loadObj(path);
+        }
+        else if (".gltf"  == ext)
+        {
+            // TODO: might not work correctly w/ separated .bin files
+            //       Implement "::tinygltf::FsCallbacks" into the Manager
+            return formats::loadGltf(path);
+        }
+
+        // the rest is decoded right from a mapping
+        models::Blob::Sptr blob = formats::loadBlob(path);
         if (".png"  == ext ||
             ".jpg" == ext ||
             ".jpeg" == ext ||
             ".tga" == ext)
         {
-            models::Image::Sptr image = formats::loadImage(path);
+            models::Image::Sptr image = formats::loadImage(blob, path);
             MINIRE_INVARIANT(image, "image not loaded: {}", path.string());
             return image;
         }
-        else if (".obj"  == ext)
+        else if (".ktx2" == ext)
         {
-            return formats::loadObj(path);
+            // blocks are referred right from the mapping
+            return formats::loadKtx2(blob, path);
         }
-        else if (".gltf"  == ext)
+        else if (".dds" == ext)
         {
-            // TODO: might not work correctly w/ separated .bin files
-            //       Implement "::tinygltf::FsCallbacks" into the Manager
-            return formats::loadGltf(path);
+            return formats::loadDds(blob, path);
         }
         else if (".glb"  == ext)
         {
-            return formats::loadGlb(path);
+            return formats::loadGlb(blob, path);
         }
         else
         {
-            MINIRE_THROW("Unknown content type (\"{}\"): {}", ext, path.string());
+            MINIRE_DEBUG("Unknown content type (\"{}\"), it's a blob: {}", ext, path.string());
+            return blob;
+        }
+    }
+}
+
+namespace minire::content::readers
+{
+    namespace
+    {
+        // an uncompressed blob of a pack, it keeps the mapping alive
+        struct ArchiveBlob : public models::Blob
+        {
+            ArchiveBlob(std::shared_ptr<utils::MappedFile const> file,
+                        Bytes bytes)
+                : _file(std::move(file))
+                , _bytes(bytes)
+            {}
+
+            Bytes bytes() const override { return _bytes; }
+
+        private:
+            std::shared_ptr<utils::MappedFile const> _file;
+            Bytes                                    _bytes;
+        };
+
+        struct InflatedBlob : public models::Blob
+        {
+            explicit InflatedBlob(size_t size)
+                : _data(size)
+            {}
+
+            Bytes bytes() const override { return _data; }
+
+            std::vector<std::byte> _data;
+        };
+    }
+
+    Archive::Archive(std::string filename)
+        : _filename(std::move(filename))
+        , _file(std::make_shared<utils::MappedFile>(_filename))
+    {
+        using namespace formats::pack;
+
+        std::span<std::byte const> const bytes = _file->bytes();
+
+        Header header;
+        MINIRE_INVARIANT(bytes.size() >= sizeof(header),
+                         "not a pack: {}", _filename);
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        MINIRE_INVARIANT(kMagic == header._magic,
+                         "not a pack: {}", _filename);
+        MINIRE_INVARIANT(kVersion == header._version,
+                         "unsupported pack version {}: {}", header._version, _filename);
+
+        size_t const maxCount = (bytes.size() - sizeof(header)) / sizeof(Entry);
+        MINIRE_INVARIANT(header._count <= maxCount &&
+                         header._namesOffset <= bytes.size() &&
+                         header._namesSize <= bytes.size() - header._namesOffset,
+                         "corrupted pack: {}", _filename);
+
+        // the mapping is page aligned, so are entries after the header
+        _entries = Entries(reinterpret_cast<Entry const *>(bytes.data() + sizeof(header)),
+                           header._count);
+        _names = _file->view().substr(header._namesOffset, header._namesSize);
+
+        MINIRE_INFO("readers::Archive: {} ({} assets)", _filename, _entries.size());
+    }
+
+    Archive::~Archive() = default;
+
+    AssetSptr Archive::load(Id const & id) const
+    {
+        formats::pack::Entry const * entry = find(id);
+        if (!entry)
+        {
+            return nullptr;
+        }
+
+        MINIRE_INFO("Loading asset: {} (from {})", id, _filename);
+        return std::make_shared<Asset const>(decode(id, *entry));
+    }
+
+    Asset Archive::decode(Id const & id, formats::pack::Entry const & entry) const
+    {
+        using formats::pack::Type;
+
+        models::Blob::Sptr data = blob(entry);
+        switch(entry._type)
+        {
+            case Type::kImage:
+            {
+                // precompressed ones are told by their magic numbers
+                if (formats::isKtx2(data->bytes())) return formats::loadKtx2(data, id);
+                if (formats::isDds(data->bytes())) return formats::loadDds(data, id);
+
+                models::Image::Sptr image = formats::loadImage(data, id);
+                MINIRE_INVARIANT(image, "image not loaded: {}", id);
+                return image;
+            }
+            case Type::kObj:
+            {
+                models::Blob::Bytes const bytes = data->bytes();
+                return formats::parseObj(std::string_view(reinterpret_cast<char const *>(bytes.data()),
+                                                          bytes.size()), id);
+            }
+            case Type::kGltf:
+                // buffers and images are looked up in the pack as well
+                return formats::loadGltf(data, id, [this](std::string const & path)
+                {
+                    formats::pack::Entry const * file = find(path);
+                    return file ? blob(*file) : models::Blob::Sptr();
+                });
+            case Type::kGlb:
+                return formats::loadGlb(data, id);
+            case Type::kBlob:
+                return data;
+        }
+
+        MINIRE_THROW("unknown type {} of asset {} in pack {}",
+                     static_cast<int>(entry._type), id, _filename);
+    }
+
+    bool Archive::contains(Id const & id) const
+    {
+        return nullptr != find(id);
+    }
+
+    std::optional<uint64_t> Archive::hash(Id const & id) const
+    {
+        formats::pack::Entry const * entry = find(id);
+        if (!entry) return std::nullopt;
+        return utils::hashBytes(stored(*entry));
+    }
+
+    models::Blob::Sptr Archive::raw(Id const & id) const
+    {
+        formats::pack::Entry const * entry = find(id);
+        return entry ? blob(*entry) : nullptr;
+    }
+
+    formats::pack::Entry const * Archive::find(std::string_view id) const
+    {
+        using formats::pack::Entry;
+
+        uint64_t const hash = formats::pack::hash(id);
+        auto it = std::lower_bound(_entries.begin(), _entries.end(), hash,
+                                   [](Entry const & entry, uint64_t hash)
+                                   {
+                                       return entry._hash < hash;
+                                   });
+
+        // collisions are resolved by names
+        for(; it != _entries.end() && it->_hash == hash; ++it)
+        {
+            MINIRE_INVARIANT(it->_nameOffset <= _names.size() &&
+                             it->_nameSize <= _names.size() - it->_nameOffset,
+                             "corrupted pack: {}", _filename);
+            if (_names.substr(it->_nameOffset, it->_nameSize) == id)
+            {
+                return &*it;
+            }
         }
+        return nullptr;
+    }
+
+    models::Blob::Bytes Archive::stored(formats::pack::Entry const & entry) const
+    {
+        std::span<std::byte const> const bytes = _file->bytes();
+        MINIRE_INVARIANT(entry._offset <= bytes.size() &&
+                         entry._size <= bytes.size() - entry._offset,
+                         "corrupted pack: {}", _filename);
+        return bytes.subspan(entry._offset, entry._size);
+    }
+
+    models::Blob::Sptr Archive::blob(formats::pack::Entry const & entry) const
+    {
+        using formats::pack::Compression;
+
+        models::Blob::Bytes const stored = this->stored(entry);
+        switch(entry._compression)
+        {
+            case Compression::kNone:
+                return std::make_shared<ArchiveBlob>(_file, stored);
+            case Compression::kZlib:
+            {
+                MINIRE_INVARIANT(entry._size <= std::numeric_limits<int>::max() &&
+                                 entry._rawSize <= std::numeric_limits<int>::max(),
+                                 "compressed blob is too big in pack: {}", _filename);
+
+                auto result = std::make_shared<InflatedBlob>(entry._rawSize);
+                int const inflated = ::stbi_zlib_decode_buffer(
+                    reinterpret_cast<char *>(result->_data.data()),
+                    static_cast<int>(entry._rawSize),
+                    reinterpret_cast<char const *>(stored.data()),
+                    static_cast<int>(stored.size()));
+                MINIRE_INVARIANT(inflated >= 0 &&
+                                 static_cast<uint64_t>(inflated) == entry._rawSize,
+                                 "failed to inflate a blob in pack: {}", _filename);
+                return result;
+            }
+        }
+
+        MINIRE_THROW("unknown compression {} in pack {}",
+                     static_cast<int>(entry._compression), _filename);
     }
 }
 
@@ -223,15 +870,43 @@ namespace minire::content::readers
         return *this;
     }
 
-    Asset Chained::load(Id const & id) const
+    AssetSptr Chained::load(Id const & id) const
     {
         for(Reader::Uptr const & reader : _readers)
         {
             assert(reader);
-            Asset asset = reader->load(id);
-            if (hasData(asset))
+            AssetSptr asset = reader->load(id);
+            if (asset && hasData(*asset))
                 return asset;
         }
-        return std::monostate();
+        return nullptr;
+    }
+
+    bool Chained::contains(Id const & id) const
+    {
+        return std::any_of(_readers.cbegin(), _readers.cend(),
+                           [&id](Reader::Uptr const & reader) { return reader->contains(id); });
+    }
+
+    std::optional<uint64_t> Chained::hash(Id const & id) const
+    {
+        for(Reader::Uptr const & reader : _readers)
+        {
+            assert(reader);
+            if (reader->contains(id))
+                return reader->hash(id);
+        }
+        return std::nullopt;
+    }
+
+    models::Blob::Sptr Chained::raw(Id const & id) const
+    {
+        for(Reader::Uptr const & reader : _readers)
+        {
+            assert(reader);
+            if (reader->contains(id))
+                return reader->raw(id);
+        }
+        return nullptr;
     }
 }
@@ -0,0 +1,210 @@
+// A stress test of content::Manager: threads borrow, hold, release and
+// upload assets concurrently while a tight size limit keeps evicting them,
+// and the main thread borrows them asynchronously meanwhile.
+// And a check that images of a glTF model aren't counted twice.
+
+#include <minire/content/manager.hpp>
+#include <minire/errors.hpp>
+#include <minire/formats/gltf.hpp>
+
+#include <utils/gltf-interpreters.hpp>
+
+#include <fmt/format.h>
+
+#include <atomic>
+#include <cstdlib> // for EXIT_SUCCESS
+#include <exception>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    constexpr size_t kThreads    = 16;
+    constexpr size_t kIterations = 20000;
+    constexpr size_t kAssets     = 256;
+    constexpr size_t kHeld       = 8;   // leases held by a thread at most
+    constexpr size_t kSizeLimit  = 16 * 1024; // a quarter of all the assets
+
+    std::string contentOf(minire::content::Id const & id)
+    {
+        // long enough to be out of SSO, so the limit is hit often
+        return fmt::format("{:-<200}", id);
+    }
+
+    class CountingReader : public minire::content::Reader
+    {
+    public:
+        minire::content::AssetSptr load(minire::content::Id const & id) const override
+        {
+            ++_loads;
+            return std::make_shared<minire::content::Asset const>(contentOf(id));
+        }
+
+        bool contains(minire::content::Id const &) const override { return true; }
+
+        size_t loads() const { return _loads.load(); }
+
+    private:
+        mutable std::atomic<size_t> _loads = 0;
+    };
+
+    void check(minire::content::Lease const & lease)
+    {
+        MINIRE_INVARIANT(lease.as<std::string>() == contentOf(lease.id()),
+                         "wrong content of {}", lease.id());
+    }
+
+    void hammer(minire::content::Manager & manager, size_t seed)
+    {
+        std::mt19937 random(seed);
+        std::uniform_int_distribution<size_t> asset(0, kAssets - 1);
+        std::uniform_int_distribution<size_t> action(0, 99);
+
+        std::vector<minire::content::Lease> held;
+        for(size_t i = 0; i < kIterations; ++i)
+        {
+            std::string const id = fmt::format("asset-{}", asset(random));
+            size_t const what = action(random);
+
+            minire::content::Lease lease;
+            if (what < 2)
+            {
+                // fails while the asset is used by anyone, that's fine
+                try
+                {
+                    lease = manager.upload(id, contentOf(id));
+                }
+                catch(minire::FailedInvariant const &) {}
+            }
+            else
+            {
+                lease = manager.borrow(id);
+            }
+
+            if (lease)
+            {
+                check(lease);
+                held.push_back(std::move(lease));
+            }
+
+            if (what % 7 == 0 && !held.empty())
+            {
+                // a copy shares the usage of the original one
+                minire::content::Lease copy = held.front();
+                held.push_back(std::move(copy));
+            }
+
+            if (!held.empty() && (held.size() > kHeld || what % 3 == 0))
+            {
+                std::uniform_int_distribution<size_t> victim(0, held.size() - 1);
+                held.erase(held.begin() + victim(random));
+            }
+        }
+
+        for(auto const & lease : held)
+        {
+            check(lease);
+        }
+    }
+
+    // the Manager's thread: async borrows of the same assets as the others
+    void borrowAsync(minire::content::Manager & manager, size_t seed)
+    {
+        std::mt19937 random(seed);
+        std::uniform_int_distribution<size_t> asset(0, kAssets - 1);
+
+        size_t pending = 0;
+        std::vector<minire::content::Lease> held;
+        auto const ready = [&](minire::content::Lease lease, std::exception_ptr error)
+        {
+            --pending;
+            if (error) std::rethrow_exception(error);
+            check(lease);
+            held.push_back(std::move(lease));
+            if (held.size() > kHeld) held.erase(held.begin());
+        };
+
+        for(size_t i = 0; i < kIterations / 4; ++i)
+        {
+            ++pending;
+            manager.borrowAsync(fmt::format("asset-{}", asset(random)), ready);
+            manager.poll();
+        }
+
+        while (pending > 0)
+        {
+            if (0 == manager.poll()) std::this_thread::yield();
+        }
+    }
+
+    // images of a model are uploaded as assets which refer its pixels
+    void checkGltfImages()
+    {
+        constexpr int kSide = 64;
+
+        auto model = std::make_shared<::tinygltf::Model>();
+
+        ::tinygltf::Image & image = model->images.emplace_back();
+        image.width = kSide;
+        image.height = kSide;
+        image.component = 4;
+        image.bits = 8;
+        image.pixel_type = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+        image.image.resize(kSide * kSide * 4);
+
+        model->textures.emplace_back().source = 0;
+        model->materials.emplace_back().pbrMetallicRoughness.baseColorTexture.index = 0;
+
+        ::tinygltf::Primitive & primitive = model->meshes.emplace_back().primitives.emplace_back();
+        primitive.attributes = {{"POSITION", 0}, {"NORMAL", 0}};
+        primitive.material = 0;
+
+        minire::content::Manager manager(kSizeLimit * 16);
+        minire::content::Lease const source = manager.upload("model.gltf", minire::formats::GltfModelSptr(model));
+        size_t const modelSize = manager.stats()._size;
+        MINIRE_INVARIANT(modelSize >= image.image.size(), "pixels aren't counted w/ the model");
+
+        minire::utils::GltfMeshFeatures const features =
+            minire::utils::prefetchGltfFeatures(model, "model.gltf", 0, manager);
+        MINIRE_INVARIANT(features._textureLeases.size() == 1, "the image isn't uploaded");
+
+        size_t const imageSize = manager.stats()._size - modelSize;
+        fmt::print("glTF model: {}, its image: {}\n", modelSize, imageSize);
+        MINIRE_INVARIANT(imageSize < image.image.size(),
+                         "pixels are counted twice: {} of {}", imageSize, image.image.size());
+    }
+}
+
+int main()
+{
+    minire::content::Manager manager(kSizeLimit);
+    CountingReader & reader = manager.setReader<CountingReader>();
+
+    std::vector<std::jthread> threads;
+    for(size_t i = 0; i < kThreads; ++i)
+    {
+        threads.emplace_back(hammer, std::ref(manager), i);
+    }
+    borrowAsync(manager, kThreads);
+    threads.clear(); // joins
+
+    minire::content::Manager::Stats const stats = manager.stats();
+    fmt::print("hits: {}, misses: {}, evictions: {}, loads: {}, size: {}, unused: {}\n",
+               stats._hits, stats._misses, stats._evictions, reader.loads(),
+               stats._size, stats._unused);
+
+    // all the leases are released, so everything is garbage
+    MINIRE_INVARIANT(stats._size == stats._unused,
+                     "leaked usage: {} != {}", stats._size, stats._unused);
+    MINIRE_INVARIANT(stats._size <= kSizeLimit,
+                     "not evicted: {} > {}", stats._size, kSizeLimit);
+    MINIRE_INVARIANT(stats._evictions > 0, "nothing was evicted");
+
+    checkGltfImages();
+
+    // the Manager aborts if any Lease outlives it
+    return EXIT_SUCCESS;
+}
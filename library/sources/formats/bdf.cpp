@@ -3,327 +3,472 @@
 #include <minire/errors.hpp>
 #include <minire/logging.hpp>
 
-#include <cctype>
-#include <fstream>
+#include <utils/mapped-file.hpp>
+#include <utils/parallel.hpp>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <iterator>
 
 namespace minire::formats
 {
-    // Bdf::Char //
-
-    void Bdf::Char::reset()
-    {
-        _name.clear();
-        _encoding = 0;
-        _swx0 =
-        _swy0 =
-        _dwx0 =
-        _dwy0 =
-        _swx1 =
-        _swy1 =
-        _dwx1 =
-        _dwy1 =
-        _bbx._w =
-        _bbx._h =
-        _bbx._xOff =
-        _bbx._yOff = 
-        _bits = 0;
-        _loaded = false;
-        _bitLines.clear();
-    }
-
-    // Bdf //
-
-    std::string::const_iterator Bdf::parseNonSpace(
-        std::string::const_iterator const & begin,
-        std::string::const_iterator const & end,
-        std::string & token)
+    namespace
     {
-        std::string::const_iterator it = begin;
-
-        // skip prologue spaces
-        while (it != end && ::isspace(*it)) ++it;
+        // bytes of text per a worker at least (see utils::workersFor)
+        constexpr size_t kMinBytesPerWorker = 32 * 1024;
 
-        // skip non-space of token
-        while (it != end && !::isspace(*it)) ++it;
-        token.assign(begin, it);
+        constexpr uint8_t kNotHex = 0xFF;
 
-        return it;
-    }
-
-    void Bdf::parse(std::string::const_iterator const & begin,
-                    std::string::const_iterator const & end)
-    {
-        std::string keyword;
-
-        std::string::const_iterator it =
-            parseNonSpace(begin, end, keyword);
-
-        if ("STARTFONT" == keyword)
+        constexpr std::array<uint8_t, 256> kHexDigits = []
         {
-            if (_fontStarted) MINIRE_THROW("font already started: {}", location());
-            it = parseNonSpace(it, end, _version);
-            _fontStarted = true;
-        }
-        else if ("ENDFONT" == keyword)
+            std::array<uint8_t, 256> digits{};
+            digits.fill(kNotHex);
+            for(int c = '0'; c <= '9'; ++c) digits[c] = c - '0';
+            for(int c = 'a'; c <= 'f'; ++c) digits[c] = c - 'a' + 10;
+            for(int c = 'A'; c <= 'F'; ++c) digits[c] = c - 'A' + 10;
+            return digits;
+        }();
+
+        constexpr bool isSpace(char c)
         {
-            if (!_fontStarted) MINIRE_THROW("font already ended: {}", location());
-            _fontStarted = false;
+            return ' ' == c || '\t' == c || '\r' == c || '\v' == c || '\f' == c;
         }
-        else if ("FONT" == keyword)
+
+        // of chars sorted by encodings
+        template<typename Chars>
+        auto lowerBound(Chars & chars, size_t encoding)
         {
-            if (!_fontStarted) MINIRE_THROW("font already ended: {}", location());
-            it = parseNonSpace(it, end, _fontName);
+            return std::lower_bound(chars.begin(), chars.end(), encoding,
+                                    [](auto const & glyph, size_t e) { return glyph.encoding() < e; });
         }
-        else if ("SIZE" == keyword)
-        {
-            if (!_fontStarted) MINIRE_THROW("font already ended: {}", location());
-
-            std::string pointSize, xRes, yRes;
+    }
 
-            it = parseNonSpace(it, end, pointSize);
-            it = parseNonSpace(it, end, xRes);
-            it = parseNonSpace(it, end, yRes);
+    // Bdf::Parser //
 
-            _pointSize = std::stoull(pointSize);
-            _xRes = std::stoull(xRes);
-            _yRes = std::stoull(yRes);
-        }
-        else if ("FONTBOUNDINGBOX" == keyword)
+    // Walks lines of a text that isn't copied, so it must outlive the parser
+    class Bdf::Parser
+    {
+    public:
+        // starts at the first line which begins at offset or after it
+        Parser(std::string_view text,
+               std::string const & filename,
+               size_t offset)
+            : _text(text)
+            , _filename(filename)
+            , _offset(std::min(offset, text.size()))
         {
-            if (!_fontStarted) MINIRE_THROW("font already ended: {}", location());
-
-            std::string w, h, xOff, yOff;
-
-            it = parseNonSpace(it, end, w);
-            it = parseNonSpace(it, end, h);
-            it = parseNonSpace(it, end, xOff);
-            it = parseNonSpace(it, end, yOff);
-
-            _bbx._w = std::stoi(w);
-            _bbx._h = std::stoi(h);
-            _bbx._xOff = std::stoi(xOff);
-            _bbx._yOff = std::stoi(yOff);
+            if (_offset > 0 && '\n' != _text[_offset - 1])
+            {
+                size_t const eol = _text.find('\n', _offset);
+                _offset = std::string_view::npos == eol ? _text.size() : eol + 1;
+            }
+            fetch();
         }
-        else if ("CHARS" == keyword)
-        {
-            if (!_fontStarted) MINIRE_THROW("font already ended: {}", location());
 
-            std::string chars;
-            it = parseNonSpace(it, end, chars);
-        }
-        else if ("STARTCHAR" == keyword)
-        {
-            if (!_fontStarted) MINIRE_THROW("font already ended: {}", location());
-            if (_haveCurrent) MINIRE_THROW("char already started: {}", location());
+    public:
+        bool done() const { return _offset >= _text.size(); }
 
-            _current.reset();
-            it = parseNonSpace(it, end, _current._name);
+        size_t offset() const { return _offset; }
 
-            // setup BBX inherited from font (may be overwritten l8r)
-            _current._bbx = _bbx;
+        std::string_view keyword() const { return _keyword; }
 
-            _haveCurrent = true;
-        }
-        else if ("ENCODING" == keyword)
+        void next()
         {
-            if (!_fontStarted) MINIRE_THROW("font already ended: {}", location());
-            if (!_haveCurrent) MINIRE_THROW("char already ended: {}", location());
-
-            std::string encoding;
-            it = parseNonSpace(it, end, encoding);
-            _current._encoding = std::stoull(encoding);
-
-            it = end; // i.e. skipping alternative
+            _offset = _next;
+            fetch();
         }
-        else if ("SWIDTH" == keyword)
+
+        // pops the next token of the current line
+        std::string_view token()
         {
-            if (!_fontStarted) MINIRE_THROW("font already ended: {}", location());
-            if (!_haveCurrent) MINIRE_THROW("char already ended: {}", location());
+            size_t begin = 0;
+            while (begin < _rest.size() && isSpace(_rest[begin])) ++begin;
 
-            std::string swx0, swy0;
-            it = parseNonSpace(it, end, swx0);
-            it = parseNonSpace(it, end, swy0);
+            size_t end = begin;
+            while (end < _rest.size() && !isSpace(_rest[end])) ++end;
 
-            _current._swx0 = std::stoi(swx0);
-            _current._swy0 = std::stoi(swy0);
+            std::string_view const result = _rest.substr(begin, end - begin);
+            _rest.remove_prefix(end);
+            return result;
         }
-        else if ("DWIDTH" == keyword)
+
+        // pops the rest of the current line w/o surrounding spaces
+        std::string_view rest()
         {
-            if (!_fontStarted) MINIRE_THROW("font already ended: {}", location());
-            if (!_haveCurrent) MINIRE_THROW("char already ended: {}", location());
+            std::string_view result = _rest;
+            while (!result.empty() && isSpace(result.front())) result.remove_prefix(1);
+            while (!result.empty() && isSpace(result.back())) result.remove_suffix(1);
+            _rest = std::string_view();
+            return result;
+        }
 
-            std::string dwx0, dwy0;
-            it = parseNonSpace(it, end, dwx0);
-            it = parseNonSpace(it, end, dwy0);
+        template<typename T>
+        T number()
+        {
+            std::string_view const text = token();
+            char const * const end = text.data() + text.size();
 
-            _current._dwx0 = std::stoi(dwx0);
-            _current._dwy0 = std::stoi(dwy0);
+            T value{};
+            auto const [ptr, ec] = std::from_chars(text.data(), end, value);
+            if (std::errc() != ec || ptr != end)
+            {
+                MINIRE_THROW("number expected but got \"{}\": {}", text, location());
+            }
+            return value;
         }
-        else if ("SWIDTH1" == keyword)
-        {
-            if (!_fontStarted) MINIRE_THROW("font already ended: {}", location());
-            if (!_haveCurrent) MINIRE_THROW("char already ended: {}", location());
 
-            std::string swx1, swy1;
-            it = parseNonSpace(it, end, swx1);
-            it = parseNonSpace(it, end, swy1);
+        std::string location() const
+        {
+            // counted on errors only, so chunks can be parsed independently
+            size_t const line = 1 + std::count(_text.cbegin(),
+                                               _text.cbegin() + _offset,
+                                               '\n');
+            return _filename + ":" + std::to_string(line);
+        }
 
-            _current._swx1 = std::stoi(swx1);
-            _current._swy1 = std::stoi(swy1);
+    public:
+        // parses chars which STARTCHARs are in [offset; last), the last
+        // of them may end beyond it; stops on ENDFONT
+        Chars chars(size_t last, BBox const & bbox, bool & ended)
+        {
+            Chars result;
+            for(; !done() && _offset < last; next())
+            {
+                if ("STARTCHAR" == _keyword)
+                {
+                    result.push_back(parseChar(bbox));
+                }
+                else if ("ENDFONT" == _keyword)
+                {
+                    ended = true;
+                    break;
+                }
+                else if (!_keyword.empty() && "COMMENT" != _keyword)
+                {
+                    MINIRE_WARNING("unexpected keyword: \"{}\": {}", _keyword, location());
+                }
+            }
+            return result;
         }
-        else if ("DWIDTH1" == keyword)
+
+        // skips a tail of a char that began before the parser's start
+        void skipToChar()
         {
-            if (!_fontStarted) MINIRE_THROW("font already ended: {}", location());
-            if (!_haveCurrent) MINIRE_THROW("char already ended: {}", location());
+            while (!done() && "STARTCHAR" != _keyword && "ENDFONT" != _keyword)
+            {
+                next();
+            }
+        }
 
-            std::string dwx1, dwy1;
-            it = parseNonSpace(it, end, dwx1);
-            it = parseNonSpace(it, end, dwy1);
+    private:
+        void fetch()
+        {
+            if (done())
+            {
+                _next = _text.size();
+                _rest = _keyword = std::string_view();
+                return;
+            }
 
-            _current._dwx1 = std::stoi(dwx1);
-            _current._dwy1 = std::stoi(dwy1);
+            size_t const eol = _text.find('\n', _offset);
+            size_t const end = std::string_view::npos == eol ? _text.size() : eol;
+            _next = std::string_view::npos == eol ? end : end + 1;
+            _rest = _text.substr(_offset, end - _offset);
+            _keyword = token();
         }
-        else if ("BBX" == keyword)
-        {
-            if (!_fontStarted) MINIRE_THROW("font already ended: {}", location());
-            if (!_haveCurrent) MINIRE_THROW("char already ended: {}", location());
 
-            std::string w, h, xOff, yOff;
+        Char parseChar(BBox const & bbox)
+        {
+            Char glyph;
+            glyph._name = token();
+            glyph._bbx = bbox; // may be overwritten by BBX
 
-            it = parseNonSpace(it, end, w);
-            it = parseNonSpace(it, end, h);
-            it = parseNonSpace(it, end, xOff);
-            it = parseNonSpace(it, end, yOff);
+            bool encoded = false;
+            bool haveBitmap = false;
+            for(next(); !done(); next())
+            {
+                if ("ENCODING" == _keyword)
+                {
+                    // -1 stands for glyphs w/o a standard encoding,
+                    // an alternative encoding is ignored
+                    long long const encoding = number<long long>();
+                    encoded = encoding >= 0;
+                    glyph._encoding = encoded ? encoding : 0;
+                }
+                else if ("SWIDTH" == _keyword)
+                {
+                    glyph._swx0 = number<int>();
+                    glyph._swy0 = number<int>();
+                }
+                else if ("DWIDTH" == _keyword)
+                {
+                    glyph._dwx0 = number<int>();
+                    glyph._dwy0 = number<int>();
+                }
+                else if ("SWIDTH1" == _keyword)
+                {
+                    glyph._swx1 = number<int>();
+                    glyph._swy1 = number<int>();
+                }
+                else if ("DWIDTH1" == _keyword)
+                {
+                    glyph._dwx1 = number<int>();
+                    glyph._dwy1 = number<int>();
+                }
+                else if ("BBX" == _keyword)
+                {
+                    if (haveBitmap) MINIRE_THROW("BBX after BITMAP: {}", location());
+                    glyph._bbx._w = number<size_t>();
+                    glyph._bbx._h = number<size_t>();
+                    glyph._bbx._xOff = number<int>();
+                    glyph._bbx._yOff = number<int>();
+                }
+                else if ("BITMAP" == _keyword)
+                {
+                    if (haveBitmap) MINIRE_THROW("bitmap already started: {}", location());
+                    parseBitmap(glyph);
+                    haveBitmap = true;
+                }
+                else if ("ENDCHAR" == _keyword)
+                {
+                    if (!haveBitmap) MINIRE_THROW("char w/o a bitmap: {}", location());
+                    glyph._loaded = encoded;
+                    return glyph;
+                }
+                else if ("STARTCHAR" == _keyword || "ENDFONT" == _keyword)
+                {
+                    MINIRE_THROW("char already started: {}", location());
+                }
+                else if (!_keyword.empty() && "COMMENT" != _keyword)
+                {
+                    MINIRE_WARNING("unexpected keyword: \"{}\": {}", _keyword, location());
+                }
+            }
 
-            _current._bbx._w = std::stoi(w);
-            _current._bbx._h = std::stoi(h);
-            _current._bbx._xOff = std::stoi(xOff);
-            _current._bbx._yOff = std::stoi(yOff);
+            MINIRE_THROW("ENDCHAR expected: {}", location());
         }
-        else if ("BITMAP" == keyword)
+
+        void parseBitmap(Char & glyph)
         {
-            if (!_fontStarted) MINIRE_THROW("font already ended: {}", location());
-            if (!_haveCurrent) MINIRE_THROW("char already ended: {}", location());
-            if (_haveBitmap) MINIRE_THROW("bitmap already started: {}", location());
+            glyph._stride = (glyph._bbx._w + 7) / 8;
+            glyph._bitmap.assign(glyph._stride * glyph._bbx._h, 0);
 
-            _haveBitmap = true;
+            size_t const digits = glyph._stride * 2;
+            for(size_t y = 0; y < glyph._bbx._h; ++y)
+            {
+                next();
+                if (done()) MINIRE_THROW("bitmap is truncated: {}", location());
+
+                // rows are padded to bytes, but some fonts pad them more
+                std::string_view const line = _keyword;
+                uint8_t * row = glyph._bitmap.data() + y * glyph._stride;
+                for(size_t i = 0; i < line.size(); ++i)
+                {
+                    uint8_t const digit = kHexDigits[static_cast<uint8_t>(line[i])];
+                    if (kNotHex == digit)
+                    {
+                        MINIRE_THROW("bitmap line expected but got \"{}\": {}",
+                                     line, location());
+                    }
+                    if (i < digits) row[i / 2] |= (i % 2) ? digit : (digit << 4);
+                }
+            }
         }
-        else if ("ENDCHAR" == keyword)
-        {
-            if (!_fontStarted) MINIRE_THROW("font already ended: {}", location());
-            if (!_haveCurrent) MINIRE_THROW("char already ended: {}", location());
 
-            assert(_current._bitLines.size() == _current._bbx._h);
+    private:
+        std::string_view    _text;
+        std::string const & _filename;
+        size_t              _offset;  // of the current line
+        size_t              _next;    // of the next line
+        std::string_view    _keyword;
+        std::string_view    _rest;    // of the current line after parsed tokens
+    };
 
-            _current._loaded = true;
-            _chars.resize(_current._encoding + 1);
-            _chars[_current._encoding] = std::move(_current);
-            ++_loadedChars;
+    // Bdf //
 
-            _haveCurrent = false;
-            _haveBitmap = false;
-        }
-        else if ("COMMENT" == keyword)
-        {
-            // just ignore
-            it = end;
-        }
-        else if ("STARTPROPERTIES" == keyword)
-        {
-            if (!_fontStarted) MINIRE_THROW("font already ended: {}", location());
-            if (_propertiesStarted) MINIRE_THROW("properties already started: {}", location());
+    void Bdf::load(std::string_view text)
+    {
+        bool started = false;
+        bool properties = false;
 
-            _propertiesStarted = true;
-            it = end;
-        }
-        else if ("ENDPROPERTIES" == keyword)
+        for(Parser parser(text, _filename, 0); !parser.done(); parser.next())
         {
-            if (!_fontStarted) MINIRE_THROW("font already ended: {}", location());
-            if (!_propertiesStarted) MINIRE_THROW("properties already ended: {}", location());
+            std::string_view const keyword = parser.keyword();
 
-            _propertiesStarted = false;
-        }
-        else if (_fontStarted && !_haveCurrent && !_haveBitmap && _propertiesStarted)
-        {
-            // skip spaces after keyword
-            while (it != end && ::isspace(*it)) ++it;
+            if (properties)
+            {
+                if ("ENDPROPERTIES" == keyword)
+                {
+                    properties = false;
+                }
+                else if (!keyword.empty())
+                {
+                    _properties[std::string(keyword)] = parser.rest();
+                }
+                continue;
+            }
 
-            std::string value(it, end);
-            _properties[keyword] = std::move(value);
+            if (keyword.empty() || "COMMENT" == keyword) continue;
 
-            it = end;
-        }
-        else if (_fontStarted && _haveCurrent && _haveBitmap && !_propertiesStarted)
-        {
-            size_t idx;
-            size_t bitLine = std::stoull(keyword, &idx, 16);
-            if (idx != keyword.size())
+            if ("STARTFONT" == keyword)
             {
-                MINIRE_THROW("bitmap line expected but got \"{}\": {}",
-                             keyword, location());
+                if (started) MINIRE_THROW("font already started: {}", parser.location());
+                _version = parser.token();
+                started = true;
+                continue;
             }
 
-            _current._bits = keyword.size() * 4;
-            _current._bitLines.push_back(bitLine);
-        }
-        else if (!keyword.empty())
-        {
-            MINIRE_WARNING("unexpected keyword: \"{}\": {}", keyword, location());
-            it = end;
-        }
+            if (!started) MINIRE_THROW("font already ended: {}", parser.location());
 
-        // skip residual spaces
-        while (it != end && ::isspace(*it)) ++it;
+            if ("ENDFONT" == keyword)
+            {
+                return; // a font w/o chars
+            }
+            else if ("FONT" == keyword)
+            {
+                _fontName = parser.rest();
+            }
+            else if ("SIZE" == keyword)
+            {
+                _pointSize = parser.number<size_t>();
+                _xRes = parser.number<size_t>();
+                _yRes = parser.number<size_t>();
+            }
+            else if ("FONTBOUNDINGBOX" == keyword)
+            {
+                _bbx._w = parser.number<size_t>();
+                _bbx._h = parser.number<size_t>();
+                _bbx._xOff = parser.number<int>();
+                _bbx._yOff = parser.number<int>();
+            }
+            else if ("STARTPROPERTIES" == keyword)
+            {
+                properties = true;
+            }
+            else if ("CHARS" == keyword)
+            {
+                // it's just a hint, encodings define the size of _chars
+                parser.number<size_t>();
+            }
+            else if ("STARTCHAR" == keyword)
+            {
+                loadChars(text, parser.offset());
+                return;
+            }
+            else
+            {
+                MINIRE_WARNING("unexpected keyword: \"{}\": {}", keyword, parser.location());
+            }
+        }
 
-        assert(it == end);
+        MINIRE_WARNING("ENDFONT is missing: {}", _filename);
     }
 
-    std::string Bdf::location(void) const
+    void Bdf::loadChars(std::string_view text, size_t begin)
     {
-        return _filename + ":" + std::to_string(_lineNumber);
-    }
+        // chars are independent, so the text is split into even chunks,
+        // each worker takes chars which STARTCHAR lines are in its chunk
+        size_t const size = text.size() - begin;
+        size_t const workers = utils::workersFor(size, kMinBytesPerWorker);
 
-    void Bdf::load(std::istream & is)
-    {
-        std::string line;
-        while (std::getline(is, line))
+        std::vector<Chars> chunks(workers);
+        std::vector<uint8_t> ended(workers, false); // not a vector<bool> to be written concurrently
+
+        utils::parallel(workers, [&](size_t i)
         {
-            parse(line.cbegin(), line.cend());
-            ++_lineNumber;
+            Parser parser(text, _filename, begin + size * i / workers);
+            parser.skipToChar();
+
+            bool endFont = false;
+            chunks[i] = parser.chars(begin + size * (i + 1) / workers, _bbx, endFont);
+            ended[i] = endFont;
+        });
+
+        // a sparse table: a font of a few thousands of glyphs can have
+        // encodings up to 0x10FFFF
+        size_t loaded = 0;
+        for(Chars const & chunk : chunks)
+        {
+            loaded += std::count_if(chunk.cbegin(), chunk.cend(),
+                                    [](Char const & glyph) { return glyph._loaded; });
         }
+        _chars.reserve(loaded);
+
+        for(Chars & chunk : chunks)
+        for(Char & glyph : chunk)
+        {
+            if (glyph._loaded) _chars.push_back(std::move(glyph));
+        }
+
+        // chunks are in the file's order, so is a run of equal encodings,
+        // and the last definition of a char wins
+        std::stable_sort(_chars.begin(), _chars.end(),
+                         [](Char const & a, Char const & b) { return a._encoding < b._encoding; });
+        auto const last = std::unique(_chars.rbegin(), _chars.rend(),
+                                      [this](Char const & a, Char const & b)
+                                      {
+                                          if (a._encoding != b._encoding) return false;
+                                          MINIRE_WARNING("char {} is redefined: {}", a._encoding, _filename);
+                                          return true;
+                                      });
+        _chars.erase(_chars.begin(), last.base());
+
+        if (std::none_of(ended.cbegin(), ended.cend(), [](uint8_t e) { return e; }))
+        {
+            MINIRE_WARNING("ENDFONT is missing: {}", _filename);
+        }
+
+        MINIRE_DEBUG("bdf {}: {} chars decoded by {} worker(s)",
+                     _filename, _chars.size(), workers);
     }
 
     Bdf::Bdf(std::string const & filename)
         : _filename(filename)
     {
-        std::ifstream is(_filename);
-        if (!is) MINIRE_THROW("cannot open: \"{}\"", _filename);
-        load(is);
+        utils::MappedFile const file(_filename);
+        load(file.view());
     }
 
     Bdf::Bdf(std::istream & is,
              std::string const & filename)
         : _filename(filename)
     {
-        load(is);
+        std::string const text(std::istreambuf_iterator<char>(is), {});
+        load(text);
     }
 
-    void Bdf::fillChar(size_t encoding, size_t value)
+    size_t Bdf::bytes() const
     {
-        if (encoding < _chars.size())
+        size_t result = _chars.capacity() * sizeof(Char);
+        for(Char const & glyph : _chars)
         {
-            Char & glyph = _chars[encoding];
-            if (!glyph._loaded)
-            {
-                MINIRE_THROW("cannot fillChar {}, not loaded",
-                             encoding);
-            }
+            result += glyph._bitmap.capacity() + glyph._name.capacity();
+        }
+        return result;
+    }
 
-            //size_t v = value ? std::numeric_limits<size_t>::max() : 0;
-            for(size_t & i : glyph._bitLines)
-            {
-                i = value;
-            }
+    Bdf::Char const & Bdf::find(size_t encoding) const
+    {
+        static Char const kNotFound;
+        auto const it = lowerBound(_chars, encoding);
+        return it != _chars.cend() && it->encoding() == encoding ? *it : kNotFound;
+    }
+
+    void Bdf::fillChar(size_t encoding, size_t value)
+    {
+        if (_chars.empty() || encoding > _chars.back()._encoding) return;
+
+        auto const glyph = lowerBound(_chars, encoding);
+        if (glyph->_encoding != encoding)
+        {
+            MINIRE_THROW("cannot fillChar {}, not loaded",
+                         encoding);
         }
+
+        // zero clears a glyph, anything else lights all its pixels
+        std::fill(glyph->_bitmap.begin(), glyph->_bitmap.end(),
+                  value ? 0xFF : 0x00);
     }
 }
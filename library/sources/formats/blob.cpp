@@ -0,0 +1,26 @@
+#include <minire/formats/blob.hpp>
+
+#include <utils/mapped-file.hpp>
+
+namespace minire::formats
+{
+    namespace
+    {
+        struct MappedBlob : public models::Blob
+        {
+            explicit MappedBlob(std::string const & filename)
+                : _file(filename)
+            {}
+
+            Bytes bytes() const override { return _file.bytes(); }
+
+        private:
+            utils::MappedFile _file;
+        };
+    }
+
+    models::Blob::Sptr loadBlob(std::string const & filename)
+    {
+        return std::make_shared<MappedBlob>(filename);
+    }
+}
@@ -0,0 +1,304 @@
+#include <minire/formats/compressed-image.hpp>
+
+#include <minire/errors.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace minire::formats
+{
+    namespace
+    {
+        using Format = models::CompressedImage::Format;
+
+        // KTX2 //
+
+        constexpr std::array<uint8_t, 12> kKtx2Magic =
+        {
+            0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n',
+        };
+
+        struct Ktx2Header
+        {
+            uint8_t  _identifier[12];
+            uint32_t _vkFormat;
+            uint32_t _typeSize;
+            uint32_t _pixelWidth;
+            uint32_t _pixelHeight;
+            uint32_t _pixelDepth;
+            uint32_t _layerCount;
+            uint32_t _faceCount;
+            uint32_t _levelCount;
+            uint32_t _supercompressionScheme;
+            uint32_t _dfdByteOffset;
+            uint32_t _dfdByteLength;
+            uint32_t _kvdByteOffset;
+            uint32_t _kvdByteLength;
+            uint64_t _sgdByteOffset;
+            uint64_t _sgdByteLength;
+        };
+
+        static_assert(sizeof(Ktx2Header) == 80);
+
+        struct Ktx2Level
+        {
+            uint64_t _byteOffset;
+            uint64_t _byteLength;
+            uint64_t _uncompressedByteLength;
+        };
+
+        static_assert(sizeof(Ktx2Level) == 24);
+
+        // VkFormat values
+        Format fromVkFormat(uint32_t vkFormat)
+        {
+            switch(vkFormat)
+            {
+                case 131: case 132: return Format::kBc1;       // BC1_RGB_{UNORM,SRGB}
+                case 133: case 134: return Format::kBc1Alpha;  // BC1_RGBA_{UNORM,SRGB}
+                case 137: case 138: return Format::kBc3;       // BC3_{UNORM,SRGB}
+                case 139:           return Format::kBc4;       // BC4_UNORM
+                case 141:           return Format::kBc5;       // BC5_UNORM
+                case 145: case 146: return Format::kBc7;       // BC7_{UNORM,SRGB}
+                case 147: case 148: return Format::kEtc2;      // ETC2_R8G8B8_{UNORM,SRGB}
+                case 151: case 152: return Format::kEtc2Alpha; // ETC2_R8G8B8A8_{UNORM,SRGB}
+            }
+            MINIRE_THROW("unsupported VkFormat: {}", vkFormat);
+        }
+
+        // DDS //
+
+        constexpr uint32_t fourCC(char const (&code)[5])
+        {
+            return static_cast<uint32_t>(code[0])
+                 | static_cast<uint32_t>(code[1]) << 8
+                 | static_cast<uint32_t>(code[2]) << 16
+                 | static_cast<uint32_t>(code[3]) << 24;
+        }
+
+        constexpr uint32_t kDdsMagic = fourCC("DDS ");
+
+        constexpr uint32_t kDdsFourCC = 0x4;           // DDPF_FOURCC
+        constexpr uint32_t kDdsMipMapCount = 0x20000;  // DDSD_MIPMAPCOUNT
+        constexpr uint32_t kDdsDepth = 0x800000;       // DDSD_DEPTH
+        constexpr uint32_t kDdsCubemap = 0x200;        // DDSCAPS2_CUBEMAP
+        constexpr uint32_t kDdsTexture2d = 3;          // D3D10_RESOURCE_DIMENSION_TEXTURE2D
+
+        struct DdsPixelFormat
+        {
+            uint32_t _size;
+            uint32_t _flags;
+            uint32_t _fourCC;
+            uint32_t _rgbBitCount;
+            uint32_t _rBitMask;
+            uint32_t _gBitMask;
+            uint32_t _bBitMask;
+            uint32_t _aBitMask;
+        };
+
+        struct DdsHeader
+        {
+            uint32_t       _size;
+            uint32_t       _flags;
+            uint32_t       _height;
+            uint32_t       _width;
+            uint32_t       _pitchOrLinearSize;
+            uint32_t       _depth;
+            uint32_t       _mipMapCount;
+            uint32_t       _reserved1[11];
+            DdsPixelFormat _pixelFormat;
+            uint32_t       _caps;
+            uint32_t       _caps2;
+            uint32_t       _caps3;
+            uint32_t       _caps4;
+            uint32_t       _reserved2;
+        };
+
+        static_assert(sizeof(DdsHeader) == 124);
+
+        struct DdsHeaderDx10
+        {
+            uint32_t _dxgiFormat;
+            uint32_t _resourceDimension;
+            uint32_t _miscFlag;
+            uint32_t _arraySize;
+            uint32_t _miscFlags2;
+        };
+
+        static_assert(sizeof(DdsHeaderDx10) == 20);
+
+        Format fromFourCC(uint32_t code)
+        {
+            switch(code)
+            {
+                case fourCC("DXT1"): return Format::kBc1;
+                case fourCC("DXT5"): return Format::kBc3;
+                case fourCC("ATI1"):
+                case fourCC("BC4U"): return Format::kBc4;
+                case fourCC("ATI2"):
+                case fourCC("BC5U"): return Format::kBc5;
+            }
+            MINIRE_THROW("unsupported FourCC: {:#x}", code);
+        }
+
+        // DXGI_FORMAT values
+        Format fromDxgiFormat(uint32_t dxgiFormat)
+        {
+            switch(dxgiFormat)
+            {
+                case 71: case 72: return Format::kBc1Alpha; // BC1_UNORM{,_SRGB}
+                case 77: case 78: return Format::kBc3;      // BC3_UNORM{,_SRGB}
+                case 80:          return Format::kBc4;      // BC4_UNORM
+                case 83:          return Format::kBc5;      // BC5_UNORM
+                case 98: case 99: return Format::kBc7;      // BC7_UNORM{,_SRGB}
+            }
+            MINIRE_THROW("unsupported DXGI format: {}", dxgiFormat);
+        }
+
+        // Common //
+
+        template<typename T>
+        T read(models::Blob::Bytes bytes, size_t offset)
+        {
+            MINIRE_INVARIANT(offset <= bytes.size() && sizeof(T) <= bytes.size() - offset,
+                             "unexpected end of file");
+            T result;
+            std::memcpy(&result, bytes.data() + offset, sizeof(T));
+            return result;
+        }
+
+        void validate(models::CompressedImage const & image, size_t levels)
+        {
+            MINIRE_INVARIANT(image._width > 0 && image._height > 0,
+                             "bad image size = {}x{}", image._width, image._height);
+
+            size_t const maxLevels = std::bit_width(std::max(image._width, image._height));
+            MINIRE_INVARIANT(levels > 0 && levels <= maxLevels,
+                             "bad count of mip levels: {}", levels);
+        }
+
+        // the level of the image which bytes are at the offset
+        models::CompressedImage::Level level(models::CompressedImage const & image,
+                                             size_t index,
+                                             size_t offset,
+                                             size_t length)
+        {
+            size_t const width = std::max<size_t>(image._width >> index, 1);
+            size_t const height = std::max<size_t>(image._height >> index, 1);
+            size_t const expected = models::CompressedImage::bytesInLevel(image._format, width, height);
+            MINIRE_INVARIANT(length >= expected,
+                             "level {} is too short: {} bytes instead of {}",
+                             index, length, expected);
+
+            models::Blob::Bytes const bytes = image._blob->bytes();
+            MINIRE_INVARIANT(offset <= bytes.size() && expected <= bytes.size() - offset,
+                             "level {} is out of the file", index);
+            return {width, height, bytes.subspan(offset, expected)};
+        }
+    }
+
+    bool isKtx2(models::Blob::Bytes bytes)
+    {
+        return bytes.size() >= kKtx2Magic.size() &&
+               0 == std::memcmp(bytes.data(), kKtx2Magic.data(), kKtx2Magic.size());
+    }
+
+    bool isDds(models::Blob::Bytes bytes)
+    {
+        return bytes.size() >= sizeof(kDdsMagic) &&
+               0 == std::memcmp(bytes.data(), &kDdsMagic, sizeof(kDdsMagic));
+    }
+
+    models::CompressedImage::Sptr loadKtx2(models::Blob::Sptr const & blob,
+                                           std::string const & filename) try
+    {
+        MINIRE_INVARIANT(blob, "no blob");
+        models::Blob::Bytes const bytes = blob->bytes();
+        MINIRE_INVARIANT(isKtx2(bytes), "not a KTX2 file");
+
+        auto const header = read<Ktx2Header>(bytes, 0);
+        MINIRE_INVARIANT(0 == header._supercompressionScheme,
+                         "supercompression isn't supported: {}", header._supercompressionScheme);
+        MINIRE_INVARIANT(0 == header._pixelDepth && header._layerCount <= 1 && 1 == header._faceCount,
+                         "only 2D textures are supported");
+
+        auto image = std::make_shared<models::CompressedImage>();
+        image->_width = header._pixelWidth;
+        image->_height = header._pixelHeight;
+        image->_format = fromVkFormat(header._vkFormat);
+        image->_blob = blob;
+
+        // zero levels stand for mips to be generated, which isn't an option here
+        size_t const levels = std::max<uint32_t>(header._levelCount, 1);
+        validate(*image, levels);
+
+        for(size_t i = 0; i < levels; ++i)
+        {
+            auto const entry = read<Ktx2Level>(bytes, sizeof(Ktx2Header) + i * sizeof(Ktx2Level));
+            MINIRE_INVARIANT(entry._byteOffset <= std::numeric_limits<size_t>::max() &&
+                             entry._byteLength <= std::numeric_limits<size_t>::max(),
+                             "level {} is out of the file", i);
+            image->_levels.push_back(level(*image, i, entry._byteOffset, entry._byteLength));
+        }
+
+        return image;
+    }
+    catch(std::exception const & e)
+    {
+        MINIRE_THROW("failed to load KTX2 \"{}\": {}", filename, e.what());
+    }
+
+    models::CompressedImage::Sptr loadDds(models::Blob::Sptr const & blob,
+                                          std::string const & filename) try
+    {
+        MINIRE_INVARIANT(blob, "no blob");
+        models::Blob::Bytes const bytes = blob->bytes();
+        MINIRE_INVARIANT(isDds(bytes), "not a DDS file");
+
+        size_t offset = sizeof(kDdsMagic);
+        auto const header = read<DdsHeader>(bytes, offset);
+        offset += sizeof(DdsHeader);
+        MINIRE_INVARIANT(sizeof(DdsHeader) == header._size, "bad header size: {}", header._size);
+        MINIRE_INVARIANT(header._pixelFormat._flags & kDdsFourCC, "uncompressed DDS isn't supported");
+        MINIRE_INVARIANT(!(header._flags & kDdsDepth) && !(header._caps2 & kDdsCubemap),
+                         "only 2D textures are supported");
+
+        auto image = std::make_shared<models::CompressedImage>();
+        image->_width = header._width;
+        image->_height = header._height;
+        image->_blob = blob;
+
+        if (fourCC("DX10") == header._pixelFormat._fourCC)
+        {
+            auto const dx10 = read<DdsHeaderDx10>(bytes, offset);
+            offset += sizeof(DdsHeaderDx10);
+            MINIRE_INVARIANT(kDdsTexture2d == dx10._resourceDimension && dx10._arraySize <= 1,
+                             "only 2D textures are supported");
+            image->_format = fromDxgiFormat(dx10._dxgiFormat);
+        }
+        else
+        {
+            image->_format = fromFourCC(header._pixelFormat._fourCC);
+        }
+
+        size_t const levels = (header._flags & kDdsMipMapCount) ? std::max<uint32_t>(header._mipMapCount, 1) : 1;
+        validate(*image, levels);
+
+        // levels follow the header one by one
+        for(size_t i = 0; i < levels; ++i)
+        {
+            image->_levels.push_back(level(*image, i, offset, bytes.size() - std::min(offset, bytes.size())));
+            offset += image->_levels.back()._bytes.size();
+        }
+
+        return image;
+    }
+    catch(std::exception const & e)
+    {
+        MINIRE_THROW("failed to load DDS \"{}\": {}", filename, e.what());
+    }
+}
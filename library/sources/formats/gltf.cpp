@@ -3,12 +3,20 @@
 #define TINYGLTF_IMPLEMENTATION
 
 #include <minire/errors.hpp>
+#include <minire/formats/blob.hpp>
 #include <minire/logging.hpp>
 #include <nlohmann/json.hpp>
 #include <stb/stb_image.h>
 
 #include <tinygltf/tiny_gltf.h>
 
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
 namespace minire::formats
 {
     GltfModelSptr loadGltf(std::string const & filename)
@@ -35,8 +43,72 @@ namespace minire::formats
         return result;
     }
 
-    GltfModelSptr loadGlb(std::string const & filename)
+    namespace
+    {
+        // paths are joined to the base dir by tinygltf, so they are
+        // looked up as they are
+        ::tinygltf::FsCallbacks fsCallbacks(GltfFiles const & files)
+        {
+            ::tinygltf::FsCallbacks callbacks;
+            callbacks.FileExists = [&files](std::string const & path, void *)
+            {
+                return static_cast<bool>(files(path));
+            };
+            callbacks.ExpandFilePath = [](std::string const & path, void *)
+            {
+                return path;
+            };
+            callbacks.ReadWholeFile = [&files](std::vector<unsigned char> * out,
+                                               std::string * err,
+                                               std::string const & path,
+                                               void *)
+            {
+                models::Blob::Sptr const file = files(path);
+                if (!file)
+                {
+                    if (err) *err += "file not found: " + path + "\n";
+                    return false;
+                }
+                auto const data = reinterpret_cast<unsigned char const *>(file->bytes().data());
+                out->assign(data, data + file->bytes().size());
+                return true;
+            };
+            callbacks.WriteWholeFile = [](std::string * err,
+                                          std::string const & path,
+                                          std::vector<unsigned char> const &,
+                                          void *)
+            {
+                if (err) *err += "read-only file: " + path + "\n";
+                return false;
+            };
+            callbacks.GetFileSizeInBytes = [&files](size_t * size,
+                                                    std::string * err,
+                                                    std::string const & path,
+                                                    void *)
+            {
+                models::Blob::Sptr const file = files(path);
+                if (!file)
+                {
+                    if (err) *err += "file not found: " + path + "\n";
+                    return false;
+                }
+                *size = file->bytes().size();
+                return true;
+            };
+            callbacks.user_data = nullptr;
+            return callbacks;
+        }
+    }
+
+    GltfModelSptr loadGltf(models::Blob::Sptr const & blob,
+                           std::string const & filename,
+                           GltfFiles const & files)
     {
+        MINIRE_INVARIANT(blob, "no blob of gLTF file \"{}\"", filename);
+        std::span<std::byte const> const bytes = blob->bytes();
+        MINIRE_INVARIANT(bytes.size() <= std::numeric_limits<unsigned int>::max(),
+                         "gLTF file is too big \"{}\": {}", filename, bytes.size());
+
         auto result = std::make_shared<::tinygltf::Model>();
 
         ::tinygltf::TinyGLTF loader;
@@ -44,7 +116,223 @@ namespace minire::formats
         std::string err;
         std::string warn;
 
-        bool const loaded = loader.LoadBinaryFromFile(result.get(), &err, &warn, filename);
+        MINIRE_INVARIANT(loader.SetFsCallbacks(fsCallbacks(files), &err),
+                         "failed to setup gLTF loader: {}", err);
+
+        bool const loaded = loader.LoadASCIIFromString(
+            result.get(), &err, &warn,
+            reinterpret_cast<char const *>(bytes.data()),
+            static_cast<unsigned int>(bytes.size()),
+            std::filesystem::path(filename).parent_path().string());
+
+        if (!warn.empty())
+        {
+            MINIRE_WARNING("gLTF loading warning (\"{}\"): {}", filename, warn);
+        }
+
+        if (!loaded)
+        {
+            MINIRE_THROW("failed to load gLTF file \"{}\": {}", filename, err);
+        }
+
+        return result;
+    }
+
+    namespace
+    {
+        constexpr uint32_t kGlbMagic = 0x46546C67; // "glTF"
+        constexpr uint32_t kGlbJson  = 0x4E4F534A; // "JSON"
+        constexpr uint32_t kGlbBin   = 0x004E4942; // "BIN\0"
+        constexpr uint32_t kGlbVersion = 2;
+
+        constexpr size_t kGlbHeaderSize = 12;
+        constexpr size_t kChunkHeaderSize = 8;
+
+        // the BIN buffer of a GLB is replaced by a byte while it's loaded
+        constexpr char const * kGlbBinStub = "data:application/octet-stream;base64,AA==";
+        constexpr char const * kGlbImagePrefix = "#glb-image-";
+
+        // GLBs are little-endian as well as all the supported platforms
+        uint32_t readUint32(std::span<std::byte const> bytes, size_t offset)
+        {
+            uint32_t result;
+            std::memcpy(&result, bytes.data() + offset, sizeof(result));
+            return result;
+        }
+
+        struct GlbChunks
+        {
+            std::span<std::byte const> _json;
+            std::span<std::byte const> _bin; // empty if there is none
+        };
+
+        GlbChunks readGlbChunks(std::span<std::byte const> bytes,
+                                std::string const & filename)
+        {
+            MINIRE_INVARIANT(bytes.size() >= kGlbHeaderSize + kChunkHeaderSize &&
+                             readUint32(bytes, 0) == kGlbMagic &&
+                             readUint32(bytes, kGlbHeaderSize + 4) == kGlbJson,
+                             "not a gLB file \"{}\"", filename);
+            MINIRE_INVARIANT(readUint32(bytes, 4) == kGlbVersion,
+                             "unsupported version of gLB file \"{}\": {}",
+                             filename, readUint32(bytes, 4));
+
+            size_t const json = kGlbHeaderSize + kChunkHeaderSize;
+            size_t const jsonLength = readUint32(bytes, kGlbHeaderSize);
+            MINIRE_INVARIANT(bytes.size() - json >= jsonLength,
+                             "bad JSON chunk of gLB file \"{}\"", filename);
+
+            GlbChunks result{bytes.subspan(json, jsonLength), {}};
+
+            size_t const bin = json + jsonLength;
+            if (bytes.size() >= bin + kChunkHeaderSize &&
+                readUint32(bytes, bin + 4) == kGlbBin)
+            {
+                size_t const binLength = readUint32(bytes, bin);
+                MINIRE_INVARIANT(bytes.size() - bin - kChunkHeaderSize >= binLength,
+                                 "bad BIN chunk of gLB file \"{}\"", filename);
+                result._bin = bytes.subspan(bin + kChunkHeaderSize, binLength);
+            }
+
+            return result;
+        }
+
+        // a file of an image embedded into the BIN chunk (see loadGlb)
+        struct GlbImage : models::Blob
+        {
+            Bytes _bytes;
+
+            explicit GlbImage(Bytes bytes) : _bytes(bytes) {}
+
+            Bytes bytes() const override { return _bytes; }
+        };
+
+        // an embedded image, it's pointed by a made up path while loading
+        struct GlbImageView
+        {
+            size_t      _image;
+            int         _bufferView;
+            std::string _mimeType;
+        };
+
+        // keeps the blob of a GLB alive as long as its model
+        struct GlbDeleter
+        {
+            static constexpr size_t kNoBuffer = std::numeric_limits<size_t>::max();
+
+            models::Blob::Sptr         _blob;
+            std::span<std::byte const> _bin;
+            size_t                     _binBuffer = kNoBuffer;
+
+            void operator()(::tinygltf::Model * model) const { delete model; }
+        };
+    }
+
+    GltfModelSptr loadGlb(std::string const & filename)
+    {
+        return loadGlb(loadBlob(filename), filename);
+    }
+
+    GltfModelSptr loadGlb(models::Blob::Sptr const & blob,
+                          std::string const & filename)
+    {
+        MINIRE_INVARIANT(blob, "no blob of gLB file \"{}\"", filename);
+        std::span<std::byte const> const bytes = blob->bytes();
+        GlbChunks const chunks = readGlbChunks(bytes, filename);
+
+        // NOTE: tinygltf copies the whole BIN chunk into the buffer w/o an
+        //       uri, so the JSON chunk is loaded as a .gltf instead: the
+        //       buffer is stubbed by a byte, and embedded images are read
+        //       by made up paths right from the chunk (an image at a time)
+        GlbDeleter deleter{blob, {}, GlbDeleter::kNoBuffer};
+        std::map<std::string, std::span<std::byte const>> embedded;
+        std::vector<GlbImageView> views;
+        std::string text;
+        try
+        {
+            auto const json = reinterpret_cast<char const *>(chunks._json.data());
+            auto document = nlohmann::json::parse(json, json + chunks._json.size());
+
+            // only the first buffer could refer the BIN chunk
+            auto const buffers = document.find("buffers");
+            if (buffers != document.end() && !buffers->empty() && !buffers->front().contains("uri"))
+            {
+                nlohmann::json & buffer = buffers->front();
+                size_t const byteLength = buffer.at("byteLength").get<size_t>();
+                MINIRE_INVARIANT(byteLength <= chunks._bin.size(),
+                                 "bad BIN chunk of gLB file \"{}\"", filename);
+
+                deleter._bin = chunks._bin.first(byteLength);
+                deleter._binBuffer = 0;
+                buffer["uri"] = kGlbBinStub;
+                buffer["byteLength"] = 1;
+            }
+
+            auto const images = document.find("images");
+            if (0 == deleter._binBuffer && images != document.end())
+            {
+                nlohmann::json const & bufferViews = document.at("bufferViews");
+                for(size_t i = 0; i < images->size(); ++i)
+                {
+                    nlohmann::json & image = (*images)[i];
+                    if (!image.contains("bufferView")) continue;
+
+                    int const view = image.at("bufferView").get<int>();
+                    nlohmann::json const & bufferView = bufferViews.at(view);
+                    if (0 != bufferView.value("buffer", -1)) continue;
+
+                    size_t const offset = bufferView.value("byteOffset", size_t(0));
+                    size_t const length = bufferView.at("byteLength").get<size_t>();
+                    MINIRE_INVARIANT(offset <= deleter._bin.size() &&
+                                     length <= deleter._bin.size() - offset,
+                                     "image {} is out of BIN chunk of gLB file \"{}\"", i, filename);
+
+                    std::string path = kGlbImagePrefix + std::to_string(i);
+                    views.push_back(GlbImageView{i, view, image.value("mimeType", std::string())});
+                    embedded.emplace(path, deleter._bin.subspan(offset, length));
+                    image.erase("bufferView");
+                    image.erase("mimeType");
+                    image["uri"] = std::move(path);
+                }
+            }
+
+            text = document.dump();
+        }
+        catch(nlohmann::json::exception const & e)
+        {
+            MINIRE_THROW("bad JSON chunk of gLB file \"{}\": {}", filename, e.what());
+        }
+        MINIRE_INVARIANT(text.size() <= std::numeric_limits<unsigned int>::max(),
+                         "gLB file is too big \"{}\": {}", filename, bytes.size());
+
+        // external files are relative to the GLB's one
+        std::filesystem::path const directory = std::filesystem::path(filename).parent_path();
+        GltfFiles const files = [&embedded, &directory](std::string const & path) -> models::Blob::Sptr
+        {
+            if (auto it = embedded.find(path); it != embedded.cend())
+            {
+                return std::make_shared<GlbImage>(it->second);
+            }
+
+            std::filesystem::path const file = directory / path;
+            return std::filesystem::is_regular_file(file) ? loadBlob(file.string()) : nullptr;
+        };
+
+        auto model = std::make_unique<::tinygltf::Model>();
+
+        ::tinygltf::TinyGLTF loader;
+
+        std::string err;
+        std::string warn;
+
+        MINIRE_INVARIANT(loader.SetFsCallbacks(fsCallbacks(files), &err),
+                         "failed to setup gLB loader: {}", err);
+
+        bool const loaded = loader.LoadASCIIFromString(
+            model.get(), &err, &warn,
+            text.data(),
+            static_cast<unsigned int>(text.size()),
+            std::string()); // see files
 
         if (!warn.empty())
         {
@@ -56,6 +344,37 @@ namespace minire::formats
             MINIRE_THROW("failed to load gLB file \"{}\": {}", filename, err);
         }
 
-        return result;
+        // the stubs are dropped, and the model is as tinygltf loads GLBs
+        // but the BIN buffer, which is referred in the blob by the model
+        for(GlbImageView & view : views)
+        {
+            ::tinygltf::Image & image = model->images.at(view._image);
+            image.uri.clear();
+            image.bufferView = view._bufferView;
+            image.mimeType = std::move(view._mimeType);
+        }
+
+        if (0 == deleter._binBuffer)
+        {
+            ::tinygltf::Buffer & buffer = model->buffers.front();
+            buffer.uri.clear();
+            std::vector<unsigned char>().swap(buffer.data);
+        }
+
+        return GltfModelSptr(model.release(), std::move(deleter));
+    }
+
+    std::span<std::byte const> gltfBuffer(GltfModelSptr const & model, size_t buffer)
+    {
+        MINIRE_INVARIANT(model, "gltf pointer is empty");
+        MINIRE_INVARIANT(buffer < model->buffers.size(),
+                         "bad buffer index: {} >= {}", buffer, model->buffers.size());
+
+        if (auto const * glb = std::get_deleter<GlbDeleter>(model);
+            glb && glb->_binBuffer == buffer)
+        {
+            return glb->_bin;
+        }
+        return std::as_bytes(std::span(model->buffers[buffer].data));
     }
 }
\ No newline at end of file
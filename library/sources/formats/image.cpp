@@ -3,6 +3,8 @@
 #include <minire/errors.hpp>
 #include <stb/stb_image.h>
 
+#include <limits>
+
 namespace minire::formats
 {
     namespace
@@ -16,7 +18,53 @@ namespace minire::formats
                 int channels = 0; // 8-bit components per pixel
 
                 _data = ::stbi_load(filename.c_str(), &width, &height, &channels, 0);
+                setup(width, height, channels);
+            }
+            catch(std::exception & e)
+            {
+                free();
+                MINIRE_THROW("failed to load image \"{}\": {}", filename, e.what());
+            }
+            catch(...)
+            {
+                free();
+                MINIRE_THROW("failed to load image \"{}\": (unknown expection)", filename);
+            }
+
+            explicit
+            StbImage(models::Blob::Bytes bytes,
+                     std::string const & filename) try
+            {
+                int width = 0, height = 0;
+                int channels = 0; // 8-bit components per pixel
 
+                MINIRE_INVARIANT(bytes.size() <= std::numeric_limits<int>::max(),
+                                 "image is too big: {}", bytes.size());
+                _data = ::stbi_load_from_memory(
+                    reinterpret_cast<stbi_uc const *>(bytes.data()),
+                    static_cast<int>(bytes.size()),
+                    &width, &height, &channels, 0);
+                setup(width, height, channels);
+            }
+            catch(std::exception & e)
+            {
+                free();
+                MINIRE_THROW("failed to load image \"{}\": {}", filename, e.what());
+            }
+            catch(...)
+            {
+                free();
+                MINIRE_THROW("failed to load image \"{}\": (unknown expection)", filename);
+            }
+
+            ~StbImage() override
+            {
+                free();
+            }
+
+        private:
+            void setup(int width, int height, int channels)
+            {
                 MINIRE_INVARIANT(_data, "no data loaded: {}", ::stbi_failure_reason());
                 MINIRE_INVARIANT(width > 0 && height > 0,
                                  "bad image size = {}x{}", width, height);
@@ -48,23 +96,7 @@ namespace minire::formats
                 _depth = Depth::k8;
                 _signed = false;
             }
-            catch(std::exception & e)
-            {
-                free();
-                MINIRE_THROW("failed to load image \"{}\": {}", filename, e.what());
-            }
-            catch(...)
-            {
-                free();
-                MINIRE_THROW("failed to load image \"{}\": (unknown expection)", filename);
-            }
 
-            ~StbImage() override
-            {
-                free();
-            }
-
-        private:
             void free()
             {
                 if (_data)
@@ -80,4 +112,11 @@ namespace minire::formats
     {
         return std::make_shared<StbImage>(filename);
     }
+
+    models::Image::Sptr loadImage(models::Blob::Sptr const & blob,
+                                  std::string const & filename)
+    {
+        MINIRE_INVARIANT(blob, "no blob of image \"{}\"", filename);
+        return std::make_shared<StbImage>(blob->bytes(), filename);
+    }
 }
@@ -0,0 +1,324 @@
+#pragma once
+
+#include <minire/errors.hpp>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace minire::formats
+{
+    // A point of a face as it's written: indices are 1-based absolute
+    // ones or negative ones relative to the items defined so far, zero
+    // if the face doesn't refer the item
+    struct ObjCorner
+    {
+        int64_t _vertex = 0;
+        int64_t _uv = 0;
+        int64_t _normal = 0;
+    };
+
+    constexpr bool isObjSpace(char c)
+    {
+        return ' ' == c || '\t' == c || '\r' == c || '\v' == c || '\f' == c;
+    }
+
+    // Walks lines of a text, which isn't copied, so it must outlive
+    // the parser, and passes their items to a sink:
+    //
+    //   void vertex(glm::vec3 const &);
+    //   void uv(glm::vec2 const &);
+    //   void normal(glm::vec3 const &);
+    //   void face(std::span<ObjCorner const>); // 3+ points of the same format
+    //
+    // Lines of unknown items are skipped, only counted.
+    template<typename Sink>
+    class ObjParser
+    {
+    public:
+        ObjParser(std::string_view text, std::string const & filename, Sink & sink)
+            : _text(text)
+            , _filename(filename)
+            , _sink(sink)
+        {}
+
+    public:
+        // parses lines which begin in [begin; end)
+        void parse(size_t begin, size_t end)
+        {
+            _offset = lineAt(begin);
+            end = lineAt(end);
+            while (_offset < end)
+            {
+                size_t eol = _text.find('\n', _offset);
+                if (std::string_view::npos == eol) eol = _text.size();
+
+                _line = _text.substr(_offset, eol - _offset);
+                parseLine();
+                _offset = eol + 1;
+            }
+        }
+
+        void parse() { parse(0, _text.size()); }
+
+        size_t skipped() const { return _skipped; }
+
+        // the first skipped item
+        std::string_view unknown() const { return _unknown; }
+
+    private:
+        // the first line which begins at the offset or after it
+        size_t lineAt(size_t offset) const
+        {
+            if (offset == 0 || offset >= _text.size()) return std::min(offset, _text.size());
+            if ('\n' == _text[offset - 1]) return offset;
+
+            size_t const eol = _text.find('\n', offset);
+            return std::string_view::npos == eol ? _text.size() : eol + 1;
+        }
+
+        void parseLine()
+        {
+            std::string_view const keyword = token();
+            if (keyword.empty() || '#' == keyword.front()) return;
+
+            if ("v" == keyword)
+            {
+                float const x = number<float>();
+                float const y = number<float>();
+                float const z = number<float>();
+                if (more()) number<float>(); // an optional weight
+                _sink.vertex(glm::vec3(x, y, z));
+            }
+            else if ("vt" == keyword)
+            {
+                float const u = number<float>();
+                float const v = more() ? number<float>() : 0.0f;
+                if (more()) number<float>(); // an optional depth
+                _sink.uv(glm::vec2(u, v));
+            }
+            else if ("vn" == keyword)
+            {
+                float const x = number<float>();
+                float const y = number<float>();
+                float const z = number<float>();
+                _sink.normal(glm::vec3(x, y, z));
+            }
+            else if ("f" == keyword)
+            {
+                parseFace();
+            }
+            else
+            {
+                if (0 == _skipped++) _unknown = keyword;
+                return;
+            }
+
+            if (more())
+            {
+                MINIRE_THROW("residual data left in line: \"{}\": {}", _line, location());
+            }
+        }
+
+        // points are "v" or "v/t" or "v/t/n" or "v//n"
+        void parseFace()
+        {
+            _corners.clear();
+            while (more())
+            {
+                ObjCorner & corner = _corners.emplace_back();
+                corner._vertex = index();
+                if (!skip('/')) continue;
+
+                if (!skip('/'))
+                {
+                    corner._uv = index();
+                    if (!skip('/')) continue;
+                }
+                corner._normal = index();
+            }
+
+            MINIRE_INVARIANT(_corners.size() >= 3, "a face of {} points: {}", _corners.size(), location());
+
+            ObjCorner const & first = _corners.front();
+            auto const sameFormat = [&first](ObjCorner const & corner)
+            {
+                return (0 == corner._uv) == (0 == first._uv) &&
+                       (0 == corner._normal) == (0 == first._normal);
+            };
+            MINIRE_INVARIANT(std::all_of(_corners.cbegin(), _corners.cend(), sameFormat),
+                             "points of a face differ in format: {}", location());
+
+            _sink.face(std::span<ObjCorner const>(_corners));
+        }
+
+        int64_t index()
+        {
+            int64_t const value = number<int64_t>(true);
+            MINIRE_INVARIANT(value != 0, "zero index: {}", location());
+            return value;
+        }
+
+        // pops a token of the current line
+        std::string_view token()
+        {
+            skipSpaces();
+            size_t end = 0;
+            while (end < _line.size() && !isObjSpace(_line[end])) ++end;
+
+            std::string_view const result = _line.substr(0, end);
+            _line.remove_prefix(end);
+            return result;
+        }
+
+        // a number of the current line, it's an index if it's ended by a slash
+        template<typename T>
+        T number(bool index = false)
+        {
+            skipSpaces();
+            if (!_line.empty() && '+' == _line.front()) _line.remove_prefix(1);
+
+            char const * const end = _line.data() + _line.size();
+            T value{};
+            auto const [ptr, ec] = std::from_chars(_line.data(), end, value);
+            if (std::errc() != ec || (ptr != end && !isObjSpace(*ptr) && !(index && '/' == *ptr)))
+            {
+                MINIRE_THROW("number expected but got \"{}\": {}", _line, location());
+            }
+            _line.remove_prefix(ptr - _line.data());
+            return value;
+        }
+
+        bool skip(char c)
+        {
+            bool const result = !_line.empty() && c == _line.front();
+            if (result) _line.remove_prefix(1);
+            return result;
+        }
+
+        void skipSpaces()
+        {
+            while (!_line.empty() && isObjSpace(_line.front())) _line.remove_prefix(1);
+        }
+
+        // whether anything but spaces is left in the current line
+        bool more()
+        {
+            skipSpaces();
+            return !_line.empty();
+        }
+
+        std::string location() const
+        {
+            // counted on errors only, so chunks can be parsed independently
+            size_t const line = 1 + std::count(_text.cbegin(), _text.cbegin() + _offset, '\n');
+            return _filename + ":" + std::to_string(line);
+        }
+
+    private:
+        std::string_view       _text;
+        std::string const    & _filename;
+        Sink                 & _sink;
+        size_t                 _offset = 0;
+        std::string_view       _line;     // the rest of the current one
+        std::vector<ObjCorner> _corners;  // of the current face
+        size_t                 _skipped = 0;
+        std::string_view       _unknown;
+    };
+
+    // Numbers of items (of a text or of chunks before a chunk)
+    struct ObjCounts
+    {
+        size_t _vertices = 0;
+        size_t _normals = 0;
+        size_t _uvs = 0;
+        size_t _faceVertices = 0; // corners of triangles
+        size_t _faceNormals = 0;
+        size_t _faceUvs = 0;
+    };
+
+    // Items of lines of a chunk of a text, a sink of ObjParser. Polygons
+    // are triangulated as fans around their first points. Negative indices
+    // refer items before the chunk too, so they're kept relative to the
+    // chunk's first items till all the chunks are parsed (see parseObjChunks)
+    struct ObjChunk
+    {
+        using Indices = std::vector<int64_t>;
+
+        std::vector<glm::vec3> _vertices;
+        std::vector<glm::vec3> _normals;
+        std::vector<glm::vec2> _uvs;
+
+        // 0-based ones of the whole text once it's parsed
+        Indices _faceVertices;
+        Indices _faceNormals;
+        Indices _faceUvs;
+
+        // positions of relative indices in the face arrays
+        std::vector<size_t> _relativeVertices;
+        std::vector<size_t> _relativeNormals;
+        std::vector<size_t> _relativeUvs;
+
+        ObjCounts        _before;      // items of the chunks before it
+        size_t           _skipped = 0; // lines of unknown items
+        std::string_view _unknown;     // the first of them
+
+    public:
+        void vertex(glm::vec3 const & vertex) { _vertices.push_back(vertex); }
+
+        void uv(glm::vec2 const & uv) { _uvs.push_back(uv); }
+
+        void normal(glm::vec3 const & normal) { _normals.push_back(normal); }
+
+        void face(std::span<ObjCorner const> corners)
+        {
+            for(size_t i = 2; i < corners.size(); ++i)
+            {
+                corner(corners[0]);
+                corner(corners[i - 1]);
+                corner(corners[i]);
+            }
+        }
+
+    private:
+        void corner(ObjCorner const & corner)
+        {
+            index(_faceVertices, _relativeVertices, corner._vertex, _vertices.size());
+            if (corner._uv) index(_faceUvs, _relativeUvs, corner._uv, _uvs.size());
+            if (corner._normal) index(_faceNormals, _relativeNormals, corner._normal, _normals.size());
+        }
+
+        static void index(Indices & indices, std::vector<size_t> & relative,
+                          int64_t value, size_t defined)
+        {
+            if (value > 0)
+            {
+                indices.push_back(value - 1);
+            }
+            else
+            {
+                relative.push_back(indices.size());
+                indices.push_back(static_cast<int64_t>(defined) + value);
+            }
+        }
+    };
+
+    struct ObjChunks
+    {
+        std::vector<ObjChunk> _chunks; // in the text's order
+        ObjCounts             _total;
+    };
+
+    // Parses a text by even chunks in parallel, indices are resolved once
+    // all the chunks are parsed, so faces may refer items defined anywhere
+    // in the text (i.e. below them); checks indices and formats of faces
+    ObjChunks parseObjChunks(std::string_view text, std::string const & filename);
+}
@@ -20,16 +20,23 @@
 #include <minire/errors.hpp>
 #include <minire/logging.hpp>
 
+#include <formats/obj-parser.hpp>
+#include <utils/mapped-file.hpp>
+#include <utils/parallel.hpp>
+
 #include <cctype>
 #include <cstdlib>
 #include <cmath>
 #include <climits>
 #include <algorithm>
 #include <iomanip>
+#include <iterator>
 #include <fstream>
 #include <map>
 #include <cassert>
 #include <array>
+#include <span>
+#include <string_view>
 
 // https://people.sc.fsu.edu/~jburkardt/data/obj/obj.html
 
@@ -54,168 +61,123 @@ namespace minire::formats
 
     namespace
     {
-        template<size_t kMaxBufferSize = 512>
-        class ObjLineParser
+        // bytes of text per a worker at least (see utils::workersFor)
+        constexpr size_t kMinBytesPerWorker = 1024 * 1024;
+
+        // makes indices of a chunk absolute ones, relative ones are
+        // rebased by items of the chunks before it
+        void resolve(ObjChunk::Indices & indices,
+                     std::vector<size_t> const & relative,
+                     size_t before,
+                     size_t defined,
+                     std::string const & filename)
         {
-        public:
-            explicit ObjLineParser(Obj & output) : _output(output) {}
-
-            void readLine(std::istream & is)
-            {
-                static const std::string kV = "v";
-                static const std::string kVt = "vt";
-                static const std::string kVn = "vn";
-                static const std::string kF = "f";
-                static const std::string kSharp = "#";
-
-                _p = 0;
-                _buffer[0] = '\0';
-                is.getline(_buffer.data(), _buffer.size());
-
-                skipWhitespace();
-                if (isEnd()) return;
-
-                if (skipToken(kV))
-                {
-                    _output._vertices.emplace_back(parseVec3());
-                }
-                else if (skipToken(kVt))
-                {
-                    _output._uvs.emplace_back(parseVec2());
-                }
-                else if (skipToken(kVn))
-                {
-                    _output._normals.emplace_back(parseVec3());
-                }
-                else if (skipToken(kF))
-                {
-                    parseFacePoint();
-                    parseFacePoint();
-                    parseFacePoint();
-                }
-                else if (skipToken(kSharp))
-                {
-                    _p = _buffer.size() - 1;
-                }
-                else
-                {
-                    MINIRE_WARNING("unknown item skipped: {}", ptr());
-                    _p = _buffer.size() - 1;
-                }
-
-                skipWhitespace();
-                if (!isEnd())
-                {
-                    MINIRE_THROW("resudial data left in line: /{}/: {}", _buffer.data(), ptr());
-                }
-            }
-
-        private:
-            // "v" or "v/t" or "v/t/n" or "v//n"
-            void parseFacePoint()
+            for(size_t const i : relative)
             {
-                _output._faceVertices.emplace_back(parseUint() - 1);
-                if (!skipChar('/')) return;
-
-                if (skipChar('/'))
-                {
-                    _output._faceNormals.emplace_back(parseUint() - 1);
-                }
-                else
-                {
-                    _output._faceUvs.emplace_back(parseUint() - 1);
-                    if (skipChar('/'))
-                    {
-                        _output._faceNormals.emplace_back(parseUint() - 1);
-                    }
-                }
+                indices[i] += static_cast<int64_t>(before);
             }
 
-        private:
-            bool skipToken(std::string const & token)
+            for(int64_t const value : indices)
             {
-                skipWhitespace();
-
-                size_t bufResidue = _buffer.size() - _p;
-                if (bufResidue >= token.size() &&
-                    0 == strncmp(ptr(), token.c_str(), token.size()) &&
-                    isWhitespace(token.size()))
-                {
-                    _p += token.size();
-                    return true;
-                }
-                return false;
+                MINIRE_INVARIANT(value >= 0 && static_cast<uint64_t>(value) < defined,
+                                 "index out of range: {} of {}, {}", value + 1, defined, filename);
             }
+        }
+    }
 
-            bool skipChar(char c)
+    ObjChunks parseObjChunks(std::string_view text, std::string const & filename)
+    {
+        // lines are independent but negative indices, so the text is
+        // split into even chunks, each worker takes lines which begin
+        // in its chunk
+        size_t const workers = utils::workersFor(text.size(), kMinBytesPerWorker);
+
+        ObjChunks result;
+        result._chunks.resize(workers);
+        utils::parallel(workers, [&](size_t i)
+        {
+            ObjChunk & chunk = result._chunks[i];
+            ObjParser<ObjChunk> parser(text, filename, chunk);
+            parser.parse(text.size() * i / workers, text.size() * (i + 1) / workers);
+            chunk._skipped = parser.skipped();
+            chunk._unknown = parser.unknown();
+        });
+
+        ObjCounts & total = result._total;
+        for(ObjChunk & chunk : result._chunks)
+        {
+            chunk._before = total;
+            total._vertices += chunk._vertices.size();
+            total._normals += chunk._normals.size();
+            total._uvs += chunk._uvs.size();
+            total._faceVertices += chunk._faceVertices.size();
+            total._faceNormals += chunk._faceNormals.size();
+            total._faceUvs += chunk._faceUvs.size();
+
+            if (chunk._skipped > 0)
             {
-                skipWhitespace();
-                bool const skip = !isEnd() && chr() == c;
-                _p += (skip ? 1 : 0);
-                return skip;
+                MINIRE_WARNING("{} lines of unknown items skipped, e.g. \"{}\": {}",
+                               chunk._skipped, chunk._unknown, filename);
             }
+        }
 
-            void skipWhitespace() { while(!isEnd() && ::isspace(chr())) ++_p; }
-
-            bool isWhitespace(size_t offset) const
-            {
-                size_t np = _p + offset;
-                return np < _buffer.size() &&
-                       ('\0' == _buffer[np] || ::isspace(_buffer[np]));
-            }
+        MINIRE_INVARIANT((total._faceUvs == 0 || total._faceUvs == total._faceVertices) &&
+                         (total._faceNormals == 0 || total._faceNormals == total._faceVertices),
+                         "faces differ in format: {}", filename);
 
-            float parseFloat()
-            {
-                skipWhitespace();
-
-                char * endptr;
-                char const * begin = ptr();
-                float result = std::strtof(begin, &endptr);
-                if (HUGE_VAL == result) MINIRE_THROW("bad float token");
-                _p += (endptr - begin);
-                return result;
-            }
+        utils::parallel(workers, [&](size_t i)
+        {
+            ObjChunk & chunk = result._chunks[i];
+            resolve(chunk._faceVertices, chunk._relativeVertices,
+                    chunk._before._vertices, total._vertices, filename);
+            resolve(chunk._faceNormals, chunk._relativeNormals,
+                    chunk._before._normals, total._normals, filename);
+            resolve(chunk._faceUvs, chunk._relativeUvs,
+                    chunk._before._uvs, total._uvs, filename);
+        });
+
+        MINIRE_DEBUG("obj {}: {} vertices, {} triangles parsed by {} worker(s)",
+                     filename, total._vertices, total._faceVertices / 3, workers);
 
-            uint32_t parseUint()
-            {
-                skipWhitespace();
-
-                char * endptr;
-                char const * begin = ptr();
-                int64_t result = std::strtoll(begin, &endptr, 10);
-                if (LLONG_MAX == result || LLONG_MIN == result) MINIRE_THROW("bad int token");
-                if (result <= 0) MINIRE_THROW("negative indeces not supported");
-                if (result > std::numeric_limits<uint32_t>::max()) MINIRE_THROW("too large index");
-                _p += (endptr - begin);
-                return static_cast<uint32_t>(result);
-            }
+        return result;
+    }
 
-            glm::vec2 parseVec2()
-            {
-                float x = parseFloat();
-                float y = parseFloat();
-                return glm::vec2(x, y);
-            }
+    Obj parseObj(std::string_view text, std::string const & filename)
+    {
+        ObjChunks const parsed = parseObjChunks(text, filename);
+        ObjCounts const & total = parsed._total;
 
-            glm::vec3 parseVec3()
-            {
-                float x = parseFloat();
-                float y = parseFloat();
-                float z = parseFloat();
-                return glm::vec3(x, y, z);
-            }
+        Obj result;
+        result._vertices.resize(total._vertices);
+        result._normals.resize(total._normals);
+        result._uvs.resize(total._uvs);
+        result._faceVertices.resize(total._faceVertices);
+        result._faceNormals.resize(total._faceNormals);
+        result._faceUvs.resize(total._faceUvs);
+
+        // indices are checked already, so they're just narrowed
+        auto const copy = [](auto const & source, auto & target, size_t offset)
+        {
+            using Target = typename std::decay_t<decltype(target)>::value_type;
+            std::transform(source.cbegin(), source.cend(), target.begin() + offset,
+                           [](auto const & item) { return static_cast<Target>(item); });
+        };
 
-            bool isEnd() const { return _p >= _buffer.size() || '\0' == *ptr(); }
-            char const * ptr() const { return &_buffer[_p]; }
-            char chr() const { return _buffer[_p]; }
+        utils::parallel(parsed._chunks.size(), [&](size_t i)
+        {
+            ObjChunk const & chunk = parsed._chunks[i];
+            ObjCounts const & before = chunk._before;
 
-        private:
-            using Buffer = std::array<char, kMaxBufferSize>;
+            copy(chunk._vertices, result._vertices, before._vertices);
+            copy(chunk._normals, result._normals, before._normals);
+            copy(chunk._uvs, result._uvs, before._uvs);
+            copy(chunk._faceVertices, result._faceVertices, before._faceVertices);
+            copy(chunk._faceNormals, result._faceNormals, before._faceNormals);
+            copy(chunk._faceUvs, result._faceUvs, before._faceUvs);
+        });
 
-            size_t    _p = 0;
-            Buffer    _buffer;
-            Obj     & _output;
-        };
+        assert(result.validate());
+        return result;
     }
 
     /*!
@@ -223,9 +185,8 @@ namespace minire::formats
      * */
     Obj loadObj(std::string const & filename)
     {
-        std::ifstream ifs(filename, std::ifstream::in);
-        if (!ifs) MINIRE_THROW("failed to open: \"{}\"", filename);
-        return loadObj(ifs);
+        utils::MappedFile const file(filename);
+        return parseObj(file.view(), filename);
     }
 
     /*!
@@ -233,11 +194,8 @@ namespace minire::formats
      * */
     Obj loadObj(std::istream & is)
     {
-        Obj result;
-        ObjLineParser<512> parser(result);
-        while(is.good()) parser.readLine(is);
-        assert(result.validate());
-        return result;
+        std::string const text(std::istreambuf_iterator<char>(is), {});
+        return parseObj(text, "<stream>");
     }
 
     namespace
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <minire/errors.hpp>
+
+#include <opengl.hpp>
+
+#include <utility>
+
+namespace minire::opengl
+{
+    // It's signaled once all the commands issued before it are completed
+    class Fence
+    {
+    public:
+        Fence()
+            : _sync(::glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0))
+        {
+            MINIRE_MAYBE_THROW_GL(glFenceSync);
+            MINIRE_INVARIANT(_sync, "failed to create a fence");
+        }
+
+        ~Fence()
+        {
+            ::glDeleteSync(_sync);
+        }
+
+        Fence(Fence && other)
+            : _sync(std::exchange(other._sync, nullptr))
+        {}
+
+        Fence & operator=(Fence && other)
+        {
+            std::swap(_sync, other._sync);
+            return *this;
+        }
+
+    public:
+        // doesn't wait (but flushes the commands to let it be signaled)
+        bool signaled() const
+        {
+            GLenum const result = ::glClientWaitSync(_sync, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+            MINIRE_MAYBE_THROW_GL(glClientWaitSync);
+            MINIRE_INVARIANT(GL_WAIT_FAILED != result, "failed to wait for a fence");
+            return GL_ALREADY_SIGNALED == result || GL_CONDITION_SATISFIED == result;
+        }
+
+    private:
+        GLsync _sync;
+
+        Fence(Fence const &) = delete;
+        Fence & operator=(Fence const &) = delete;
+    };
+}
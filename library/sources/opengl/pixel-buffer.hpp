@@ -0,0 +1,92 @@
+#pragma once
+
+#include <minire/errors.hpp>
+
+#include <opengl.hpp>
+
+#include <cstdint>
+#include <utility>
+
+namespace minire::opengl
+{
+    // A buffer of pixels to be uploaded into textures (GL_PIXEL_UNPACK_BUFFER),
+    // while it's mapped its memory could be written by any thread
+    class PixelBuffer
+    {
+    public:
+        explicit PixelBuffer(GLsizeiptr size)
+            : _id(0)
+            , _size(size)
+        {
+            MINIRE_GL(glGenBuffers, 1, &_id);
+            bind();
+            MINIRE_GL(glBufferData, GL_PIXEL_UNPACK_BUFFER, _size, nullptr, GL_STREAM_DRAW);
+            unbind();
+        }
+
+        ~PixelBuffer()
+        {
+            ::glDeleteBuffers(1, &_id); // unmaps it as well
+        }
+
+        PixelBuffer(PixelBuffer && other)
+            : _id(std::exchange(other._id, 0))
+            , _size(std::exchange(other._size, 0))
+            , _mapped(std::exchange(other._mapped, nullptr))
+        {}
+
+        PixelBuffer & operator=(PixelBuffer && other)
+        {
+            std::swap(_id, other._id);
+            std::swap(_size, other._size);
+            std::swap(_mapped, other._mapped);
+            return *this;
+        }
+
+    public:
+        GLuint id() const { return _id; }
+
+        GLsizeiptr size() const { return _size; }
+
+        void bind() const { MINIRE_GL(glBindBuffer, GL_PIXEL_UNPACK_BUFFER, _id); }
+
+        // NOTE: textures are uploaded from client memory while it's unbound
+        static void unbind() { MINIRE_GL(glBindBuffer, GL_PIXEL_UNPACK_BUFFER, 0); }
+
+        // the previous content is discarded
+        uint8_t * map()
+        {
+            MINIRE_INVARIANT(!_mapped, "a pixel buffer is mapped already");
+            bind();
+            _mapped = static_cast<uint8_t *>(::glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, _size,
+                                                                GL_MAP_WRITE_BIT |
+                                                                GL_MAP_INVALIDATE_BUFFER_BIT));
+            MINIRE_MAYBE_THROW_GL(glMapBufferRange);
+            unbind();
+            MINIRE_INVARIANT(_mapped, "failed to map a pixel buffer of {} bytes", _size);
+            return _mapped;
+        }
+
+        // returns false if the content is lost while it's mapped
+        bool unmap()
+        {
+            MINIRE_INVARIANT(_mapped, "a pixel buffer isn't mapped");
+            bind();
+            GLboolean const intact = ::glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            MINIRE_MAYBE_THROW_GL(glUnmapBuffer);
+            unbind();
+            _mapped = nullptr;
+            return GL_TRUE == intact;
+        }
+
+        bool mapped() const { return nullptr != _mapped; }
+
+    private:
+        GLuint     _id;
+        GLsizeiptr _size;
+        uint8_t  * _mapped = nullptr;
+
+        PixelBuffer(PixelBuffer const &) = delete;
+        PixelBuffer & operator=(PixelBuffer const &) = delete;
+    };
+}
@@ -3,6 +3,7 @@
 #include <opengl.hpp>
 #include <opengl/shader.hpp>
 
+#include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include <glm/mat4x4.hpp>
 #include <glm/gtc/type_ptr.hpp> // for gln::value_ptr
@@ -73,6 +74,12 @@ namespace minire::opengl
             MINIRE_GL(glUniform1f, location, value);
         }
 
+        void setUniform(GLint location, glm::vec2 const & value) const
+        {
+            assert(isUsing());
+            MINIRE_GL(glUniform2f, location, value.x, value.y);
+        }
+
         void setUniform(GLint location, glm::vec3 const & value) const
         {
             assert(isUsing());
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <opengl.hpp>
+
+#include <memory>
+#include <utility>
+
+namespace minire::opengl
+{
+    // Filtering and wrapping of textures, it overrides parameters
+    // of a texture which is bound to the same texture unit
+    class Sampler
+    {
+    public:
+        using Sptr = std::shared_ptr<Sampler const>;
+
+        Sampler()
+            : _id(0)
+        {
+            MINIRE_GL(glGenSamplers, 1, &_id);
+        }
+
+        ~Sampler()
+        {
+            ::glDeleteSamplers(1, &_id);
+        }
+
+        Sampler(Sampler && other)
+            : _id(std::exchange(other._id, 0))
+        {}
+
+        Sampler & operator=(Sampler && other)
+        {
+            std::swap(_id, other._id);
+            return *this;
+        }
+
+    public:
+        GLuint id() const { return _id; }
+
+        void bind(GLuint unit) const { MINIRE_GL(glBindSampler, unit, _id); }
+
+        void parameteri(GLenum pname, GLint param) const
+        {
+            MINIRE_GL(glSamplerParameteri, _id, pname, param);
+        }
+
+    private:
+        GLuint _id;
+
+        Sampler(Sampler const &) = delete;
+        Sampler & operator=(Sampler const &) = delete;
+    };
+}
@@ -2,6 +2,9 @@
 
 #include <minire/errors.hpp>
 
+#include <string_view>
+#include <unordered_set>
+
 namespace minire::opengl
 {
     GLenum toInternalFormat(models::Image::Format format)
@@ -25,4 +28,80 @@ namespace minire::opengl
             default: MINIRE_THROW("image format not supported: {}", int(format));
         }
     }
+
+    // NOTE: S3TC, BPTC and ETC2 aren't core in GL 3.3 (see CompressedFormats)
+    GLenum toInternalFormat(models::CompressedImage::Format format)
+    {
+        switch(format)
+        {
+            case models::CompressedImage::Format::kBc1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            case models::CompressedImage::Format::kBc1Alpha: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+            case models::CompressedImage::Format::kBc3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            case models::CompressedImage::Format::kBc4: return GL_COMPRESSED_RED_RGTC1;
+            case models::CompressedImage::Format::kBc5: return GL_COMPRESSED_RG_RGTC2;
+            case models::CompressedImage::Format::kBc7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+            case models::CompressedImage::Format::kEtc2: return GL_COMPRESSED_RGB8_ETC2;
+            case models::CompressedImage::Format::kEtc2Alpha: return GL_COMPRESSED_RGBA8_ETC2_EAC;
+            default: MINIRE_THROW("compressed format not supported: {}", int(format));
+        }
+    }
+
+    char const * toString(models::CompressedImage::Format format)
+    {
+        switch(format)
+        {
+            case models::CompressedImage::Format::kBc1: return "BC1";
+            case models::CompressedImage::Format::kBc1Alpha: return "BC1 w/ alpha";
+            case models::CompressedImage::Format::kBc3: return "BC3";
+            case models::CompressedImage::Format::kBc4: return "BC4";
+            case models::CompressedImage::Format::kBc5: return "BC5";
+            case models::CompressedImage::Format::kBc7: return "BC7";
+            case models::CompressedImage::Format::kEtc2: return "ETC2";
+            case models::CompressedImage::Format::kEtc2Alpha: return "ETC2 w/ alpha";
+        }
+        return "unknown";
+    }
+
+    CompressedFormats::CompressedFormats()
+    {
+        GLint count = 0;
+        MINIRE_GL(glGetIntegerv, GL_NUM_EXTENSIONS, &count);
+        std::unordered_set<std::string_view> extensions;
+        for(GLint i = 0; i < count; ++i)
+        {
+            auto const * name = reinterpret_cast<char const *>(::glGetStringi(GL_EXTENSIONS, i));
+            MINIRE_MAYBE_THROW_GL(glGetStringi);
+            if (name) extensions.emplace(name);
+        }
+
+        GLint major = 0;
+        GLint minor = 0;
+        MINIRE_GL(glGetIntegerv, GL_MAJOR_VERSION, &major);
+        MINIRE_GL(glGetIntegerv, GL_MINOR_VERSION, &minor);
+        auto const core = [major, minor](GLint sinceMajor, GLint sinceMinor)
+        {
+            return major > sinceMajor || (major == sinceMajor && minor >= sinceMinor);
+        };
+
+        using Format = models::CompressedImage::Format;
+        auto const support = [this](Format format, bool supported)
+        {
+            _supported.set(static_cast<size_t>(format), supported);
+        };
+
+        bool const s3tc = extensions.contains("GL_EXT_texture_compression_s3tc");
+        bool const bptc = core(4, 2) || extensions.contains("GL_ARB_texture_compression_bptc");
+        bool const etc2 = core(4, 3) || extensions.contains("GL_ARB_ES3_compatibility");
+
+        support(Format::kBc1, s3tc);
+        support(Format::kBc1Alpha, s3tc);
+        support(Format::kBc3, s3tc);
+        support(Format::kBc4, true); // RGTC is core since GL 3.0
+        support(Format::kBc5, true);
+        support(Format::kBc7, bptc);
+        support(Format::kEtc2, etc2);
+        support(Format::kEtc2Alpha, etc2);
+
+        MINIRE_INFO("compressed textures: S3TC {}, BPTC {}, ETC2 {}", s3tc, bptc, etc2);
+    }
 }
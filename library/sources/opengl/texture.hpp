@@ -1,10 +1,12 @@
 #pragma once
 
 #include <opengl.hpp>
+#include <minire/models/compressed-image.hpp>
 #include <minire/models/image.hpp>
 
 #include <minire/logging.hpp> // TODO: [X]
 
+#include <bitset>
 #include <memory>
 
 namespace minire::opengl
@@ -67,4 +69,25 @@ namespace minire::opengl
     GLenum toInternalFormat(models::Image::Format format);
 
     GLenum toFormat(models::Image::Format format);
+
+    GLenum toInternalFormat(models::CompressedImage::Format format);
+
+    char const * toString(models::CompressedImage::Format format);
+
+    // Compressed formats the context samples, S3TC, BPTC and ETC2 are up
+    // to extensions before they're core, so extensions are queried once
+    // (by the ctor, w/ the context current)
+    class CompressedFormats
+    {
+    public:
+        CompressedFormats();
+
+        bool supports(models::CompressedImage::Format format) const
+        {
+            return _supported.test(static_cast<size_t>(format));
+        }
+
+    private:
+        std::bitset<8> _supported; // by CompressedImage::Format
+    };
 }
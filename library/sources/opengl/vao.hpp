@@ -79,6 +79,12 @@ namespace minire::opengl
                       reinterpret_cast<const GLvoid*>(pointer));
         }
 
+        void divisor(GLuint index, GLuint divisor) const
+        {
+            bind();
+            MINIRE_GL(glVertexAttribDivisor, index, divisor);
+        }
+
         static void unbind()
         {
             MINIRE_GL(glBindVertexArray, 0);
@@ -94,6 +94,14 @@ namespace minire::opengl
             MINIRE_GL(glBindBuffer, _target, _vboId);
         }
 
+        // binds it to another VAO, i.e. the VBO is shared by VertexBuffers;
+        // the target it's created w/ is only a hint, it may be bound to any
+        void bindTo(VAO const & vao, GLenum target) const
+        {
+            vao.bind();
+            MINIRE_GL(glBindBuffer, target, _vboId);
+        }
+
         void bufferData(GLsizeiptr size,
                         const GLvoid *data,
                         GLenum usage)
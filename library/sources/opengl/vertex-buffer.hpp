@@ -8,7 +8,13 @@
 #include <opengl/vao.hpp>
 #include <opengl/vbo.hpp>
 
+#include <glm/vec3.hpp>
+
+#include <memory>
+#include <optional>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace minire::opengl
 {
@@ -16,15 +22,47 @@ namespace minire::opengl
     // TODO: maybe rename it? Like Brush or Drawable
     struct VertexBuffer
     {
-        using VboMap = std::unordered_map<size_t, opengl::VBO>;
+        using VboMap = std::unordered_map<size_t, opengl::VBO::Sptr>;
+
+        // an attribute pointer of the VAO
+        struct Binding
+        {
+            GLuint    _vbo;
+            GLuint    _location;
+            GLint     _components;
+            GLenum    _type;
+            GLboolean _normalized;
+            GLsizei   _stride;
+            size_t    _offset;
+
+            bool operator==(Binding const &) const = default;
+        };
 
         opengl::VAO::Sptr _vao;
         VboMap            _vboMap;
         size_t            _elementsCount = 0;
         GLenum            _elementsType = 0;
+        size_t            _elementsOffset = 0; // bytes, in the elements VBO
         utils::Aabb       _aabb;
         GLenum            _drawMode = GL_TRIANGLES;
 
+        // the least and the greatest element, for glDrawRangeElements
+        std::optional<std::pair<GLuint, GLuint>> _elementsRange;
+
+        // positions are decoded as offset + position * scale
+        glm::vec3         _positionScale = glm::vec3(1.0f);
+        glm::vec3         _positionOffset = glm::vec3(0.0f);
+
+        // of shared VBOs (see bind), VertexBuffers w/ equal ones can be
+        // drawn by one call (see append)
+        GLuint               _elementsVbo = 0;
+        std::vector<Binding> _bindings;
+
+        // ranges of elements of appended primitives, glMultiDrawElements
+        // takes them as they are
+        std::vector<GLsizei>        _drawCounts;
+        std::vector<GLvoid const *> _drawOffsets;
+
     public:
         VertexBuffer()
             : _vao(std::make_shared<opengl::VAO>())
@@ -35,23 +73,99 @@ namespace minire::opengl
 
         opengl::VBO & createVbo(size_t index, GLenum target)
         {
-            auto [it, inserted] = _vboMap.emplace(index, opengl::VBO(_vao, target));
-            if (!inserted && it->second.target() != target)
+            auto [it, inserted] = _vboMap.emplace(index, nullptr);
+            if (inserted)
+            {
+                it->second = std::make_shared<opengl::VBO>(_vao, target);
+            }
+            else if (it->second->target() != target)
             {
                 MINIRE_THROW("VBO re-created w/ different target: {} != {}",
-                             target, it->second.target());
+                             target, it->second->target());
             }
-            return it->second;
+            return *it->second;
+        }
+
+        // Binds a VBO, which might be shared w/ other VertexBuffers, to the VAO
+        // as the target, whatever one it's created w/; attributes of an array
+        // one are set up by attrib()
+        void bind(size_t index, opengl::VBO::Sptr const & vbo, GLenum target)
+        {
+            assert(vbo);
+            auto [it, inserted] = _vboMap.emplace(index, vbo);
+            MINIRE_INVARIANT(inserted || it->second == vbo, "VBO re-bound: {}", index);
+
+            vbo->bindTo(*_vao, target);
+            if (GL_ELEMENT_ARRAY_BUFFER == target) _elementsVbo = vbo->id();
+        }
+
+        void attrib(opengl::VBO const & vbo, Binding const & binding)
+        {
+            assert(binding._vbo == vbo.id());
+            vbo.bindTo(*_vao, GL_ARRAY_BUFFER);
+            _vao->enableAttrib(binding._location);
+            _vao->attribPointer(binding._location, binding._components, binding._type,
+                                binding._normalized, binding._stride, binding._offset);
+            _bindings.push_back(binding);
         }
 
         void bindVao() const { assert(_vao); _vao->bind(); }
 
         utils::Aabb const & aabb() const { return _aabb; }
 
+        // the same vertices and elements are drawn the same way
+        bool drawableWith(VertexBuffer const & other) const
+        {
+            return _elementsVbo != 0
+                && _elementsVbo == other._elementsVbo
+                && _elementsType == other._elementsType
+                && _drawMode == other._drawMode
+                && _bindings == other._bindings
+                && _positionScale == other._positionScale
+                && _positionOffset == other._positionOffset;
+        }
+
+        // elements of another primitive are drawn along w/ these
+        // ones by glMultiDrawElements
+        void append(VertexBuffer const & other)
+        {
+            assert(drawableWith(other));
+            auto const add = [this](VertexBuffer const & buffer)
+            {
+                if (!buffer._drawCounts.empty())
+                {
+                    _drawCounts.insert(_drawCounts.end(), buffer._drawCounts.cbegin(), buffer._drawCounts.cend());
+                    _drawOffsets.insert(_drawOffsets.end(), buffer._drawOffsets.cbegin(), buffer._drawOffsets.cend());
+                    return;
+                }
+                _drawCounts.push_back(static_cast<GLsizei>(buffer._elementsCount));
+                _drawOffsets.push_back(reinterpret_cast<GLvoid const *>(buffer._elementsOffset));
+            };
+
+            if (_drawCounts.empty()) add(*this);
+            add(other);
+            _aabb.extend(other._aabb);
+        }
+
         void drawElements() const
         {
             bindVao();
-            MINIRE_GL(glDrawElements, _drawMode, _elementsCount, _elementsType, 0);
+            if (!_drawCounts.empty())
+            {
+                MINIRE_GL(glMultiDrawElements, _drawMode, _drawCounts.data(), _elementsType,
+                          _drawOffsets.data(), static_cast<GLsizei>(_drawCounts.size()));
+            }
+            else if (_elementsRange)
+            {
+                MINIRE_GL(glDrawRangeElements, _drawMode, _elementsRange->first, _elementsRange->second,
+                          _elementsCount, _elementsType,
+                          reinterpret_cast<GLvoid const *>(_elementsOffset));
+            }
+            else
+            {
+                MINIRE_GL(glDrawElements, _drawMode, _elementsCount, _elementsType,
+                          reinterpret_cast<GLvoid const *>(_elementsOffset));
+            }
         }
 
     private:
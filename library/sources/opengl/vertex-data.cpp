@@ -0,0 +1,230 @@
+#include <opengl/vertex-data.hpp>
+
+#include <minire/errors.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace minire::opengl
+{
+    namespace
+    {
+        template<typename T>
+        float component(std::byte const * data, size_t index, bool normalized)
+        {
+            T value;
+            std::memcpy(&value, data + index * sizeof(T), sizeof(T));
+            if constexpr (std::is_integral_v<T> && sizeof(T) < 4)
+            {
+                // the same as GL does for normalized integers
+                if (normalized)
+                {
+                    return std::max(static_cast<float>(value) / std::numeric_limits<T>::max(), -1.0f);
+                }
+            }
+            return static_cast<float>(value);
+        }
+
+        uint32_t element(VertexData const & primitive, size_t index)
+        {
+            auto const read = [&primitive, index](auto value) -> uint32_t
+            {
+                std::memcpy(&value, primitive._elements.data() + index * sizeof(value), sizeof(value));
+                return value;
+            };
+
+            switch(primitive._elementsType)
+            {
+                case GL_UNSIGNED_BYTE:  return read(uint8_t());
+                case GL_UNSIGNED_SHORT: return read(uint16_t());
+                case GL_UNSIGNED_INT:   return read(uint32_t());
+                default: MINIRE_THROW("unsupported elements type: {}", primitive._elementsType);
+            }
+        }
+
+        size_t elementSize(GLenum type)
+        {
+            switch(type)
+            {
+                case GL_UNSIGNED_BYTE:  return sizeof(uint8_t);
+                case GL_UNSIGNED_SHORT: return sizeof(uint16_t);
+                case GL_UNSIGNED_INT:   return sizeof(uint32_t);
+                default: MINIRE_THROW("unsupported elements type: {}", type);
+            }
+        }
+
+        // the same attributes are read the same way from the same VBOs
+        bool sameLayout(VertexData const & a, VertexData const & b)
+        {
+            return a._drawMode == b._drawMode
+                && a._stride == b._stride
+                && a._attribs == b._attribs
+                && a._positionScale == b._positionScale
+                && a._positionOffset == b._positionOffset;
+        }
+    }
+
+    VertexData::Attrib const * VertexData::attrib(int32_t location) const
+    {
+        auto const it = std::find_if(_attribs.cbegin(), _attribs.cend(),
+                                     [location](Attrib const & attrib)
+                                     {
+                                         return attrib._location == location;
+                                     });
+        return it != _attribs.cend() ? &*it : nullptr;
+    }
+
+    glm::vec4 VertexData::read(size_t vertex, Attrib const & attrib) const
+    {
+        assert(vertex < vertices());
+        std::byte const * data = _vertices.data() + vertex * _stride + attrib._offset;
+        bool const normalized = attrib._normalized != 0;
+
+        glm::vec4 result(0.0f, 0.0f, 0.0f, 1.0f);
+        for(int32_t i = 0; i < std::min(attrib._components, 4); ++i)
+        {
+            switch(attrib._type)
+            {
+                case GL_FLOAT:          result[i] = component<float>(data, i, normalized); break;
+                case GL_BYTE:           result[i] = component<int8_t>(data, i, normalized); break;
+                case GL_UNSIGNED_BYTE:  result[i] = component<uint8_t>(data, i, normalized); break;
+                case GL_SHORT:          result[i] = component<int16_t>(data, i, normalized); break;
+                case GL_UNSIGNED_SHORT: result[i] = component<uint16_t>(data, i, normalized); break;
+                case GL_INT:            result[i] = component<int32_t>(data, i, false); break;
+                case GL_UNSIGNED_INT:   result[i] = component<uint32_t>(data, i, false); break;
+                default: MINIRE_THROW("unsupported attribute type: {}", attrib._type);
+            }
+        }
+        return result;
+    }
+
+    glm::vec3 VertexData::position(size_t vertex) const
+    {
+        Attrib const * positions = attrib(_locations._vertexAttribute);
+        MINIRE_INVARIANT(positions, "no positions");
+        return _positionOffset + glm::vec3(read(vertex, *positions)) * _positionScale;
+    }
+
+    std::vector<VertexBuffer> upload(MeshData const & data)
+    {
+        std::vector<VertexData> const & primitives = data._primitives;
+
+        // groups of primitives sharing VBOs, in order of appearance
+        std::vector<std::vector<size_t>> groups;
+        for(size_t i = 0; i < primitives.size(); ++i)
+        {
+            auto const group = std::find_if(groups.begin(), groups.end(),
+                                            [&primitives, i](std::vector<size_t> const & group)
+                                            {
+                                                return sameLayout(primitives[group.front()], primitives[i]);
+                                            });
+            if (group != groups.end())
+            {
+                group->push_back(i);
+            }
+            else
+            {
+                groups.push_back({i});
+            }
+        }
+
+        std::vector<VertexBuffer> result(primitives.size());
+        for(std::vector<size_t> const & group : groups)
+        {
+            size_t const stride = primitives[group.front()]._stride;
+            size_t vertices = 0;
+            for(size_t const i : group)
+            {
+                vertices += primitives[i].vertices();
+            }
+
+            // 16-bit elements while they can address all the vertices of the group
+            bool const narrow = vertices <= std::numeric_limits<uint16_t>::max() + size_t(1);
+            GLenum const elementsType = narrow ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+            size_t const size = elementSize(elementsType);
+
+            std::vector<std::byte> groupVertices;
+            std::vector<std::byte> groupElements;
+            groupVertices.reserve(vertices * stride);
+
+            size_t base = 0;
+            for(size_t const i : group)
+            {
+                VertexData const & primitive = primitives[i];
+                MINIRE_INVARIANT(primitive._elements.size() >= primitive._elementsCount * elementSize(primitive._elementsType),
+                                 "elements are out of the buffer: {} < {}",
+                                 primitive._elements.size(), primitive._elementsCount);
+
+                VertexBuffer & buffer = result[i];
+                buffer._elementsCount = primitive._elementsCount;
+                buffer._elementsType = elementsType;
+                buffer._elementsOffset = groupElements.size();
+                buffer._aabb = primitive._aabb;
+                buffer._drawMode = primitive._drawMode;
+                buffer._positionScale = primitive._positionScale;
+                buffer._positionOffset = primitive._positionOffset;
+                if (primitive.vertices() > 0)
+                {
+                    buffer._elementsRange.emplace(static_cast<GLuint>(base),
+                                                  static_cast<GLuint>(base + primitive.vertices() - 1));
+                }
+
+                groupElements.resize(groupElements.size() + primitive._elementsCount * size);
+                std::byte * out = groupElements.data() + buffer._elementsOffset;
+                for(size_t e = 0; e < primitive._elementsCount; ++e)
+                {
+                    uint32_t const value = element(primitive, e);
+                    MINIRE_INVARIANT(value < primitive.vertices(),
+                                     "element is out of vertices: {} >= {}", value, primitive.vertices());
+
+                    uint32_t const rebased = static_cast<uint32_t>(base + value);
+                    if (narrow)
+                    {
+                        uint16_t const narrowed = static_cast<uint16_t>(rebased);
+                        std::memcpy(out + e * size, &narrowed, size);
+                    }
+                    else
+                    {
+                        std::memcpy(out + e * size, &rebased, size);
+                    }
+                }
+
+                VertexData::Bytes const bytes = primitive._vertices.first(primitive.vertices() * stride);
+                groupVertices.insert(groupVertices.end(), bytes.begin(), bytes.end());
+                base += primitive.vertices();
+            }
+
+            // VBOs are created w/ the VAO of the first primitive and bound to the rest
+
+            VertexBuffer & first = result[group.front()];
+            auto const ebo = std::make_shared<VBO>(first._vao, GL_ELEMENT_ARRAY_BUFFER);
+            ebo->bufferData(groupElements.size(), groupElements.data(), GL_STATIC_DRAW);
+            auto const vbo = std::make_shared<VBO>(first._vao, GL_ARRAY_BUFFER);
+            vbo->bufferData(groupVertices.size(), groupVertices.data(), GL_STATIC_DRAW);
+
+            for(size_t const i : group)
+            {
+                VertexBuffer & buffer = result[i];
+                buffer.bind(0, ebo, GL_ELEMENT_ARRAY_BUFFER);
+                buffer.bind(1, vbo, GL_ARRAY_BUFFER);
+                for(VertexData::Attrib const & attrib : primitives[i]._attribs)
+                {
+                    if (-1 == attrib._location) continue;
+
+                    buffer.attrib(*vbo, VertexBuffer::Binding{
+                        vbo->id(),
+                        static_cast<GLuint>(attrib._location),
+                        attrib._components,
+                        attrib._type,
+                        static_cast<GLboolean>(attrib._normalized ? GL_TRUE : GL_FALSE),
+                        static_cast<GLsizei>(stride),
+                        attrib._offset,
+                    });
+                }
+            }
+        }
+        return result;
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <minire/material.hpp>
+#include <minire/models/mesh-features.hpp>
+#include <minire/utils/aabb.hpp>
+
+#include <opengl.hpp>
+#include <opengl/vertex-buffer.hpp>
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace minire::opengl
+{
+    // Vertices and elements of a VertexBuffer as they are uploaded:
+    // attributes are interleaved and bound to the locations of
+    // the program they are drawn with
+    struct VertexData
+    {
+        using Bytes = std::span<std::byte const>;
+        using Locations = material::Program::Locations;
+
+        struct Attrib
+        {
+            int32_t  _location;   // -1 if the program doesn't use it
+            int32_t  _components;
+            uint32_t _type;
+            uint32_t _normalized;
+            uint32_t _offset;     // in a vertex
+
+            bool operator==(Attrib const &) const = default;
+        };
+
+        models::MeshFeatures _features;
+        Locations            _locations;
+        GLenum               _drawMode = GL_TRIANGLES;
+        GLenum               _elementsType = GL_UNSIGNED_INT;
+        size_t               _elementsCount = 0;
+        size_t               _stride = 0;
+        utils::Aabb          _aabb;
+        std::vector<Attrib>  _attribs;
+        Bytes                _elements;
+        Bytes                _vertices;
+        glm::vec3            _positionScale = glm::vec3(1.0f);  // see VertexBuffer
+        glm::vec3            _positionOffset = glm::vec3(0.0f);
+
+    public:
+        VertexBuffer upload() const
+        {
+            VertexBuffer result;
+            result._elementsCount = _elementsCount;
+            result._elementsType = _elementsType;
+            result._aabb = _aabb;
+            result._drawMode = _drawMode;
+            result._positionScale = _positionScale;
+            result._positionOffset = _positionOffset;
+
+            opengl::VBO & ebo = result.createVbo(0, GL_ELEMENT_ARRAY_BUFFER);
+            ebo.bufferData(_elements.size(), _elements.data(), GL_STATIC_DRAW);
+
+            opengl::VBO & vbo = result.createVbo(1, GL_ARRAY_BUFFER);
+            vbo.bufferData(_vertices.size(), _vertices.data(), GL_STATIC_DRAW);
+
+            for(Attrib const & attrib : _attribs)
+            {
+                if (-1 == attrib._location) continue;
+
+                result._vao->enableAttrib(attrib._location);
+                result._vao->attribPointer(attrib._location,
+                                           attrib._components,
+                                           attrib._type,
+                                           attrib._normalized ? GL_TRUE : GL_FALSE,
+                                           _stride,
+                                           attrib._offset);
+            }
+
+            return result;
+        }
+
+        size_t vertices() const { return _stride ? _vertices.size() / _stride : 0; }
+
+        // nullptr if there is no attribute at the location
+        Attrib const * attrib(int32_t location) const;
+
+        // components of an attribute of a vertex as a shader sees them
+        glm::vec4 read(size_t vertex, Attrib const &) const;
+
+        // the decoded one, i.e. in the model space
+        glm::vec3 position(size_t vertex) const;
+
+        bool boundTo(Locations const & locations) const
+        {
+            return _locations._vertexAttribute == locations._vertexAttribute
+                && _locations._uvAttribute == locations._uvAttribute
+                && _locations._normalAttribute == locations._normalAttribute
+                && _locations._tangentAttribute == locations._tangentAttribute;
+        }
+    };
+
+    // VertexData of primitives of a mesh and memory they refer
+    struct MeshData
+    {
+        std::vector<VertexData>     _primitives;
+        std::shared_ptr<void const> _storage;
+    };
+
+    // VertexBuffers of all the primitives: ones of the same layout and
+    // position decoding share VBOs, their vertices are concatenated and
+    // elements are rebased, so they're drawable by one call (see
+    // VertexBuffer::drawableWith)
+    std::vector<VertexBuffer> upload(MeshData const &);
+}
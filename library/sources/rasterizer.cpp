@@ -27,7 +27,7 @@ namespace minire
         , _sprites(_textures)
         , _2dProjection(1.0)
     {
-        // TODO: preload textures for sprites
+        // NOTE: textures of sprites are preloaded by warmup()
 
         _materials.add(models::PbrMaterial::kMaterialKind,
                        std::make_unique<rasterizer::materials::PbrFactory>(_textures));
@@ -38,6 +38,26 @@ namespace minire
         _2dProjection = glm::ortho(0.0f, w, 0.0f, h);
     }
 
+    void Rasterizer::warmup(models::WarmupManifest const & manifest)
+    {
+        MINIRE_INVARIANT(!_warmup, "a warmup is in progress already");
+        _warmup = std::make_unique<rasterizer::Warmup>(manifest, _contentManager, _meshes,
+                                                       _textures, _fonts, _materials, _ubo);
+    }
+
+    bool Rasterizer::warmupStep(size_t budget)
+    {
+        if (!_warmup) return true;
+
+        if (_warmup->step(budget))
+        {
+            _warmup->report();
+            _warmup.reset();
+            return true;
+        }
+        return false;
+    }
+
     void Rasterizer::draw(utils::Viewpoint const & viewpoint,
                       Scene const & scene)
     {
@@ -66,6 +86,9 @@ namespace minire
         MINIRE_GL(glDisable, GL_BLEND);
         MINIRE_GL(glBlendFunc, GL_ONE, GL_ZERO);
 
+        // mipmaps of textures uploaded since the last frame
+        _textures.flush();
+
         // draw coordinates
         _coordinates.draw();
 
@@ -89,11 +112,12 @@ namespace minire
         //        or use stencil for buffer for 2Ds)
         //      - (that will kill blending for 2Ds)
 
-        // TODO: group by texture
+        _barriers.clear();
+        _sprites.zOrders(_barriers);
 
         _drawables.clear();
-        _labels.predraw(_drawables);
-        _sprites.predraw(_drawables);
+        _labels.predraw(_drawables, _barriers);
+        _sprites.predraw(_drawables); // must be the last (see Sprites::predraw)
 
         // TODO: avoid sorting, use Z-buffer instead
         std::sort(_drawables.begin(), _drawables.end(),
@@ -11,11 +11,15 @@
 #include <rasterizer/sprites.hpp>
 #include <rasterizer/textures.hpp>
 #include <rasterizer/ubo.hpp>
+#include <rasterizer/warmup.hpp>
 #include <scene.hpp>
 #include <utils/viewpoint.hpp>
 
 #include <glm/mat4x4.hpp>
 
+#include <memory>
+#include <vector>
+
 namespace minire::content { class Manager; }
 
 namespace minire
@@ -31,6 +35,13 @@ namespace minire
 
         void setScreenSize(float w, float h);
 
+        // starts decoding of the manifest's content (see rasterizer::Warmup)
+        void warmup(models::WarmupManifest const &);
+
+        // uploads warmed up content for about budget microseconds,
+        // returns false until the warmup (if any) is done
+        bool warmupStep(size_t budget);
+
     public:
         rasterizer::Labels & labels() { return _labels; }
         rasterizer::Sprites & sprites() { return _sprites; }
@@ -58,6 +69,9 @@ namespace minire
 
         glm::mat4                      _2dProjection;
         rasterizer::Drawable::PtrsList _drawables;
+        std::vector<size_t>            _barriers; // z-orders of sprites
         size_t                         _modelsUsage;
+
+        std::unique_ptr<rasterizer::Warmup> _warmup; // while it's in progress
     };
 }
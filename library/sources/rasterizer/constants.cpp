@@ -16,6 +16,20 @@ namespace minire::rasterizer
             return normalize(tbn * normal);
         }
 
+        // samples layer.x of a texture array, mips finer than layer.y aren't
+        // streamed yet, and the fallback is used until any of them is
+        vec4 sampleLayer(sampler2DArray tex, vec2 uv, vec2 layer, vec4 fallback)
+        {
+            if (layer.y < 0.0) return fallback;
+            if (layer.y == 0.0) return texture(tex, vec3(uv, layer.x));
+
+            vec2 texels = uv * vec2(textureSize(tex, 0).xy);
+            vec2 dx = dFdx(texels);
+            vec2 dy = dFdy(texels);
+            float lod = 0.5 * log2(max(dot(dx, dx), dot(dy, dy)));
+            return textureLod(tex, vec3(uv, layer.x), max(lod, layer.y));
+        }
+
         float DistributionGGX(vec3 N, vec3 H, float roughness)
         {
             float a = roughness*roughness;
@@ -151,11 +165,19 @@ namespace minire::rasterizer
         out vec2 bznkFragUv;
         {% endif %}
 
+        {% if kQuantized %}
+        in vec2 bznkNormal;
+        {% else %}
         in vec3 bznkNormal;
+        {% endif %}
         out vec3 bznkFragNormal;
 
         {% if kHasTangents %}
+        {% if kQuantized %}
+        in vec2 bznkTangent;
+        {% else %}
         in vec3 bznkTangent;
+        {% endif %}
         out mat3 bznkTbn;
         {% endif %}
 
@@ -163,22 +185,49 @@ namespace minire::rasterizer
 
         uniform mat4 bznkModel;
 
+        // see material::Program::preparePrimitive
+        uniform vec3 bznkPositionScale = vec3(1.0);
+        uniform vec3 bznkPositionOffset = vec3(0.0);
+
         {{ kUboDatablock }}
 
+        {% if kQuantized %}
+        // see utils::octEncode
+        vec3 octDecode(vec2 e)
+        {
+            vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+            if (v.z < 0.0)
+            {
+                v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0,
+                                                v.y >= 0.0 ? 1.0 : -1.0);
+            }
+            return normalize(v);
+        }
+        {% endif %}
+
         void main()
         {
-            bznkWorldPos = bznkModel * vec4(bznkVertex, 1.0);
+            vec3 position = bznkPositionOffset + bznkVertex * bznkPositionScale;
+            bznkWorldPos = bznkModel * vec4(position, 1.0);
             gl_Position = _viewProjection * bznkWorldPos;
 
             {% if kHasUvs %}
             bznkFragUv = bznkUv;
             {% endif %}
 
+            {% if kQuantized %}
+            vec3 N = normalize(vec3(bznkModel * vec4(octDecode(bznkNormal), 0.0)));
+            {% else %}
             vec3 N = normalize(vec3(bznkModel * vec4(bznkNormal, 0.0)));
+            {% endif %}
             bznkFragNormal = N;
 
             {% if kHasTangents %}
+            {% if kQuantized %}
+            vec3 T = normalize(vec3(bznkModel * vec4(octDecode(bznkTangent), 0.0)));
+            {% else %}
             vec3 T = normalize(vec3(bznkModel * vec4(bznkTangent, 0.0)));
+            {% endif %}
             T = normalize(T - dot(T, N) * N);
             vec3 B = cross(N, T);
             bznkTbn = mat3(T, B, N);
@@ -213,31 +262,37 @@ namespace minire::rasterizer
 
         uniform vec3 bznkAlbedoFactor = vec3(1.0, 1.0, 1.0);
         {% if kHasAlbedoTexture %}
-        uniform sampler2D bznkAlbedoTexture;
+        uniform sampler2DArray bznkAlbedoTexture;
+        uniform vec2 bznkAlbedoLayer = vec2(0.0, 0.0);
         {% endif %}
 
         uniform float bznkMetallicFactor = 1.0;
         {% if kHasMetallicTexture %}
-        uniform sampler2D bznkMetallicTexture;
+        uniform sampler2DArray bznkMetallicTexture;
+        uniform vec2 bznkMetallicLayer = vec2(0.0, 0.0);
         {% endif %}
 
         uniform float bznkRoughnessFactor = 1.0;
         {% if kHasRoughnessTexture %}
-        uniform sampler2D bznkRoughnessTexture;
+        uniform sampler2DArray bznkRoughnessTexture;
+        uniform vec2 bznkRoughnessLayer = vec2(0.0, 0.0);
         {% endif %}
 
         {% if kHasNormalTexture %}
-        uniform sampler2D bznkNormalTexture;
+        uniform sampler2DArray bznkNormalTexture;
+        uniform vec2 bznkNormalLayer = vec2(0.0, 0.0);
         uniform float bznkNormalScale = 1.0;
         {% endif %}
 
         {% if kHasAoTexture %}
-        uniform sampler2D bznkAoTexture;
+        uniform sampler2DArray bznkAoTexture;
+        uniform vec2 bznkAoLayer = vec2(0.0, 0.0);
         {% endif %}
         uniform float bznkAoStrength = 1.0;
 
         {% if kHasEmissiveTexture %}
-        uniform sampler2D bznkEmissiveTexture;
+        uniform sampler2DArray bznkEmissiveTexture;
+        uniform vec2 bznkEmissiveLayer = vec2(0.0, 0.0);
         {% endif %}
 
         uniform vec3 bznkEmissiveFactor = vec3(0.0, 0.0, 0.0);
@@ -254,30 +309,30 @@ namespace minire::rasterizer
         {
             vec3 albedo = bznkAlbedoFactor;
             {% if kHasAlbedoTexture %}
-            albedo *= pow(texture(bznkAlbedoTexture, bznkFragUv).rgb, vec3(2.2));
+            albedo *= pow(sampleLayer(bznkAlbedoTexture, bznkFragUv, bznkAlbedoLayer, vec4(1.0)).rgb, vec3(2.2));
             {% endif %}
 
             float metallic = bznkMetallicFactor;
             {% if kHasMetallicTexture %}
-            metallic *= texture(bznkMetallicTexture, bznkFragUv).{{ kMetallicTexComp }};
+            metallic *= sampleLayer(bznkMetallicTexture, bznkFragUv, bznkMetallicLayer, vec4(1.0)).{{ kMetallicTexComp }};
             {% endif %}
 
             float roughness = bznkRoughnessFactor;
             {% if kHasRoughnessTexture %}
-            roughness *= texture(bznkRoughnessTexture, bznkFragUv).{{ kRoughnessTexComp }};
+            roughness *= sampleLayer(bznkRoughnessTexture, bznkFragUv, bznkRoughnessLayer, vec4(1.0)).{{ kRoughnessTexComp }};
             {% endif %}
 
             {% if kHasNormalTexture and kHasTangents %}
             vec3 normal = normalMapping(
                 bznkTbn,
-                texture(bznkNormalTexture, bznkFragUv).rgb,
+                sampleLayer(bznkNormalTexture, bznkFragUv, bznkNormalLayer, vec4(0.5, 0.5, 1.0, 1.0)).rgb,
                 bznkNormalScale);
             {% else %}
             vec3 normal = bznkFragNormal;
             {% endif %}
 
             {% if kHasAoTexture %}
-            float sampledAo = texture(bznkAoTexture, bznkFragUv).{{ kAoTexComp }};
+            float sampledAo = sampleLayer(bznkAoTexture, bznkFragUv, bznkAoLayer, vec4(1.0)).{{ kAoTexComp }};
             float ao = (1.0 + bznkAoStrength * (sampledAo - 1.0));
             {% else %}
             float ao = bznkAoStrength;
@@ -285,7 +340,7 @@ namespace minire::rasterizer
 
             vec3 emissiveFactor = bznkEmissiveFactor;
             {% if kHasEmissiveTexture %}
-            emissiveFactor *= texture(bznkEmissiveTexture, bznkFragUv).rgb;
+            emissiveFactor *= sampleLayer(bznkEmissiveTexture, bznkFragUv, bznkEmissiveLayer, vec4(0.0)).rgb;
             {% endif %}
 
             bznkOutColor = pbrFragColor(albedo,
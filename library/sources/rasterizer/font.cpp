@@ -3,126 +3,146 @@
 #include <minire/errors.hpp>
 #include <minire/formats/bdf.hpp>
 #include <minire/logging.hpp>
-#include <opengl.hpp>
 
+#include <rasterizer/glyph-atlas.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cassert>
+#include <cstring>
 
 namespace minire::rasterizer
 {
-    Font::Font(formats::Bdf const & bdf)
-        : _texture(GL_TEXTURE_2D)
+    namespace
     {
-        auto const bbox = bdf.bbox();
-
-        // glyph parameters
-        _glyphWidth = bbox._w;
-        _glyphHeight = bbox._h;
-        
-        // allocate atlas
-        using AtlasPixel = uint8_t;
-        size_t atlasWidth = minimalSide(bdf.loadedChars());
-        size_t atlasHeight = atlasWidth;
-        size_t atlasBytes = atlasWidth * atlasHeight * sizeof(AtlasPixel);
-        std::vector<AtlasPixel> atlasPixels(atlasBytes, 0);
-
-        size_t stX = 0, stY = 0;
-        _uvMapping.resize(bdf.maxEncoding() + 1,
-                          std::make_pair(false, utils::Rect()));
-        for(size_t i = 0; i <= bdf.maxEncoding(); ++i)
+        // 8 pixels (0x00 or 0xFF) for a byte of bits, MSB is the left one
+        constexpr std::array<uint64_t, 256> kExpanded = []
         {
-            auto const & glyph = bdf.find(i);
-            if (!glyph.loaded()) continue;
-
-            glyph.render<AtlasPixel, 0xFF, 0x00>(atlasPixels.data(),
-                                                 atlasWidth,
-                                                 atlasHeight,
-                                                 stX, stY);
-
-            /*
-            Rect uvRect((float(stX) - .5) * float(atlasWidth),
-                        (float(stY) - .5) * float(atlasHeight),
-                        (float(stX + bbox._w - 1) + .5) * float(atlasWidth),
-                        (float(stY + bbox._h - 1) + .5) * float(atlasHeight));
-            */
-            utils::Rect uvRect(stX, stY,
-                               stX + bbox._w - 1,
-                               stY + bbox._h - 1);
-            _uvMapping[i] = std::make_pair(true, uvRect);
-
-            stX += bbox._w;
-            if (stX + bbox._w > atlasWidth)
+            std::array<uint64_t, 256> expanded{};
+            for(size_t bits = 0; bits < 256; ++bits)
             {
-                stX = 0;
-                stY += bbox._h;
-                if (stY + bbox._h > atlasHeight)
+                std::array<uint8_t, 8> pixels{};
+                for(size_t x = 0; x < 8; ++x)
                 {
-                    MINIRE_THROW("bad dimension stX = {}, stY = {}, atlas {}x{}, font {}x{}",
-                                 stX, stY, atlasWidth, atlasHeight, bbox._w, bbox._h);
+                    pixels[x] = (bits & (0x80 >> x)) ? 0xFF : 0x00;
                 }
+                expanded[bits] = std::bit_cast<uint64_t>(pixels);
             }
-        }
+            return expanded;
+        }();
+    }
 
-        // load atlas into GPU
-        _texture.bind();
-        MINIRE_GL(glTexStorage2D, GL_TEXTURE_2D, 1, GL_R8, atlasWidth, atlasHeight);
-        MINIRE_GL(glTexSubImage2D, GL_TEXTURE_2D, 0, 0, 0, atlasWidth, atlasHeight,
-                  GL_RED, GL_UNSIGNED_BYTE, atlasPixels.data());
+    Font::Font(formats::Bdf const & bdf,
+               std::shared_ptr<GlyphAtlas> atlas)
+        : _atlas(std::move(atlas))
+    {
+        MINIRE_INVARIANT(_atlas, "font w/o an atlas: {}", bdf.filename());
 
-        // texture parameters
-        _texture.parameteri(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        _texture.parameteri(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        _texture.parameteri(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        _texture.parameteri(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        auto const bbox = bdf.bbox();
 
-        MINIRE_DEBUG("texture for {}: {} ({}x{})",
-                     bdf.filename(), _texture.id(), atlasWidth, atlasHeight);
-    }
+        // glyph parameters
+        _glyphWidth = bbox._w;
+        _glyphHeight = bbox._h;
+        _pixels.resize(_glyphWidth * _glyphHeight);
 
-    size_t Font::minimalSide(size_t chars) const
-    {
-        static constexpr int kMax = 18;
+        MINIRE_INVARIANT(_atlas->glyphSize() == glyphSize(),
+                         "font {} doesn't fit the atlas", bdf.filename());
+        _atlasFont = _atlas->registerFont();
 
-        int i;
-        for(i = 0; i < kMax; ++i)
+        _glyphs.reserve(bdf.loadedChars());
+        for(auto const & glyph : bdf.chars())
         {
-            size_t const side = size_t(1) << i;
-
-            size_t const charsPerVert = side / _glyphWidth;
-            size_t const charsPerHoriz = side / _glyphHeight;
-            if (charsPerVert * charsPerHoriz >= chars)
+            size_t const i = glyph.encoding();
+
+            size_t const width = std::min(glyph.bbox()._w, _glyphWidth);
+            size_t const height = std::min(glyph.bbox()._h, _glyphHeight);
+            size_t const stride = (width + 7) / 8;
+
+            _glyphs.push_back(Glyph{_bits.size(),
+                                    static_cast<uint16_t>(width),
+                                    static_cast<uint16_t>(height)});
+            _bits.resize(_bits.size() + stride * height, 0);
+
+            // BDF rows are already MSB first and padded to bytes,
+            // only clipped pixels need to be dropped
+            uint8_t const tailMask = 0xFF << ((8 - width % 8) % 8);
+            uint8_t * bits = _bits.data() + _glyphs.back()._offset;
+            for(size_t y = 0; y < height; ++y)
             {
-                break;
+                uint8_t * row = bits + y * stride;
+                std::memcpy(row, glyph.row(y), stride);
+                if (stride) row[stride - 1] &= tailMask;
             }
-        }
 
-        if (i == kMax)
-        {
-            MINIRE_THROW("too large atlas: {}, {}x{}",
-                         chars, _glyphWidth, _glyphHeight);
+            size_t const block = i >> kBlockBits;
+            if (block >= _table.size()) _table.resize(block + 1);
+            if (!_table[block])
+            {
+                _table[block] = std::make_unique<Block>();
+                _table[block]->fill(0);
+            }
+            (*_table[block])[i % kBlockSize] = _glyphs.size();
         }
 
-        return 1 << i;
+        MINIRE_DEBUG("font {}: {} glyphs, {} bytes of bitmaps",
+                     bdf.filename(), _glyphs.size(), _bits.size());
     }
 
-    void Font::bind() const
-    {
-        _texture.bind();
-    }
+    Font::~Font() = default;
 
-    utils::Rect const & Font::uvRect(size_t codePoint, size_t fallback) const
+    Font::Glyph const * Font::find(size_t codePoint) const
     {
-        return uvRect(loaded(codePoint) ? codePoint : fallback);
+        size_t const block = codePoint >> kBlockBits;
+        if (block >= _table.size() || !_table[block]) return nullptr;
+
+        uint32_t const index = (*_table[block])[codePoint % kBlockSize];
+        return index ? &_glyphs[index - 1] : nullptr;
     }
 
-    utils::Rect const & Font::uvRect(size_t codePoint) const
+    uint32_t Font::glyph(size_t codePoint, size_t fallback) const
     {
-        assert(loaded(codePoint));
-        return _uvMapping[codePoint].second;
+        Glyph const * glyph = find(codePoint);
+        if (!glyph)
+        {
+            codePoint = fallback;
+            glyph = find(codePoint);
+        }
+        if (!glyph)
+        {
+            codePoint = 0; // see Fonts::get
+            glyph = find(codePoint);
+        }
+        MINIRE_INVARIANT(glyph, "no glyph for {}", codePoint);
+
+        GlyphAtlas::Key const key = (GlyphAtlas::Key(_atlasFont) << 32) | codePoint;
+        if (auto index = _atlas->find(key)) return *index;
+
+        render(*glyph, _pixels.data());
+        return _atlas->insert(key, _pixels.data());
     }
 
-    bool Font::loaded(size_t codePoint) const
+    void Font::render(Glyph const & glyph, uint8_t * pixels) const
     {
-        return codePoint < _uvMapping.size()
-            && _uvMapping[codePoint].first;
+        std::fill(pixels, pixels + _glyphWidth * _glyphHeight, 0x00);
+
+        size_t const stride = (glyph._width + 7) / 8;
+        uint8_t const * bits = _bits.data() + glyph._offset;
+        for(size_t y = 0; y < glyph._height; ++y)
+        {
+            uint8_t const * row = bits + y * stride;
+            uint8_t * out = pixels + y * _glyphWidth;
+
+            // 8 pixels per a byte of bits
+            size_t x = 0;
+            for(; x + 8 <= glyph._width; x += 8)
+            {
+                std::memcpy(out + x, &kExpanded[row[x / 8]], 8);
+            }
+            if (x < glyph._width)
+            {
+                std::memcpy(out + x, &kExpanded[row[x / 8]], glyph._width - x);
+            }
+        }
     }
 }
@@ -1,23 +1,28 @@
 #pragma once
 
-#include <minire/utils/rect.hpp>
-
-#include <opengl/texture.hpp>
-
 #include <glm/vec2.hpp>
 
+#include <array>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <vector>
-#include <utility>
 
 namespace minire::formats { class Bdf; }
 
 namespace minire::rasterizer
 {
+    class GlyphAtlas;
+
+    // Keeps 1-bit bitmaps of glyphs in a two-level sparse table by code
+    // point, and rasterizes them into the atlas on the first use.
     class Font
     {
     public:
-        explicit Font(formats::Bdf const & bdf);
+        explicit Font(formats::Bdf const & bdf,
+                      std::shared_ptr<GlyphAtlas> atlas);
+
+        ~Font();
 
         size_t glyphWidth() const { return _glyphWidth; }
 
@@ -25,25 +30,42 @@ namespace minire::rasterizer
 
         glm::vec2 glyphSize() const { return glm::vec2(_glyphWidth, _glyphHeight); }
 
-        // NOTE: safe to for any codePoint
-        utils::Rect const & uvRect(size_t codePoint, size_t fallback) const;
+        // Index of a glyph in the atlas, it's rasterized if needed
+        // (safe to for any codePoint)
+        uint32_t glyph(size_t codePoint, size_t fallback) const;
 
-        void bind() const;
+        GlyphAtlas & atlas() const { return *_atlas; }
 
-        bool loaded(size_t codePoint) const;
+        bool loaded(size_t codePoint) const { return find(codePoint); }
 
     private:
-        size_t minimalSide(size_t chars) const;
+        struct Glyph
+        {
+            size_t   _offset; // in _bits
+            uint16_t _width;
+            uint16_t _height;
+        };
 
-        // NOTE: UB in case of codePoint not loaded
-        utils::Rect const & uvRect(size_t codePoint) const;
+        static constexpr size_t kBlockBits = 8;
+        static constexpr size_t kBlockSize = size_t(1) << kBlockBits;
 
-    private:
-        using UvMapping = std::vector<std::pair<bool, utils::Rect>>;
+        // glyph's index + 1, or 0 if there is no glyph
+        using Block = std::array<uint32_t, kBlockSize>;
+        using Table = std::vector<std::unique_ptr<Block>>;
+
+        Glyph const * find(size_t codePoint) const;
 
-        opengl::Texture _texture;
-        size_t          _glyphWidth;    // in pixels
-        size_t          _glyphHeight;   // in pixels
-        UvMapping       _uvMapping;     // char code to UVs
+        void render(Glyph const &, uint8_t * pixels) const;
+
+    private:
+        std::shared_ptr<GlyphAtlas> _atlas;
+        uint32_t                    _atlasFont;     // the font in the atlas
+        size_t                      _glyphWidth;    // in pixels
+        size_t                      _glyphHeight;   // in pixels
+        Table                       _table;         // by codePoint >> kBlockBits
+        std::vector<Glyph>          _glyphs;
+        std::vector<uint8_t>        _bits;          // rows, padded to bytes
+
+        mutable std::vector<uint8_t> _pixels;       // to rasterize into
     };
 }
@@ -1,6 +1,7 @@
 #include <rasterizer/fonts.hpp>
 
 #include <rasterizer/font.hpp>
+#include <rasterizer/glyph-atlas.hpp>
 
 #include <minire/content/manager.hpp>
 #include <minire/errors.hpp>
@@ -30,10 +31,11 @@ namespace minire::rasterizer
         {
             auto lease = _contentManager.borrow(fontId);
             assert(lease);
-            formats::Bdf::Sptr const & bdf = lease->as<formats::Bdf::Sptr>();
+            formats::Bdf::Sptr const & bdf = lease.as<formats::Bdf::Sptr>();
             if (!bdf) MINIRE_THROW("bdf is a nullptr: {}", fontId);
             bdf->fillChar(0, 0);
-            auto nit = _fonts.emplace(fontId, std::make_shared<Font>(*bdf));
+            auto nit = _fonts.emplace(fontId, std::make_shared<Font>(
+                *bdf, atlas(bdf->bbox()._w, bdf->bbox()._h)));
             MINIRE_INVARIANT(nit.second, "failed to save cached Font");
             MINIRE_INFO("Loading font: {}", fontId);
             assert(nit.first->second);
@@ -43,4 +45,14 @@ namespace minire::rasterizer
         assert(it->second);
         return it->second;
     }
+
+    std::shared_ptr<GlyphAtlas> Fonts::atlas(size_t width, size_t height) const
+    {
+        auto & atlas = _atlases[std::make_pair(width, height)];
+        if (!atlas)
+        {
+            atlas = std::make_shared<GlyphAtlas>(width, height);
+        }
+        return atlas;
+    }
 }
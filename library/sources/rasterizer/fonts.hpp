@@ -2,14 +2,18 @@
 
 #include <minire/content/id.hpp>
 
+#include <cstddef>
+#include <map>
 #include <memory>
 #include <unordered_map>
+#include <utility>
 
 namespace minire::content { class Manager; }
 
 namespace minire::rasterizer
 {
     class Font;
+    class GlyphAtlas;
 
     class Fonts
     {
@@ -19,11 +23,18 @@ namespace minire::rasterizer
 
         std::shared_ptr<Font const> get(content::Id const &) const;
 
+    private:
+        std::shared_ptr<GlyphAtlas> atlas(size_t width, size_t height) const;
+
     private:
         using Cache = std::unordered_map<content::Id,
                                          std::shared_ptr<Font>>;
+        // fonts of the same glyph size share an atlas
+        using Atlases = std::map<std::pair<size_t, size_t>,
+                                 std::shared_ptr<GlyphAtlas>>;
 
         content::Manager & _contentManager;
         mutable Cache      _fonts;
+        mutable Atlases    _atlases;
     };
 }
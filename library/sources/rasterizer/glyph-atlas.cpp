@@ -0,0 +1,124 @@
+#include <rasterizer/glyph-atlas.hpp>
+
+#include <minire/errors.hpp>
+#include <minire/logging.hpp>
+
+#include <opengl.hpp>
+
+#include <cassert>
+
+namespace minire::rasterizer
+{
+    GlyphAtlas::GlyphAtlas(size_t glyphWidth, size_t glyphHeight)
+        : _texture(GL_TEXTURE_2D_ARRAY)
+        , _glyphWidth(glyphWidth)
+        , _glyphHeight(glyphHeight)
+        , _slotsPerRow(glyphWidth ? kPageSide / glyphWidth : 0)
+        , _slotsPerPage(glyphHeight ? _slotsPerRow * (kPageSide / glyphHeight) : 0)
+    {
+        MINIRE_INVARIANT(_slotsPerPage > 0,
+                         "bad glyph size for an atlas: {}x{}",
+                         glyphWidth, glyphHeight);
+        MINIRE_INVARIANT(_slotsPerPage * kMaxPages <= (1u << 24),
+                         "too many glyphs in an atlas: {}x{}",
+                         glyphWidth, glyphHeight);
+
+        _texture.bind();
+        MINIRE_GL(glTexStorage3D, GL_TEXTURE_2D_ARRAY, 1, GL_R8,
+                  kPageSide, kPageSide, kMaxPages);
+
+        _texture.parameteri(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        _texture.parameteri(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        _texture.parameteri(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        _texture.parameteri(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        _pages.reserve(kMaxPages);
+        _pages.emplace_back();
+
+        MINIRE_DEBUG("glyph atlas {}x{}: {} ({} pages of {} glyphs)",
+                     glyphWidth, glyphHeight, _texture.id(),
+                     kMaxPages, _slotsPerPage);
+    }
+
+    std::optional<uint32_t> GlyphAtlas::find(Key key)
+    {
+        auto it = _index.find(key);
+        if (it == _index.cend()) return std::nullopt;
+
+        _pages[it->second / _slotsPerPage]._lastUse = ++_clock;
+        return it->second;
+    }
+
+    void GlyphAtlas::touch(Pages pages)
+    {
+        if (0 == pages) return;
+
+        ++_clock;
+        for(size_t i(0); i < _pages.size(); ++i)
+        {
+            if (pages & (Pages(1) << i)) _pages[i]._lastUse = _clock;
+        }
+    }
+
+    uint32_t GlyphAtlas::insert(Key key, uint8_t const * pixels)
+    {
+        assert(_index.find(key) == _index.cend());
+
+        if (_pages[_current]._keys.size() >= _slotsPerPage)
+        {
+            _current = allocatePage();
+        }
+
+        Page & page = _pages[_current];
+        size_t const slot = page._keys.size();
+        page._keys.push_back(key);
+        page._lastUse = ++_clock;
+
+        uint32_t const index = _current * _slotsPerPage + slot;
+        _index.emplace(key, index);
+
+        _texture.bind();
+        MINIRE_GL(glPixelStorei, GL_UNPACK_ALIGNMENT, 1);
+        MINIRE_GL(glTexSubImage3D, GL_TEXTURE_2D_ARRAY, 0,
+                  (slot % _slotsPerRow) * _glyphWidth,
+                  (slot / _slotsPerRow) * _glyphHeight,
+                  _current,
+                  _glyphWidth, _glyphHeight, 1,
+                  GL_RED, GL_UNSIGNED_BYTE, pixels);
+        MINIRE_GL(glPixelStorei, GL_UNPACK_ALIGNMENT, 4);
+
+        return index;
+    }
+
+    size_t GlyphAtlas::allocatePage()
+    {
+        if (_pages.size() < kMaxPages)
+        {
+            _pages.emplace_back();
+            return _pages.size() - 1;
+        }
+
+        size_t lru = 0;
+        for(size_t i(1); i < _pages.size(); ++i)
+        {
+            if (_pages[i]._lastUse < _pages[lru]._lastUse) lru = i;
+        }
+
+        for(Key key : _pages[lru]._keys)
+        {
+            _index.erase(key);
+        }
+        _pages[lru]._keys.clear();
+        ++_evictions;
+
+        MINIRE_DEBUG("glyph atlas {}x{}: page {} evicted",
+                     _glyphWidth, _glyphHeight, lru);
+
+        return lru;
+    }
+
+    void GlyphAtlas::bind() const
+    {
+        _texture.bind();
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <opengl/texture.hpp>
+
+#include <glm/vec2.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace minire::rasterizer
+{
+    // Glyphs of a single size, rasterized on demand into fixed cells
+    // of pages of a GL_TEXTURE_2D_ARRAY. If there is no room left,
+    // the least recently used page is evicted as a whole.
+    class GlyphAtlas
+    {
+    public:
+        using Key = uint64_t; // (font << 32) | code point
+        using Pages = uint32_t; // a bit per page
+
+        static constexpr size_t kPageSide = 512;  // in pixels
+        static constexpr size_t kMaxPages = 16;
+        static_assert(kMaxPages <= sizeof(Pages) * 8);
+
+        explicit GlyphAtlas(size_t glyphWidth, size_t glyphHeight);
+
+    public:
+        // a new identifier of a font that shares the atlas
+        uint32_t registerFont() { return _fonts++; }
+
+        // index of a glyph: page * slotsPerPage() + slot, where slots
+        // are laid out row-major by slotsPerRow() in a row
+        std::optional<uint32_t> find(Key key);
+
+        // glyphWidth x glyphHeight pixels, one byte each
+        uint32_t insert(Key key, uint8_t const * pixels);
+
+        // pages of glyphs which are in use (i.e. drawn) are the most recent,
+        // so they aren't evicted while the atlas is looked up by others
+        void touch(Pages pages);
+
+        // a bit of a page a glyph is in
+        Pages pageOf(uint32_t index) const { return Pages(1) << (index / _slotsPerPage); }
+
+        // incremented on every eviction, indices got before are invalid
+        size_t evictions() const { return _evictions; }
+
+    public:
+        glm::vec2 glyphSize() const { return glm::vec2(_glyphWidth, _glyphHeight); }
+
+        size_t slotsPerRow() const { return _slotsPerRow; }
+
+        size_t slotsPerPage() const { return _slotsPerPage; }
+
+        void bind() const;
+
+    private:
+        struct Page
+        {
+            size_t           _lastUse = 0;
+            std::vector<Key> _keys;   // a key per used slot
+        };
+
+        size_t allocatePage();
+
+    private:
+        opengl::Texture                   _texture;
+        size_t                            _glyphWidth;
+        size_t                            _glyphHeight;
+        size_t                            _slotsPerRow;
+        size_t                            _slotsPerPage;
+        std::vector<Page>                 _pages;
+        size_t                            _current = 0; // being filled
+        size_t                            _clock = 0;   // of uses
+        size_t                            _evictions = 0;
+        uint32_t                          _fonts = 0;
+        std::unordered_map<Key, uint32_t> _index;
+    };
+}
@@ -8,18 +8,11 @@
 
 #include <rasterizer/font.hpp>
 #include <rasterizer/fonts.hpp>
-#include <opengl.hpp>
-#include <opengl/program.hpp>
-#include <opengl/shader.hpp>
-#include <opengl/vao.hpp>
-#include <opengl/vbo.hpp>
-#include <utils/sparse-range.hpp>
-
-#include <glm/gtc/type_ptr.hpp> // for gln::value_ptr
+#include <rasterizer/glyph-atlas.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
-#include <limits>
 
 namespace minire::rasterizer
 {
@@ -34,346 +27,50 @@ namespace minire::rasterizer
         }
     }
 
-    static const char * kVertShader = R"(
-        #version 330 core
-
-        layout(location = 0) in vec2 bznkPos;
-        layout(location = 1) in vec2 bznkUv;
-        layout(location = 2) in vec4 bznkFgColor;
-        layout(location = 3) in vec4 bznkBgColor;
-        layout(location = 4) in uint bznkFont;
-
-        uniform mat4 bznkProj;
-        uniform vec2 bznkPosition;
-
-        out vec2 bznkFragPos;
-        out vec2 bznkFragUv;
-        flat out vec4 bznkFragFgColor;
-        flat out vec4 bznkFragBgColor;
-        flat out uint bznkFragFont;
-
-        void main()
-        {
-            gl_Position = bznkProj *
-                          vec4(bznkPosition + bznkPos, 0.0, 1.0);
-            bznkFragUv = bznkUv;
-            bznkFragFgColor = bznkFgColor;
-            bznkFragBgColor = bznkBgColor;
-            bznkFragFont = bznkFont;
-        }
-    )";
-
-    static const char * kFragShader = R"(
-        #version 330 core
-
-        in vec2 bznkFragPos;
-        in vec2 bznkFragUv;
-        flat in vec4 bznkFragFgColor;
-        flat in vec4 bznkFragBgColor;
-        flat in uint bznkFragFont;
-
-        uniform sampler2D bznkFonts[3];
-
-        out vec4 bznkOutColor;
-
-        void main()
-        {
-            ivec2 offset = ivec2(bznkFragUv);
-            float fgFactor = texelFetch(bznkFonts[bznkFragFont], offset, 0).r;
+    Label::Label(Fonts const & fonts,
+                 int z, bool visible)
+        : _fonts(fonts)
+        , _symbols()
+        , _position(0.0)
+        , _zOrder(z)
+        , _visible(visible)
+    {}
 
-            //float fgFactor = texture(bznkFonts[bznkFragFont], bznkFragUv).r;
-            float bgFactor = 1.0 - fgFactor;
-            bznkOutColor = bznkFragBgColor * bgFactor
-                         + bznkFragFgColor * fgFactor;
-        }
-    )";
+    Label::~Label() = default;
 
-    class Label::Program
+    void Label::setVisible(bool v)
     {
-    public:
-        Program()
-            : _program({
-                std::make_shared<opengl::Shader>(GL_VERTEX_SHADER, kVertShader),
-                std::make_shared<opengl::Shader>(GL_FRAGMENT_SHADER, kFragShader)
-            })
-            , _fontsUniform(_program.getUniformLocation("bznkFonts"))
-            , _projUniform(_program.getUniformLocation("bznkProj"))
-            , _positionUniform(_program.getUniformLocation("bznkPosition"))
-        {}
-
-        void use() const { _program.use(); }
-
-        void setFontsUniform(std::array<GLint, 3> const & v) const
-        {
-            MINIRE_GL(glUniform1iv, _fontsUniform, v.size(), v.data());
-        }
-
-        void setProjUniform(glm::mat4 const & m) const
+        if (_visible != v)
         {
-            MINIRE_GL(glUniformMatrix4fv, _projUniform, 1, GL_FALSE, glm::value_ptr(m));
-        }
-
-        void setPositionUniform(glm::vec2 const & v) const
-        {
-            MINIRE_GL(glUniform2f, _positionUniform, v.x, v.y);
-        }
-
-    public:
-        static Program const & instance()
-        {
-            static const Program kProgram;
-            return kProgram;
+            _visible = v;
+            _relayout = true;
         }
+    }
 
-    private:
-        opengl::Program _program;
-        GLint           _fontsUniform;
-        GLint           _projUniform;
-        GLint           _positionUniform;
-    };
-
-    // NOTE: Clients must align data elements consistent with the 
-    //       requirements of the client platform, with an additional
-    //       base-level requirement that an offset within a buffer to
-    //       a datum comprising N be a multiple of N.        
-    struct Vertex
+    void Label::setZOrder(size_t z)
     {
-        glm::vec2 _pos;
-        glm::vec2 _uv;
-        glm::vec4 _fgColor;
-        glm::vec4 _bgColor;
-        uint32_t  _font;
-    };
-
-    class Label::Buffer
-    {
-        void setupSymbol(size_t disp,
-                         float gx, float gy,
-                         float gw, float gh,
-                         text::Symbol const & symbol,
-                         Font const & font,
-                         uint32_t fontCode,
-                         bool const isCursor,
-                         std::vector<Vertex> & out)
-        {
-            utils::Rect /*const &*/ uv = font.uvRect(symbol.codePoint(), L'?');
-
-            if (true) // TODO: move that into rasterizer::Font::Font
-            {
-                uv._left += .5f;
-                uv._right += .5f;
-                uv._top += .5f;
-                uv._bottom += .5f;
-            }
-
-            glm::vec4 fg = symbol.foreground();
-            glm::vec4 bg = symbol.background();
-
-            if (symbol.blank())
-            {
-                bg = fg = glm::vec4(0);
-            }
-            else
-            {
-                /*
-                    inv cur | res
-                    --------+----
-                     0   0  |  0
-                     0   1  |  1
-                     1   0  |  1
-                     1   1  |  0
-                */
-                if (symbol.invertColors() != isCursor)
-                {
-                    std::swap(fg.x, bg.x);
-                    std::swap(fg.y, bg.y);
-                    std::swap(fg.z, bg.z);
-                    if (isCursor) fg.w = bg.w = 1.0f;
-                }
-            }
-
-            //gx -= .5f;
-            //gy -= .5f;
-            gw -= .5f;
-            gh -= .5f;
-
-            out[disp + 0] = Vertex{ glm::vec2(gx, gy + gh),
-                                    glm::vec2(uv._left, uv._top),
-                                    fg, bg, fontCode};
-            out[disp + 1] = Vertex{ glm::vec2(gx, gy), 
-                                    glm::vec2(uv._left, uv._bottom),
-                                    fg, bg, fontCode};
-            out[disp + 2] = Vertex{ glm::vec2(gx + gw, gy),
-                                    glm::vec2(uv._right, uv._bottom),
-                                    fg, bg, fontCode};
-            out[disp + 3] = Vertex{ glm::vec2(gx, gy + gh),
-                                    glm::vec2(uv._left, uv._top),
-                                    fg, bg, fontCode};
-            out[disp + 4] = Vertex{ glm::vec2(gx + gw, gy),
-                                    glm::vec2(uv._right, uv._bottom),
-                                    fg, bg, fontCode};
-            out[disp + 5] = Vertex{ glm::vec2(gx + gw, gy + gh),
-                                    glm::vec2(uv._right, uv._top),
-                                    fg, bg, fontCode};
-        }
-
-        std::pair<size_t, size_t> // in byte (first, past-the-end)
-        update(Symbols const & symbols,
-               Dirty const & /*dirty*/,
-               Font const & fontRegular,
-               Font const & fontBold,
-               Font const & fontItalic,
-               Label::Cursor const & cursor,
-               glm::vec2 const & glyphSize,
-               size_t const col,
-               size_t const row)
-        {
-            size_t const disp = col * 6 + row * 6 * symbols.cols();
-
-            text::Symbol const & symbol = symbols.at(row, col);
-            size_t const gw = glyphSize.x;
-            size_t const gh = glyphSize.y;
-
-            bool const isCursor = cursor._shown
-                               && cursor._row == row
-                               && cursor._column == col;
-
-            size_t const fontCode = fontCodeOf(symbol);
-            Font const * font = &fontRegular;
-            if (symbol.bold() && fontBold.loaded(symbol.codePoint()))
-                font = &fontBold;
-            if (symbol.italic() && fontItalic.loaded(symbol.codePoint()))
-                font = &fontItalic;
-
-            setupSymbol(disp, col * gw, row * gh, gw, gh,
-                        symbol, *font, fontCode, isCursor,
-                        _vertices);
-
-            return std::make_pair(disp * sizeof(Vertex),
-                                  (disp + 6) * sizeof(Vertex));
-        }
-
-        static size_t fontCodeOf(text::Symbol const & s)
+        if (_zOrder != z)
         {
-            if (s.bold()) return 1;
-            if (s.italic()) return 2;
-            return 0;
+            _zOrder = z;
+            _relayout = true;
         }
-
-    public:
-        void update(Symbols const & symbols,
-                    Dirty const & dirty,
-                    Font const & fontRegular,
-                    Font const & fontBold,
-                    Font const & fontItalic,
-                    Label::Cursor const & cursor,
-                    glm::vec2 const & glyphSize)
-        {
-            size_t const rows = symbols.rows();
-            size_t const cols = symbols.cols();
-            size_t required = rows * cols * 6 * sizeof(Vertex);
-
-            _vao->bind();
-            assert(std::numeric_limits<GLsizeiptr>::max() > required);
-            if (static_cast<GLsizeiptr>(required) != _vbo.size())
-            {   // size changed, rebuild whole buffer
-                _vertices.resize(rows * cols * 6);
-                for(size_t col(0); col < cols; ++col)
-                for(size_t row(0); row < rows; ++row)
-                {
-                    update(symbols, dirty,
-                           fontRegular, fontBold, fontItalic,
-                           cursor, glyphSize, col, row);
-                }
-
-                // TODO: maybe reuse existing VBO if it is large enough
-                _vbo.bufferData(required, _vertices.data(), GL_STATIC_DRAW);
-            }
-            else if (!dirty.empty())
-            {   // size not changed, just update dirties
-                utils::SparseRange<size_t> updates; // in bytes
-                for (auto const & d: dirty)
-                {
-                    auto range = update(symbols, dirty, 
-                                        fontRegular, fontBold, fontItalic,
-                                        cursor, glyphSize, d.second, d.first);
-                    updates.insert(range.first, range.second);
-                }
-                for(auto const & range : updates.tighten())
-                {
-                    assert(range.first < range.second);
-                    size_t const offset = range.first;
-                    size_t const size = range.second - range.first;
-                    _vbo.bufferSubData(offset, size,
-                        reinterpret_cast<uint8_t*>(_vertices.data()) + offset);
-                }
-            }
-        }
-
-        void draw() const
-        {
-            _vao->bind();
-            _vbo.bind();
-            MINIRE_GL(glDrawArrays, GL_TRIANGLES, 0, _vertices.size());
-        }
-
-        Buffer()
-            : _vao(std::make_shared<opengl::VAO>())
-            , _vbo(_vao, GL_ARRAY_BUFFER)
-        {
-            size_t const stride = sizeof(Vertex);
-            size_t pointer = 0;
-
-           // layout(location = 0) in vec2 bznkPos;
-            _vao->enableAttrib(0);
-            _vao->attribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, pointer);
-            pointer += sizeof(Vertex::_pos);
-
-            // layout(location = 1) in vec2 bznkUv;
-            _vao->enableAttrib(1);
-            _vao->attribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, pointer);
-            pointer += sizeof(Vertex::_uv);
-
-            // layout(location = 2) in vec4 bznkFgColor;
-            _vao->enableAttrib(2);
-            _vao->attribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, pointer);
-            pointer += sizeof(Vertex::_fgColor);
-
-            // layout(location = 3) in vec4 bznkBgColor;
-            _vao->enableAttrib(3);
-            _vao->attribPointer(3, 4, GL_FLOAT, GL_FALSE, stride, pointer);
-            pointer += sizeof(Vertex::_bgColor);
-
-            // layout(location = 4) in uint bznkFont;
-            _vao->enableAttrib(4);
-            _vao->attribIPointer(4, 1, GL_UNSIGNED_INT, stride, pointer);
-            pointer += sizeof(Vertex::_font);
-        }
-
-    private:
-        opengl::VAO::Sptr   _vao;
-        opengl::VBO         _vbo;
-        std::vector<Vertex> _vertices;
-    };
-
-    Label::Label(Fonts const & fonts,
-                 int z, bool visible)
-        : Drawable(z)
-        , _fonts(fonts)
-        , _symbols()
-        , _position(0.0)
-        , _program(Program::instance())
-        , _buffer(std::make_unique<Buffer>())
-        , _invalidated(true)
-        , _visible(visible)
-    {}
-
-    Label::~Label() = default;
+    }
 
     void Label::resize(size_t rows, size_t cols)
     {
+        MINIRE_INVARIANT(rows <= kMaxSide && cols <= kMaxSide,
+                         "too large label: {}x{}", rows, cols);
+        if (_top > 0)
+        {   // unroll the ring
+            text::PackedSymbol * begin = _symbols.row(0);
+            std::rotate(begin, _symbols.row(_top), begin + _symbols.size());
+            _top = 0;
+        }
+
         _symbols.resize(rows, cols);
-        _invalidated = true;
+        _dirty.resize(rows, cols);
+        _rebuild = true;
+        _relayout = true;
     }
 
     void Label::setFont(content::Id const & fontName,
@@ -381,7 +78,7 @@ namespace minire::rasterizer
     {
         auto lease = contentManager.borrow(fontName);
         assert(lease);
-        setFont(lease->as<models::Font>());
+        setFont(lease.as<models::Font>());
     }
 
     void Label::setFont(models::Font const & fontData)
@@ -407,40 +104,15 @@ namespace minire::rasterizer
                          fontData._regular, fontData._italic);
         }
 
+        // guaranteed by rasterizer::Fonts for fonts of the same size
+        assert(&_fontRegular->atlas() == &_fontBold->atlas());
+        assert(&_fontRegular->atlas() == &_fontItalic->atlas());
+
         assert(fontData._glyphWidth == _glyphSize.x);
         assert(fontData._glyphHeight == _glyphSize.y);
-    }
-
-    void Label::draw(glm::mat4 const & projection) const
-    {
-        static const std::array<GLint, 3> kTextureUnits{0, 1, 2};
-
-        if (_invalidated)
-        {
-            revalidate();
-        }
-
-        assert(_buffer);
-        assert(_fontRegular);
-        assert(_fontBold);
-        assert(_fontItalic);
-
-        _program.use();
-
-        MINIRE_GL(glActiveTexture, GL_TEXTURE0);
-        _fontRegular->bind();
 
-        MINIRE_GL(glActiveTexture, GL_TEXTURE1);
-        _fontBold->bind();
-
-        MINIRE_GL(glActiveTexture, GL_TEXTURE2);
-        _fontItalic->bind();
-
-        _program.setFontsUniform(kTextureUnits);
-        _program.setProjUniform(projection);
-        _program.setPositionUniform(_position);
-
-        _buffer->draw();
+        _rebuild = true;
+        _relayout = true;
     }
 
     void Label::set(size_t row, size_t col,
@@ -475,64 +147,346 @@ namespace minire::rasterizer
                 return;
             }
 
-            at(row, col).set(i.first, i.second);
+            set(row, col, i.first, i.second);
             ++col;
         }
     }
 
+    void Label::set(size_t row, size_t col,
+                    text::PackedSymbol const & symbol)
+    {
+        row = physical(row);
+        text::PackedSymbol & target = _symbols.at(row, col);
+        if (target != symbol)
+        {
+            target = symbol;
+            _dirty.set(row, col);
+        }
+    }
+
+    void Label::set(size_t row, size_t col,
+                    text::Symbol const & symbol)
+    {
+        text::PackedSymbol packed = pack(symbol, symbol.codePoint());
+        packed.blank(symbol.blank());
+        set(row, col, packed);
+    }
+
+    void Label::set(size_t row, size_t col,
+                    text::TextFormat const & format, wchar_t c)
+    {
+        set(row, col, pack(format, c));
+    }
+
+    void Label::unset(size_t row, size_t col)
+    {
+        text::PackedSymbol symbol = at(row, col);
+        if (!symbol.blank())
+        {
+            symbol.unset();
+            set(row, col, symbol);
+        }
+    }
+
+    void Label::setPalette(size_t first, std::vector<glm::vec4> const & colors)
+    {
+        _palette.set(first, colors);
+        _rebuild = true;
+    }
+
+    text::PackedSymbol Label::pack(text::TextFormat const & format, wchar_t c)
+    {
+        auto fg = _palette.intern(format.foreground());
+        auto bg = _palette.intern(format.background());
+        if (!fg || !bg)
+        {
+            compactPalette();
+            fg = _palette.intern(format.foreground());
+            bg = _palette.intern(format.background());
+            MINIRE_INVARIANT(fg && bg, "too many true colors in a label");
+        }
+
+        text::PackedSymbol result(c, *fg, *bg);
+        result.bold(format.bold())
+              .italic(format.italic())
+              .underline(format.underline())
+              .strikeout(format.strikeout())
+              .invertColors(format.invertColors());
+        return result;
+    }
+
+    void Label::compactPalette()
+    {
+        std::vector<bool> used(_palette.size(), false);
+        for(text::PackedSymbol const & symbol : _symbols)
+        {
+            if (symbol.foreground() < used.size()) used[symbol.foreground()] = true;
+            if (symbol.background() < used.size()) used[symbol.background()] = true;
+        }
+
+        // NOTE: colors stay the same, so cells don't need an update
+        std::vector<uint16_t> const remap = _palette.compact(used);
+        for(size_t i(0); i < _symbols.size(); ++i)
+        {
+            text::PackedSymbol & symbol = _symbols.at(i);
+            if (symbol.foreground() < remap.size())
+                symbol.foreground(remap[symbol.foreground()]);
+            if (symbol.background() < remap.size())
+                symbol.background(remap[symbol.background()]);
+        }
+    }
+
+    void Label::setRegion(size_t row, size_t col, size_t cols,
+                          std::vector<text::PackedSymbol> const & symbols)
+    {
+        if (0 == cols) return;
+
+        MINIRE_INVARIANT(0 == symbols.size() % cols,
+                         "region of {} symbols is not {} wide",
+                         symbols.size(), cols);
+
+        // true colors are interned by the label, a client can't refer them
+        for(text::PackedSymbol const & symbol : symbols)
+        {
+            MINIRE_INVARIANT(symbol.foreground() < text::PackedSymbol::kPaletteSize &&
+                             symbol.background() < text::PackedSymbol::kPaletteSize,
+                             "region symbol colors {}/{} are out of the palette",
+                             symbol.foreground(), symbol.background());
+        }
+
+        size_t const rows = symbols.size() / cols;
+        if (row + rows > _symbols.rows() || col + cols > _symbols.cols())
+        {
+            MINIRE_ERROR("region {}x{} at ({}, {}) is clipped by label {}x{}",
+                         rows, cols, row, col,
+                         _symbols.rows(), _symbols.cols());
+        }
+        if (row >= _symbols.rows() || col >= _symbols.cols()) return;
+
+        size_t const width = std::min(cols, _symbols.cols() - col);
+        size_t const height = std::min(rows, _symbols.rows() - row);
+        for(size_t r(0); r < height; ++r)
+        {
+            text::PackedSymbol const * source = symbols.data() + r * cols;
+            size_t const targetRow = physical(row + r);
+            text::PackedSymbol * target = _symbols.row(targetRow) + col;
+
+            // only the changed span of a row is copied and marked
+            size_t first = 0;
+            while (first < width && source[first] == target[first]) ++first;
+            if (first == width) continue;
+
+            size_t last = width;
+            while (source[last - 1] == target[last - 1]) --last;
+
+            std::copy(source + first, source + last, target + first);
+            _dirty.set(targetRow, col + first, col + last);
+        }
+    }
+
+    void Label::scroll(int rows)
+    {
+        size_t const height = _symbols.rows();
+        // w/o std::abs, it's undefined for INT_MIN
+        size_t const shift = rows < 0 ? 0u - unsigned(rows) : unsigned(rows);
+        if (0 == shift || 0 == height) return;
+
+        if (shift >= height)
+        {
+            for(size_t row(0); row < height; ++row)
+            for(size_t col(0); col < _symbols.cols(); ++col)
+            {
+                unset(row, col);
+            }
+            return;
+        }
+
+        // the cursor stays at the same place, over another symbol
+        markCursor();
+
+        _top = rows > 0 ? (_top + shift) % height
+                        : (_top + height - shift) % height;
+
+        size_t const first = rows > 0 ? height - shift : 0;
+        for(size_t row = first; row < first + shift; ++row)
+        for(size_t col(0); col < _symbols.cols(); ++col)
+        {
+            unset(row, col);
+        }
+
+        markCursor();
+    }
+
     void Label::setPosition(float x, float y)
     {
         _position = pixelFix(glm::vec2(x, y));
     }
 
-    void Label::revalidate() const
+    GlyphAtlas const & Label::atlas() const
     {
-        assert(_buffer);
-        assert(_fontRegular);
-        assert(_fontBold);
-        assert(_fontItalic);
+        assert(drawable());
+        return _fontRegular->atlas();
+    }
 
-        _buffer->update(_symbols,
-                        _dirty,
-                        *_fontRegular,
-                        *_fontBold,
-                        *_fontItalic,
-                        _cursor,
-                        _glyphSize);
+    bool Label::stale() const
+    {
+        return drawable() && _evictions != atlas().evictions();
+    }
 
-        _dirty.clear();
-        _invalidated = false;
+    void Label::touchGlyphs() const
+    {
+        assert(drawable());
+        _fontRegular->atlas().touch(_pages);
     }
 
-    void Label::setCursor(size_t column, size_t row)
+    Label::Ranges const & Label::revalidate() const
+    {
+        assert(drawable());
+
+        _updated.clear();
+
+        // NOTE: glyphs that are rasterized below could evict others,
+        //       then the label stays stale
+        if (stale()) _rebuild = true;
+        _evictions = atlas().evictions();
+
+        size_t const cols = _symbols.cols();
+
+        if (_rebuild)
+        {
+            _pages = 0;
+            _cells.resize(_symbols.rows() * cols);
+            for(size_t row(0); row < _symbols.rows(); ++row)
+            {
+                update(row, 0, cols);
+            }
+
+            _updated.emplace_back(0, _cells.size());
+            _dirty.resize(_symbols.rows(), cols);
+            _rebuild = false;
+        }
+        else
+        {
+            // runs come ordered, so adjacent ones are just glued
+            _dirty.drain([this, cols](size_t row, size_t first, size_t last)
+            {
+                update(row, first, last);
+
+                size_t const begin = first + row * cols;
+                size_t const end = last + row * cols;
+                if (!_updated.empty() && _updated.back().second == begin)
+                {
+                    _updated.back().second = end;
+                }
+                else
+                {
+                    _updated.emplace_back(begin, end);
+                }
+            });
+        }
+
+        return _updated;
+    }
+
+    void Label::update(size_t row, size_t first, size_t last) const
     {
-        text::Symbol & symbol = at(row, column);
+        text::PackedSymbol const * symbols = _symbols.row(row);
+        for(size_t col = first; col < last; ++col)
+        {
+            update(row, col, symbols[col]);
+        }
+    }
+
+    void Label::update(size_t row, size_t col,
+                       text::PackedSymbol const & symbol) const
+    {
+        bool const isCursor = _cursor._shown
+                           && physical(_cursor._row) == row
+                           && _cursor._column == col;
+
+        Font const * font = _fontRegular.get();
+        if (symbol.bold() && _fontBold->loaded(symbol.codePoint()))
+            font = _fontBold.get();
+        if (symbol.italic() && _fontItalic->loaded(symbol.codePoint()))
+            font = _fontItalic.get();
+
+        uint32_t fg = _palette.rgba(symbol.foreground());
+        uint32_t bg = _palette.rgba(symbol.background());
+
+        uint32_t glyph = font->glyph(symbol.codePoint(), L'?');
+        assert(glyph <= kGlyphMask);
+        _pages |= font->atlas().pageOf(glyph);
+
         if (symbol.blank())
         {
-            symbol.set(L'\0');
+            bg = fg = 0;
+        }
+        else
+        {
+            /*
+                inv cur | res
+                --------+----
+                 0   0  |  0
+                 0   1  |  1
+                 1   0  |  1
+                 1   1  |  0
+            */
+            if (symbol.invertColors() != isCursor)
+            {
+                // swap RGB, but not alpha
+                static constexpr uint32_t kRgb = 0x00FFFFFF;
+                uint32_t const swapped = (fg ^ bg) & kRgb;
+                fg ^= swapped;
+                bg ^= swapped;
+                if (isCursor)
+                {
+                    fg |= ~kRgb;
+                    bg |= ~kRgb;
+                }
+            }
+
+            if (symbol.underline()) glyph |= kUnderline;
+            if (symbol.strikeout()) glyph |= kStrikeout;
         }
 
-        if (_cursor._shown)
+        Cell & cell = _cells[col + row * _symbols.cols()];
+        cell._position = static_cast<uint32_t>((row << 16) | col);
+        cell._glyph = glyph;
+        cell._fg = fg;
+        cell._bg = bg;
+    }
+
+    void Label::setCursor(size_t column, size_t row)
+    {
+        text::PackedSymbol & symbol = _symbols.at(physical(row), column);
+        if (symbol.blank())
         {
-            _dirty.emplace_back(_cursor._row, _cursor._column);
+            symbol.set(L'\0');
         }
 
-        // dont need, at() will invalidate and mark as dirty:
-        //_dirty.emplace_back(row, column); 
-        //_invalidated = true;
+        markCursor();
 
         _cursor._shown = true;
         _cursor._column = column;
         _cursor._row = row;
+
+        markCursor();
     }
 
     void Label::unsetCursor()
     {
-        if (_cursor._shown)
+        markCursor();
+        _cursor._shown = false;
+    }
+
+    void Label::markCursor()
+    {
+        // NOTE: label could be shrunk under the cursor
+        if (_cursor._shown &&
+            _cursor._row < _dirty.rows() &&
+            _cursor._column < _dirty.cols())
         {
-            _dirty.emplace_back(_cursor._row, _cursor._column);
-            _cursor._shown = false;
-            _invalidated = true;
+            _dirty.set(physical(_cursor._row), _cursor._column);
         }
     }
 }
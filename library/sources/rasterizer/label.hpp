@@ -2,19 +2,22 @@
 
 #include <minire/content/id.hpp>
 #include <minire/text/formatted-string.hpp>
+#include <minire/text/packed-symbol.hpp>
 #include <minire/text/symbol.hpp>
 #include <minire/text/text-format.hpp>
 
+#include <rasterizer/palette.hpp>
 #include <utils/grid.hpp>
-#include <rasterizer/drawable.hpp>
+#include <utils/row-bitmap.hpp>
 
 #include <glm/vec2.hpp>
-#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <utility>
 #include <vector>
-#include <array>
 
 namespace minire::content { class Manager; }
 
@@ -24,40 +27,85 @@ namespace minire::rasterizer
 {
     class Fonts;
     class Font;
+    class GlyphAtlas;
 
-    class Label : public Drawable
+    // Keeps symbols and their packed GPU representation, one instance
+    // per cell. Labels are uploaded and drawn by rasterizer::Labels.
+    class Label
     {
+    public:
+        // NOTE: layout is shared with the shader in labels.cpp
+        struct Cell
+        {
+            uint32_t _position; // (row << 16) | column, row is in the ring
+            uint32_t _glyph;    // index in the glyph atlas | flags
+            uint32_t _fg;       // RGBA8
+            uint32_t _bg;       // RGBA8
+        };
+
+        static constexpr uint32_t kGlyphMask  = (1u << 24) - 1;
+        static constexpr uint32_t kUnderline  = (1u << 26);
+        static constexpr uint32_t kStrikeout  = (1u << 27);
+
+        static constexpr size_t   kMaxSide    = 0xFFFF; // in cells
+
+        using Cells = std::vector<Cell>;
+        // in cells, [(first, past-the-end)]
+        using Ranges = std::vector<std::pair<size_t, size_t>>;
+        using FontPtr = std::shared_ptr<Font const>;
+
     public:
         explicit Label(Fonts const &,
                        int z, bool visible);
 
-        ~Label(); // because of std::unique_ptr<Buffer>
+        ~Label();
 
     public:
-        text::Symbol const & at(size_t row, size_t column) const
+        text::PackedSymbol const & at(size_t row, size_t column) const
         {
-            return _symbols.at(row, column);
+            return _symbols.at(physical(row), column);
         }
 
-        // TODO: don't invalidate symbols that are not really changed
-        text::Symbol & at(size_t row, size_t column)
-        {
-            _invalidated = true;
-            _dirty.emplace_back(row, column);
-            return _symbols.at(row, column);
-        }
+        // NOTE: setters mark only really changed symbols as dirty
+        void set(size_t row, size_t column,
+                 text::PackedSymbol const &);
+
+        // colors of the symbol are interned as true colors
+        void set(size_t row, size_t column,
+                 text::Symbol const &);
+
+        void set(size_t row, size_t column,
+                 text::TextFormat const &, wchar_t);
+
+        void unset(size_t row, size_t column);
 
         void set(size_t row, size_t column,
                  text::FormattedString const &);
 
+        // a block of cols-wide rows of symbols (row-major), it's clipped
+        // by the label; colors are to be palette indices, or it throws
+        void setRegion(size_t row, size_t column, size_t cols,
+                       std::vector<text::PackedSymbol> const &);
+
+        // sets palette entries starting from the first one
+        void setPalette(size_t first, std::vector<glm::vec4> const & colors);
+
+        // moves symbols by the given rows towards the row 0 (or
+        // backwards if negative), exposed rows are blanked
+        void scroll(int rows);
+
         size_t rows() const { return _symbols.rows(); }
 
         size_t cols() const { return _symbols.cols(); }
 
-        void setVisible(bool v) { _visible = v; }
+        void setVisible(bool v);
 
         bool visible() const { return _visible; }
 
+        size_t zOrder() const { return _zOrder; }
+
+        void setZOrder(size_t z);
+
     public:
         // in pixels, (0, 0) at left-bottom
         void setPosition(float x, float y);
@@ -75,18 +123,62 @@ namespace minire::rasterizer
         void unsetCursor();
 
     public:
-        // TODO: consider to put projection into UBO
-        void draw(glm::mat4 const & projection) const override;
+        // a label without fonts cannot be drawn
+        bool drawable() const { return static_cast<bool>(_fontRegular); }
 
-    private:
-        void revalidate() const;
+        glm::vec2 const & position() const { return _position; }
+
+        glm::vec2 const & glyphSize() const { return _glyphSize; }
+
+        // NOTE: all the fonts of a label share it
+        GlyphAtlas const & atlas() const;
+
+        // cells refer to glyphs that are evicted from the atlas
+        bool stale() const;
+
+        // marks pages of the atlas which cells refer as used
+        void touchGlyphs() const;
+
+        // symbols and cells are a ring of rows, that's the row 0 in it
+        size_t top() const { return _top; }
+
+        // returns true once after a change of cells count, fonts,
+        // visibility or z-order, i.e. when the stream should be rebuilt
+        bool takeRelayout() const { return std::exchange(_relayout, false); }
+
+        // updates cells of dirty symbols, returns their ranges
+        Ranges const & revalidate() const;
+
+        Cells const & cells() const { return _cells; }
+
+        // in cells, from the beginning of the stream
+        size_t streamOffset() const { return _streamOffset; }
+
+        void setStreamOffset(size_t offset) const { _streamOffset = offset; }
 
     private:
-        class Program;
-        class Buffer;
+        // cells of [first; last) columns of a row
+        void update(size_t row, size_t first, size_t last) const;
 
-        friend class Buffer; // to access to Cursor
+        void update(size_t row, size_t column,
+                    text::PackedSymbol const &) const;
 
+        text::PackedSymbol pack(text::TextFormat const &, wchar_t);
+
+        // drops true colors that are not used anymore
+        void compactPalette();
+
+        void markCursor();
+
+        // row in the ring, out of range rows are kept as is
+        size_t physical(size_t row) const
+        {
+            size_t const rows = _symbols.rows();
+            if (row >= rows) return row;
+            return row + _top < rows ? row + _top : row + _top - rows;
+        }
+
+    private:
         struct Cursor
         {
             size_t _column = 0;
@@ -94,26 +186,29 @@ namespace minire::rasterizer
             bool   _shown = false;
         };
 
-        using Symbols = utils::Grid<text::Symbol>;
-        // [(row, col)]
-        using Dirty = std::vector<std::pair<size_t, size_t>>;
-
-        using FontPtr = std::shared_ptr<Font const>;
-
-        Fonts const &           _fonts;
-        FontPtr                 _fontRegular;
-        FontPtr                 _fontBold;
-        FontPtr                 _fontItalic;
-        Symbols                 _symbols;
-        glm::vec2               _position;
-        glm::vec2               _glyphSize;
-        Cursor                  _cursor;
-
-        Program const &         _program;
-        std::unique_ptr<Buffer> _buffer;
-        mutable Dirty           _dirty;
-        mutable bool            _invalidated = true;
-
-        bool                    _visible;
+        using Symbols = utils::Grid<text::PackedSymbol>;
+
+        Fonts const &            _fonts;
+        FontPtr                  _fontRegular;
+        FontPtr                  _fontBold;
+        FontPtr                  _fontItalic;
+        Symbols                  _symbols; // a ring of rows from _top
+        Palette                  _palette;
+        size_t                   _top = 0;
+        glm::vec2                _position;
+        glm::vec2                _glyphSize;
+        Cursor                   _cursor;
+
+        mutable Cells            _cells;
+        mutable Ranges           _updated;
+        mutable utils::RowBitmap _dirty;
+        mutable bool             _rebuild = true;      // all the cells
+        mutable bool             _relayout = true;
+        mutable size_t           _streamOffset = 0;
+        mutable size_t           _evictions = 0; // of the atlas, for cells
+        mutable uint32_t         _pages = 0;     // GlyphAtlas::Pages cells refer
+
+        size_t                   _zOrder;
+        bool                     _visible;
     };
 }
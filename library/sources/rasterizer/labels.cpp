@@ -2,14 +2,372 @@
 
 #include <minire/errors.hpp>
 
+#include <rasterizer/glyph-atlas.hpp>
+#include <opengl.hpp>
+#include <opengl/program.hpp>
+#include <opengl/shader.hpp>
+#include <opengl/vao.hpp>
+#include <opengl/vbo.hpp>
+
+#include <glm/gtc/type_ptr.hpp> // for gln::value_ptr
+
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <functional> // for std::less
 
 namespace minire::rasterizer
 {
+    // Labels::Program //
+
+    namespace
+    {
+        // NOTE: should be the same as kMaxLabels in the vertex shader
+        constexpr size_t kMaxBatchLabels = 64;
+
+        // a working set that doesn't fit an atlas would thrash forever
+        constexpr size_t kMaxRefreshPasses = 2;
+    }
+
+    // NOTE: see Label::Cell for the layout of bznkCell
+    static const char * kVertShader = R"(
+        #version 330 core
+
+        const int kMaxLabels = 64;
+
+        layout(location = 0) in uvec4 bznkCell; // (position, glyph, fg, bg)
+
+        uniform mat4 bznkProj;
+        uniform vec2 bznkGlyphSize;
+        uniform uint bznkSlotsPerRow;
+        uniform uint bznkSlotsPerPage;
+        uniform int  bznkLabelsCount;
+        uniform int  bznkLabelStarts[kMaxLabels];
+        uniform vec2 bznkLabelPositions[kMaxLabels];
+        uniform ivec2 bznkLabelRings[kMaxLabels]; // (top, rows)
+
+        out vec2 bznkFragLocal;
+        flat out ivec3 bznkFragOrigin; // (x, y, page)
+        flat out vec4 bznkFragFgColor;
+        flat out vec4 bznkFragBgColor;
+        flat out uint bznkFragFlags;
+
+        const vec2 kCorners[6] = vec2[6](
+            vec2(0.0, 1.0), vec2(0.0, 0.0), vec2(1.0, 0.0),
+            vec2(0.0, 1.0), vec2(1.0, 0.0), vec2(1.0, 1.0)
+        );
+
+        vec4 unpackColor(uint c)
+        {
+            return vec4(uvec4(c, c >> 8, c >> 16, c >> 24) & 0xFFu) / 255.0;
+        }
+
+        // the last label that starts at or before the instance
+        int labelOf(int instance)
+        {
+            int lo = 0;
+            int hi = bznkLabelsCount - 1;
+            while (lo < hi)
+            {
+                int mid = (lo + hi + 1) / 2;
+                if (bznkLabelStarts[mid] <= instance) lo = mid;
+                else hi = mid - 1;
+            }
+            return lo;
+        }
+
+        void main()
+        {
+            int label = labelOf(gl_InstanceID);
+
+            // rows are stored as a ring, see Label::scroll
+            ivec2 ring = bznkLabelRings[label];
+            int row = (int(bznkCell.x >> 16) - ring.x + ring.y) % ring.y;
+
+            vec2 corner = kCorners[gl_VertexID];
+            vec2 cell = vec2(bznkCell.x & 0xFFFFu, row);
+
+            uint glyph = bznkCell.y & 0xFFFFFFu;
+            uint page = glyph / bznkSlotsPerPage;
+            uint slot = glyph % bznkSlotsPerPage;
+
+            vec2 position = bznkLabelPositions[label]
+                          + cell * bznkGlyphSize
+                          + corner * (bznkGlyphSize - 0.5);
+
+            gl_Position = bznkProj * vec4(position, 0.0, 1.0);
+
+            bznkFragLocal = vec2(corner.x, 1.0 - corner.y)
+                          * (bznkGlyphSize - 1.0) + 0.5;
+            bznkFragOrigin = ivec3(vec2(slot % bznkSlotsPerRow,
+                                        slot / bznkSlotsPerRow)
+                                   * bznkGlyphSize, page);
+            bznkFragFgColor = unpackColor(bznkCell.z);
+            bznkFragBgColor = unpackColor(bznkCell.w);
+            bznkFragFlags = bznkCell.y;
+        }
+    )";
+
+    // NOTE: flags are Label::kUnderline and Label::kStrikeout
+    static const char * kFragShader = R"(
+        #version 330 core
+
+        in vec2 bznkFragLocal;
+        flat in ivec3 bznkFragOrigin;
+        flat in vec4 bznkFragFgColor;
+        flat in vec4 bznkFragBgColor;
+        flat in uint bznkFragFlags;
+
+        uniform vec2 bznkGlyphSize;
+        uniform sampler2DArray bznkGlyphs;
+
+        out vec4 bznkOutColor;
+
+        void main()
+        {
+            ivec2 local = ivec2(bznkFragLocal);
+            ivec3 texel = ivec3(bznkFragOrigin.xy + local, bznkFragOrigin.z);
+            float fgFactor = texelFetch(bznkGlyphs, texel, 0).r;
+
+            int height = int(bznkGlyphSize.y);
+            if (0u != (bznkFragFlags & 0x4000000u) && local.y == height - 1)
+                fgFactor = 1.0;
+            if (0u != (bznkFragFlags & 0x8000000u) && local.y == height / 2)
+                fgFactor = 1.0;
+
+            float bgFactor = 1.0 - fgFactor;
+            bznkOutColor = bznkFragBgColor * bgFactor
+                         + bznkFragFgColor * fgFactor;
+        }
+    )";
+
+    class Labels::Program
+    {
+    public:
+        Program()
+            : _program({
+                std::make_shared<opengl::Shader>(GL_VERTEX_SHADER, kVertShader),
+                std::make_shared<opengl::Shader>(GL_FRAGMENT_SHADER, kFragShader)
+            })
+            , _glyphsUniform(_program.getUniformLocation("bznkGlyphs"))
+            , _projUniform(_program.getUniformLocation("bznkProj"))
+            , _glyphSizeUniform(_program.getUniformLocation("bznkGlyphSize"))
+            , _slotsPerRowUniform(_program.getUniformLocation("bznkSlotsPerRow"))
+            , _slotsPerPageUniform(_program.getUniformLocation("bznkSlotsPerPage"))
+            , _labelsCountUniform(_program.getUniformLocation("bznkLabelsCount"))
+            , _labelStartsUniform(_program.getUniformLocation("bznkLabelStarts"))
+            , _labelPositionsUniform(_program.getUniformLocation("bznkLabelPositions"))
+            , _labelRingsUniform(_program.getUniformLocation("bznkLabelRings"))
+        {}
+
+        void use() const { _program.use(); }
+
+        void setGlyphsUniform(GLint const v) const
+        {
+            MINIRE_GL(glUniform1i, _glyphsUniform, v);
+        }
+
+        void setProjUniform(glm::mat4 const & m) const
+        {
+            MINIRE_GL(glUniformMatrix4fv, _projUniform, 1, GL_FALSE, glm::value_ptr(m));
+        }
+
+        void setGlyphSizeUniform(glm::vec2 const & v) const
+        {
+            MINIRE_GL(glUniform2f, _glyphSizeUniform, v.x, v.y);
+        }
+
+        void setSlotsUniforms(GLuint const perRow, GLuint const perPage) const
+        {
+            MINIRE_GL(glUniform1ui, _slotsPerRowUniform, perRow);
+            MINIRE_GL(glUniform1ui, _slotsPerPageUniform, perPage);
+        }
+
+        void setLabelsUniforms(GLint const * starts,
+                               glm::vec2 const * positions,
+                               GLint const * rings, // pairs of (top, rows)
+                               size_t count) const
+        {
+            assert(count > 0 && count <= kMaxBatchLabels);
+            MINIRE_GL(glUniform1i, _labelsCountUniform, count);
+            MINIRE_GL(glUniform1iv, _labelStartsUniform, count, starts);
+            MINIRE_GL(glUniform2fv, _labelPositionsUniform, count,
+                      glm::value_ptr(*positions));
+            MINIRE_GL(glUniform2iv, _labelRingsUniform, count, rings);
+        }
+
+    private:
+        opengl::Program _program;
+        GLint           _glyphsUniform;
+        GLint           _projUniform;
+        GLint           _glyphSizeUniform;
+        GLint           _slotsPerRowUniform;
+        GLint           _slotsPerPageUniform;
+        GLint           _labelsCountUniform;
+        GLint           _labelStartsUniform;
+        GLint           _labelPositionsUniform;
+        GLint           _labelRingsUniform;
+    };
+
+    // Labels::Stream //
+
+    class Labels::Stream
+    {
+    public:
+        Stream()
+            : _vao(std::make_shared<opengl::VAO>())
+            , _vbo(_vao, GL_ARRAY_BUFFER)
+        {
+            // layout(location = 0) in uvec4 bznkCell;
+            _vao->enableAttrib(0);
+            _vao->divisor(0, 1);
+        }
+
+    public:
+        // lays out all the labels in the given order and uploads them
+        void rebuild(Order const & order)
+        {
+            _staging.clear();
+            for(Label const * label : order)
+            {
+                assert(label);
+                label->revalidate();
+                label->setStreamOffset(_staging.size());
+                Label::Cells const & cells = label->cells();
+                _staging.insert(_staging.end(), cells.cbegin(), cells.cend());
+            }
+
+            // NOTE: re-specifying the storage orphans the old one
+            //       and that avoids stalls on buffers still in use
+            _vbo.bufferData(_staging.size() * sizeof(Label::Cell),
+                            _staging.data(), GL_DYNAMIC_DRAW);
+        }
+
+        // re-uploads changed cells in place
+        void refresh(Order const & order)
+        {
+            for(Label const * label : order)
+            {
+                assert(label);
+                Label::Cells const & cells = label->cells();
+                for(auto const & range : label->revalidate())
+                {
+                    assert(range.first < range.second);
+                    assert(range.second <= cells.size());
+                    size_t const offset = label->streamOffset() + range.first;
+                    _vbo.bufferSubData(offset * sizeof(Label::Cell),
+                                       (range.second - range.first) * sizeof(Label::Cell),
+                                       cells.data() + range.first);
+                }
+            }
+        }
+
+        // instances of a draw call will start from the first cell
+        void bind(size_t first) const
+        {
+            _vbo.bind();
+            _vao->attribIPointer(0, 4, GL_UNSIGNED_INT,
+                                 sizeof(Label::Cell),
+                                 first * sizeof(Label::Cell));
+        }
+
+    private:
+        opengl::VAO::Sptr  _vao;
+        opengl::VBO        _vbo;
+        Label::Cells       _staging;
+    };
+
+    // Labels::Batch //
+
+    // A range of the stream that shares a glyph atlas
+    class Labels::Batch : public Drawable
+    {
+    public:
+        Batch(Label const & label,
+              Program const & program,
+              Stream const & stream)
+            : Drawable(label.zOrder())
+            , _first(label.streamOffset())
+            , _count(label.cells().size())
+            , _lastZOrder(label.zOrder())
+            , _labels{&label}
+            , _program(program)
+            , _stream(stream)
+        {}
+
+    public:
+        bool accepts(Label const & label) const
+        {
+            Label const & head = *_labels.front();
+            return _labels.size() < kMaxBatchLabels
+                && &head.atlas() == &label.atlas();
+        }
+
+        size_t lastZOrder() const { return _lastZOrder; }
+
+        void extend(Label const & label)
+        {
+            assert(label.zOrder() >= _lastZOrder);
+            assert(_first + _count == label.streamOffset());
+            _count += label.cells().size();
+            _lastZOrder = label.zOrder();
+            _labels.push_back(&label);
+        }
+
+        void draw(glm::mat4 const & projection) const override
+        {
+            Label const & head = *_labels.front();
+            assert(head.drawable());
+
+            std::array<GLint, kMaxBatchLabels> starts;
+            std::array<glm::vec2, kMaxBatchLabels> positions;
+            std::array<GLint, kMaxBatchLabels * 2> rings;
+            for(size_t i(0); i < _labels.size(); ++i)
+            {
+                starts[i] = _labels[i]->streamOffset() - _first;
+                positions[i] = _labels[i]->position();
+                rings[i * 2 + 0] = _labels[i]->top();
+                rings[i * 2 + 1] = _labels[i]->rows();
+            }
+
+            _program.use();
+
+            GlyphAtlas const & atlas = head.atlas();
+
+            MINIRE_GL(glActiveTexture, GL_TEXTURE0);
+            atlas.bind();
+
+            _program.setGlyphsUniform(0);
+            _program.setProjUniform(projection);
+            _program.setGlyphSizeUniform(atlas.glyphSize());
+            _program.setSlotsUniforms(atlas.slotsPerRow(), atlas.slotsPerPage());
+            _program.setLabelsUniforms(starts.data(), positions.data(),
+                                       rings.data(), _labels.size());
+
+            _stream.bind(_first);
+
+            MINIRE_GL(glDrawArraysInstanced, GL_TRIANGLES, 0, 6, _count);
+        }
+
+    private:
+        size_t                     _first;  // in cells
+        size_t                     _count;  // in cells
+        size_t                     _lastZOrder;
+        std::vector<Label const *> _labels;
+        Program const &            _program;
+        Stream const &             _stream;
+    };
+
+    // Labels //
+
     Labels::Labels(Fonts const & fonts)
         : _fonts(fonts)
+        , _program(std::make_unique<Program>())
+        , _stream(std::make_unique<Stream>())
     {}
 
+    Labels::~Labels() = default;
+
     Label & Labels::allocate(std::string key, int z, bool visible)
     {
         auto res = _store.emplace(std::move(key),
@@ -18,12 +376,16 @@ namespace minire::rasterizer
         {
             MINIRE_THROW("label duplicate: \"{}\"", key);
         }
+        _reorder = true;
         return *(res.first->second);
     }
-    
+
     void Labels::deallocate(std::string const & key)
     {
-        _store.erase(key);
+        if (_store.erase(key))
+        {
+            _reorder = true;
+        }
     }
 
     Label & Labels::get(std::string const & key)
@@ -46,15 +408,98 @@ namespace minire::rasterizer
         return *it->second;
     }
 
-    void Labels::predraw(Drawable::PtrsList & out) const
+    void Labels::reorder() const
     {
+        _order.clear();
         for(auto const & label : _store)
         {
             assert(label.second);
-            if (label.second->visible())
+            if (label.second->visible() && label.second->drawable())
             {
-                out.push_back(label.second.get());
+                _order.push_back(label.second.get());
             }
         }
+
+        std::sort(_order.begin(), _order.end(),
+            [](Label const * a, Label const * b)
+            {
+                if (a->zOrder() != b->zOrder()) return a->zOrder() < b->zOrder();
+                return std::less<GlyphAtlas const *>{}(&a->atlas(), &b->atlas());
+            });
+
+        _stream->rebuild(_order);
+        _reorder = false;
+    }
+
+    void Labels::batch(std::vector<size_t> const & barriers) const
+    {
+        assert(std::is_sorted(barriers.cbegin(), barriers.cend()));
+
+        auto const crosses = [&barriers](size_t fromZ, size_t toZ)
+        {
+            if (fromZ == toZ) return false;
+            auto it = std::lower_bound(barriers.cbegin(), barriers.cend(), fromZ);
+            return it != barriers.cend() && *it <= toZ;
+        };
+
+        _batches.clear();
+        for(Label const * label : _order)
+        {
+            if (!_batches.empty())
+            {
+                Batch & last = _batches.back();
+                if (last.accepts(*label) &&
+                    !crosses(last.lastZOrder(), label->zOrder()))
+                {
+                    last.extend(*label);
+                    continue;
+                }
+            }
+
+            _batches.emplace_back(*label, *_program, *_stream);
+        }
+    }
+
+    void Labels::predraw(Drawable::PtrsList & out,
+                         std::vector<size_t> const & barriers) const
+    {
+        // pages of glyphs of labels being drawn are the most recent ones,
+        // so static labels keep them while others rasterize new glyphs
+        bool relayout = _reorder;
+        for(auto const & label : _store)
+        {
+            assert(label.second);
+            relayout = label.second->takeRelayout() || relayout;
+            if (label.second->visible() && label.second->drawable())
+            {
+                label.second->touchGlyphs();
+            }
+        }
+
+        if (relayout)
+        {
+            reorder();
+        }
+        else
+        {
+            _stream->refresh(_order);
+        }
+
+        // glyphs rasterized on the way could evict ones that are used by
+        // labels handled before, so they have to be refreshed again
+        for(size_t pass(0); pass < kMaxRefreshPasses; ++pass)
+        {
+            bool const stale = std::any_of(_order.cbegin(), _order.cend(),
+                [](Label const * label) { return label->stale(); });
+            if (!stale) break;
+            _stream->refresh(_order);
+        }
+
+        batch(barriers);
+
+        for(Batch const & batch : _batches)
+        {
+            out.push_back(&batch);
+        }
     }
-}
\ No newline at end of file
+}
@@ -7,16 +7,26 @@
 
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace minire::rasterizer
 {
     class Fonts;
 
+    // All labels share a single stream of cells, one instance per cell.
+    // Labels of a z-range that use the same fonts are drawn by a single
+    // instanced draw call.
     class Labels
     {
+        class Program;
+        class Stream;
+        class Batch;
+
     public:
         explicit Labels(Fonts const &);
 
+        ~Labels(); // because of std::unique_ptr<Program>, <Stream>
+
     public:
         Label & allocate(std::string, int z = 0, bool visible = true);
 
@@ -26,13 +36,29 @@ namespace minire::rasterizer
 
         Label const & get(std::string const &) const;
 
-        void predraw(Drawable::PtrsList & out) const;
+        // NOTE: batches cannot span over any of the sorted barriers,
+        //       that are z-orders of other drawables
+        void predraw(Drawable::PtrsList & out,
+                     std::vector<size_t> const & barriers) const;
+
+    private:
+        void reorder() const;
+
+        void batch(std::vector<size_t> const & barriers) const;
 
     private:
         using LabelPtr = std::unique_ptr<Label>;
         using Store = std::unordered_map<std::string, LabelPtr>;
+        using Order = std::vector<Label const *>;
+        using Batches = std::vector<Batch>;
+
+        Fonts const &            _fonts;
+        std::unique_ptr<Program> _program;
+        std::unique_ptr<Stream>  _stream;
+        Store                    _store;
 
-        Fonts const & _fonts;
-        Store         _store;
+        mutable Order            _order;   // visible ones, sorted by (z, font)
+        mutable Batches          _batches;
+        mutable bool             _reorder = true;
     };
 }
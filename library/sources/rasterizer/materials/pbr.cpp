@@ -41,6 +41,7 @@ namespace minire::rasterizer::materials
             result += features.hasUv() ? "UV/" : "";
             result += features.hasNormal() ? "N/" : "";
             result += features.hasTangent() ? "T/" : "";
+            result += features.quantized() ? "Q/" : "";
 
             result += pbrModel._albedoTexture ? "A:TF/" : "A:F/";
             result += pbrModel._metallicTexture ? fmt::format("M:T{}F/", static_cast<int>(pbrModel._metallicTextureComponent))
@@ -62,16 +63,16 @@ namespace minire::rasterizer::materials
     PbrInstance::PbrInstance(models::PbrMaterial const & pbrModel,
                              Textures const & textures)
         : _albedoFactor(pbrModel._albedoFactor)
-        , _albedoTexture(textures.get(pbrModel._albedoTexture, pbrModel._albedoSampler))
+        , _albedoTexture(textures.stream(pbrModel._albedoTexture, pbrModel._albedoSampler))
         , _metallicFactor(pbrModel._metallicFactor)
-        , _metallicTexture(textures.get(pbrModel._metallicTexture, pbrModel._metallicSampler))
+        , _metallicTexture(textures.stream(pbrModel._metallicTexture, pbrModel._metallicSampler))
         , _roughnessFactor(pbrModel._roughnessFactor)
-        , _roughnessTexture(textures.get(pbrModel._roughnessTexture, pbrModel._roughnessSampler))
-        , _normalTexture(textures.get(pbrModel._normalTexture, pbrModel._normalSampler))
+        , _roughnessTexture(textures.stream(pbrModel._roughnessTexture, pbrModel._roughnessSampler))
+        , _normalTexture(textures.stream(pbrModel._normalTexture, pbrModel._normalSampler))
         , _normalScale(pbrModel._normalScale)
-        , _aoTexture(textures.get(pbrModel._aoTexture, pbrModel._aoSampler))
+        , _aoTexture(textures.stream(pbrModel._aoTexture, pbrModel._aoSampler))
         , _aoStrength(pbrModel._aoStrength)
-        , _emissiveTexture(textures.get(pbrModel._emissiveTexture, pbrModel._emissiveSampler))
+        , _emissiveTexture(textures.stream(pbrModel._emissiveTexture, pbrModel._emissiveSampler))
         , _emissiveFactor(pbrModel._emissiveFactor)
     {}
 
@@ -90,16 +91,21 @@ namespace minire::rasterizer::materials
         glProgram.setUniform(location, value);
     }
 
-    GLint PbrInstance::setUniform(Textures::Texture::Sptr const & texture,
+    GLint PbrInstance::setUniform(Textures::Binding const & texture,
+                                  Textures const & textures,
                                   opengl::Program const & glProgram,
-                                  GLint location, GLint texUnit)
+                                  GLint location, GLint layerLocation,
+                                  GLint texUnit)
     {
         if (!texture) return 0;
 
         assert(location != -1);
-        MINIRE_GL(glActiveTexture, GL_TEXTURE0 + texUnit);
+        assert(layerLocation != -1);
         glProgram.setUniform(location, texUnit);
-        texture->bind();
+
+        // NOTE: materials w/ textures of the same arrays don't rebind anything
+        GLuint const layer = textures.bind(texture, texUnit);
+        glProgram.setUniform(layerLocation, glm::vec2(layer, texture._texture->minLod()));
         return 1;
     }
 
@@ -124,27 +130,40 @@ namespace minire::rasterizer::materials
         GLint texUnit = 0;
 
         PbrInstance::setUniform(pbrInstance._albedoFactor, _program, _albedoFactor);
-        texUnit += PbrInstance::setUniform(pbrInstance._albedoTexture, _program, _albedoTexture, texUnit);
+        texUnit += PbrInstance::setUniform(pbrInstance._albedoTexture, _textures, _program,
+                                           _albedoTexture, _albedoLayer, texUnit);
 
         PbrInstance::setUniform(pbrInstance._metallicFactor, _program, _metallicFactor);
-        texUnit += PbrInstance::setUniform(pbrInstance._metallicTexture, _program, _metallicTexture, texUnit);
+        texUnit += PbrInstance::setUniform(pbrInstance._metallicTexture, _textures, _program,
+                                           _metallicTexture, _metallicLayer, texUnit);
 
         PbrInstance::setUniform(pbrInstance._roughnessFactor, _program, _roughnessFactor);
-        texUnit += PbrInstance::setUniform(pbrInstance._roughnessTexture, _program, _roughnessTexture, texUnit);
+        texUnit += PbrInstance::setUniform(pbrInstance._roughnessTexture, _textures, _program,
+                                           _roughnessTexture, _roughnessLayer, texUnit);
 
         if (pbrInstance._normalTexture)
         {
-            texUnit += PbrInstance::setUniform(pbrInstance._normalTexture, _program, _normalTexture, texUnit);
+            texUnit += PbrInstance::setUniform(pbrInstance._normalTexture, _textures, _program,
+                                               _normalTexture, _normalLayer, texUnit);
             PbrInstance::setUniform(pbrInstance._normalScale, _program, _normalScale);
         }
 
-        texUnit += PbrInstance::setUniform(pbrInstance._aoTexture, _program, _aoTexture, texUnit);
+        texUnit += PbrInstance::setUniform(pbrInstance._aoTexture, _textures, _program,
+                                           _aoTexture, _aoLayer, texUnit);
         PbrInstance::setUniform(pbrInstance._aoStrength, _program, _aoStrength);
 
-        texUnit += PbrInstance::setUniform(pbrInstance._emissiveTexture, _program, _emissiveTexture, texUnit);
+        texUnit += PbrInstance::setUniform(pbrInstance._emissiveTexture, _textures, _program,
+                                           _emissiveTexture, _emissiveLayer, texUnit);
         PbrInstance::setUniform(pbrInstance._emissiveFactor, _program, _emissiveFactor);
     }
 
+    void PbrProgram::preparePrimitive(glm::vec3 const & positionScale,
+                                      glm::vec3 const & positionOffset) const
+    {
+        _program.setUniform(_positionScale, positionScale);
+        _program.setUniform(_positionOffset, positionOffset);
+    }
+
     material::Program::Locations PbrProgram::locations() const
     {
         return material::Program::Locations
@@ -186,6 +205,7 @@ namespace minire::rasterizer::materials
         {
             {"kHasUvs",              features.hasUv()},
             {"kHasTangents",         features.hasTangent()},
+            {"kQuantized",           features.quantized()},
 
             {"kHasAlbedoTexture",    pbrModel._albedoTexture.has_value()},
             {"kHasMetallicTexture",  pbrModel._metallicTexture.has_value()},
@@ -223,24 +243,31 @@ namespace minire::rasterizer::materials
         // Collect uniforms, attribs locations and build the result
 
         auto result = std::make_shared<PbrProgram>(std::move(program),
-                                                   pbrSignature(pbrModel, features));
+                                                   pbrSignature(pbrModel, features),
+                                                   _textures);
 
         result->_albedoFactor = result->_program.getUniformLocation("bznkAlbedoFactor");
         result->_albedoTexture = result->_program.getUniformLocation("bznkAlbedoTexture");
+        result->_albedoLayer = result->_program.getUniformLocation("bznkAlbedoLayer");
 
         result->_metallicFactor = result->_program.getUniformLocation("bznkMetallicFactor");
         result->_metallicTexture = result->_program.getUniformLocation("bznkMetallicTexture");
+        result->_metallicLayer = result->_program.getUniformLocation("bznkMetallicLayer");
 
         result->_roughnessFactor = result->_program.getUniformLocation("bznkRoughnessFactor");
         result->_roughnessTexture = result->_program.getUniformLocation("bznkRoughnessTexture");
+        result->_roughnessLayer = result->_program.getUniformLocation("bznkRoughnessLayer");
 
         result->_normalTexture = result->_program.getUniformLocation("bznkNormalTexture");
+        result->_normalLayer = result->_program.getUniformLocation("bznkNormalLayer");
         result->_normalScale = result->_program.getUniformLocation("bznkNormalScale");
 
         result->_aoTexture = result->_program.getUniformLocation("bznkAoTexture");
+        result->_aoLayer = result->_program.getUniformLocation("bznkAoLayer");
         result->_aoStrength = result->_program.getUniformLocation("bznkAoStrength");
 
         result->_emissiveTexture = result->_program.getUniformLocation("bznkEmissiveTexture");
+        result->_emissiveLayer = result->_program.getUniformLocation("bznkEmissiveLayer");
         result->_emissiveFactor = result->_program.getUniformLocation("bznkEmissiveFactor");
 
         result->_modelUniformLocation = result->_program.getUniformLocation("bznkModel");
@@ -249,6 +276,12 @@ namespace minire::rasterizer::materials
         result->_colorFactorUniformLocation = result->_program.getUniformLocation("bznkColorFactor");
         assert(result->_colorFactorUniformLocation != -1);
 
+        result->_positionScale = result->_program.getUniformLocation("bznkPositionScale");
+        assert(result->_positionScale != -1);
+
+        result->_positionOffset = result->_program.getUniformLocation("bznkPositionOffset");
+        assert(result->_positionOffset != -1);
+
         result->_positionAttribute = result->_program.getAttribLocation("bznkVertex");
         assert(result->_positionAttribute != -1);
 
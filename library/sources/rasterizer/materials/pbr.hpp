@@ -25,27 +25,30 @@ namespace minire::rasterizer::materials
         static void setUniform(glm::vec3 const &, opengl::Program const &,
                                GLint location);
 
-        static GLint setUniform(Textures::Texture::Sptr const & uniformData,
+        // binds the texture and its sampler to the unit, and selects its layer
+        static GLint setUniform(Textures::Binding const & uniformData,
+                                Textures const & textures,
                                 opengl::Program const & glProgram,
-                                GLint location, GLint texUnit);
+                                GLint location, GLint layerLocation,
+                                GLint texUnit);
 
-        glm::vec3               _albedoFactor;
-        Textures::Texture::Sptr _albedoTexture;
+        glm::vec3          _albedoFactor;
+        Textures::Binding  _albedoTexture;
 
-        float                   _metallicFactor;
-        Textures::Texture::Sptr _metallicTexture;
+        float              _metallicFactor;
+        Textures::Binding  _metallicTexture;
 
-        float                   _roughnessFactor;
-        Textures::Texture::Sptr _roughnessTexture;
+        float              _roughnessFactor;
+        Textures::Binding  _roughnessTexture;
 
-        Textures::Texture::Sptr _normalTexture;
-        float                   _normalScale;
+        Textures::Binding  _normalTexture;
+        float              _normalScale;
 
-        Textures::Texture::Sptr _aoTexture;
-        float                   _aoStrength;
+        Textures::Binding  _aoTexture;
+        float              _aoStrength;
 
-        Textures::Texture::Sptr _emissiveTexture;
-        glm::vec3               _emissiveFactor;
+        Textures::Binding  _emissiveTexture;
+        glm::vec3          _emissiveFactor;
 
         friend class PbrProgram;
         friend class PbrFactory;
@@ -58,6 +61,9 @@ namespace minire::rasterizer::materials
                             glm::mat4 const & modelTransform,
                             float const colorFactor) const override;
 
+        void preparePrimitive(glm::vec3 const & positionScale,
+                              glm::vec3 const & positionOffset) const override;
+
         opengl::Program const & glProgram() const override { return _program; }
 
         Locations locations() const override;
@@ -65,33 +71,42 @@ namespace minire::rasterizer::materials
     public:
         // TODO: make this guy private (but keep compatibility with std::make_shared)
         explicit PbrProgram(opengl::Program && program,
-                            std::string signature)
+                            std::string signature,
+                            Textures const & textures)
             : _program(std::move(program))
             , _signature(signature)
+            , _textures(textures)
         {}
 
     private:
         opengl::Program   _program;
         std::string const _signature;
+        Textures const  & _textures;
 
         // Uniform locations
 
         GLint _albedoFactor = -1;
         GLint _albedoTexture = -1;
+        GLint _albedoLayer = -1;
 
         GLint _metallicFactor = -1;
         GLint _metallicTexture = -1;
+        GLint _metallicLayer = -1;
 
         GLint _roughnessFactor = -1;
         GLint _roughnessTexture = -1;
+        GLint _roughnessLayer = -1;
 
         GLint _normalTexture = -1;
+        GLint _normalLayer = -1;
         GLint _normalScale = -1;
 
         GLint _aoTexture = -1;
+        GLint _aoLayer = -1;
         GLint _aoStrength = -1;
 
         GLint _emissiveTexture = -1;
+        GLint _emissiveLayer = -1;
         GLint _emissiveFactor = -1;
 
         GLint _positionAttribute = -1;
@@ -101,6 +116,8 @@ namespace minire::rasterizer::materials
 
         GLint _modelUniformLocation = -1;
         GLint _colorFactorUniformLocation = -1;
+        GLint _positionScale = -1;
+        GLint _positionOffset = -1;
 
         friend class PbrFactory;
     };
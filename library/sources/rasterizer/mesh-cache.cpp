@@ -0,0 +1,472 @@
+#include <rasterizer/mesh-cache.hpp>
+
+#include <minire/content/manager.hpp>
+#include <minire/errors.hpp>
+#include <minire/logging.hpp>
+
+#include <utils/hash-bytes.hpp>
+#include <utils/mapped-file.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <vector>
+
+// A file is laid out as:
+//
+//   FileHeader
+//   per primitive:
+//     PrimitiveHeader
+//     VertexData::Attrib[_attribs]
+//     elements, padded to kAlignment
+//     vertices, padded to kAlignment
+//
+// Features of the primitives are kept aside (to find out locations
+// before a file is looked up):
+//
+//   FileHeader
+//   uint32_t[_primitives], padded to kAlignment
+//
+// The integers are in the native byte order, files aren't portable.
+namespace minire::rasterizer
+{
+    namespace
+    {
+        constexpr uint32_t kMagic         = 0x434D524D; // "MRMC"
+        constexpr uint32_t kFeaturesMagic = 0x464D524D; // "MRMF"
+        constexpr uint32_t kVersion       = 4; // keyed by locations since 4
+        constexpr size_t   kAlignment = 8;
+
+        struct FileHeader
+        {
+            uint32_t _magic;
+            uint32_t _version;
+            uint64_t _sourceHash;
+            uint64_t _meshIndex;
+            uint64_t _quantized;
+            uint64_t _locations;    // a hash of them
+            uint64_t _primitives;
+        };
+
+        struct PrimitiveHeader
+        {
+            int32_t  _locations[4]; // vertex, uv, normal, tangent
+            uint32_t _features;     // see kHas*
+            uint32_t _drawMode;
+            uint32_t _elementsType;
+            uint32_t _attribs;
+            uint64_t _elementsCount;
+            uint64_t _stride;
+            float    _aabb[6];      // min, max
+            float    _positionDecode[6]; // scale, offset
+            uint64_t _elementsSize;
+            uint64_t _verticesSize;
+        };
+
+        using Attrib = opengl::VertexData::Attrib;
+
+        static_assert(sizeof(FileHeader) % kAlignment == 0);
+        static_assert(sizeof(PrimitiveHeader) % kAlignment == 0);
+        static_assert(sizeof(Attrib) == 20);
+
+        constexpr uint32_t kHasUv      = 1;
+        constexpr uint32_t kHasNormal  = 2;
+        constexpr uint32_t kHasTangent = 4;
+        constexpr uint32_t kQuantized  = 8;
+
+        size_t padded(size_t size)
+        {
+            return (size + kAlignment - 1) / kAlignment * kAlignment;
+        }
+
+        uint64_t hashOf(MeshCache::Locations const & locations)
+        {
+            std::vector<int32_t> values;
+            values.reserve(locations.size() * 4);
+            for(material::Program::Locations const & primitive : locations)
+            {
+                values.insert(values.end(), {primitive._vertexAttribute, primitive._uvAttribute,
+                                             primitive._normalAttribute, primitive._tangentAttribute});
+            }
+            return utils::hashBytes(std::as_bytes(std::span(values)));
+        }
+
+        MeshCache::Locations locationsOf(opengl::MeshData const & data)
+        {
+            MeshCache::Locations result;
+            result.reserve(data._primitives.size());
+            for(opengl::VertexData const & primitive : data._primitives)
+            {
+                result.push_back(primitive._locations);
+            }
+            return result;
+        }
+
+        uint32_t bitsOf(models::MeshFeatures const & features)
+        {
+            return (features.hasUv() ? kHasUv : 0)
+                 | (features.hasNormal() ? kHasNormal : 0)
+                 | (features.hasTangent() ? kHasTangent : 0)
+                 | (features.quantized() ? kQuantized : 0);
+        }
+
+        models::MeshFeatures featuresOf(uint32_t bits)
+        {
+            return models::MeshFeatures(bits & kHasUv, bits & kHasNormal,
+                                        bits & kHasTangent, bits & kQuantized);
+        }
+
+        // reads a file front to back, fails on overruns
+        class Reader
+        {
+        public:
+            explicit Reader(std::span<std::byte const> bytes)
+                : _bytes(bytes)
+            {}
+
+            template<typename T>
+            T read()
+            {
+                T result;
+                std::memcpy(&result, take(sizeof(T)).data(), sizeof(T));
+                return result;
+            }
+
+            std::span<std::byte const> take(size_t size)
+            {
+                MINIRE_INVARIANT(size <= _bytes.size() - _offset, "truncated file");
+                std::span<std::byte const> result = _bytes.subspan(_offset, size);
+                _offset += size;
+                return result;
+            }
+
+            std::span<std::byte const> takePadded(size_t size)
+            {
+                std::span<std::byte const> result = take(size);
+                take(padded(size) - size);
+                return result;
+            }
+
+            bool atEnd() const { return _offset == _bytes.size(); }
+
+        private:
+            std::span<std::byte const> _bytes;
+            size_t                     _offset = 0;
+        };
+
+        void writePadded(std::ofstream & output, std::span<std::byte const> bytes)
+        {
+            static char const kZeros[kAlignment] = {};
+            output.write(reinterpret_cast<char const *>(bytes.data()), bytes.size());
+            output.write(kZeros, padded(bytes.size()) - bytes.size());
+        }
+
+        template<typename T>
+        void write(std::ofstream & output, T const & value)
+        {
+            output.write(reinterpret_cast<char const *>(&value), sizeof(value));
+        }
+
+        // writes a temporary file and renames it, so readers never see
+        // a partial one
+        template<typename Write>
+        void writeFile(std::string const & path, Write const & write)
+        {
+            std::string const temporary = path + ".tmp";
+            try
+            {
+                std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+                MINIRE_INVARIANT(output, "cannot create the file");
+                write(output);
+                output.close();
+                MINIRE_INVARIANT(output, "failed to write the file");
+
+                std::filesystem::rename(temporary, path);
+            }
+            catch(...)
+            {
+                std::error_code ignored;
+                std::filesystem::remove(temporary, ignored);
+                throw;
+            }
+        }
+    }
+
+    MeshCache::MeshCache(content::Manager & contentManager)
+        : _contentManager(contentManager)
+        , _self(this, [](MeshCache *) {})
+    {}
+
+    bool MeshCache::enabled() const
+    {
+        return !_contentManager.cacheDir().empty();
+    }
+
+    std::optional<uint64_t> MeshCache::sourceHash(content::Id const & source)
+    {
+        if (!enabled()) return std::nullopt;
+
+        auto it = _hashes.find(source);
+        if (it == _hashes.cend())
+        {
+            it = _hashes.emplace(source, _contentManager.hash(source)).first;
+        }
+        return it->second;
+    }
+
+    void MeshCache::hashAsync(content::Id const & source, std::function<void()> hashed)
+    {
+        if (!enabled() || _hashes.contains(source))
+        {
+            hashed();
+            return;
+        }
+
+        auto & waiting = _hashing[source];
+        waiting.push_back(std::move(hashed));
+        if (waiting.size() > 1) return; // it's in flight already
+
+        std::weak_ptr<MeshCache> self = _self;
+        _contentManager.hashAsync(source,
+            [self, source](std::optional<uint64_t> hash)
+            {
+                auto cache = self.lock();
+                if (!cache) return;
+
+                cache->_hashes.emplace(source, hash);
+
+                auto it = cache->_hashing.find(source);
+                assert(it != cache->_hashing.end());
+                std::vector<std::function<void()>> const waiting = std::move(it->second);
+                cache->_hashing.erase(it);
+
+                for(auto const & callback : waiting)
+                {
+                    callback();
+                }
+            });
+    }
+
+    std::string MeshCache::filename(uint64_t sourceHash, size_t meshIndex, bool quantized,
+                                    Locations const & locations) const
+    {
+        std::filesystem::path result(_contentManager.cacheDir());
+        result /= fmt::format("{:016x}-{:x}{}-{:016x}.mesh", sourceHash, meshIndex,
+                              quantized ? "-q" : "", hashOf(locations));
+        return result.string();
+    }
+
+    std::string MeshCache::featuresFilename(uint64_t sourceHash, size_t meshIndex, bool quantized) const
+    {
+        std::filesystem::path result(_contentManager.cacheDir());
+        result /= fmt::format("{:016x}-{:x}{}.features", sourceHash, meshIndex, quantized ? "-q" : "");
+        return result.string();
+    }
+
+    bool MeshCache::contains(uint64_t sourceHash, size_t meshIndex, bool quantized,
+                             Locations const & locations) const
+    {
+        return enabled() && std::filesystem::exists(filename(sourceHash, meshIndex, quantized, locations));
+    }
+
+    bool MeshCache::contains(uint64_t sourceHash, size_t meshIndex, bool quantized) const
+    {
+        return enabled() && std::filesystem::exists(featuresFilename(sourceHash, meshIndex, quantized));
+    }
+
+    std::optional<opengl::MeshData> MeshCache::load(uint64_t sourceHash, size_t meshIndex,
+                                                    bool quantized, Locations const & locations) const
+    {
+        if (!contains(sourceHash, meshIndex, quantized, locations)) return std::nullopt;
+
+        std::string const path = filename(sourceHash, meshIndex, quantized, locations);
+        try
+        {
+            auto file = std::make_shared<utils::MappedFile>(path);
+            Reader reader(file->bytes());
+
+            auto const header = reader.read<FileHeader>();
+            if (header._magic != kMagic ||
+                header._version != kVersion ||
+                header._sourceHash != sourceHash ||
+                header._meshIndex != meshIndex ||
+                header._quantized != quantized ||
+                header._locations != hashOf(locations) ||
+                header._primitives != locations.size())
+            {
+                MINIRE_WARNING("mesh cache file is outdated: {}", path);
+                return std::nullopt;
+            }
+
+            opengl::MeshData result;
+            for(uint64_t i = 0; i < header._primitives; ++i)
+            {
+                auto const primitive = reader.read<PrimitiveHeader>();
+
+                std::vector<Attrib> attribs(primitive._attribs);
+                for(Attrib & attrib : attribs)
+                {
+                    attrib = reader.read<Attrib>();
+                }
+
+                result._primitives.push_back(opengl::VertexData{
+                    featuresOf(primitive._features),
+                    {primitive._locations[0], primitive._locations[1],
+                     primitive._locations[2], primitive._locations[3]},
+                    primitive._drawMode,
+                    primitive._elementsType,
+                    primitive._elementsCount,
+                    primitive._stride,
+                    utils::Aabb(primitive._aabb[0], primitive._aabb[1], primitive._aabb[2],
+                                primitive._aabb[3], primitive._aabb[4], primitive._aabb[5]),
+                    std::move(attribs),
+                    reader.takePadded(primitive._elementsSize),
+                    reader.takePadded(primitive._verticesSize),
+                    glm::vec3(primitive._positionDecode[0], primitive._positionDecode[1],
+                              primitive._positionDecode[2]),
+                    glm::vec3(primitive._positionDecode[3], primitive._positionDecode[4],
+                              primitive._positionDecode[5]),
+                });
+            }
+            MINIRE_INVARIANT(reader.atEnd(), "trailing bytes");
+            bool const bound = std::equal(result._primitives.cbegin(), result._primitives.cend(),
+                                          locations.cbegin(),
+                                          [](opengl::VertexData const & primitive,
+                                             material::Program::Locations const & locations)
+                                          {
+                                              return primitive.boundTo(locations);
+                                          });
+            MINIRE_INVARIANT(bound, "locations of primitives differ");
+
+            result._storage = std::move(file);
+            return result;
+        }
+        catch(std::exception const & e)
+        {
+            MINIRE_WARNING("bad mesh cache file {}: {}", path, e.what());
+            return std::nullopt;
+        }
+    }
+
+    std::optional<std::vector<models::MeshFeatures>>
+    MeshCache::features(uint64_t sourceHash, size_t meshIndex, bool quantized) const
+    {
+        if (!enabled()) return std::nullopt;
+
+        std::string const path = featuresFilename(sourceHash, meshIndex, quantized);
+        if (!std::filesystem::exists(path)) return std::nullopt;
+
+        try
+        {
+            utils::MappedFile const file(path);
+            Reader reader(file.bytes());
+
+            auto const header = reader.read<FileHeader>();
+            if (header._magic != kFeaturesMagic ||
+                header._version != kVersion ||
+                header._sourceHash != sourceHash ||
+                header._meshIndex != meshIndex ||
+                header._quantized != quantized)
+            {
+                MINIRE_WARNING("mesh cache file is outdated: {}", path);
+                return std::nullopt;
+            }
+
+            Reader bits(reader.takePadded(header._primitives * sizeof(uint32_t)));
+            MINIRE_INVARIANT(reader.atEnd(), "trailing bytes");
+
+            std::vector<models::MeshFeatures> result;
+            result.reserve(header._primitives);
+            for(uint64_t i = 0; i < header._primitives; ++i)
+            {
+                result.push_back(featuresOf(bits.read<uint32_t>()));
+            }
+            return result;
+        }
+        catch(std::exception const & e)
+        {
+            MINIRE_WARNING("bad mesh cache file {}: {}", path, e.what());
+            return std::nullopt;
+        }
+    }
+
+    void MeshCache::store(uint64_t sourceHash, size_t meshIndex, bool quantized,
+                          opengl::MeshData const & data) const
+    {
+        if (!enabled()) return;
+
+        Locations const locations = locationsOf(data);
+        std::string const path = filename(sourceHash, meshIndex, quantized, locations);
+        try
+        {
+            writeFile(path, [&](std::ofstream & output)
+            {
+                write(output, FileHeader{kMagic, kVersion, sourceHash, meshIndex, quantized,
+                                         hashOf(locations), data._primitives.size()});
+                for(opengl::VertexData const & primitive : data._primitives)
+                {
+                    PrimitiveHeader header{};
+                    header._locations[0] = primitive._locations._vertexAttribute;
+                    header._locations[1] = primitive._locations._uvAttribute;
+                    header._locations[2] = primitive._locations._normalAttribute;
+                    header._locations[3] = primitive._locations._tangentAttribute;
+                    header._features = bitsOf(primitive._features);
+                    header._drawMode = primitive._drawMode;
+                    header._elementsType = primitive._elementsType;
+                    header._attribs = primitive._attribs.size();
+                    header._elementsCount = primitive._elementsCount;
+                    header._stride = primitive._stride;
+                    header._aabb[0] = primitive._aabb.min().x;
+                    header._aabb[1] = primitive._aabb.min().y;
+                    header._aabb[2] = primitive._aabb.min().z;
+                    header._aabb[3] = primitive._aabb.max().x;
+                    header._aabb[4] = primitive._aabb.max().y;
+                    header._aabb[5] = primitive._aabb.max().z;
+                    header._positionDecode[0] = primitive._positionScale.x;
+                    header._positionDecode[1] = primitive._positionScale.y;
+                    header._positionDecode[2] = primitive._positionScale.z;
+                    header._positionDecode[3] = primitive._positionOffset.x;
+                    header._positionDecode[4] = primitive._positionOffset.y;
+                    header._positionDecode[5] = primitive._positionOffset.z;
+                    header._elementsSize = primitive._elements.size();
+                    header._verticesSize = primitive._vertices.size();
+
+                    write(output, header);
+                    for(Attrib const & attrib : primitive._attribs)
+                    {
+                        write(output, attrib);
+                    }
+                    writePadded(output, primitive._elements);
+                    writePadded(output, primitive._vertices);
+                }
+            });
+
+            // features are the same for all the locations
+            writeFile(featuresFilename(sourceHash, meshIndex, quantized), [&](std::ofstream & output)
+            {
+                std::vector<uint32_t> bits;
+                bits.reserve(data._primitives.size());
+                for(opengl::VertexData const & primitive : data._primitives)
+                {
+                    bits.push_back(bitsOf(primitive._features));
+                }
+
+                write(output, FileHeader{kFeaturesMagic, kVersion, sourceHash, meshIndex, quantized,
+                                         0, bits.size()});
+                writePadded(output, std::as_bytes(std::span(bits)));
+            });
+
+            MINIRE_DEBUG("mesh cache file is stored: {}", path);
+        }
+        catch(std::exception const & e)
+        {
+            MINIRE_WARNING("failed to store mesh cache file {}: {}", path, e.what());
+        }
+    }
+}
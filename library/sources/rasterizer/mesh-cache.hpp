@@ -0,0 +1,82 @@
+#pragma once
+
+#include <minire/content/id.hpp>
+#include <minire/material.hpp>
+#include <minire/models/mesh-features.hpp>
+
+#include <opengl/vertex-data.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace minire::content { class Manager; }
+
+namespace minire::rasterizer
+{
+    // Keeps VertexData of meshes in files of content::Manager::cacheDir(),
+    // a file is keyed by (a hash of the source, a mesh index, whether it's
+    // quantized, see models::SceneModel::_quantized, attribute locations
+    // of its primitives), so a source drawn by a few programs has a file
+    // per each. A cached mesh is mapped and uploaded as is, w/o decoding
+    // its source.
+    class MeshCache
+    {
+    public:
+        // of primitives of a mesh, in their order
+        using Locations = std::vector<material::Program::Locations>;
+
+        explicit MeshCache(content::Manager &);
+
+    public:
+        bool enabled() const;
+
+        // std::nullopt if the cache is disabled or the source can't be hashed
+        std::optional<uint64_t> sourceHash(content::Id const & source);
+
+        // hashes the source on a loader thread unless it's hashed already,
+        // so sourceHash doesn't read it; hashed is called by
+        // content::Manager::poll() (or right away)
+        void hashAsync(content::Id const & source, std::function<void()> hashed);
+
+        bool contains(uint64_t sourceHash, size_t meshIndex, bool quantized,
+                      Locations const &) const;
+
+        // whether a mesh is stored for any locations (see features)
+        bool contains(uint64_t sourceHash, size_t meshIndex, bool quantized) const;
+
+        // std::nullopt if there is no valid file
+        std::optional<opengl::MeshData> load(uint64_t sourceHash, size_t meshIndex,
+                                             bool quantized, Locations const &) const;
+
+        // features of primitives of a stored mesh (w/ any locations), to
+        // find out locations of its programs w/o its source
+        std::optional<std::vector<models::MeshFeatures>> features(uint64_t sourceHash,
+                                                                  size_t meshIndex,
+                                                                  bool quantized) const;
+
+        // NOTE: failures are logged only, the cache is an optimization
+        void store(uint64_t sourceHash, size_t meshIndex, bool quantized,
+                   opengl::MeshData const &) const;
+
+    private:
+        std::string filename(uint64_t sourceHash, size_t meshIndex, bool quantized,
+                             Locations const &) const;
+
+        std::string featuresFilename(uint64_t sourceHash, size_t meshIndex, bool quantized) const;
+
+    private:
+        using Hashes = std::unordered_map<content::Id, std::optional<uint64_t>>;
+        using Hashing = std::unordered_map<content::Id, std::vector<std::function<void()>>>;
+
+        content::Manager           & _contentManager;
+        Hashes                       _hashes;  // sources are hashed once per run
+        Hashing                      _hashing; // callbacks of sources in flight
+        std::shared_ptr<MeshCache>   _self;    // is expired for callbacks outliving it
+    };
+}
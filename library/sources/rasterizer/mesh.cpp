@@ -7,67 +7,180 @@
 #include <minire/utils/std-pair-hash.hpp>
 
 #include <rasterizer/materials.hpp>
+#include <rasterizer/mesh-cache.hpp>
 #include <utils/gltf-interpreters.hpp>
+#include <utils/mesh-optimizer.hpp>
 #include <utils/obj-interpreters.hpp>
 #include <utils/overloaded.hpp>
+#include <utils/vertex-quantizer.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <optional>
+#include <string_view>
 #include <variant>
 
 namespace minire::rasterizer
 {
+    namespace
+    {
+        // of vertices as they're uploaded, see models::SceneModel::_quantized
+        models::MeshFeatures uploaded(models::MeshFeatures const & features, bool quantized)
+        {
+            return models::MeshFeatures(features.hasUv(), features.hasNormal(),
+                                        features.hasTangent(), quantized);
+        }
+    }
+
+    bool Mesh::loadCachedObj(content::Id const & id,
+                             models::SceneModel const & sceneModel,
+                             MeshCache const & meshCache,
+                             uint64_t sourceHash,
+                             Materials const & materials,
+                             Ubo const & ubo)
+    {
+        auto const & defaultMaterial = sceneModel._defaultMaterial;
+        std::optional<std::vector<models::MeshFeatures>> const features =
+            meshCache.features(sourceHash, sceneModel._meshIndex, sceneModel._quantized);
+        if (!features || features->size() != 1 || !defaultMaterial)
+        {
+            return false;
+        }
+
+        // the file is looked up by locations of the program
+        auto matProgram = materials.build(*defaultMaterial, features->front(), ubo);
+        auto matInstance = materials.instantiate(*defaultMaterial, features->front());
+
+        MINIRE_INVARIANT(matProgram, "no material program for {}", id);
+        MINIRE_INVARIANT(matInstance, "no material instance for {}", id);
+
+        std::optional<opengl::MeshData> data = meshCache.load(sourceHash, sceneModel._meshIndex,
+                                                               sceneModel._quantized,
+                                                               {matProgram->locations()});
+        if (!data)
+        {
+            return false;
+        }
+
+        opengl::VertexData const & primitive = data->_primitives.front();
+        MINIRE_INFO("Loading a mesh from cache: {}", sceneModel._source);
+        _aabb = primitive._aabb;
+        _primitives.emplace_back(Primitive{primitive.upload()});
+        _materials.emplace_back(Material{std::move(matProgram), std::move(matInstance), {0}});
+        return true;
+    }
+
+    void Mesh::loadObj(content::Id const & id,
+                       models::SceneModel const & sceneModel,
+                       MeshCache & meshCache,
+                       std::optional<uint64_t> const & sourceHash,
+                       Materials const & materials,
+                       Ubo const & ubo,
+                       ObjBuilder const & build)
+    {
+        auto const & defaultMaterial = sceneModel._defaultMaterial;
+        MINIRE_INVARIANT(defaultMaterial, "material not specified: {}", id);
+
+        material::Program::Sptr matProgram;
+        material::Instance::Uptr matInstance;
+        opengl::MeshData data = build([&](models::MeshFeatures const & features)
+        {
+            models::MeshFeatures const meshFeatures = uploaded(features, sceneModel._quantized);
+
+            matProgram = materials.build(*defaultMaterial, meshFeatures, ubo);
+            matInstance = materials.instantiate(*defaultMaterial, meshFeatures);
+
+            MINIRE_INVARIANT(matProgram, "no material program for {}", id);
+            MINIRE_INVARIANT(matInstance, "no material instance for {}", id);
+            return matProgram->locations();
+        });
+
+        data = utils::optimize(data);
+        if (sceneModel._quantized)
+        {
+            data = utils::quantize(data);
+        }
+
+        if (sourceHash)
+        {
+            meshCache.store(*sourceHash, models::SceneModel::kNoIndex, sceneModel._quantized, data);
+        }
+
+        opengl::VertexBuffer vertexBuffer = data._primitives.front().upload();
+        _aabb.extend(vertexBuffer._aabb);
+
+        _primitives.emplace_back(Primitive{std::move(vertexBuffer)});
+        _materials.emplace_back(Material{std::move(matProgram), std::move(matInstance), {0}});
+    }
+
     void Mesh::loadPrimitives(content::Id const & id,
                                models::SceneModel const & sceneModel,
                                content::Manager & contentManager,
+                               MeshCache & meshCache,
+                               utils::GltfVbos & gltfVbos,
                                Materials const & materials,
                                Ubo const & ubo)
     {
         size_t const meshIndex = sceneModel._meshIndex;
         auto const & defaultMaterial = sceneModel._defaultMaterial;
 
+        // OBJ-meshes are taken from the cache as they are, while glTF-ones
+        // are still decoded for materials and textures
+        std::optional<uint64_t> const sourceHash = meshCache.sourceHash(sceneModel._source);
+        if (sourceHash &&
+            meshIndex == models::SceneModel::kNoIndex &&
+            loadCachedObj(id, sceneModel, meshCache, *sourceHash, materials, ubo))
+        {
+            return;
+        }
+
+        _aabb = utils::Aabb();
+
+        // OBJ-meshes which aren't resident are built right from their text,
+        // only GPU data is needed from them
+        if (meshIndex == models::SceneModel::kNoIndex && !contentManager.tryBorrow(sceneModel._source))
+        {
+            if (models::Blob::Sptr const source = contentManager.raw(sceneModel._source))
+            {
+                MINIRE_INFO("Loading a mesh from source text: {}", sceneModel._source);
+                models::Blob::Bytes const bytes = source->bytes();
+                std::string_view const text(reinterpret_cast<char const *>(bytes.data()), bytes.size());
+                return loadObj(id, sceneModel, meshCache, sourceHash, materials, ubo,
+                               [&text, &sceneModel](utils::LocationsOf const & locationsOf)
+                               {
+                                   return utils::createVertexData(text, sceneModel._source, locationsOf);
+                               });
+            }
+        }
+
         MINIRE_INFO("Loading a mesh from source: {}", sceneModel._source);
         auto lease = contentManager.borrow(sceneModel._source);
         assert(lease);
 
-        _aabb = utils::Aabb();
-
-        return lease->visit(utils::Overloaded
+        return lease.visit(utils::Overloaded
         {
-            [this, &id, meshIndex, &defaultMaterial, &materials, &ubo]
+            [this, &id, &sceneModel, meshIndex, &materials, &ubo, &meshCache, &sourceHash]
             (formats::Obj const & obj)
             {
-                MINIRE_INVARIANT(defaultMaterial, "material not specified: {}", id);
                 MINIRE_INVARIANT(meshIndex == models::SceneModel::kNoIndex,
                                  "OBJ-mesh cannot have an index: {}", id);
-                models::MeshFeatures meshFeatures = utils::getMeshFeatures(obj);
-
-                auto matProgram = materials.build(*defaultMaterial, meshFeatures, ubo);
-                auto matInstance = materials.instantiate(*defaultMaterial, meshFeatures);
-
-                MINIRE_INVARIANT(matProgram, "no material program for {}", id);
-                MINIRE_INVARIANT(matInstance, "no material instance for {}", id);
-
-                material::Program::Locations const & locations = matProgram->locations();
-                opengl::VertexBuffer vertexBuffer = utils::createVertexBuffer(
-                    obj,
-                    locations._vertexAttribute,
-                    locations._uvAttribute,
-                    locations._normalAttribute);
-
-                _aabb.extend(vertexBuffer._aabb);
-
-                _primitives.emplace_back(Primitive{std::move(vertexBuffer)});
-                _materials.emplace_back(Material{std::move(matProgram), std::move(matInstance), {0}});
+                loadObj(id, sceneModel, meshCache, sourceHash, materials, ubo,
+                        [&obj](utils::LocationsOf const & locationsOf)
+                        {
+                            return utils::createVertexData(obj, locationsOf(utils::getMeshFeatures(obj)));
+                        });
             },
 
-            [this, &id, meshIndex, &defaultMaterial, &materials, &ubo, &contentManager]
+            [this, &id, &sceneModel, meshIndex, &defaultMaterial, &materials, &ubo,
+             &contentManager, &meshCache, &sourceHash, &gltfVbos]
             (formats::GltfModelSptr const & gltf)
             {
                 MINIRE_INVARIANT(gltf, "gltf pointer is empty: {}", id);
                 MINIRE_INVARIANT(meshIndex != models::SceneModel::kNoIndex,
                                  "gLTF-mesh must have an index: {}", id);
 
-                auto prefetched = utils::prefetchGltfFeatures(gltf, meshIndex, contentManager);
+                auto prefetched = utils::prefetchGltfFeatures(gltf, sceneModel._source, meshIndex,
+                                                              contentManager);
 
                 using MatComboKey = std::pair<models::MeshFeatures, size_t>;
                 using MatMap = std::unordered_map<MatComboKey, Material>;
@@ -79,7 +192,9 @@ namespace minire::rasterizer
                 for(size_t primIndex = 0; primIndex < prefetched._primitives.size(); ++primIndex)
                 {
                     auto const & primitive = prefetched._primitives[primIndex];
-                    MatComboKey key(primitive._meshFeatures, primitive._materialModel);
+                    models::MeshFeatures const meshFeatures = uploaded(primitive._meshFeatures,
+                                                                       sceneModel._quantized);
+                    MatComboKey key(meshFeatures, primitive._materialModel);
                     auto it = materialsMap.find(key);
                     if (it == materialsMap.cend())
                     {
@@ -95,8 +210,8 @@ namespace minire::rasterizer
                             useDefault ? *defaultMaterial
                                        : *prefetched._materialModels[primitive._materialModel];
 
-                        auto matProgram = materials.build(effectiveMaterial, primitive._meshFeatures, ubo);
-                        auto matInstance = materials.instantiate(effectiveMaterial, primitive._meshFeatures);
+                        auto matProgram = materials.build(effectiveMaterial, meshFeatures, ubo);
+                        auto matInstance = materials.instantiate(effectiveMaterial, meshFeatures);
 
                         MINIRE_INVARIANT(matProgram, "no material program for {}", id);
                         MINIRE_INVARIANT(matInstance, "no material instance for {}", id);
@@ -117,8 +232,40 @@ namespace minire::rasterizer
                     _materials.emplace_back(std::move(material));
                 }
 
-                std::vector<opengl::VertexBuffer> vertexBuffers = utils::createVertexBuffers(
-                    *gltf, meshIndex, locationsForPrims);
+                // quantized and cached primitives go through VertexData, and
+                // are optimized, the rest are uploaded as they're authored;
+                // either way primitives share VBOs and are grouped
+                std::optional<opengl::MeshData> data;
+                if (sourceHash)
+                {
+                    // cached primitives are keyed by their locations
+                    data = meshCache.load(*sourceHash, meshIndex, sceneModel._quantized, locationsForPrims);
+                }
+
+                if (!data && (sourceHash || sceneModel._quantized))
+                {
+                    data = utils::optimize(utils::createVertexData(gltf, meshIndex, locationsForPrims));
+                    if (sceneModel._quantized)
+                    {
+                        data = utils::quantize(*data);
+                    }
+
+                    if (sourceHash)
+                    {
+                        meshCache.store(*sourceHash, meshIndex, sceneModel._quantized, *data);
+                    }
+                }
+
+                std::vector<opengl::VertexBuffer> vertexBuffers;
+                if (data)
+                {
+                    vertexBuffers = opengl::upload(*data);
+                }
+                else
+                {
+                    vertexBuffers = utils::createVertexBuffers(gltf, sceneModel._source, meshIndex,
+                                                               locationsForPrims, gltfVbos);
+                }
                 assert(vertexBuffers.size() == prefetched._primitives.size());
                 _primitives.reserve(vertexBuffers.size());
                 for(opengl::VertexBuffer & vertexBuffer : vertexBuffers)
@@ -126,6 +273,8 @@ namespace minire::rasterizer
                     _aabb.extend(vertexBuffer._aabb);
                     _primitives.emplace_back(std::move(vertexBuffer));
                 }
+
+                groupPrimitives();
             },
 
             [&id](auto const &)
@@ -135,13 +284,47 @@ namespace minire::rasterizer
         });
     }
 
+    void Mesh::groupPrimitives()
+    {
+        // primitives of a material which share VBOs are drawn by one call
+        for(Material & material : _materials)
+        {
+            std::vector<size_t> groups;
+            for(size_t const primIndex : material._primitives)
+            {
+                opengl::VertexBuffer const & buffer = _primitives[primIndex]._buffer;
+                auto const group = std::find_if(groups.cbegin(), groups.cend(),
+                                                [this, &buffer](size_t const group)
+                                                {
+                                                    return _primitives[group]._buffer.drawableWith(buffer);
+                                                });
+                if (group != groups.cend())
+                {
+                    _primitives[*group]._buffer.append(buffer);
+                }
+                else
+                {
+                    groups.push_back(primIndex);
+                }
+            }
+
+            if (groups.size() < material._primitives.size())
+            {
+                MINIRE_DEBUG("{} primitives are drawn by {} calls", material._primitives.size(), groups.size());
+            }
+            material._primitives = std::move(groups);
+        }
+    }
+
     Mesh::Mesh(content::Id const & id,
                models::SceneModel const & sceneModel,
                content::Manager & contentManager,
+               MeshCache & meshCache,
+               utils::GltfVbos & gltfVbos,
                Materials const & materials,
                Ubo const & ubo)
     {
-        loadPrimitives(id, sceneModel, contentManager, materials, ubo);
+        loadPrimitives(id, sceneModel, contentManager, meshCache, gltfVbos, materials, ubo);
     }
 
     void Mesh::draw(glm::mat4 const & modelTransform,
@@ -157,7 +340,10 @@ namespace minire::rasterizer
             for(size_t const primIndex : material._primitives)
             {
                 assert(primIndex < _primitives.size());
-                _primitives[primIndex]._buffer.drawElements();
+                opengl::VertexBuffer const & buffer = _primitives[primIndex]._buffer;
+                material._matProgram->preparePrimitive(buffer._positionScale,
+                                                       buffer._positionOffset);
+                buffer.drawElements();
             }
         }
     }
@@ -6,10 +6,14 @@
 #include <minire/utils/aabb.hpp>
 
 #include <opengl/vertex-buffer.hpp>
+#include <utils/gltf-interpreters.hpp>
+#include <utils/obj-interpreters.hpp>
 
 #include <glm/mat4x4.hpp>
 
+#include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -18,6 +22,7 @@ namespace minire::content { class Manager; }
 namespace minire::rasterizer
 {
     class Materials;
+    class MeshCache;
     class Ubo;
 
     class Mesh final
@@ -28,6 +33,8 @@ namespace minire::rasterizer
         explicit Mesh(content::Id const & id,
                       models::SceneModel const &,
                       content::Manager &,
+                      MeshCache &,
+                      utils::GltfVbos &,
                       Materials const &,
                       Ubo const &);
 
@@ -54,9 +61,34 @@ namespace minire::rasterizer
         void loadPrimitives(content::Id const & id,
                             models::SceneModel const & sceneModel,
                             content::Manager & contentManager,
+                            MeshCache & meshCache,
+                            utils::GltfVbos & gltfVbos,
                             Materials const & materials,
                             Ubo const & ubo);
 
+        // an OBJ-mesh w/o decoding its source, false if it isn't cached
+        bool loadCachedObj(content::Id const & id,
+                           models::SceneModel const & sceneModel,
+                           MeshCache const & meshCache,
+                           uint64_t sourceHash,
+                           Materials const & materials,
+                           Ubo const & ubo);
+
+        // builds data of an OBJ-mesh for the locations of its program
+        using ObjBuilder = std::function<opengl::MeshData(utils::LocationsOf const &)>;
+
+        void loadObj(content::Id const & id,
+                     models::SceneModel const & sceneModel,
+                     MeshCache & meshCache,
+                     std::optional<uint64_t> const & sourceHash,
+                     Materials const & materials,
+                     Ubo const & ubo,
+                     ObjBuilder const & build);
+
+        // Merges primitives of each material which can be drawn by one
+        // call (see opengl::VertexBuffer::append), the rest stay unused
+        void groupPrimitives();
+
     private:
         std::vector<Material>  _materials;
         std::vector<Primitive> _primitives;
@@ -6,6 +6,7 @@
 
 #include <cassert>
 #include <algorithm>
+#include <exception>
 
 namespace minire::rasterizer
 {
@@ -17,6 +18,8 @@ namespace minire::rasterizer
         : _contentManager(contentManager)
         , _ubo(ubo)
         , _materials(materials)
+        , _cache(contentManager)
+        , _self(this, [](Meshes *) {})
     {}
 
     void Meshes::incUse(content::Id const & id)
@@ -24,12 +27,23 @@ namespace minire::rasterizer
         load(id);
         ++_store[id]._usage;
     }
+
+    void Meshes::incUseAsync(content::Id const & id)
+    {
+        loadAsync(id);
+        ++_store[id]._usage;
+    }
     
+    void Meshes::preload(content::Id const & id)
+    {
+        load(id);
+    }
+
     void Meshes::decUse(content::Id const & id)
     {
-        if (!_store[id]._init)
+        if (_store[id]._usage <= 0)
         {
-            MINIRE_THROW("cannot decrease usage for non-loaded model: {}", id);
+            MINIRE_THROW("cannot decrease usage for non-used model: {}", id);
         }
 
         --_store[id]._usage;
@@ -47,17 +61,133 @@ namespace minire::rasterizer
 
         if (!item._init)
         {
-            // load a model itself
+            // load a model itself (waits for it if it's loading already)
             auto lease = _contentManager.borrow(id);
             assert(lease);
-            models::SceneModel const & sceneModel = lease->as<models::SceneModel>();
-            item._model = std::make_unique<Mesh>(id, sceneModel, _contentManager,
-                                                 _materials, _ubo);
+            emplace(id, lease.as<models::SceneModel>());
+        }
+    }
+
+    void Meshes::loadAsync(content::Id const & id)
+    {
+        auto & item = _store[id];
+        if (item._init || item._loading) return;
+        item._loading = true;
+
+        // the scene model first, then a hash of its source (to look it up
+        // in the cache), and then the source itself, which is the heavy one
+        std::weak_ptr<Meshes> self = _self;
+        _contentManager.borrowAsync(id,
+            [self, id](content::Lease model,
+                       std::exception_ptr error)
+            {
+                auto meshes = self.lock();
+                if (!meshes) return;
+
+                try
+                {
+                    if (error) std::rethrow_exception(error);
+                    assert(model);
+
+                    models::SceneModel const & sceneModel = model.as<models::SceneModel>();
+                    meshes->_cache.hashAsync(sceneModel._source,
+                        [self, id, model]
+                        {
+                            if (auto meshes = self.lock())
+                            {
+                                meshes->fetchSource(id, model);
+                            }
+                        });
+                }
+                catch(std::exception const & e)
+                {
+                    meshes->failed(id, e.what());
+                }
+            });
+    }
+
+    void Meshes::fetchSource(content::Id const & id, content::Lease model)
+    {
+        try
+        {
+            models::SceneModel const & sceneModel = model.as<models::SceneModel>();
+            if (cached(sceneModel))
+            {
+                if (!_store[id]._init) emplace(id, sceneModel);
+                return;
+            }
+
+            std::weak_ptr<Meshes> self = _self;
+            _contentManager.borrowAsync(sceneModel._source,
+                [self, id, model](content::Lease,
+                                  std::exception_ptr error)
+                {
+                    auto meshes = self.lock();
+                    if (!meshes) return;
+
+                    try
+                    {
+                        if (error) std::rethrow_exception(error);
 
-            // mark slot as initialized
-            item._init = true;
-            MINIRE_INFO("Loading model: {}", id);
+                        // the source is held by the Lease till the end,
+                        // so the Mesh finds it in the content::Manager
+                        if (!meshes->_store[id]._init)
+                        {
+                            meshes->emplace(id, model.as<models::SceneModel>());
+                        }
+                    }
+                    catch(std::exception const & e)
+                    {
+                        meshes->failed(id, e.what());
+                    }
+                });
         }
+        catch(std::exception const & e)
+        {
+            failed(id, e.what());
+        }
+    }
+
+    void Meshes::failed(content::Id const & id, char const * reason)
+    {
+        _store[id]._loading = false;
+        MINIRE_ERROR("failed to load model {}: {}", id, reason);
+    }
+
+    void Meshes::emplace(content::Id const & id,
+                         models::SceneModel const & sceneModel)
+    {
+        auto & item = _store[id];
+        assert(!item._init);
+
+        item._model = std::make_unique<Mesh>(id, sceneModel, _contentManager,
+                                             _cache, _gltfVbos, _materials, _ubo);
+        item._aabb = item._model->aabb();
+
+        // mark slot as initialized
+        item._init = true;
+        item._loading = false;
+        MINIRE_INFO("Loading model: {}", id);
+    }
+
+    void Meshes::cachedAsync(models::SceneModel const & sceneModel,
+                             std::function<void(bool)> done)
+    {
+        _cache.hashAsync(sceneModel._source,
+            [this, sceneModel, done = std::move(done)]
+            {
+                // the cache is a member, so it's alive while it calls back
+                done(cached(sceneModel));
+            });
+    }
+
+    bool Meshes::cached(models::SceneModel const & sceneModel)
+    {
+        // glTF-meshes need their materials anyway
+        if (sceneModel._meshIndex != models::SceneModel::kNoIndex) return false;
+
+        std::optional<uint64_t> const sourceHash = _cache.sourceHash(sceneModel._source);
+        return sourceHash && _cache.contains(*sourceHash, sceneModel._meshIndex, sceneModel._quantized);
     }
 
     void Meshes::unload(content::Id const & id)
@@ -68,15 +198,20 @@ namespace minire::rasterizer
         }
     }
 
+    bool Meshes::ready(content::Id const & id) const
+    {
+        auto const it = _store.find(id);
+        return it != _store.cend() && it->second._init;
+    }
+
     utils::Aabb const & Meshes::aabb(content::Id const & id) const
     {
         auto const & it = _store.find(id);
-        if (it == _store.cend() || !it->second._init)
+        if (it == _store.cend() || (!it->second._init && !it->second._loading))
         {
             MINIRE_THROW("model {} is not loaded", id);
         }
-        assert(it->second._model);
-        return it->second._model->aabb();
+        return it->second._aabb;
     }
 
     void Meshes::draw(scene::ModelRef::List & entities) const
@@ -86,9 +221,9 @@ namespace minire::rasterizer
         for(scene::ModelRef const & entity : entities)
         {
             StoreItem const & modelData = _store.at(entity._model);
+            if (!modelData._init) continue; // still loading
 
             assert(modelData._model);
-            assert(modelData._init);
             assert(entity._transform);
 
             modelData._model->draw(*entity._transform, entity._colorFactor);
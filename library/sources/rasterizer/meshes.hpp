@@ -3,16 +3,18 @@
 #include <minire/content/id.hpp>
 #include <minire/utils/aabb.hpp>
 
+#include <rasterizer/mesh-cache.hpp>
 #include <rasterizer/mesh.hpp>
 #include <scene/model.hpp>
 
+#include <functional>
 #include <limits>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
-namespace minire::content { class Manager; }
+namespace minire::content { class Lease; class Manager; }
 
 namespace minire::rasterizer
 {
@@ -30,27 +32,59 @@ namespace minire::rasterizer
 
         void incUse(content::Id const &); // will also load()
 
+        // the mesh is loaded in background (see content::Manager::poll),
+        // it isn't drawn until ready() and has a unit aabb till then
+        void incUseAsync(content::Id const &);
+
         void decUse(content::Id const &); // will also unload()
 
+        // loads the mesh w/o using it (see rasterizer::Warmup)
+        void preload(content::Id const &);
+
+        bool ready(content::Id const &) const;
+
+        // tells whether the mesh can be built w/o decoding its source, the
+        // source is hashed on a loader thread, so done is called by
+        // content::Manager::poll() (or right away if it's hashed already)
+        void cachedAsync(models::SceneModel const &, std::function<void(bool)> done);
+
+        // NOTE: a reference stays valid while the mesh is used
         utils::Aabb const & aabb(content::Id const &) const;
 
     private:
         void load(content::Id const &);
+        void loadAsync(content::Id const &);
         void unload(content::Id const &);
 
+        void emplace(content::Id const &, models::SceneModel const &);
+
+        // NOTE: the source is to be hashed already (see cachedAsync)
+        bool cached(models::SceneModel const &);
+
+        // emplaces the model once its source is borrowed, unless it's cached
+        void fetchSource(content::Id const &, content::Lease model);
+
+        void failed(content::Id const &, char const * reason);
+
     private:
         struct StoreItem
         {
-            Mesh::Uptr _model;
-            int        _usage = 0;
-            bool       _init = false;
+            Mesh::Uptr  _model;
+            int         _usage = 0;
+            bool        _init = false;
+            bool        _loading = false;
+            utils::Aabb _aabb = utils::Aabb(-0.5f, -0.5f, -0.5f,
+                                             0.5f,  0.5f,  0.5f);
         };
 
         using Store = std::unordered_map<content::Id, StoreItem>;
 
-        content::Manager & _contentManager;
-        Ubo const &        _ubo;
-        Materials const &  _materials;
-        Store              _store;
+        content::Manager      & _contentManager;
+        Ubo const &             _ubo;
+        Materials const &       _materials;
+        MeshCache               _cache;
+        utils::GltfVbos         _gltfVbos;
+        Store                   _store;
+        std::shared_ptr<Meshes> _self; // is expired for callbacks outliving it
     };
 }
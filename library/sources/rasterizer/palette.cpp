@@ -0,0 +1,114 @@
+#include <rasterizer/palette.hpp>
+
+#include <minire/errors.hpp>
+
+#include <glm/gtc/packing.hpp> // for glm::packUnorm4x8
+
+#include <array>
+#include <cassert>
+
+namespace minire::rasterizer
+{
+    namespace
+    {
+        uint32_t rgb(uint32_t r, uint32_t g, uint32_t b)
+        {
+            return r | (g << 8) | (b << 16) | (0xFFu << 24);
+        }
+
+        // see xterm's 256colres.h
+        std::vector<uint32_t> xtermColors()
+        {
+            static const std::array<uint32_t, 16> kSystem{
+                rgb(0x00, 0x00, 0x00), rgb(0xCD, 0x00, 0x00),
+                rgb(0x00, 0xCD, 0x00), rgb(0xCD, 0xCD, 0x00),
+                rgb(0x00, 0x00, 0xEE), rgb(0xCD, 0x00, 0xCD),
+                rgb(0x00, 0xCD, 0xCD), rgb(0xE5, 0xE5, 0xE5),
+                rgb(0x7F, 0x7F, 0x7F), rgb(0xFF, 0x00, 0x00),
+                rgb(0x00, 0xFF, 0x00), rgb(0xFF, 0xFF, 0x00),
+                rgb(0x5C, 0x5C, 0xFF), rgb(0xFF, 0x00, 0xFF),
+                rgb(0x00, 0xFF, 0xFF), rgb(0xFF, 0xFF, 0xFF),
+            };
+
+            std::vector<uint32_t> result(kSystem.cbegin(), kSystem.cend());
+            result.reserve(text::PackedSymbol::kPaletteSize);
+
+            // 6x6x6 cube
+            auto const level = [](uint32_t i) { return i ? 55 + i * 40 : 0; };
+            for(uint32_t r(0); r < 6; ++r)
+            for(uint32_t g(0); g < 6; ++g)
+            for(uint32_t b(0); b < 6; ++b)
+            {
+                result.push_back(rgb(level(r), level(g), level(b)));
+            }
+
+            // grayscale ramp
+            for(uint32_t i(0); i < 24; ++i)
+            {
+                uint32_t const gray = 8 + i * 10;
+                result.push_back(rgb(gray, gray, gray));
+            }
+
+            assert(result.size() == text::PackedSymbol::kPaletteSize);
+            return result;
+        }
+    }
+
+    Palette::Palette()
+        : _colors(xtermColors())
+    {}
+
+    void Palette::set(size_t first, std::vector<glm::vec4> const & colors)
+    {
+        MINIRE_INVARIANT(first + colors.size() <= text::PackedSymbol::kPaletteSize,
+                         "palette overflow: {} colors from {}",
+                         colors.size(), first);
+
+        for(size_t i(0); i < colors.size(); ++i)
+        {
+            _colors[first + i] = glm::packUnorm4x8(colors[i]);
+        }
+    }
+
+    std::optional<uint16_t> Palette::intern(glm::vec4 const & color)
+    {
+        uint32_t const rgba = glm::packUnorm4x8(color);
+
+        auto it = _trueColors.find(rgba);
+        if (it != _trueColors.cend()) return it->second;
+
+        if (_colors.size() >= kMaxSize) return std::nullopt;
+
+        uint16_t const index = static_cast<uint16_t>(_colors.size());
+        _colors.push_back(rgba);
+        _trueColors.emplace(rgba, index);
+        return index;
+    }
+
+    std::vector<uint16_t> Palette::compact(std::vector<bool> const & used)
+    {
+        assert(used.size() == _colors.size());
+
+        std::vector<uint16_t> remap(_colors.size());
+        size_t const first = text::PackedSymbol::kPaletteSize;
+        for(size_t i(0); i < first; ++i)
+        {
+            remap[i] = static_cast<uint16_t>(i);
+        }
+
+        _trueColors.clear();
+        size_t size = first;
+        for(size_t i = first; i < _colors.size(); ++i)
+        {
+            if (!used[i]) continue;
+
+            remap[i] = static_cast<uint16_t>(size);
+            _colors[size] = _colors[i];
+            _trueColors.emplace(_colors[size], remap[i]);
+            ++size;
+        }
+        _colors.resize(size);
+
+        return remap;
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <minire/text/packed-symbol.hpp>
+
+#include <glm/vec4.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace minire::rasterizer
+{
+    // Colors of a label, RGBA8. The first text::PackedSymbol::kPaletteSize
+    // entries are set by clients (xterm's 256 colors by default), the
+    // rest are true colors, interned on demand.
+    class Palette
+    {
+    public:
+        static constexpr size_t kMaxSize = 0x10000; // 16-bit indices
+
+        Palette();
+
+    public:
+        uint32_t rgba(uint16_t index) const
+        {
+            return index < _colors.size() ? _colors[index] : 0;
+        }
+
+        // NOTE: indices should be within the palette part
+        void set(size_t first, std::vector<glm::vec4> const & colors);
+
+        // returns std::nullopt if there is no room for a new true color
+        std::optional<uint16_t> intern(glm::vec4 const & color);
+
+        // drops true colors that are not marked as used, and returns
+        // a mapping from old indices to new ones
+        std::vector<uint16_t> compact(std::vector<bool> const & used);
+
+        size_t size() const { return _colors.size(); }
+
+    private:
+        std::vector<uint32_t>                  _colors;
+        std::unordered_map<uint32_t, uint16_t> _trueColors; // RGBA8 to index
+    };
+}
@@ -14,7 +14,9 @@
 #include <glm/mat4x4.hpp>
 #include <glm/gtc/type_ptr.hpp> // for gln::value_ptr
 
+#include <algorithm>
 #include <cassert>
+#include <functional> // for std::less
 #include <variant>
 #include <vector>
 
@@ -128,11 +130,11 @@ namespace minire::rasterizer
         class TileInfoVisitor
         {
         public:
-            TileInfoVisitor(Textures::Texture const & texture,
+            TileInfoVisitor(Textures::Region const & region,
                             glm::vec2 const & position,
                             glm::vec2 const & dimensions,
                             std::vector<Vertex> & vertices)
-                : _texture(texture)
+                : _origin(region._x, region._y)
                 , _position(position)
                 , _dimensions(dimensions)
                 , _vertices(vertices)
@@ -308,7 +310,7 @@ namespace minire::rasterizer
 
                 for(int i(0); i < 6; ++i)
                 {
-                    out[offset + i]._rep = glm::vec2(left, top);
+                    out[offset + i]._rep = _origin + glm::vec2(left, top);
                     out[offset + i]._dims = texMinSz;
                 }
 
@@ -316,7 +318,7 @@ namespace minire::rasterizer
             }
 
         private:
-            Textures::Texture const & _texture;
+            glm::vec2                 _origin; // of an image on an atlas page
             glm::vec2                 _position;
             glm::vec2                 _dimensions;
             std::vector<Vertex> &     _vertices;
@@ -325,28 +327,101 @@ namespace minire::rasterizer
 
     // Sprites::Sprite //
 
-    class Sprites::Sprite : public Drawable
+    class Sprites::Sprite
     {
     public:
-        Sprite(Textures::Texture::Sptr texture,
+        Sprite(Textures::Region const & region,
                TileInfo tileInfo,
                glm::vec2 const & position,
                glm::vec2 const & dimensions,
-               bool visible, int z,
-               Program const & program)
-            : Drawable(z)
-            , _texture(texture)
+               bool visible, size_t z)
+            : _region(region)
             , _tileInfo(tileInfo)
             , _position(position)
             , _dimensions(dimensions)
             , _visible(visible)
-            , _program(program)
-            , _vao(std::make_shared<opengl::VAO>())
-            , _vbo(_vao, GL_ARRAY_BUFFER)
+            , _zOrder(z)
+            , _vertices(getTileInfoSize(_tileInfo))
             , _invalidated(true)
         {
-            MINIRE_INVARIANT(_texture, "sprite created w/o a texture");
+            MINIRE_INVARIANT(_region._page, "sprite created w/o a texture");
+        }
+
+    public:
+        bool visible() const { return _visible; }
+
+        size_t zOrder() const { return _zOrder; }
+
+        Textures::Page const * page() const { return _region._page; }
+
+        bool invalidated() const { return _invalidated; }
+
+        void setPosition(glm::vec2 const & p)
+        {
+            _position = p;
+            _invalidated = true;
+        }
+
+        void setDimensions(glm::vec2 const & d)
+        {
+            if (std::holds_alternative<utils::Rect>(_tileInfo))
+            {
+                MINIRE_THROW("should not set dimensions for sprite!");
+            }
+
+            _dimensions = d;
+            _invalidated = true;
+        }
+
+        void setVisible(bool visible)
+        {
+            _visible = visible;
+        }
+
+        void setZOrder(size_t z)
+        {
+            _zOrder = z;
+        }
+
+    public:
+        std::vector<Vertex> const & vertices() const
+        {
+            if (_invalidated)
+            {
+                TileInfoVisitor visitor(_region, _position, _dimensions, _vertices);
+                std::visit(visitor, _tileInfo);
+                _invalidated = false;
+            }
+            return _vertices;
+        }
+
+        // in vertices, from the beginning of the stream
+        size_t streamOffset() const { return _streamOffset; }
 
+        void setStreamOffset(size_t offset) const { _streamOffset = offset; }
+
+    private:
+        Textures::Region            _region;
+        TileInfo                    _tileInfo;
+        glm::vec2                   _position;
+        glm::vec2                   _dimensions;
+        bool                        _visible;
+        size_t                      _zOrder;
+
+        mutable std::vector<Vertex> _vertices;
+        mutable bool                _invalidated;
+        mutable size_t              _streamOffset = 0;
+    };
+
+    // Sprites::Stream //
+
+    class Sprites::Stream
+    {
+    public:
+        Stream()
+            : _vao(std::make_shared<opengl::VAO>())
+            , _vbo(_vao, GL_ARRAY_BUFFER)
+        {
             size_t const stride = sizeof(Vertex);
             size_t pointer = 0;
 
@@ -368,82 +443,110 @@ namespace minire::rasterizer
             // layout(location = 3) in vec2 bznkDims;
             _vao->enableAttrib(3);
             _vao->attribPointer(3, 2, GL_FLOAT, GL_FALSE, stride, pointer);
-            pointer += sizeof(Vertex::_rep);
-
-            // allocate storage
-            _vertices.resize(getTileInfoSize(_tileInfo));
-            _vbo.bufferData(_vertices.size() * sizeof(Vertex),
-                            nullptr, GL_STATIC_DRAW);
+            pointer += sizeof(Vertex::_dims);
         }
 
     public:
-        bool visible() const { return _visible; }
-
-        void setPosition(glm::vec2 const & p)
+        // lays out all the sprites in the given order and uploads them
+        void rebuild(Order const & order)
         {
-            _position = p;
-            _invalidated = true;
+            _staging.clear();
+            for(Sprite const * sprite : order)
+            {
+                assert(sprite);
+                std::vector<Vertex> const & vertices = sprite->vertices();
+                sprite->setStreamOffset(_staging.size());
+                _staging.insert(_staging.end(), vertices.cbegin(), vertices.cend());
+            }
+
+            // NOTE: re-specifying the storage orphans the old one
+            //       and that avoids stalls on buffers still in use
+            _vbo.bufferData(_staging.size() * sizeof(Vertex),
+                            _staging.data(), GL_DYNAMIC_DRAW);
         }
 
-        void setDimensions(glm::vec2 const & d)
+        // re-uploads moved or resized sprites in place
+        void refresh(Order const & order)
         {
-            if (std::holds_alternative<utils::Rect>(_tileInfo))
+            for(Sprite const * sprite : order)
             {
-                MINIRE_THROW("should not set dimensions for sprite!");
+                assert(sprite);
+                if (!sprite->invalidated()) continue;
+
+                std::vector<Vertex> const & vertices = sprite->vertices();
+                _vbo.bufferSubData(sprite->streamOffset() * sizeof(Vertex),
+                                   vertices.size() * sizeof(Vertex),
+                                   vertices.data());
             }
+        }
 
-            _dimensions = d;
-            _invalidated = true;
+        void bind() const
+        {
+            _vao->bind();
         }
 
-        void setVisible(bool visible)
+    private:
+        opengl::VAO::Sptr   _vao;
+        opengl::VBO         _vbo;
+        std::vector<Vertex> _staging;
+    };
+
+    // Sprites::Batch //
+
+    // A range of the stream that shares an atlas page
+    class Sprites::Batch : public Drawable
+    {
+    public:
+        Batch(size_t z,
+              Textures::Page const & page,
+              size_t first,
+              size_t count,
+              Program const & program,
+              Stream const & stream)
+            : Drawable(z)
+            , _page(page)
+            , _first(first)
+            , _count(count)
+            , _lastZOrder(z)
+            , _program(program)
+            , _stream(stream)
+        {}
+
+    public:
+        Textures::Page const & page() const { return _page; }
+
+        size_t lastZOrder() const { return _lastZOrder; }
+
+        size_t end() const { return _first + _count; }
+
+        void extend(size_t count, size_t z)
         {
-            _visible = visible;
+            assert(z >= _lastZOrder);
+            _count += count;
+            _lastZOrder = z;
         }
 
         void draw(glm::mat4 const & projection) const override
         {
-            revalidate();
-
             _program.use();
             _program.setProjUniform(projection);
             _program.setTextureUniform(0);
 
             MINIRE_GL(glActiveTexture, GL_TEXTURE0);
-            _texture->bind();
+            _page.bind();
 
-            _vao->bind();
-            _vbo.bind();
-
-            MINIRE_GL(glDrawArrays, GL_TRIANGLES, 0, _vertices.size());
-        }
+            _stream.bind();
 
-    private:
-        void revalidate() const
-        {
-            if (_invalidated)
-            {
-                assert(_texture);
-                TileInfoVisitor visitor(*_texture, _position, _dimensions, _vertices);
-                std::visit(visitor, _tileInfo);
-                _vbo.bufferSubData(0, _vertices.size() * sizeof(Vertex),
-                                   _vertices.data());
-                _invalidated = false;
-            }
+            MINIRE_GL(glDrawArrays, GL_TRIANGLES, _first, _count);
         }
 
     private:
-        Textures::Texture::Sptr     _texture;
-        TileInfo                    _tileInfo;
-        glm::vec2                   _position;
-        glm::vec2                   _dimensions;
-        bool                        _visible;
-        Program const &             _program;
-
-        mutable std::vector<Vertex> _vertices;
-        mutable opengl::VAO::Sptr   _vao;
-        mutable opengl::VBO         _vbo;
-        mutable bool                _invalidated;
+        Textures::Page const & _page;
+        size_t                 _first;  // in vertices
+        size_t                 _count;  // in vertices
+        size_t                 _lastZOrder;
+        Program const &        _program;
+        Stream const &         _stream;
     };
 
     // Sprites //
@@ -451,6 +554,7 @@ namespace minire::rasterizer
     Sprites::Sprites(Textures const & textures)
         : _textures(textures)
         , _program(std::make_unique<Program>())
+        , _stream(std::make_unique<Stream>())
     {}
 
     Sprites::~Sprites() = default;
@@ -462,14 +566,8 @@ namespace minire::rasterizer
                          bool const visible,
                          int const z)
     {
-        auto res = _store.emplace(id,
-            std::make_unique<Sprite>(_textures.getNoMipmap(texture), tile,
-                                     position, glm::vec2(), visible, z,
-                                     *_program));
-        if (!res.second)
-        {
-            MINIRE_THROW("sprite alrady exists: \"{}\"", id);
-        }
+        add(id, std::make_unique<Sprite>(_textures.getAtlased(texture), tile,
+                                         position, glm::vec2(), visible, z));
     }
 
     void Sprites::create(std::string const & id,
@@ -480,14 +578,18 @@ namespace minire::rasterizer
                          bool const visible,
                          int const z)
     {
-        auto res = _store.emplace(id,
-            std::make_unique<Sprite>(_textures.getNoMipmap(texture), tile,
-                                     position, dimensions, visible, z,
-                                     *_program));
+        add(id, std::make_unique<Sprite>(_textures.getAtlased(texture), tile,
+                                         position, dimensions, visible, z));
+    }
+
+    void Sprites::add(std::string const & id, SpritePtr sprite)
+    {
+        auto res = _store.emplace(id, std::move(sprite));
         if (!res.second)
         {
             MINIRE_THROW("sprite alrady exists: \"{}\"", id);
         }
+        _reorder = true;
     }
 
     void Sprites::move(std::string const & id,
@@ -505,18 +607,31 @@ namespace minire::rasterizer
     void Sprites::visible(std::string const & id,
                           bool visible)
     {
-        find(id).setVisible(visible);
+        Sprite & sprite = find(id);
+        if (sprite.visible() != visible)
+        {
+            sprite.setVisible(visible);
+            _reorder = true;
+        }
     }
 
     void Sprites::setZOrder(std::string const & id,
                             size_t zOrder)
     {
-        find(id).setZOrder(zOrder);
+        Sprite & sprite = find(id);
+        if (sprite.zOrder() != zOrder)
+        {
+            sprite.setZOrder(zOrder);
+            _reorder = true;
+        }
     }
 
     void Sprites::remove(std::string const & id)
     {
-        _store.erase(id);
+        if (_store.erase(id))
+        {
+            _reorder = true;
+        }
     }
 
     Sprites::Sprite & Sprites::find(std::string const & id) const
@@ -526,16 +641,99 @@ namespace minire::rasterizer
         return *it->second;
     }
 
-    void Sprites::predraw(Drawable::PtrsList & out) const
+    void Sprites::reorder() const
     {
-        // TODO: sort by visibility
-        // TODO: sort by texture
+        _order.clear();
         for(auto const & sprite : _store)
         {
             if (sprite.second->visible())
             {
-                out.push_back(sprite.second.get());
+                _order.push_back(sprite.second.get());
+            }
+        }
+
+        std::sort(_order.begin(), _order.end(),
+            [](Sprite const * a, Sprite const * b)
+            {
+                if (a->zOrder() != b->zOrder()) return a->zOrder() < b->zOrder();
+                return std::less<Textures::Page const *>{}(a->page(), b->page());
+            });
+
+        _stream->rebuild(_order);
+        _reorder = false;
+    }
+
+    void Sprites::batch(Drawable::PtrsList const & others) const
+    {
+        // a batch cannot span over a z-order of any other drawable
+        std::vector<size_t> barriers;
+        barriers.reserve(others.size());
+        for(Drawable const * other : others)
+        {
+            assert(other);
+            barriers.push_back(other->zOrder());
+        }
+        std::sort(barriers.begin(), barriers.end());
+
+        auto const crosses = [&barriers](size_t fromZ, size_t toZ)
+        {
+            if (fromZ == toZ) return false;
+            auto it = std::lower_bound(barriers.cbegin(), barriers.cend(), fromZ);
+            return it != barriers.cend() && *it <= toZ;
+        };
+
+        _batches.clear();
+        for(Sprite const * sprite : _order)
+        {
+            size_t const count = sprite->vertices().size();
+
+            if (!_batches.empty())
+            {
+                Batch & last = _batches.back();
+                if (&last.page() == sprite->page() &&
+                    !crosses(last.lastZOrder(), sprite->zOrder()))
+                {
+                    assert(last.end() == sprite->streamOffset());
+                    last.extend(count, sprite->zOrder());
+                    continue;
+                }
             }
+
+            _batches.emplace_back(sprite->zOrder(), *sprite->page(),
+                                  sprite->streamOffset(), count,
+                                  *_program, *_stream);
+        }
+    }
+
+    void Sprites::zOrders(std::vector<size_t> & out) const
+    {
+        if (_reorder)
+        {
+            reorder();
+        }
+
+        for(Sprite const * sprite : _order)
+        {
+            out.push_back(sprite->zOrder());
+        }
+    }
+
+    void Sprites::predraw(Drawable::PtrsList & out) const
+    {
+        if (_reorder)
+        {
+            reorder();
+        }
+        else
+        {
+            _stream->refresh(_order);
+        }
+
+        batch(out);
+
+        for(Batch const & batch : _batches)
+        {
+            out.push_back(&batch);
         }
     }
 }
@@ -10,20 +10,26 @@
 #include <string>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace minire::rasterizer
 {
     class Textures;
 
+    // All sprites share a single vertex stream, while their textures
+    // are packed into atlas pages. Sprites of a z-range that use the same
+    // page are drawn by a single draw call.
     class Sprites
     {
         class Sprite;
         class Program;
+        class Stream;
+        class Batch;
 
     public:
         explicit Sprites(Textures const &);
 
-        ~Sprites(); // because of std::unique_ptr<Program>
+        ~Sprites(); // because of std::unique_ptr<Program>, <Stream>
 
         void create(std::string const & id,
                     content::Id const & texture,
@@ -55,17 +61,35 @@ namespace minire::rasterizer
         void remove(std::string const & id);
 
     public:
+        // appends sorted z-orders of visible sprites
+        void zOrders(std::vector<size_t> & out) const;
+
+        // NOTE: batches are split by z-orders of drawables that are
+        //       already in the out, so it should be called the last one
         void predraw(Drawable::PtrsList & out) const;
 
     private:
         Sprite & find(std::string const &) const;
 
+        void add(std::string const &, std::unique_ptr<Sprite>);
+
+        void reorder() const;
+
+        void batch(Drawable::PtrsList const & others) const;
+
     private:
         using SpritePtr = std::unique_ptr<Sprite>;
         using Store = std::unordered_map<std::string, SpritePtr>;
+        using Order = std::vector<Sprite const *>;
+        using Batches = std::vector<Batch>;
 
         Textures const &          _textures;
         std::unique_ptr<Program>  _program;
+        std::unique_ptr<Stream>   _stream;
         Store                     _store;
+
+        mutable Order             _order;   // visible ones, sorted by (z, page)
+        mutable Batches           _batches;
+        mutable bool              _reorder = true;
     };
 }
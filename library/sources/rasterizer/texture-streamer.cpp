@@ -0,0 +1,260 @@
+#include <rasterizer/texture-streamer.hpp>
+
+#include <minire/errors.hpp>
+#include <minire/logging.hpp>
+#include <minire/models/image.hpp>
+
+#include <opengl/texture.hpp>
+#include <utils/downsample.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace minire::rasterizer
+{
+    TextureStreamer::TextureStreamer(size_t threads)
+        : _workers(threads)
+    {}
+
+    TextureStreamer::~TextureStreamer()
+    {
+        MINIRE_INFO("texture streamer: {} textures streamed, {} KiB by {} steps, {} pending",
+                    _stats._textures, _stats._bytes / 1024, _stats._steps, _jobs.size());
+    }
+
+    void TextureStreamer::stream(std::shared_ptr<Textures::Texture> texture,
+                                 content::Lease image,
+                                 Textures::Array::Sptr fallback)
+    {
+        assert(texture);
+        models::Image::Sptr const & decoded = image.as<models::Image::Sptr>();
+        MINIRE_INVARIANT(decoded, "no valid image to stream");
+        MINIRE_INVARIANT(fallback, "no fallback texture array");
+
+        Textures::Array::Format const & format = texture->array().format();
+        MINIRE_INVARIANT(format._streamed, "a texture isn't a layer of a streamed array");
+        MINIRE_INVARIANT(decoded->_depth == models::Image::Depth::k8 &&
+                         decoded->_width == format._width &&
+                         decoded->_height == format._height,
+                         "an image can't be streamed into a texture: {}x{}",
+                         decoded->_width, decoded->_height);
+
+        // levels are packed tightly, the finest first
+        size_t const bytesInPixel = decoded->bytesInPixel();
+        std::vector<Level> levels;
+        size_t bytes = 0;
+        for(GLsizei level = 0; level < format._levels; ++level)
+        {
+            size_t const width = std::max<size_t>(format._width >> level, 1);
+            size_t const height = std::max<size_t>(format._height >> level, 1);
+            levels.push_back(Level{width, height, bytes});
+            bytes += width * height * bytesInPixel;
+        }
+
+        GLenum const pixelFormat = opengl::toFormat(decoded->_format);
+        size_t const coarsest = levels.size() - 1;
+
+        auto job = std::unique_ptr<Job>(new Job{
+            ._texture = std::move(texture),
+            ._fallback = std::move(fallback),
+            ._image = std::move(image),
+            ._buffer = opengl::PixelBuffer(bytes),
+            ._pixels = nullptr,
+            ._format = pixelFormat,
+            ._bytesInPixel = bytesInPixel,
+            ._levels = std::move(levels),
+            ._level = coarsest,
+        });
+        job->_pixels = job->_buffer.map();
+
+        Job & prepared = *job;
+        _jobs.push_back(std::move(job));
+        _workers.submit([&prepared] { prepare(prepared); });
+    }
+
+    void TextureStreamer::prepare(Job & job)
+    {
+        try
+        {
+            models::Image const & image = *job._image.as<models::Image::Sptr>();
+            Level const & finest = job._levels.front();
+            std::memcpy(job._pixels, image._data,
+                        finest._width * finest._height * job._bytesInPixel);
+
+            // a level is downsampled from the previous one in the local memory,
+            // since reading of the mapped one could be very slow
+            std::vector<uint8_t> previous;
+            std::vector<uint8_t> next;
+            uint8_t const * source = image._data;
+            for(size_t i = 1; i < job._levels.size(); ++i)
+            {
+                Level const & from = job._levels[i - 1];
+                Level const & to = job._levels[i];
+                next.resize(to._width * to._height * job._bytesInPixel);
+                utils::downsample(source, from._width, from._height,
+                                  next.data(), to._width, to._height,
+                                  job._bytesInPixel);
+                std::memcpy(job._pixels + to._offset, next.data(), next.size());
+
+                std::swap(previous, next);
+                source = previous.data();
+            }
+        }
+        catch(...)
+        {
+            job._error = std::current_exception();
+        }
+
+        job._prepared.store(true, std::memory_order_release);
+    }
+
+    bool TextureStreamer::unmap(Job & job)
+    {
+        assert(State::kPreparing == job._state);
+
+        bool const intact = job._buffer.unmap();
+        job._pixels = nullptr;
+
+        try
+        {
+            if (job._error) std::rethrow_exception(job._error);
+
+            if (!intact)
+            {
+                // the content is undefined, so the buffer is re-specified
+                // by mapping it again, and the image is prepared once more
+                MINIRE_WARNING("texture streamer: a pixel buffer of a {}x{} texture is lost, retrying",
+                               job._texture->width(), job._texture->height());
+                job._pixels = job._buffer.map();
+                job._prepared.store(false, std::memory_order_relaxed);
+                _workers.submit([&job] { prepare(job); });
+                return true;
+            }
+        }
+        catch(std::exception const & e)
+        {
+            MINIRE_ERROR("texture streamer: failed to stream a {}x{} texture: {}",
+                         job._texture->width(), job._texture->height(), e.what());
+            release(job);
+            return false;
+        }
+
+        job._image = content::Lease(); // the decoded image isn't needed anymore
+        job._state = State::kUploading;
+        return true;
+    }
+
+    void TextureStreamer::release(Job & job)
+    {
+        Textures::Texture & texture = *job._texture;
+        texture._array->release(texture._layer);
+        texture._array = std::move(job._fallback);
+        texture._layer = 0;
+        texture._minLod = -1.0f;
+    }
+
+    size_t TextureStreamer::upload(Job & job, size_t budget)
+    {
+        assert(State::kUploading == job._state);
+        assert(job._level < job._levels.size());
+
+        // a level is uploaded by bands of rows
+        Level const & level = job._levels[job._level];
+        size_t const lineBytes = level._width * job._bytesInPixel;
+        size_t const rows = std::clamp<size_t>(budget / lineBytes, 1, level._height - job._row);
+
+        // NOTE: the job's pixel buffer must be bound
+        job._texture->array().bind();
+        MINIRE_GL(glTexSubImage3D,
+                  GL_TEXTURE_2D_ARRAY,
+                  job._level, 0, job._row, job._texture->layer(),
+                  level._width, rows, 1,
+                  job._format,
+                  GL_UNSIGNED_BYTE,
+                  reinterpret_cast<void const *>(level._offset + job._row * lineBytes));
+        job._row += rows;
+
+        if (job._row == level._height)
+        {
+            // the level could be sampled from now on
+            job._texture->_minLod = static_cast<float>(job._level);
+            job._row = 0;
+
+            if (0 == job._level)
+            {
+                job._fence.emplace();
+                job._state = State::kFencing;
+            }
+            else
+            {
+                --job._level;
+            }
+        }
+
+        return rows * lineBytes;
+    }
+
+    void TextureStreamer::step(size_t budget)
+    {
+        ++_stats._steps;
+
+        // pixel buffers are unmapped once workers are done w/ them
+        for(auto it = _jobs.begin(); it != _jobs.end();)
+        {
+            Job & job = **it;
+            if (State::kPreparing == job._state &&
+                job._prepared.load(std::memory_order_acquire) &&
+                !unmap(job))
+            {
+                it = _jobs.erase(it);
+                continue;
+            }
+            ++it;
+        }
+
+        // the smallest pending mip of all the textures is the next one
+        size_t spent = 0;
+        MINIRE_GL(glPixelStorei, GL_UNPACK_ALIGNMENT, 1);
+        while(spent < budget)
+        {
+            Job * next = nullptr;
+            size_t nextBytes = 0;
+            for(auto const & job : _jobs)
+            {
+                if (State::kUploading != job->_state) continue;
+
+                Level const & level = job->_levels[job->_level];
+                size_t const bytes = level._width * level._height * job->_bytesInPixel;
+                if (!next || bytes < nextBytes)
+                {
+                    next = job.get();
+                    nextBytes = bytes;
+                }
+            }
+            if (!next) break;
+
+            next->_buffer.bind();
+            spent += upload(*next, budget - spent);
+        }
+        opengl::PixelBuffer::unbind();
+        MINIRE_GL(glPixelStorei, GL_UNPACK_ALIGNMENT, 4);
+        _stats._bytes += spent;
+
+        // pixel buffers are released once GL is done w/ them
+        for(auto it = _jobs.begin(); it != _jobs.end();)
+        {
+            Job & job = **it;
+            if (State::kFencing == job._state && job._fence->signaled())
+            {
+                ++_stats._textures;
+                MINIRE_DEBUG("texture streamed: {}x{}, {} levels",
+                             job._texture->width(), job._texture->height(),
+                             job._levels.size());
+                it = _jobs.erase(it);
+                continue;
+            }
+            ++it;
+        }
+    }
+}
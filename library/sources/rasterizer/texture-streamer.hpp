@@ -0,0 +1,115 @@
+#pragma once
+
+#include <minire/content/manager.hpp>
+
+#include <opengl/fence.hpp>
+#include <opengl/pixel-buffer.hpp>
+#include <rasterizer/textures.hpp>
+#include <utils/thread-pool.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <list>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace minire::rasterizer
+{
+    // Uploads mip chains of 8-bit images into reserved layers of texture
+    // arrays by a few frames: workers downsample an image straight into
+    // a mapped pixel buffer, and step() uploads it under a byte budget,
+    // the smallest mips of all the textures first. A texture is sampled
+    // at the finest mip uploaded so far (see Textures::Texture::minLod),
+    // and a pixel buffer is released once a fence after its uploads is
+    // signaled.
+    class TextureStreamer
+    {
+        TextureStreamer(TextureStreamer const &) = delete;
+        TextureStreamer & operator=(TextureStreamer const &) = delete;
+
+    public:
+        struct Stats
+        {
+            size_t _textures = 0; // completed ones
+            size_t _bytes = 0;    // uploaded
+            size_t _steps = 0;    // calls of step()
+        };
+
+    public:
+        explicit TextureStreamer(size_t threads);
+
+        ~TextureStreamer();
+
+        // NOTE: the texture must be a reserved layer of a streamed array,
+        //       and the lease must hold a models::Image::Sptr; if the image
+        //       fails, the layer is released and the texture is sampled
+        //       from the first layer of the fallback array
+        void stream(std::shared_ptr<Textures::Texture> texture,
+                    content::Lease image,
+                    Textures::Array::Sptr fallback);
+
+        // uploads budget bytes at most (but a row at least)
+        void step(size_t budget);
+
+        // of textures which aren't uploaded or fenced yet
+        size_t pending() const { return _jobs.size(); }
+
+        Stats const & stats() const { return _stats; }
+
+    private:
+        struct Level
+        {
+            size_t _width;
+            size_t _height;
+            size_t _offset; // in the pixel buffer
+        };
+
+        enum class State
+        {
+            kPreparing, // by a worker
+            kUploading,
+            kFencing,
+        };
+
+        struct Job
+        {
+            std::shared_ptr<Textures::Texture> _texture;
+            Textures::Array::Sptr              _fallback;
+            content::Lease                     _image;  // till it's prepared
+            opengl::PixelBuffer                _buffer;
+            uint8_t                          * _pixels; // the mapped buffer
+            GLenum                             _format;
+            size_t                             _bytesInPixel;
+            std::vector<Level>                 _levels; // the finest first
+            State                              _state = State::kPreparing;
+            std::atomic<bool>                  _prepared = false;
+            std::exception_ptr                 _error = nullptr; // of the worker
+            size_t                             _level;  // the one being uploaded
+            size_t                             _row = 0;
+            std::optional<opengl::Fence>       _fence = std::nullopt;
+        };
+
+        using Jobs = std::list<std::unique_ptr<Job>>;
+
+        // called by a worker
+        static void prepare(Job &);
+
+        // returns false if the job is failed, a lost pixel buffer
+        // is mapped again and the job is prepared once more
+        bool unmap(Job &);
+
+        // of a failed job, see stream()
+        static void release(Job &);
+
+        // returns bytes uploaded
+        size_t upload(Job &, size_t budget);
+
+    private:
+        Jobs              _jobs;
+        Stats             _stats;
+        utils::ThreadPool _workers; // must be the last (jobs are used by it)
+    };
+}
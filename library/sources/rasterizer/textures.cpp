@@ -2,12 +2,19 @@
 
 #include <minire/content/manager.hpp>
 #include <minire/errors.hpp>
+#include <minire/logging.hpp>
+#include <minire/models/compressed-image.hpp>
 
 #include <opengl.hpp>
+#include <rasterizer/texture-streamer.hpp>
+#include <utils/downsample.hpp>
 
 #include <glm/glm.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <exception>
+#include <vector>
 
 namespace minire::rasterizer
 {
@@ -16,71 +23,567 @@ namespace minire::rasterizer
         GLsizei maxMipMaps(size_t w, size_t h)
         {
             size_t const side = std::min(w, h);
-            return glm::floor(glm::log2(static_cast<float>(side))) - 1;        
+            GLsizei const levels = glm::floor(glm::log2(static_cast<float>(side))) - 1;
+            return std::max<GLsizei>(levels, 1);
+        }
+
+        Textures::Array::Format formatOf(models::Image const & image,
+                                         bool mipmaps,
+                                         bool streamed)
+        {
+            return
+            {
+                ._width = image._width,
+                ._height = image._height,
+                ._internalFormat = opengl::toInternalFormat(image._format),
+                ._levels = mipmaps ? maxMipMaps(image._width, image._height) : 1,
+                ._streamed = streamed,
+            };
+        }
+
+        // mips of compressed images are prebuilt
+        Textures::Array::Format formatOf(models::CompressedImage const & image,
+                                         bool mipmaps)
+        {
+            return
+            {
+                ._width = image._width,
+                ._height = image._height,
+                ._internalFormat = opengl::toInternalFormat(image._format),
+                ._levels = mipmaps ? static_cast<GLsizei>(image._levels.size()) : 1,
+            };
+        }
+
+        size_t bytesOf(models::Image const & image, bool mipmaps)
+        {
+            // mipmaps take a third more
+            size_t const bytes = image._width * image._height * image.bytesInPixel();
+            return mipmaps ? bytes * 4 / 3 : bytes;
+        }
+
+        size_t bytesOf(models::CompressedImage const & image, bool mipmaps)
+        {
+            return mipmaps ? image.bytes() : image._levels.front()._bytes.size();
         }
     }
 
-    Textures::Texture::Texture(models::Image const & image,
-                               models::Sampler const & sampler,
-                               bool const mipmaps)
-        : _texture(GL_TEXTURE_2D) // TODO: maybe GL_TEXTURE_2D_ARRAY will be more efficient
+    Textures::Array::Array(Format const & format, size_t capacity)
+        : _texture(GL_TEXTURE_2D_ARRAY)
+        , _format(format)
+        , _capacity(capacity)
     {
-        _width = image._width;
-        _height = image._height;
+        MINIRE_INVARIANT(_capacity > 0, "an empty texture array");
 
+        // allocate storage of all the layers (content is undefined until added)
         _texture.bind();
+        MINIRE_GL(glTexStorage3D,
+                  GL_TEXTURE_2D_ARRAY,
+                  _format._levels,
+                  _format._internalFormat,
+                  _format._width, _format._height,
+                  _capacity);
 
-        // allocate storage
-        GLsizei levels = mipmaps ? maxMipMaps(_width, _height) : 1;
-        MINIRE_GL(glTexStorage2D,
-                  GL_TEXTURE_2D,
-                  levels,
-                  opengl::toInternalFormat(image._format),
-                  _width, _height);
+        // NOTE: filtering and wrapping are set by samplers (see getSampler)
+    }
+
+    size_t Textures::Array::add(models::Image const & image)
+    {
+        MINIRE_INVARIANT(!_format._streamed, "an image is added to a streamed texture array");
+        MINIRE_INVARIANT(!full(), "no room for a layer in a texture array");
+        MINIRE_INVARIANT(image._width == _format._width &&
+                         image._height == _format._height &&
+                         opengl::toInternalFormat(image._format) == _format._internalFormat,
+                         "an image doesn't match a texture array: {}x{}",
+                         image._width, image._height);
+        size_t const layer = nextLayer();
+
+        // 16-bit images are reduced to the 8-bit storage by GL (see Page::place)
+        bool const deep = image._depth == models::Image::Depth::k16;
+        MINIRE_INVARIANT((image._depth == models::Image::Depth::k8 || deep) && !image._signed,
+                         "only unsigned 8 or 16-bit images could be added to a texture array");
 
         // upload pixel data
-        MINIRE_GL(glTexSubImage2D,
-                  GL_TEXTURE_2D,
-                  0, 0, 0,
-                  _width, _height,
+        _texture.bind();
+        MINIRE_GL(glPixelStorei, GL_UNPACK_ALIGNMENT, 1);
+        MINIRE_GL(glTexSubImage3D,
+                  GL_TEXTURE_2D_ARRAY,
+                  0, 0, 0, layer,
+                  _format._width, _format._height, 1,
                   opengl::toFormat(image._format),
-                  GL_UNSIGNED_BYTE,
+                  deep ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE,
                   image._data);
+        MINIRE_GL(glPixelStorei, GL_UNPACK_ALIGNMENT, 4);
 
-        if (mipmaps)
+        if (_format._levels > 1)
         {
-            MINIRE_GL(glGenerateMipmap, GL_TEXTURE_2D);
+            if (image._depth == models::Image::Depth::k8)
+            {
+                // glGenerateMipmap works on the whole array, so mips of the
+                // layer are downsampled here, each from the previous one
+                size_t const bytesInPixel = image.bytesInPixel();
+                std::vector<uint8_t> previous;
+                std::vector<uint8_t> next;
+                uint8_t const * source = image._data;
+                MINIRE_GL(glPixelStorei, GL_UNPACK_ALIGNMENT, 1); // rows of small mips aren't aligned
+                for(GLsizei level = 1; level < _format._levels; ++level)
+                {
+                    size_t const fromWidth = std::max<size_t>(_format._width >> (level - 1), 1);
+                    size_t const fromHeight = std::max<size_t>(_format._height >> (level - 1), 1);
+                    size_t const width = std::max<size_t>(_format._width >> level, 1);
+                    size_t const height = std::max<size_t>(_format._height >> level, 1);
+
+                    next.resize(width * height * bytesInPixel);
+                    utils::downsample(source, fromWidth, fromHeight,
+                                      next.data(), width, height,
+                                      bytesInPixel);
+                    MINIRE_GL(glTexSubImage3D,
+                              GL_TEXTURE_2D_ARRAY,
+                              level, 0, 0, layer,
+                              width, height, 1,
+                              opengl::toFormat(image._format),
+                              GL_UNSIGNED_BYTE,
+                              next.data());
+
+                    std::swap(previous, next);
+                    source = previous.data();
+                }
+                MINIRE_GL(glPixelStorei, GL_UNPACK_ALIGNMENT, 4);
+            }
+            else
+            {
+                // deferred to have a single call for all the layers
+                // uploaded during a frame
+                _dirty = true;
+            }
+        }
+
+        return takeLayer();
+    }
+
+    size_t Textures::Array::add(models::CompressedImage const & image)
+    {
+        MINIRE_INVARIANT(!_format._streamed, "an image is added to a streamed texture array");
+        MINIRE_INVARIANT(!full(), "no room for a layer in a texture array");
+        MINIRE_INVARIANT(image._width == _format._width &&
+                         image._height == _format._height &&
+                         opengl::toInternalFormat(image._format) == _format._internalFormat &&
+                         image._levels.size() >= static_cast<size_t>(_format._levels),
+                         "an image doesn't match a texture array: {}x{}",
+                         image._width, image._height);
+        size_t const layer = nextLayer();
+
+        // upload blocks of the prebuilt mips as they are
+        _texture.bind();
+        for(GLsizei level = 0; level < _format._levels; ++level)
+        {
+            models::CompressedImage::Level const & mip = image._levels[level];
+            MINIRE_GL(glCompressedTexSubImage3D,
+                      GL_TEXTURE_2D_ARRAY,
+                      level, 0, 0, layer,
+                      mip._width, mip._height, 1,
+                      _format._internalFormat,
+                      mip._bytes.size(),
+                      mip._bytes.data());
         }
 
-        // texture parameters
-        _texture.parameteri(GL_TEXTURE_MIN_FILTER, sampler._minFilter);
-        _texture.parameteri(GL_TEXTURE_MAG_FILTER, sampler._magFilter);
-        _texture.parameteri(GL_TEXTURE_WRAP_S, sampler._wrapS);
-        _texture.parameteri(GL_TEXTURE_WRAP_T, sampler._wrapT);
+        return takeLayer();
+    }
+
+    size_t Textures::Array::reserve()
+    {
+        MINIRE_INVARIANT(!full(), "no room for a layer in a texture array");
+        return takeLayer();
+    }
+
+    void Textures::Array::release(size_t layer)
+    {
+        MINIRE_INVARIANT(layer < _layers &&
+                         std::find(_released.cbegin(), _released.cend(), layer) == _released.cend(),
+                         "a texture array layer isn't taken: {}", layer);
+        _released.push_back(layer);
+    }
+
+    size_t Textures::Array::takeLayer()
+    {
+        if (_released.empty()) return _layers++;
+
+        size_t const layer = _released.back();
+        _released.pop_back();
+        return layer;
+    }
+
+    bool Textures::Array::flush()
+    {
+        if (!_dirty) return false;
+
+        _texture.bind();
+        MINIRE_GL(glGenerateMipmap, GL_TEXTURE_2D_ARRAY);
+        _dirty = false;
+        return true;
     }
 
     Textures::Texture::Sptr
-    Textures::get(content::Manager & contentManager,
-                  content::Id const & id,
-                  models::Sampler const & sampler,
+    Textures::get(content::Id const & id,
                   Cache & cache,
-                  bool mipmaps)
+                  bool mipmaps) const
     {
-        Key key(id, sampler);
+        ++_stats._requests;
 
-        auto it = cache.find(key);
+        auto it = cache.find(id);
         if (it == cache.cend())
         {
-            auto lease = contentManager.borrow(id);
+            auto lease = _contentManager.borrow(id);
             assert(lease);
-            models::Image::Sptr image = lease->as<models::Image::Sptr>();
-            MINIRE_INVARIANT(image, "no valid image inside an asset: {}", id);
-            auto texture = std::make_shared<Texture>(*image, sampler, mipmaps);
-            auto [newIt, inserted]  = cache.emplace(key, texture);
+
+            Texture::Sptr texture;
+            if (auto const * compressed = lease.tryAs<models::CompressedImage::Sptr>())
+            {
+                MINIRE_INVARIANT(*compressed, "no valid image inside an asset: {}", id);
+                texture = allocate(**compressed, mipmaps);
+            }
+            else
+            {
+                models::Image::Sptr image = lease.as<models::Image::Sptr>();
+                MINIRE_INVARIANT(image, "no valid image inside an asset: {}", id);
+                texture = allocate(*image, mipmaps);
+            }
+
+            auto [newIt, inserted]  = cache.emplace(id, std::move(texture));
             MINIRE_INVARIANT(inserted, "failed to cache a texture");
             it = newIt;
+            ++_stats._textures;
         }
 
         return it->second;
     }
+
+    Textures::Texture::Sptr
+    Textures::stream(content::Id const & id,
+                     Cache & cache) const
+    {
+        ++_stats._requests;
+
+        auto it = cache.find(id);
+        if (it != cache.cend())
+        {
+            return it->second;
+        }
+
+        if (!_pending)
+        {
+            _pending = std::make_shared<Array>(Array::Format{._width = 1, ._height = 1,
+                                                             ._internalFormat = GL_RGBA8},
+                                               1);
+            _pending->reserve();
+            _units.clear();
+        }
+
+        // it's sampled through the fallback till the coarsest mip is uploaded
+        auto texture = std::make_shared<Texture>(_pending, 0, -1.0f);
+        auto [newIt, inserted]  = cache.emplace(id, texture);
+        MINIRE_INVARIANT(inserted, "failed to cache a texture");
+        ++_stats._textures;
+
+        // an image isn't decoded on the render thread, even if it's resident
+        // the callback is called by the content::Manager's poll()
+        std::weak_ptr<Textures const> self = _self;
+        _contentManager.borrowAsync(id,
+            [self, texture, id](content::Lease image,
+                                std::exception_ptr error)
+            {
+                auto textures = self.lock();
+                if (!textures) return;
+
+                try
+                {
+                    if (error) std::rethrow_exception(error);
+                    assert(image);
+                    textures->place(texture, id, std::move(image));
+                }
+                catch(std::exception const & e)
+                {
+                    MINIRE_ERROR("failed to stream a texture {}: {}", id, e.what());
+                }
+            });
+
+        return newIt->second;
+    }
+
+    void Textures::place(std::shared_ptr<Texture> const & streamed,
+                         content::Id const & id,
+                         content::Lease lease) const
+    {
+        Texture & texture = *streamed;
+        assert(texture._array == _pending);
+
+        auto const retarget = [&texture](Texture::Sptr const & allocated)
+        {
+            texture._array = allocated->_array;
+            texture._layer = allocated->_layer;
+            texture._minLod = allocated->_minLod;
+        };
+
+        if (auto const * compressed = lease.tryAs<models::CompressedImage::Sptr>())
+        {
+            // blocks and their mips are ready, so there is nothing to stream
+            MINIRE_INVARIANT(*compressed, "no valid image inside an asset: {}", id);
+            retarget(allocate(**compressed, true));
+            return;
+        }
+
+        models::Image::Sptr image = lease.as<models::Image::Sptr>();
+        MINIRE_INVARIANT(image, "no valid image inside an asset: {}", id);
+
+        if (image->_depth != models::Image::Depth::k8)
+        {
+            // the streamer downsamples 8-bit images only
+            retarget(allocate(*image, true));
+            return;
+        }
+
+        Array::Sptr const array = arrayOf(formatOf(*image, true, true), bytesOf(*image, true));
+        texture._layer = array->reserve();
+        texture._array = array;
+
+        _streamer->stream(streamed, std::move(lease), _pending);
+        ++_stats._streamed;
+    }
+
+    Textures::Texture::Sptr
+    Textures::allocate(models::Image const & image,
+                       bool mipmaps) const
+    {
+        Array::Sptr const & array = arrayOf(formatOf(image, mipmaps, false), bytesOf(image, mipmaps));
+        size_t const layer = array->add(image);
+
+        // the array is bound to the active unit by now
+        _units.clear();
+
+        return std::make_shared<Texture const>(array, layer);
+    }
+
+    Textures::Texture::Sptr
+    Textures::allocate(models::CompressedImage const & image,
+                       bool mipmaps) const
+    {
+        MINIRE_INVARIANT(_compressedFormats.supports(image._format),
+                         "{} compressed textures aren't supported by the GL context",
+                         opengl::toString(image._format));
+
+        Array::Sptr const & array = arrayOf(formatOf(image, mipmaps), bytesOf(image, mipmaps));
+        size_t const layer = array->add(image);
+
+        // the array is bound to the active unit by now
+        _units.clear();
+
+        return std::make_shared<Texture const>(array, layer);
+    }
+
+    Textures::Array::Sptr const &
+    Textures::arrayOf(Array::Format const & format,
+                      size_t layerBytes) const
+    {
+        auto & arrays = _pool[format];
+        if (arrays.empty() || arrays.back()->full())
+        {
+            if (0 == _maxLayers)
+            {
+                GLint maxLayers = 0;
+                MINIRE_GL(glGetIntegerv, GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+                _maxLayers = std::max<GLint>(maxLayers, 1);
+            }
+
+            size_t const limit = std::min({kMaxArrayLayers,
+                                           _maxLayers,
+                                           std::max<size_t>(kMaxArrayBytes / layerBytes, 1)});
+            // a format starts w/ a single layer, most images are unique,
+            // and the next array doubles the previous one
+            size_t const capacity = std::min(limit,
+                                             arrays.empty() ? 1 : arrays.back()->capacity() * 2);
+
+            arrays.push_back(std::make_shared<Array>(format, capacity));
+            ++_stats._arrays;
+            _stats._bytes += layerBytes * capacity;
+            MINIRE_DEBUG("texture array allocated: {}x{}, {} levels, {} layers{}",
+                         format._width, format._height, format._levels, capacity,
+                         format._streamed ? ", streamed" : "");
+
+            // it's bound to the active unit by now
+            _units.clear();
+        }
+
+        return arrays.back();
+    }
+
+    GLuint Textures::bind(Binding const & binding, GLuint unit) const
+    {
+        assert(binding);
+        assert(binding._sampler);
+
+        if (unit >= _units.size())
+        {
+            _units.resize(unit + 1);
+        }
+
+        Unit & bound = _units[unit];
+        Texture const & texture = *binding._texture;
+
+        if (bound._array != texture.array().id())
+        {
+            MINIRE_GL(glActiveTexture, GL_TEXTURE0 + unit);
+            texture.bind();
+            bound._array = texture.array().id();
+        }
+
+        if (bound._sampler != binding._sampler->id())
+        {
+            binding._sampler->bind(unit);
+            bound._sampler = binding._sampler->id();
+        }
+
+        return texture.layer();
+    }
+
+    void Textures::flush() const
+    {
+        _streamer->step(kStreamBudget);
+
+        for(auto & [format, arrays] : _pool)
+        {
+            for(Array::Sptr const & array : arrays)
+            {
+                array->flush();
+            }
+        }
+
+        // arrays are bound while streamed and flushed, and units are used by 2D drawing
+        _units.clear();
+    }
+
+    opengl::Sampler::Sptr Textures::getSampler(models::Sampler const & sampler) const
+    {
+        auto it = _samplers.find(sampler);
+        if (it == _samplers.cend())
+        {
+            auto glSampler = std::make_shared<opengl::Sampler>();
+            glSampler->parameteri(GL_TEXTURE_MIN_FILTER, sampler._minFilter);
+            glSampler->parameteri(GL_TEXTURE_MAG_FILTER, sampler._magFilter);
+            glSampler->parameteri(GL_TEXTURE_WRAP_S, sampler._wrapS);
+            glSampler->parameteri(GL_TEXTURE_WRAP_T, sampler._wrapT);
+
+            auto [newIt, inserted] = _samplers.emplace(sampler, std::move(glSampler));
+            MINIRE_INVARIANT(inserted, "failed to cache a sampler");
+            it = newIt;
+            ++_stats._samplers;
+        }
+
+        return it->second;
+    }
+
+    Textures::Textures(content::Manager & contentManager)
+        : _contentManager(contentManager)
+        , _streamer(std::make_unique<TextureStreamer>(kStreamThreads))
+        , _self(this, [](Textures const *) {})
+    {}
+
+    Textures::~Textures()
+    {
+        MINIRE_INFO("textures: {} requests share {} textures ({} streamed) in {} arrays "
+                    "and {} samplers ({:.2f}x dedup), {} KiB",
+                    _stats._requests, _stats._textures, _stats._streamed, _stats._arrays,
+                    _stats._samplers, _stats.dedupRatio(), _stats._bytes / 1024);
+    }
+
+    Textures::Page::Page(size_t width, size_t height)
+        : _texture(GL_TEXTURE_2D)
+        , _packer(width, height)
+    {
+        // allocate storage (content is undefined until images are placed)
+        _texture.bind();
+        MINIRE_GL(glTexStorage2D, GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+
+        // texture parameters (pages are sampled by texelFetch only)
+        _texture.parameteri(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        _texture.parameteri(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        _texture.parameteri(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        _texture.parameteri(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    std::optional<Textures::Region>
+    Textures::Page::place(models::Image const & image)
+    {
+        // 16-bit images (e.g. of PNGs) are reduced to 8 bits by GL, as
+        // they're unpacked into the RGBA8 storage
+        bool const deep = image._depth == models::Image::Depth::k16;
+        MINIRE_INVARIANT((image._depth == models::Image::Depth::k8 || deep) && !image._signed,
+                         "only unsigned 8 or 16-bit images could be atlased");
+
+        auto const position = _packer.insert(image._width, image._height);
+        if (!position) return std::nullopt;
+
+        // upload pixel data (RGB and grayscale are expanded to RGBA by GL)
+        _texture.bind();
+        MINIRE_GL(glPixelStorei, GL_UNPACK_ALIGNMENT, 1);
+        MINIRE_GL(glTexSubImage2D,
+                  GL_TEXTURE_2D,
+                  0, position->first, position->second,
+                  image._width, image._height,
+                  opengl::toFormat(image._format),
+                  deep ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE,
+                  image._data);
+        MINIRE_GL(glPixelStorei, GL_UNPACK_ALIGNMENT, 4);
+
+        return Region{this,
+                      position->first, position->second,
+                      image._width, image._height};
+    }
+
+    Textures::Region const & Textures::getAtlased(content::Id const & id) const
+    {
+        auto it = _atlasCache.find(id);
+        if (it != _atlasCache.cend())
+        {
+            return it->second;
+        }
+
+        auto lease = _contentManager.borrow(id);
+        assert(lease);
+        models::Image::Sptr image = lease.as<models::Image::Sptr>();
+        MINIRE_INVARIANT(image, "no valid image inside an asset: {}", id);
+
+        std::optional<Region> region;
+
+        if (image->_width > kPageSide || image->_height > kPageSide)
+        {
+            // too large to share a page with anybody else
+            _pages.emplace_back(std::make_unique<Page>(image->_width, image->_height));
+            region = _pages.back()->place(*image);
+        }
+        else
+        {
+            // first fit over existing pages (the most recent ones first)
+            for(auto page = _pages.rbegin(); page != _pages.rend() && !region; ++page)
+            {
+                assert(*page);
+                region = (*page)->place(*image);
+            }
+
+            if (!region)
+            {
+                _pages.emplace_back(std::make_unique<Page>(kPageSide, kPageSide));
+                MINIRE_DEBUG("new atlas page allocated: #{}", _pages.size());
+                region = _pages.back()->place(*image);
+            }
+        }
+
+        MINIRE_INVARIANT(region, "failed to atlas an image: {} ({}x{})",
+                         id, image->_width, image->_height);
+
+        // a page is bound to the active unit by now
+        _units.clear();
+
+        auto [newIt, inserted] = _atlasCache.emplace(id, *region);
+        MINIRE_INVARIANT(inserted, "failed to cache an atlas region");
+        return newIt->second;
+    }
 }
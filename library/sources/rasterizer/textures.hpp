@@ -2,100 +2,324 @@
 
 #include <minire/content/id.hpp>
 #include <minire/models/sampler.hpp>
-#include <minire/utils/std-pair-hash.hpp>
 
+#include <opengl/sampler.hpp>
 #include <opengl/texture.hpp>
+#include <utils/skyline-packer.hpp>
 
+#include <compare>
+#include <map>
 #include <memory>
+#include <optional>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
-namespace minire::content { class Manager; }
-namespace minire::models { struct Image; }
+namespace minire::content { class Lease; class Manager; }
+namespace minire::models { struct CompressedImage; struct Image; }
 
 namespace minire::rasterizer
 {
+    class TextureStreamer;
+
     class Textures
     {
     public:
-        class Texture
+        // GL_TEXTURE_2D_ARRAY whose layers are images of the same size and
+        // format, its storage is immutable, so the capacity is fixed
+        class Array
         {
+            Array(Array const &) = delete;
+            Array & operator=(Array const &) = delete;
+
+        public:
+            using Sptr = std::shared_ptr<Array>;
+
+            struct Format
+            {
+                size_t  _width = 0;
+                size_t  _height = 0;
+                GLenum  _internalFormat = 0;
+                GLsizei _levels = 1;
+                bool    _streamed = false; // mips are uploaded by TextureStreamer
+
+                auto operator<=>(Format const &) const = default;
+            };
+
+            explicit Array(Format const &, size_t capacity);
+
+            void bind() const { _texture.bind(); }
+
+            GLuint id() const { return _texture.id(); }
+
+            Format const & format() const { return _format; }
+
+            size_t capacity() const { return _capacity; }
+
+            size_t layers() const { return _layers - _released.size(); }
+
+            bool full() const { return _layers == _capacity && _released.empty(); }
+
+            // uploads an image into a new layer, returns its index
+            // NOTE: mipmaps of 8-bit images are built right away, mipmaps
+            //       of 16-bit ones are undefined until flush()
+            size_t add(models::Image const &);
+
+            // uploads blocks of the image and its prebuilt mips
+            size_t add(models::CompressedImage const &);
+
+            // returns an index of a new layer w/ undefined content
+            size_t reserve();
+
+            // the layer is taken by the next add() or reserve()
+            void release(size_t layer);
+
+            // generates mipmaps if there are new layers, returns true if so
+            bool flush();
+
         private:
-            Texture() = delete;
+            // released layers are taken first
+            size_t nextLayer() const { return _released.empty() ? _layers : _released.back(); }
 
-            Texture(Texture const &) = delete;
-            Texture & operator=(Texture const &) = delete;
+            size_t takeLayer();
 
-            Texture(Texture &&) = default;
-            Texture & operator=(Texture &&) = default;
+        private:
+            opengl::Texture     _texture;
+            Format const        _format;
+            size_t const        _capacity;
+            size_t              _layers = 0;   // ever taken ones
+            std::vector<size_t> _released;
+            bool                _dirty = false;
+        };
 
+        // A layer of an Array
+        class Texture
+        {
         public:
-            using Sptr = std::shared_ptr<Texture>;
+            using Sptr = std::shared_ptr<Texture const>;
 
             // NOTE: dont' use it directly (who knows what could happen!)
-            explicit Texture(models::Image const &,
-                             models::Sampler const &,
-                             bool mipmaps);
+            explicit Texture(Array::Sptr array, size_t layer, float minLod = 0)
+                : _array(std::move(array))
+                , _layer(layer)
+                , _minLod(minLod)
+            {}
 
-            void bind() const { _texture.bind(); }
+            void bind() const { _array->bind(); }
 
-            size_t width() const { return _width; }
+            Array const & array() const { return *_array; }
 
-            size_t height() const { return _height; }
+            size_t layer() const { return _layer; }
+
+            size_t width() const { return _array->format()._width; }
+
+            size_t height() const { return _array->format()._height; }
+
+            // the finest mip which could be sampled, it's negative
+            // until the coarsest one is streamed (see TextureStreamer)
+            float minLod() const { return _minLod; }
 
         private:
-            opengl::Texture _texture;
-            size_t          _width;
-            size_t          _height;
+            Array::Sptr  _array;
+            size_t       _layer;  // it's moved once a streamed image is decoded
+            float        _minLod;
 
+            friend class TextureStreamer;
             friend class Textures;
         };
 
+        // A texture and a sampler it's sampled with, textures of an image
+        // are shared by all the samplers, and samplers by all the textures
+        struct Binding
+        {
+            Texture::Sptr         _texture;
+            opengl::Sampler::Sptr _sampler;
+
+            explicit operator bool() const { return static_cast<bool>(_texture); }
+        };
+
+        class Page;
+
+        // A rectangle of an atlas page occupied by a single image (in pixels)
+        struct Region
+        {
+            Page const * _page = nullptr;
+            size_t       _x = 0;
+            size_t       _y = 0;
+            size_t       _width = 0;
+            size_t       _height = 0;
+        };
+
+        // RGBA8 texture w/o mipmaps shared by many small images
+        class Page
+        {
+            Page(Page const &) = delete;
+            Page & operator=(Page const &) = delete;
+
+        public:
+            explicit Page(size_t width, size_t height);
+
+            void bind() const { _texture.bind(); }
+
+            // returns std::nullopt if there is no room for an image
+            std::optional<Region> place(models::Image const &);
+
+            size_t width() const { return _packer.width(); }
+
+            size_t height() const { return _packer.height(); }
+
+        private:
+            opengl::Texture      _texture;
+            utils::SkylinePacker _packer;
+        };
+
+        // Textures are shared by all the requests of the same (id, sampler),
+        // i.e. by materials of meshes of a glTF source referring an image
+        struct Stats
+        {
+            size_t _requests = 0; // of get() and getNoMipmap()
+            size_t _textures = 0;
+            size_t _samplers = 0;
+            size_t _arrays = 0;   // shared by the textures as layers
+            size_t _streamed = 0; // of the textures
+            size_t _bytes = 0;    // of the arrays, an estimate
+
+            double dedupRatio() const
+            {
+                return _textures ? static_cast<double>(_requests) / _textures : 1.0;
+            }
+        };
+
     public:
-        explicit Textures(content::Manager & contentManager)
-            : _contentManager(contentManager)
-        {}
+        explicit Textures(content::Manager & contentManager);
+
+        ~Textures();
 
         // use this both for preload and for getting ptr
-        Texture::Sptr get(content::Id const & id,
-                          models::Sampler const & sampler = {}) const
+        Binding get(content::Id const & id,
+                    models::Sampler const & sampler = {}) const
+        {
+            return {get(id, _cache, true), getSampler(sampler)};
+        }
+
+        Binding get(content::MaybeId const & id,
+                    models::Sampler const & sampler = {}) const
         {
-            return get(_contentManager, id, sampler, _cache, true);
+            return id ? get(*id, sampler) : Binding();
         }
 
-        Texture::Sptr get(content::MaybeId const & id,
-                          models::Sampler const & sampler = {}) const
+        Binding getNoMipmap(content::Id const & id,
+                            models::Sampler const & sampler = {}) const
         {
-            return id ? get(*id, sampler) : Texture::Sptr();
+            return {get(id, _cacheNoMipmap, false), getSampler(sampler)};
         }
 
-        Texture::Sptr getNoMipmap(content::Id const & id,
-                                  models::Sampler const & sampler = {}) const
+        Binding getNoMipmap(content::MaybeId const & id,
+                            models::Sampler const & sampler = {}) const
         {
-            return get(_contentManager, id, sampler, _cacheNoMipmap, false);
+            return id ? getNoMipmap(*id, sampler) : Binding();
         }
 
-        Texture::Sptr getNoMipmap(content::MaybeId const & id,
-                                  models::Sampler const & sampler = {}) const
+        // Like get() but the image is decoded in background and uploaded by
+        // a few frames (see flush), the texture is sampled at a lower
+        // resolution meanwhile (or not at all till it's decoded)
+        Binding stream(content::Id const & id,
+                       models::Sampler const & sampler = {}) const
         {
-            return id ? get(*id, sampler) : Texture::Sptr();
+            return {stream(id, _cache), getSampler(sampler)};
         }
 
+        Binding stream(content::MaybeId const & id,
+                       models::Sampler const & sampler = {}) const
+        {
+            return id ? stream(*id, sampler) : Binding();
+        }
+
+        opengl::Sampler::Sptr getSampler(models::Sampler const &) const;
+
+        // NOTE: images larger than a page are placed on dedicated pages
+        Region const & getAtlased(content::Id const & id) const;
+
+        // Binds a texture to the unit and the sampler to the unit unless
+        // they're bound there already, returns the layer to sample
+        GLuint bind(Binding const &, GLuint unit) const;
+
+        // Streams textures for the frame (kStreamBudget bytes), generates
+        // mipmaps of arrays w/ new layers, and forgets what is bound
+        // (call it once a frame before the units are used)
+        void flush() const;
+
+        Stats const & stats() const { return _stats; }
+
     private:
-        using Key = std::pair<content::Id, models::Sampler>;
-        using Cache = std::unordered_map<Key, Texture::Sptr>;
+        using Cache = std::unordered_map<content::Id, Texture::Sptr>;
+        using Samplers = std::unordered_map<models::Sampler, opengl::Sampler::Sptr>;
 
-        static Texture::Sptr get(content::Manager &,
-                                 content::Id const &,
-                                 models::Sampler const &,
-                                 Cache &,
-                                 bool mipmaps);
+        Texture::Sptr get(content::Id const &,
+                          Cache &,
+                          bool mipmaps) const;
 
         // TODO: move mipmap into Sampler and merge _cache w/ _cacheNoMipmap
 
+        Texture::Sptr stream(content::Id const &,
+                             Cache &) const;
+
+        // moves a streamed texture into an array of its decoded image
+        void place(std::shared_ptr<Texture> const &, content::Id const &, content::Lease) const;
+
+        // places an image into a layer of an array of its format
+        Texture::Sptr allocate(models::Image const &, bool mipmaps) const;
+
+        Texture::Sptr allocate(models::CompressedImage const &, bool mipmaps) const;
+
+        // an array of the format w/ room for a layer
+        Array::Sptr const & arrayOf(Array::Format const &,
+                                    size_t layerBytes) const;
+
     private:
+        using AtlasCache = std::unordered_map<content::Id, Region>;
+        using Pages = std::vector<std::unique_ptr<Page>>;
+        using Pool = std::map<Array::Format, std::vector<Array::Sptr>>;
+
+        // what is bound to a texture unit
+        struct Unit
+        {
+            GLuint _array = 0;
+            GLuint _sampler = 0;
+        };
+
+        using Units = std::vector<Unit>;
+
+        static constexpr size_t kPageSide = 2048;
+
+        // arrays of a format are allocated w/ capacities of 1, 2, 4 ...
+        // layers (so at most a half of the last one is wasted) up to
+        // the limit of layers or of bytes
+        static constexpr size_t kMaxArrayLayers = 64;
+        static constexpr size_t kMaxArrayBytes = 128 * 1024 * 1024;
+
+        // uploaded by TextureStreamer per frame
+        static constexpr size_t kStreamBudget = 4 * 1024 * 1024;
+        static constexpr size_t kStreamThreads = 2;
+
         content::Manager       & _contentManager;
+        std::unique_ptr<TextureStreamer> _streamer;
+        opengl::CompressedFormats const _compressedFormats;
 
         mutable Cache            _cache;
         mutable Cache            _cacheNoMipmap;
+        mutable Samplers         _samplers;
+        mutable AtlasCache       _atlasCache;
+        mutable Pages            _pages;
+        mutable Pool             _pool;
+        mutable Units            _units;
+        mutable size_t           _maxLayers = 0; // by GL, it's queried once
+        mutable Stats            _stats;
+
+        // a layer streamed textures refer till their images are decoded
+        mutable Array::Sptr      _pending;
+
+        // is expired for callbacks outliving it
+        std::shared_ptr<Textures const> _self;
     };
 }
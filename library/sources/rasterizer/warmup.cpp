@@ -0,0 +1,305 @@
+#include <rasterizer/warmup.hpp>
+
+#include <minire/errors.hpp>
+#include <minire/logging.hpp>
+#include <minire/models/scene-model.hpp>
+#include <minire/utils/unow.hpp>
+
+#include <rasterizer/fonts.hpp>
+#include <rasterizer/materials.hpp>
+#include <rasterizer/meshes.hpp>
+#include <rasterizer/textures.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <exception>
+
+namespace minire::rasterizer
+{
+    namespace
+    {
+        char const * nameOf(Warmup::Kind kind)
+        {
+            switch(kind)
+            {
+                case Warmup::Kind::kMesh:    return "mesh";
+                case Warmup::Kind::kTexture: return "texture";
+                case Warmup::Kind::kFont:    return "font";
+                case Warmup::Kind::kProgram: return "program";
+            }
+            return "unknown";
+        }
+
+        double ms(size_t microseconds)
+        {
+            return microseconds / 1000.0;
+        }
+    }
+
+    Warmup::Warmup(models::WarmupManifest const & manifest,
+                   content::Manager & contentManager,
+                   Meshes & meshes,
+                   Textures const & textures,
+                   Fonts const & fonts,
+                   Materials const & materials,
+                   Ubo const & ubo)
+        : _contentManager(contentManager)
+        , _meshes(meshes)
+        , _textures(textures)
+        , _fonts(fonts)
+        , _materials(materials)
+        , _ubo(ubo)
+        , _start(utils::uNow())
+        , _self(this, [](Warmup *) {})
+    {
+        // requests of higher priorities are the first in the loaders' queue
+        std::vector<models::WarmupManifest::Group const *> groups;
+        for(models::WarmupManifest::Group const & group : manifest._groups)
+        {
+            groups.push_back(&group);
+        }
+        std::stable_sort(groups.begin(), groups.end(),
+                         [](auto const * a, auto const * b) { return a->_priority > b->_priority; });
+
+        for(models::WarmupManifest::Group const * group : groups)
+        {
+            int const priority = group->_priority;
+
+            // programs don't depend on any content, so they're ready right away
+            for(models::WarmupManifest::Material const & material : group->_materials)
+            {
+                MINIRE_INVARIANT(material._model, "no material model to warm up");
+                models::MeshFeatures const & features = material._features;
+                size_t const event = add(Kind::kProgram,
+                                         fmt::format("{}:{}{}{}",
+                                                     material._model->materialKind(),
+                                                     features.hasUv() ? "u" : "-",
+                                                     features.hasNormal() ? "n" : "-",
+                                                     features.hasTangent() ? "t" : "-"),
+                                         priority);
+                ready(event, [this, material]
+                {
+                    _materials.build(*material._model, material._features, _ubo);
+                });
+            }
+
+            for(content::Id const & id : group->_meshes)
+            {
+                size_t const event = add(Kind::kMesh, id, priority);
+                fetch(event, id, [this, event, id](content::Lease model)
+                {
+                    models::SceneModel const & sceneModel = model.as<models::SceneModel>();
+                    _leases.push_back(std::move(model));
+
+                    // the source is hashed on a loader thread to look it up in the cache
+                    ++_decoding;
+                    std::weak_ptr<Warmup> self = _self;
+                    _meshes.cachedAsync(sceneModel, [self, event, id, source = sceneModel._source](bool cached)
+                    {
+                        auto warmup = self.lock();
+                        if (!warmup) return;
+
+                        assert(warmup->_decoding > 0);
+                        --warmup->_decoding;
+
+                        Upload upload = [warmup = warmup.get(), id] { warmup->_meshes.preload(id); };
+                        if (cached)
+                        {
+                            warmup->ready(event, std::move(upload));
+                            return;
+                        }
+
+                        // the source is borrowed by the Mesh from the Manager
+                        warmup->fetch(event, source, [warmup = warmup.get(), event, upload](content::Lease source)
+                        {
+                            warmup->_leases.push_back(std::move(source));
+                            warmup->ready(event, std::move(upload));
+                        });
+                    });
+                });
+            }
+
+            for(models::WarmupManifest::Texture const & texture : group->_textures)
+            {
+                size_t const event = add(Kind::kTexture, texture._id, priority);
+                fetch(event, texture._id, [this, event, texture](content::Lease image)
+                {
+                    _leases.push_back(std::move(image));
+                    ready(event, [this, texture]
+                    {
+                        if (texture._atlased)
+                        {
+                            _textures.getAtlased(texture._id);
+                        }
+                        else
+                        {
+                            _textures.get(texture._id, texture._sampler);
+                        }
+                    });
+                });
+            }
+
+            for(content::Id const & id : group->_fonts)
+            {
+                size_t const event = add(Kind::kFont, id, priority);
+                fetch(event, id, [this, event, id](content::Lease bdf)
+                {
+                    _leases.push_back(std::move(bdf));
+                    ready(event, [this, id] { _fonts.get(id); });
+                });
+            }
+        }
+
+        MINIRE_INFO("warmup: {} items requested", _timeline.size());
+    }
+
+    size_t Warmup::add(Kind kind, content::Id id, int priority)
+    {
+        _timeline.push_back(Event{kind, std::move(id), priority});
+        return _timeline.size() - 1;
+    }
+
+    void Warmup::fetch(size_t event, content::Id const & id, Decoded decoded)
+    {
+        ++_decoding;
+
+        std::weak_ptr<Warmup> self = _self;
+        _contentManager.borrowAsync(id,
+            [self, event, decoded = std::move(decoded)](content::Lease lease,
+                                                        std::exception_ptr error)
+            {
+                auto warmup = self.lock();
+                if (!warmup) return;
+
+                assert(warmup->_decoding > 0);
+                --warmup->_decoding;
+
+                try
+                {
+                    if (error) std::rethrow_exception(error);
+                    assert(lease);
+                    decoded(std::move(lease));
+                }
+                catch(std::exception const & e)
+                {
+                    warmup->fail(event, e.what());
+                }
+            });
+    }
+
+    void Warmup::ready(size_t event, Upload upload)
+    {
+        assert(event < _timeline.size());
+        Event & entry = _timeline[event];
+        entry._decoded = now();
+        _queues[entry._priority].push_back(Task{event, std::move(upload)});
+    }
+
+    void Warmup::fail(size_t event, std::string const & reason)
+    {
+        assert(event < _timeline.size());
+        Event & entry = _timeline[event];
+        entry._failed = true;
+        entry._uploaded = now();
+        MINIRE_ERROR("warmup: failed to warm up {} {}: {}",
+                     nameOf(entry._kind), entry._id, reason);
+    }
+
+    size_t Warmup::now() const
+    {
+        return utils::uNow() - _start;
+    }
+
+    bool Warmup::done() const
+    {
+        return 0 == _decoding &&
+               std::all_of(_queues.cbegin(), _queues.cend(),
+                           [](auto const & queue) { return queue.second.empty(); });
+    }
+
+    bool Warmup::step(size_t budget)
+    {
+        ++_frames;
+
+        size_t const start = utils::uNow();
+        do
+        {
+            // the highest priority one which is decoded already
+            auto it = std::find_if(_queues.begin(), _queues.end(),
+                                   [](auto const & queue) { return !queue.second.empty(); });
+            if (it == _queues.end()) break;
+
+            Task task = std::move(it->second.front());
+            it->second.pop_front();
+
+            size_t const begin = utils::uNow();
+            try
+            {
+                task._upload();
+                Event & entry = _timeline[task._event];
+                entry._uploadTime = utils::uNow() - begin;
+                entry._uploaded = now();
+            }
+            catch(std::exception const & e)
+            {
+                fail(task._event, e.what());
+            }
+        }
+        while(utils::uNow() - start < budget);
+
+        return done();
+    }
+
+    void Warmup::report() const
+    {
+        struct Totals
+        {
+            size_t _items = 0;
+            size_t _failed = 0;
+            size_t _decoded = 0;    // by the last one
+            size_t _uploaded = 0;   // by the last one
+            size_t _uploadTime = 0;
+        };
+
+        std::array<Totals, 4> totals;
+        size_t end = 0;
+        for(Event const & event : _timeline)
+        {
+            Totals & total = totals[static_cast<size_t>(event._kind)];
+            ++total._items;
+            total._failed += event._failed ? 1 : 0;
+            total._decoded = std::max(total._decoded, event._decoded);
+            total._uploaded = std::max(total._uploaded, event._uploaded);
+            total._uploadTime += event._uploadTime;
+            end = std::max(end, event._uploaded);
+
+            MINIRE_DEBUG("warmup: {} {} (priority {}): decoded at {:.1f} ms, "
+                         "uploaded at {:.1f} ms in {:.1f} ms{}",
+                         nameOf(event._kind), event._id, event._priority,
+                         ms(event._decoded), ms(event._uploaded), ms(event._uploadTime),
+                         event._failed ? ", FAILED" : "");
+        }
+
+        for(size_t kind = 0; kind < totals.size(); ++kind)
+        {
+            Totals const & total = totals[kind];
+            if (0 == total._items) continue;
+
+            MINIRE_INFO("warmup: {} {}s ({} failed): decoded by {:.1f} ms, "
+                        "uploaded by {:.1f} ms, uploads took {:.1f} ms",
+                        total._items, nameOf(static_cast<Kind>(kind)), total._failed,
+                        ms(total._decoded), ms(total._uploaded), ms(total._uploadTime));
+        }
+
+        MINIRE_INFO("warmup: {} items are done by {:.1f} ms in {} frames",
+                    _timeline.size(), ms(end), _frames);
+
+        Textures::Stats const & textures = _textures.stats();
+        MINIRE_INFO("warmup: {} texture requests share {} textures in {} arrays ({:.2f}x dedup), {} KiB",
+                    textures._requests, textures._textures, textures._arrays,
+                    textures.dedupRatio(), textures._bytes / 1024);
+    }
+}
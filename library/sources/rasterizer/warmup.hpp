@@ -0,0 +1,108 @@
+#pragma once
+
+#include <minire/content/manager.hpp>
+#include <minire/models/warmup-manifest.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace minire::rasterizer
+{
+    class Fonts;
+    class Materials;
+    class Meshes;
+    class Textures;
+    class Ubo;
+
+    // Decodes content of a WarmupManifest on loader threads of the
+    // content::Manager, and uploads decoded items by time slices of
+    // frames (see step), so the first interactive frame loads nothing.
+    // Decoded assets are held till the Warmup is destroyed.
+    class Warmup
+    {
+    public:
+        enum class Kind
+        {
+            kMesh, kTexture, kFont, kProgram,
+        };
+
+        // times are in microseconds since the Warmup is started
+        struct Event
+        {
+            Kind        _kind;
+            content::Id _id;
+            int         _priority;
+            size_t      _decoded = 0;    // by poll(), it's 0 w/o decoding
+            size_t      _uploaded = 0;
+            size_t      _uploadTime = 0; // taken on the render thread
+            bool        _failed = false;
+        };
+
+        using Timeline = std::vector<Event>;
+
+    public:
+        Warmup(models::WarmupManifest const &,
+               content::Manager &,
+               Meshes &,
+               Textures const &,
+               Fonts const &,
+               Materials const &,
+               Ubo const &);
+
+    public:
+        // Uploads decoded items for about budget microseconds (one item
+        // at least), returns true once everything is uploaded or failed
+        bool step(size_t budget);
+
+        bool done() const;
+
+        Timeline const & timeline() const { return _timeline; }
+
+        // logs where the time went
+        void report() const;
+
+    private:
+        using Upload = std::function<void()>;
+        using Decoded = std::function<void(content::Lease)>;
+
+        size_t add(Kind, content::Id, int priority);
+
+        // borrows an asset asynchronously, decoded is called by poll()
+        void fetch(size_t event, content::Id const &, Decoded);
+
+        void ready(size_t event, Upload);
+
+        void fail(size_t event, std::string const & reason);
+
+        size_t now() const;
+
+    private:
+        struct Task
+        {
+            size_t _event;
+            Upload _upload;
+        };
+
+        using Queues = std::map<int, std::deque<Task>, std::greater<int>>; // the highest priority first
+
+        content::Manager           & _contentManager;
+        Meshes                     & _meshes;
+        Textures const             & _textures;
+        Fonts const                & _fonts;
+        Materials const            & _materials;
+        Ubo const                  & _ubo;
+
+        size_t const                 _start;
+        size_t                       _frames = 0;
+        size_t                       _decoding = 0; // requests in flight
+        Timeline                     _timeline;
+        Queues                       _queues;
+        std::vector<content::Lease>  _leases;
+        std::shared_ptr<Warmup>      _self; // is expired for callbacks outliving it
+    };
+}
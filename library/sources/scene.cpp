@@ -28,7 +28,7 @@ namespace minire
 
         for(scene::Model::Uptr const & model : _models)
         {
-            if (model) _rasterizer.meshes().decUse(model->model());
+            if (model) release(*model);
         }
         _activeModels.clear();
         _models.clear();
@@ -42,11 +42,14 @@ namespace minire
         if (_models.size() <= e._id) _models.resize(e._id + 1);
         if (_models[e._id]) MINIRE_THROW("model slot busy: {}", e._id);
 
-        _rasterizer.meshes().incUse(e._model);
+        rasterizer::Meshes & meshes = _rasterizer.meshes();
+        if (e._placeholder) meshes.incUse(*e._placeholder);
+        meshes.incUseAsync(e._model);
         auto model = std::make_unique<scene::Model>(
             e._id,
             e._model,
-            _rasterizer.meshes().aabb(e._model),
+            e._placeholder,
+            meshes.aabb(e._model),
             e._position);
         _models[e._id] = std::move(model);
     }
@@ -62,7 +65,7 @@ namespace minire
     void Scene::handle(events::controller::SceneUnmergeModel const & e)
     {
         auto & model = getModel(e._id);
-        _rasterizer.meshes().decUse(model->model());
+        release(*model);
         model.reset();
         _activeModels.erase(e._id);
 
@@ -99,6 +102,15 @@ namespace minire
         _activeLights.insert(e._id);
     }
 
+    void Scene::release(scene::Model const & model)
+    {
+        _rasterizer.meshes().decUse(model.model());
+        if (model.placeholder())
+        {
+            _rasterizer.meshes().decUse(*model.placeholder());
+        }
+    }
+
     scene::Model::Uptr & Scene::getModel(size_t id)
     {
         if (id >= _models.size())
@@ -192,8 +204,15 @@ namespace minire
         for(scene::Model::Uptr const & model : _models)
         {
             if (!model) continue;
+
+            // the placeholder is drawn until the model is loaded
+            content::Id const & mesh =
+                !model->placeholder() || _rasterizer.meshes().ready(model->model())
+                    ? model->model()
+                    : *model->placeholder();
+
             bool const selected = 0 != _selectedModelsIds.count(model->id());
-            result.emplace_back(model->model(),
+            result.emplace_back(mesh,
                                 model->transform(),
                                 selected ? 1.5f : 1.0f);
         }
@@ -50,6 +50,8 @@ namespace minire
         scene::PointLightRef::List cullPointLights(utils::Viewpoint const &, size_t) const;
 
     private:
+        void release(scene::Model const &);
+
         scene::Model::Uptr & getModel(size_t id);
         scene::PointLight::Uptr & getPointLight(size_t id);
 
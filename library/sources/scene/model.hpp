@@ -21,10 +21,12 @@ namespace minire::scene
     public:
         Model(size_t id,
               content::Id model,
+              content::MaybeId placeholder,
               utils::Aabb const & aabb, // will store a reference!
               models::ModelPosition const & position)
             : _id(id)
             , _model(model)
+            , _placeholder(std::move(placeholder))
             , _lerpable(position)
             , _aabb(aabb)
             , _aabbTransformed(aabb)
@@ -49,6 +51,8 @@ namespace minire::scene
 
         content::Id const & model() const { return _model; }
 
+        content::MaybeId const & placeholder() const { return _placeholder; }
+
         size_t id() const { return _id; }
 
         using Uptr = std::unique_ptr<Model>;
@@ -65,6 +69,7 @@ namespace minire::scene
     private:
         size_t              _id;
         content::Id         _model;
+        content::MaybeId    _placeholder;
         Lerpable            _lerpable;
         glm::mat4           _transform;
         utils::Aabb const & _aabb;
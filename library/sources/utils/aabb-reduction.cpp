@@ -0,0 +1,75 @@
+#include <utils/aabb-reduction.hpp>
+
+#include <minire/errors.hpp>
+
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64)
+    #include <xmmintrin.h>
+    #define MINIRE_AABB_SSE 1
+#endif
+
+namespace minire::utils
+{
+    Aabb reduceAabb(std::span<std::byte const> vertices, size_t stride)
+    {
+        MINIRE_INVARIANT(stride >= 3 * sizeof(float), "too short vertices: {}", stride);
+        size_t const count = vertices.size() / stride;
+        if (0 == count) return Aabb();
+
+        std::byte const * data = vertices.data();
+
+#if defined(MINIRE_AABB_SSE)
+        // positions are loaded into (x, y, z, x) lanes, so the last one
+        // doesn't read past the buffer; 2 pairs of accumulators hide
+        // the latency of min/max
+        auto const load = [data, stride](size_t vertex)
+        {
+            float xyz[4];
+            std::memcpy(xyz, data + vertex * stride, 3 * sizeof(float));
+            xyz[3] = xyz[0];
+            return _mm_loadu_ps(xyz);
+        };
+
+        __m128 min0 = load(0);
+        __m128 max0 = min0;
+        __m128 min1 = min0;
+        __m128 max1 = min0;
+
+        size_t i = 1;
+        for(; i + 1 < count; i += 2)
+        {
+            __m128 const a = load(i);
+            __m128 const b = load(i + 1);
+            min0 = _mm_min_ps(min0, a);
+            max0 = _mm_max_ps(max0, a);
+            min1 = _mm_min_ps(min1, b);
+            max1 = _mm_max_ps(max1, b);
+        }
+        if (i < count)
+        {
+            __m128 const a = load(i);
+            min0 = _mm_min_ps(min0, a);
+            max0 = _mm_max_ps(max0, a);
+        }
+
+        alignas(16) float min[4];
+        alignas(16) float max[4];
+        _mm_store_ps(min, _mm_min_ps(min0, min1));
+        _mm_store_ps(max, _mm_max_ps(max0, max1));
+        return Aabb(glm::vec3(min[0], min[1], min[2]),
+                    glm::vec3(max[0], max[1], max[2]));
+#else
+        auto const position = [data, stride](size_t vertex)
+        {
+            glm::vec3 result;
+            std::memcpy(&result, data + vertex * stride, sizeof(result));
+            return result;
+        };
+
+        Aabb result(position(0), position(0));
+        for(size_t i = 1; i < count; ++i) result.extend(position(i));
+        return result;
+#endif
+    }
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <minire/utils/aabb.hpp>
+
+#include <cstddef>
+#include <span>
+
+namespace minire::utils
+{
+    // Of positions which are 3 floats at the beginning of interleaved
+    // vertices, it's reduced by SSE where it's available. An empty AABB
+    // at the origin if there are no vertices
+    Aabb reduceAabb(std::span<std::byte const> vertices, size_t stride);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace minire::utils
+{
+    // Halves an 8-bit image by a box filter, the last row and column of
+    // odd sides are repeated
+    inline void downsample(uint8_t const * src, size_t srcWidth, size_t srcHeight,
+                           uint8_t * dst, size_t dstWidth, size_t dstHeight,
+                           size_t bytesInPixel)
+    {
+        size_t const srcLine = srcWidth * bytesInPixel;
+        for(size_t y = 0; y < dstHeight; ++y)
+        {
+            uint8_t const * row0 = src + std::min(2 * y, srcHeight - 1) * srcLine;
+            uint8_t const * row1 = src + std::min(2 * y + 1, srcHeight - 1) * srcLine;
+            for(size_t x = 0; x < dstWidth; ++x)
+            {
+                size_t const x0 = std::min(2 * x, srcWidth - 1) * bytesInPixel;
+                size_t const x1 = std::min(2 * x + 1, srcWidth - 1) * bytesInPixel;
+                for(size_t c = 0; c < bytesInPixel; ++c)
+                {
+                    unsigned const sum = row0[x0 + c] + row0[x1 + c] +
+                                         row1[x0 + c] + row1[x1 + c];
+                    *dst++ = static_cast<uint8_t>((sum + 2) / 4);
+                }
+            }
+        }
+    }
+}
@@ -8,10 +8,14 @@
 #include <minire/models/pbr-material.hpp>
 #include <minire/models/sampler.hpp>
 
-#include <utils/uuid.hpp>
-
 #include <algorithm>
+#include <cstddef>
+#include <cstring>
 #include <initializer_list>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
 #include <tuple>
 
 // TODO: set "LoadImageDataOption::preserve_channels" to avoid unnecessary components loading
@@ -116,6 +120,9 @@ namespace minire::utils
                 // not modifying operations will be performed
                 _data = const_cast<uint8_t *>(image.image.data());
             }
+
+            // pixels are counted w/ the model
+            bool ownsData() const override { return false; }
         };
 
         size_t requireAttr(::tinygltf::Mesh const & mesh,
@@ -139,8 +146,103 @@ namespace minire::utils
             return model.accessors[index];
         }
 
+        // KHR_mesh_quantization: positions of integer types are dequantized
+        // by the transform of nodes of the mesh, the only node transform
+        // applied (w/o rotation, which a dequantization doesn't have)
+        struct PositionDecode
+        {
+            glm::vec3 _scale = glm::vec3(1.0f);
+            glm::vec3 _offset = glm::vec3(0.0f);
+        };
+
+        bool quantized(::tinygltf::Accessor const & accessor)
+        {
+            return TINYGLTF_COMPONENT_TYPE_FLOAT != accessor.componentType;
+        }
+
+        PositionDecode positionDecode(::tinygltf::Node const & node)
+        {
+            PositionDecode result;
+            if (node.matrix.size() == 16)
+            {
+                std::vector<double> const & m = node.matrix; // column-major
+                MINIRE_INVARIANT(m[1] == 0.0 && m[2] == 0.0 && m[4] == 0.0 &&
+                                 m[6] == 0.0 && m[8] == 0.0 && m[9] == 0.0,
+                                 "rotated dequantization isn't supported: {}", node.name);
+                result._scale = glm::vec3(m[0], m[5], m[10]);
+                result._offset = glm::vec3(m[12], m[13], m[14]);
+                return result;
+            }
+
+            // the quaternion is (x, y, z, w), either sign of w is no rotation
+            MINIRE_INVARIANT(node.rotation.size() != 4 ||
+                             (node.rotation[0] == 0.0 && node.rotation[1] == 0.0 && node.rotation[2] == 0.0),
+                             "rotated dequantization isn't supported: {}", node.name);
+            if (node.scale.size() == 3)
+            {
+                result._scale = glm::vec3(node.scale[0], node.scale[1], node.scale[2]);
+            }
+            if (node.translation.size() == 3)
+            {
+                result._offset = glm::vec3(node.translation[0], node.translation[1], node.translation[2]);
+            }
+            return result;
+        }
+
+        // the decode is the same for all the nodes of a mesh w/ quantized
+        // positions, since its vertices are uploaded once for all of them
+        PositionDecode positionDecode(::tinygltf::Model const & model, size_t meshIndex)
+        {
+            assert(meshIndex < model.meshes.size());
+            ::tinygltf::Mesh const & mesh = model.meshes[meshIndex];
+            bool const anyQuantized = std::any_of(mesh.primitives.cbegin(), mesh.primitives.cend(),
+                                                  [&model](::tinygltf::Primitive const & primitive)
+                                                  {
+                                                      auto const it = primitive.attributes.find("POSITION");
+                                                      return it != primitive.attributes.cend()
+                                                          && it->second >= 0
+                                                          && static_cast<size_t>(it->second) < model.accessors.size()
+                                                          && quantized(model.accessors[static_cast<size_t>(it->second)]);
+                                                  });
+            if (!anyQuantized) return PositionDecode();
+
+            std::optional<PositionDecode> result;
+            ::tinygltf::Node const * first = nullptr;
+            for(::tinygltf::Node const & node : model.nodes)
+            {
+                if (node.mesh < 0 || static_cast<size_t>(node.mesh) != meshIndex) continue;
+
+                PositionDecode const decode = positionDecode(node);
+                if (!result)
+                {
+                    result = decode;
+                    first = &node;
+                    continue;
+                }
+                MINIRE_INVARIANT(decode._scale == result->_scale && decode._offset == result->_offset,
+                                 "nodes dequantize a shared mesh differently: {}, {}, {}",
+                                 first->name, node.name, mesh.name);
+            }
+            return result.value_or(PositionDecode());
+        }
+
+        // a value of the accessor as a shader sees it
+        double normalized(::tinygltf::Accessor const & accessor, double value)
+        {
+            if (!accessor.normalized) return value;
+            switch(accessor.componentType)
+            {
+                case TINYGLTF_COMPONENT_TYPE_BYTE:           return std::max(value / 127.0, -1.0);
+                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:  return value / 255.0;
+                case TINYGLTF_COMPONENT_TYPE_SHORT:          return std::max(value / 32767.0, -1.0);
+                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: return value / 65535.0;
+            }
+            return value;
+        }
+
         Aabb calcAabb(::tinygltf::Accessor const & position,
-                      std::string const & tag)
+                      std::string const & tag,
+                      PositionDecode const & decode)
         {
             MINIRE_INVARIANT(position.type == TINYGLTF_TYPE_VEC3,
                              "position isn't Vec3: {}, {}/{}",
@@ -157,8 +259,20 @@ namespace minire::utils
                              "maxValues are not 3: {}, {}/{}",
                              max.size(), tag, position.name);
 
-            return Aabb(glm::vec3{min[0], min[1], min[2]},
-                        glm::vec3{max[0], max[1], max[2]});
+            if (!quantized(position))
+            {
+                return Aabb(glm::vec3{min[0], min[1], min[2]},
+                            glm::vec3{max[0], max[1], max[2]});
+            }
+
+            // min and max are stored values, a negative scale swaps them
+            glm::vec3 const a = decode._offset + glm::vec3(normalized(position, min[0]),
+                                                           normalized(position, min[1]),
+                                                           normalized(position, min[2])) * decode._scale;
+            glm::vec3 const b = decode._offset + glm::vec3(normalized(position, max[0]),
+                                                           normalized(position, max[1]),
+                                                           normalized(position, max[2])) * decode._scale;
+            return Aabb(a.x, a.y, a.z, b.x, b.y, b.z);
         }
 
         ::tinygltf::BufferView const & getBufferView(::tinygltf::Accessor const & accessor,
@@ -176,50 +290,73 @@ namespace minire::utils
             return model.bufferViews[bufferViewIndex];
         }
 
-        ::tinygltf::Buffer const & getBuffer(::tinygltf::BufferView const & bufferView,
-                                             ::tinygltf::Model const & model)
+        // bytes of model's buffers, see formats::gltfBuffer
+        using GltfBuffers = std::vector<std::span<std::byte const>>;
+
+        GltfBuffers getBuffers(formats::GltfModelSptr const & model)
+        {
+            GltfBuffers result(model->buffers.size());
+            for(size_t i = 0; i < result.size(); ++i)
+            {
+                result[i] = formats::gltfBuffer(model, i);
+            }
+            return result;
+        }
+
+        std::span<std::byte const> getBuffer(::tinygltf::BufferView const & bufferView,
+                                             GltfBuffers const & buffers)
         {
             MINIRE_INVARIANT(bufferView.buffer >= 0,
                              "buffer isn't specified (wtf?): {}", bufferView.buffer);
 
             size_t const bufferIndex = static_cast<size_t>(bufferView.buffer);
-            MINIRE_INVARIANT(bufferIndex < model.buffers.size(),
-                             "bad buffer index: {} >= {}", bufferIndex, model.buffers.size());
-            return model.buffers[bufferIndex];
+            MINIRE_INVARIANT(bufferIndex < buffers.size(),
+                             "bad buffer index: {} >= {}", bufferIndex, buffers.size());
+            return buffers[bufferIndex];
         }
 
+        // the VBO of the whole bufferView of an accessor, it's uploaded once
+        // per model and bound to VAOs of all the primitives referring it;
+        // the same bufferView may hold both elements and attributes, so
+        // the target it's created w/ is only a hint
         std::tuple<::tinygltf::Accessor const &,
-                   ::tinygltf::BufferView const &>
-        createVbo(::tinygltf::Model const & model,
+                   ::tinygltf::BufferView const &,
+                   opengl::VBO::Sptr>
+        sharedVbo(::tinygltf::Model const & model,
+                  GltfBuffers const & buffers,
+                  content::Id const & source,
                   size_t const accessorIndex,
                   GLenum const target,
-                  opengl::VertexBuffer & result,
-                  bool const addAccessorOffset)
+                  GltfVbos & vbos,
+                  opengl::VertexBuffer & result)
         {
             ::tinygltf::Accessor const & accessor = getAccessor(accessorIndex, model);
-
             ::tinygltf::BufferView const & bufferView = getBufferView(accessor, model);
-            MINIRE_INVARIANT(bufferView.target >= 0, "bad bufferView.target = {}",
-                             bufferView.target);
 
-            MINIRE_INVARIANT(static_cast<GLenum>(bufferView.target) == target,
+            // the target is only a hint, it's optional
+            MINIRE_INVARIANT(bufferView.target <= 0 || static_cast<GLenum>(bufferView.target) == target,
                              "unexpected VBO target: {} != {}, {}",
                              bufferView.target, target, accessor.name);
 
-            ::tinygltf::Buffer const & buffer = getBuffer(bufferView, model);
-            MINIRE_INVARIANT(bufferView.byteOffset + bufferView.byteLength <= buffer.data.size(),
-                             "buffer overflow: {}, {}, {}, {}",
-                             bufferView.byteOffset, bufferView.byteLength, buffer.data.size(),
-                             accessor.name);
+            size_t const bufferViewIndex = static_cast<size_t>(accessor.bufferView);
+            std::weak_ptr<opengl::VBO> & cached = vbos[{source, bufferViewIndex}];
+            opengl::VBO::Sptr vbo = cached.lock();
+            if (!vbo)
+            {
+                std::span<std::byte const> const buffer = getBuffer(bufferView, buffers);
+                MINIRE_INVARIANT(bufferView.byteOffset + bufferView.byteLength <= buffer.size(),
+                                 "buffer overflow: {}, {}, {}, {}",
+                                 bufferView.byteOffset, bufferView.byteLength, buffer.size(),
+                                 accessor.name);
+
+                vbo = std::make_shared<opengl::VBO>(result._vao, target);
+                vbo->bufferData(bufferView.byteLength, buffer.data() + bufferView.byteOffset,
+                                GL_STATIC_DRAW);
+                cached = vbo;
+            }
 
-            opengl::VBO & vbo = result.createVbo(accessorIndex, target);
-            //static_assert(sizeof(typename ::tinygltf::Buffer::data::value_type) == 1,
-            //              "data vector's size isn't equal 1 byte");
-            vbo.bufferData(bufferView.byteLength,
-                           buffer.data.data() + bufferView.byteOffset +
-                                (addAccessorOffset ? accessor.byteOffset : 0),
-                           GL_STATIC_DRAW);
-            return {accessor, bufferView};
+            result.bind(bufferViewIndex, vbo, target);
+            return {accessor, bufferView, vbo};
         }
 
         void setupSampler(::tinygltf::Model const & model,
@@ -243,7 +380,7 @@ namespace minire::utils
 
         struct MaterialData
         {
-            using Leases = std::vector<std::unique_ptr<content::Lease>>;
+            using Leases = std::vector<content::Lease>;
 
             material::Model::Uptr _materialModel;
             Leases                _textureLeases;
@@ -251,6 +388,7 @@ namespace minire::utils
 
         std::pair<content::Id, ::tinygltf::Texture const *>
         fetchTexture(std::shared_ptr<::tinygltf::Model> const & model,
+                     content::Id const & source,
                      int index, int texCoord,
                      content::Manager & contentManager,
                      MaterialData::Leases & leases)
@@ -276,9 +414,15 @@ namespace minire::utils
                 MINIRE_INVARIANT(!image.as_is, "Image of {} isn't preloaded: {}",
                                  texture.name, image.name);
 
-                std::shared_ptr<models::Image> rawImage = std::make_shared<RawImage>(image, model);
-                std::string imageId = fmt::format("__minire_gltf_image_{}", newUuid());
-                auto lease = contentManager.upload(imageId, std::move(rawImage));
+                // an image is stored once for all the meshes and materials of
+                // the source, so is its texture (see rasterizer::Textures)
+                std::string imageId = fmt::format("__minire_gltf_image_{}#{}", source, imageIndex);
+                content::Lease lease = contentManager.tryBorrow(imageId);
+                if (!lease)
+                {
+                    std::shared_ptr<models::Image> rawImage = std::make_shared<RawImage>(image, model);
+                    lease = contentManager.upload(imageId, std::move(rawImage));
+                }
                 leases.emplace_back(std::move(lease));
 
                 return std::make_pair(imageId, &texture);
@@ -287,6 +431,7 @@ namespace minire::utils
         }
 
         MaterialData createMaterialModel(std::shared_ptr<::tinygltf::Model> const & model,
+                                         content::Id const & source,
                                          ::tinygltf::Material const & material,
                                          content::Manager & contentManager)
         {
@@ -316,7 +461,7 @@ namespace minire::utils
                                              pbrMr.baseColorFactor[2]};
 
             if (auto [contentId, texture] = fetchTexture(
-                    model, pbrMr.baseColorTexture.index,
+                    model, source, pbrMr.baseColorTexture.index,
                     pbrMr.baseColorTexture.texCoord,
                     contentManager, leases);
                 texture)
@@ -330,7 +475,7 @@ namespace minire::utils
             result._roughnessFactor = pbrMr.roughnessFactor;
 
             if (auto [contentId, texture] = fetchTexture(
-                    model, pbrMr.metallicRoughnessTexture.index,
+                    model, source, pbrMr.metallicRoughnessTexture.index,
                     pbrMr.metallicRoughnessTexture.texCoord,
                     contentManager, leases);
                 texture)
@@ -343,7 +488,7 @@ namespace minire::utils
             }
 
             if (auto [contentId, texture] = fetchTexture(
-                    model, material.normalTexture.index,
+                    model, source, material.normalTexture.index,
                     material.normalTexture.texCoord,
                     contentManager, leases);
                 texture)
@@ -355,7 +500,7 @@ namespace minire::utils
             }
 
             if (auto [contentId, texture] = fetchTexture(
-                    model, material.occlusionTexture.index,
+                    model, source, material.occlusionTexture.index,
                     material.occlusionTexture.texCoord,
                     contentManager, leases);
                 texture)
@@ -373,7 +518,7 @@ namespace minire::utils
                                                material.emissiveFactor[2]);
 
             if (auto [contentId, texture] = fetchTexture(
-                    model, material.emissiveTexture.index,
+                    model, source, material.emissiveTexture.index,
                     material.emissiveTexture.texCoord,
                     contentManager, leases);
                 texture)
@@ -390,17 +535,80 @@ namespace minire::utils
             };
         }
 
-        // TODO: see glDrawArrays, glDrawRangeElements, glMultiDrawElements, or glMultiDrawArrays
-        //       for cases w/o indeces and multiple primitives
+        // bytes of elements an accessor refers, elements are strided
+        // by the bufferView, or tightly packed
+        struct AccessorBytes
+        {
+            std::span<std::byte const> _bytes;
+            size_t                     _stride = 0;
+            size_t                     _size = 0; // of an element
+        };
+
+        AccessorBytes getAccessorBytes(::tinygltf::Model const & model,
+                                       GltfBuffers const & buffers,
+                                       ::tinygltf::Accessor const & accessor)
+        {
+            MINIRE_INVARIANT(accessor.sparse.count == 0 && !accessor.sparse.isSparse,
+                             "sparse accessors aren't yet supported");
+
+            ::tinygltf::BufferView const & bufferView = getBufferView(accessor, model);
+            std::span<std::byte const> const buffer = getBuffer(bufferView, buffers);
+            MINIRE_INVARIANT(bufferView.byteOffset + bufferView.byteLength <= buffer.size(),
+                             "buffer overflow: {}, {}, {}, {}",
+                             bufferView.byteOffset, bufferView.byteLength, buffer.size(),
+                             accessor.name);
+
+            int const components = ::tinygltf::GetNumComponentsInType(accessor.type);
+            int const componentSize = ::tinygltf::GetComponentSizeInBytes(accessor.componentType);
+            MINIRE_INVARIANT(components > 0 && componentSize > 0,
+                             "bad accessor type: {}/{}, {}",
+                             accessor.type, accessor.componentType, accessor.name);
+
+            AccessorBytes result;
+            result._size = static_cast<size_t>(components * componentSize);
+            result._stride = bufferView.byteStride ? bufferView.byteStride : result._size;
+            result._bytes = buffer.subspan(bufferView.byteOffset, bufferView.byteLength);
+
+            size_t const used = accessor.count ? (accessor.count - 1) * result._stride + result._size
+                                               : 0;
+            MINIRE_INVARIANT(accessor.byteOffset <= result._bytes.size() &&
+                             used <= result._bytes.size() - accessor.byteOffset,
+                             "accessor overflow: {}, {}, {}",
+                             accessor.byteOffset, used, accessor.name);
+            result._bytes = result._bytes.subspan(accessor.byteOffset, used);
+            return result;
+        }
+
+        // the least and the greatest of indices, see glDrawRangeElements
+        template<typename T>
+        std::pair<GLuint, GLuint> elementsRange(AccessorBytes const & indices)
+        {
+            size_t const count = indices._bytes.size() / sizeof(T);
+            if (0 == count) return {0, 0};
+
+            T min = std::numeric_limits<T>::max();
+            T max = 0;
+            for(size_t i = 0; i < count; ++i)
+            {
+                T value;
+                std::memcpy(&value, indices._bytes.data() + i * sizeof(T), sizeof(T));
+                min = std::min(min, value);
+                max = std::max(max, value);
+            }
+            return {min, max};
+        }
+
+        // TODO: see glDrawArrays or glMultiDrawArrays for cases w/o indeces
         // TODO: Client implementations SHOULD support at least two texture coordinate sets, ...
         // TODO: don't load texture automatically, since they might be controller via content::Manger
         opengl::VertexBuffer createVertexBuffer(::tinygltf::Model const & model,
+                                                GltfBuffers const & buffers,
+                                                content::Id const & source,
                                                 ::tinygltf::Mesh const & mesh,
                                                 ::tinygltf::Primitive const & primitive,
-                                                int vtxAttribIndex,
-                                                int uvAttribIndx,
-                                                int normAttrib,
-                                                int tangentAttrib)
+                                                PositionDecode const & decode,
+                                                material::Program::Locations const & locations,
+                                                GltfVbos & vbos)
         {
             opengl::VertexBuffer result;
 
@@ -410,55 +618,165 @@ namespace minire::utils
                 // TODO: When indices property is not defined, the number of vertex indices to render is
                 //       defined by count of attribute accessors
                 MINIRE_INVARIANT(primitive.indices >= 0, "indices are not specified: {}", mesh.name);
-                auto const & [accessor, _] = createVbo(model, static_cast<size_t>(primitive.indices),
-                                                       GL_ELEMENT_ARRAY_BUFFER, result, true);
+                auto const & [accessor, bufferView, _] = sharedVbo(model, buffers, source,
+                                                                   static_cast<size_t>(primitive.indices),
+                                                                   GL_ELEMENT_ARRAY_BUFFER, vbos, result);
 
                 MINIRE_INVARIANT(TINYGLTF_TYPE_SCALAR == accessor.type,
                                  "indices are not scalar: {}, {}", accessor.type, mesh.name);
 
+                AccessorBytes const indices = getAccessorBytes(model, buffers, accessor);
+                MINIRE_INVARIANT(indices._stride == indices._size,
+                                 "indices are strided: {}", mesh.name);
+
                 result._elementsCount = accessor.count;
                 result._elementsType = gltfComponentTypeToGlType(accessor.componentType);
+                result._elementsOffset = accessor.byteOffset;
+                switch(result._elementsType)
+                {
+                    case GL_UNSIGNED_BYTE:  result._elementsRange = elementsRange<uint8_t>(indices); break;
+                    case GL_UNSIGNED_SHORT: result._elementsRange = elementsRange<uint16_t>(indices); break;
+                    case GL_UNSIGNED_INT:   result._elementsRange = elementsRange<uint32_t>(indices); break;
+                    default: MINIRE_THROW("bad indices type: {}, {}", accessor.componentType, mesh.name);
+                }
             }
 
             // Vertex buffer and attributes
 
             using Attribs = std::initializer_list<std::tuple<std::string const &, int>>;
-            for(auto const & [accessorName, attribIndex] : Attribs {{kPosition, vtxAttribIndex},
-                                                                    {kTexCoord0, uvAttribIndx},
-                                                                    {kNormal, normAttrib},
-                                                                    {kTangent, tangentAttrib}})
+            for(auto const & [accessorName, attribIndex] : Attribs {{kPosition, locations._vertexAttribute},
+                                                                    {kTexCoord0, locations._uvAttribute},
+                                                                    {kNormal, locations._normalAttribute},
+                                                                    {kTangent, locations._tangentAttribute}})
             {
                 if (attribIndex == -1) continue;
 
                 size_t const accessorIndex = requireAttr(mesh, primitive, accessorName);
-                auto const & [accessor, bufferView] = createVbo(model, accessorIndex, GL_ARRAY_BUFFER, result, false);
+                auto const & [accessor, bufferView, vbo] = sharedVbo(model, buffers, source, accessorIndex,
+                                                                     GL_ARRAY_BUFFER, vbos, result);
 
                 MINIRE_INVARIANT(accessor.sparse.count == 0 && !accessor.sparse.isSparse,
                                 "sparse accessors aren't yet supported");
 
                 if (accessorName == kPosition)
                 {
-                    result._aabb = calcAabb(accessor, mesh.name);
+                    result._aabb = calcAabb(accessor, mesh.name, decode);
+                    if (quantized(accessor))
+                    {
+                        result._positionScale = decode._scale;
+                        result._positionOffset = decode._offset;
+                    }
                 }
 
-                result._vao->enableAttrib(attribIndex);
-                result._vao->attribPointer(attribIndex,
-                                           ::tinygltf::GetNumComponentsInType(accessor.type),
-                                           gltfComponentTypeToGlType(accessor.componentType),
-                                           accessor.normalized ? GL_TRUE : GL_FALSE,
-                                           bufferView.byteStride, accessor.byteOffset);
+                result.attrib(*vbo, opengl::VertexBuffer::Binding{
+                    vbo->id(),
+                    static_cast<GLuint>(attribIndex),
+                    ::tinygltf::GetNumComponentsInType(accessor.type),
+                    gltfComponentTypeToGlType(accessor.componentType),
+                    static_cast<GLboolean>(accessor.normalized ? GL_TRUE : GL_FALSE),
+                    static_cast<GLsizei>(bufferView.byteStride),
+                    accessor.byteOffset,
+                });
             }
 
             result._drawMode = gltfModeToGlMode(primitive.mode);
 
             return result;
         }
+
+        opengl::VertexData createVertexData(::tinygltf::Model const & model,
+                                            GltfBuffers const & buffers,
+                                            ::tinygltf::Mesh const & mesh,
+                                            ::tinygltf::Primitive const & primitive,
+                                            PositionDecode const & decode,
+                                            material::Program::Locations const & locations,
+                                            std::vector<std::byte> & elements,
+                                            std::vector<std::byte> & vertices)
+        {
+            // Elements
+
+            MINIRE_INVARIANT(primitive.indices >= 0, "indices are not specified: {}", mesh.name);
+            ::tinygltf::Accessor const & indices = getAccessor(static_cast<size_t>(primitive.indices), model);
+            MINIRE_INVARIANT(TINYGLTF_TYPE_SCALAR == indices.type,
+                             "indices are not scalar: {}, {}", indices.type, mesh.name);
+
+            AccessorBytes const indexBytes = getAccessorBytes(model, buffers, indices);
+            MINIRE_INVARIANT(indexBytes._stride == indexBytes._size,
+                             "indices are strided: {}", mesh.name);
+            elements.assign(indexBytes._bytes.begin(), indexBytes._bytes.end());
+
+            // Interleaved attributes
+
+            ::tinygltf::Accessor const & position = getAccessor(requireAttr(mesh, primitive, kPosition), model);
+            size_t const count = position.count;
+
+            using Attrib = opengl::VertexData::Attrib;
+            std::vector<Attrib> layout;
+            std::vector<AccessorBytes> sources;
+            size_t stride = 0;
+
+            using Attribs = std::initializer_list<std::tuple<std::string const &, int>>;
+            for(auto const & [accessorName, attribIndex] : Attribs {{kPosition, locations._vertexAttribute},
+                                                                    {kTexCoord0, locations._uvAttribute},
+                                                                    {kNormal, locations._normalAttribute},
+                                                                    {kTangent, locations._tangentAttribute}})
+            {
+                if (attribIndex == -1) continue;
+
+                ::tinygltf::Accessor const & accessor = getAccessor(requireAttr(mesh, primitive, accessorName), model);
+                MINIRE_INVARIANT(accessor.count == count,
+                                 "{} count mismatch: {} != {}, {}",
+                                 accessorName, accessor.count, count, mesh.name);
+
+                AccessorBytes const bytes = getAccessorBytes(model, buffers, accessor);
+                layout.push_back(Attrib{attribIndex,
+                                        ::tinygltf::GetNumComponentsInType(accessor.type),
+                                        gltfComponentTypeToGlType(accessor.componentType),
+                                        accessor.normalized ? 1u : 0u,
+                                        static_cast<uint32_t>(stride)});
+                sources.push_back(bytes);
+
+                // attributes are 4-byte aligned
+                stride += (bytes._size + 3) & ~size_t(3);
+            }
+
+            vertices.assign(count * stride, std::byte(0));
+            for(size_t a = 0; a < layout.size(); ++a)
+            {
+                AccessorBytes const & source = sources[a];
+                std::byte * target = vertices.data() + layout[a]._offset;
+                for(size_t v = 0; v < count; ++v)
+                {
+                    std::memcpy(target + v * stride,
+                                source._bytes.data() + v * source._stride,
+                                source._size);
+                }
+            }
+
+            return opengl::VertexData{
+                models::MeshFeatures(primitive.attributes.contains(kTexCoord0),
+                                     primitive.attributes.contains(kNormal),
+                                     primitive.attributes.contains(kTangent)),
+                locations,
+                gltfModeToGlMode(primitive.mode),
+                gltfComponentTypeToGlType(indices.componentType),
+                indices.count,
+                stride,
+                calcAabb(position, mesh.name, decode),
+                std::move(layout),
+                std::as_bytes(std::span(elements)),
+                std::as_bytes(std::span(vertices)),
+                quantized(position) ? decode._scale : glm::vec3(1.0f),
+                quantized(position) ? decode._offset : glm::vec3(0.0f),
+            };
+        }
     }
 
     // Publicly visible functions
 
     GltfMeshFeatures prefetchGltfFeatures(std::shared_ptr<::tinygltf::Model> const & model,
-                                         size_t const meshIndex, content::Manager & contentManager)
+                                          content::Id const & source, size_t const meshIndex,
+                                          content::Manager & contentManager)
     {
         assert(model);
 
@@ -508,7 +826,7 @@ namespace minire::utils
             if (hasMaterial && !result._materialModels[materialIndex])
             {
                 ::tinygltf::Material const & material = model->materials[materialIndex];
-                MaterialData materialData = createMaterialModel(model, material, contentManager);
+                MaterialData materialData = createMaterialModel(model, source, material, contentManager);
                 result._materialModels[materialIndex] = std::move(materialData._materialModel);
                 std::move(materialData._textureLeases.begin(),
                           materialData._textureLeases.end(),
@@ -520,10 +838,20 @@ namespace minire::utils
     }
 
     std::vector<opengl::VertexBuffer>
-    createVertexBuffers(::tinygltf::Model const & model,
+    createVertexBuffers(formats::GltfModelSptr const & gltf,
+                        content::Id const & source,
                         size_t const meshIndex,
-                        std::vector<material::Program::Locations> const & locationsForPrims)
+                        std::vector<material::Program::Locations> const & locationsForPrims,
+                        GltfVbos & vbos)
     {
+        MINIRE_INVARIANT(gltf, "gltf pointer is empty");
+        ::tinygltf::Model const & model = *gltf;
+        GltfBuffers const buffers = getBuffers(gltf);
+
+        // forget VBOs freed w/ their last primitives before looking them up
+
+        std::erase_if(vbos, [](auto const & item) { return item.second.expired(); });
+
         // fetch the mesh
 
         MINIRE_INVARIANT(meshIndex < model.meshes.size(),
@@ -535,20 +863,51 @@ namespace minire::utils
         std::vector<opengl::VertexBuffer> result;
         result.reserve(mesh.primitives.size());
         assert(locationsForPrims.size() == mesh.primitives.size());
+        PositionDecode const decode = positionDecode(model, meshIndex);
 
         // iterate primitives
 
         for(size_t primitiveIndex = 0; primitiveIndex < mesh.primitives.size(); ++primitiveIndex)
         {
             ::tinygltf::Primitive const & primitive = mesh.primitives[primitiveIndex];
-            material::Program::Locations const & locations = locationsForPrims[primitiveIndex];
-            result.emplace_back(createVertexBuffer(model, mesh, primitive,
-                                                   locations._vertexAttribute,
-                                                   locations._uvAttribute,
-                                                   locations._normalAttribute,
-                                                   locations._tangentAttribute));
+            result.emplace_back(createVertexBuffer(model, buffers, source, mesh, primitive, decode,
+                                                   locationsForPrims[primitiveIndex], vbos));
         }
 
         return result;
     }
+
+    opengl::MeshData
+    createVertexData(formats::GltfModelSptr const & gltf,
+                     size_t const meshIndex,
+                     std::vector<material::Program::Locations> const & locationsForPrims)
+    {
+        MINIRE_INVARIANT(gltf, "gltf pointer is empty");
+        ::tinygltf::Model const & model = *gltf;
+        GltfBuffers const buffers = getBuffers(gltf);
+
+        MINIRE_INVARIANT(meshIndex < model.meshes.size(),
+                         "mesh doesn't exist: {} >= {}", meshIndex, model.meshes.size());
+        ::tinygltf::Mesh const & mesh = model.meshes[meshIndex];
+        assert(locationsForPrims.size() == mesh.primitives.size());
+        PositionDecode const decode = positionDecode(model, meshIndex);
+
+        // elements and vertices of each primitive, spans refer them
+        using Storage = std::vector<std::vector<std::byte>>;
+        auto storage = std::make_shared<Storage>(mesh.primitives.size() * 2);
+
+        opengl::MeshData result;
+        result._primitives.reserve(mesh.primitives.size());
+        for(size_t primitiveIndex = 0; primitiveIndex < mesh.primitives.size(); ++primitiveIndex)
+        {
+            result._primitives.push_back(createVertexData(model, buffers, mesh,
+                                                          mesh.primitives[primitiveIndex],
+                                                          decode,
+                                                          locationsForPrims[primitiveIndex],
+                                                          (*storage)[primitiveIndex * 2],
+                                                          (*storage)[primitiveIndex * 2 + 1]));
+        }
+        result._storage = std::move(storage);
+        return result;
+    }
 }
@@ -1,16 +1,19 @@
 #pragma once
 
+#include <minire/content/manager.hpp>
 #include <minire/formats/gltf.hpp> // TODO: use forward declaration
 #include <minire/material.hpp>
 #include <minire/models/mesh-features.hpp>
+#include <minire/utils/std-pair-hash.hpp>
 #include <opengl/vertex-buffer.hpp>
+#include <opengl/vertex-data.hpp>
 
 #include <limits>
+#include <memory>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
-namespace minire::content { class Manager; }
-namespace minire::content { class Lease; }
-
 namespace minire::utils
 {
     struct GltfMeshFeatures
@@ -27,18 +30,38 @@ namespace minire::utils
 
         using Primitives = std::vector<Primitive>;
         using MaterialModels = std::vector<material::Model::Uptr>;
-        using Leases = std::vector<std::unique_ptr<content::Lease>>;
+        using Leases = std::vector<content::Lease>;
 
         MaterialModels _materialModels;
         Primitives     _primitives;
         Leases         _textureLeases;
     };
 
+    // images are uploaded into the Manager once per (source, image index)
     GltfMeshFeatures prefetchGltfFeatures(std::shared_ptr<::tinygltf::Model> const &,
-                                         size_t const meshIndex, content::Manager &);
+                                          content::Id const & source, size_t const meshIndex,
+                                          content::Manager &);
+
+    // GL buffers of bufferViews of glTF models by (source, bufferView index),
+    // each one is uploaded once and shared by VertexBuffers of all the
+    // primitives referring it, it's freed w/ the last of them and its
+    // entry is erased by the next createVertexBuffers
+    using GltfVbos = std::unordered_map<std::pair<content::Id, size_t>,
+                                        std::weak_ptr<opengl::VBO>>;
 
+    // primitives refer whole bufferViews w/ offsets and strides
+    // of their accessors, as they're authored
     std::vector<opengl::VertexBuffer>
-    createVertexBuffers(::tinygltf::Model const &,
+    createVertexBuffers(formats::GltfModelSptr const &,
+                        content::Id const & source,
                         size_t const meshIndex,
-                        std::vector<material::Program::Locations> const & locationsForPrims);
+                        std::vector<material::Program::Locations> const & locationsForPrims,
+                        GltfVbos &);
+
+    // Like createVertexBuffers but the attributes a program uses are
+    // interleaved into a vertex (i.e. to be cached, see MeshCache)
+    opengl::MeshData
+    createVertexData(formats::GltfModelSptr const &,
+                     size_t const meshIndex,
+                     std::vector<material::Program::Locations> const & locationsForPrims);
 }
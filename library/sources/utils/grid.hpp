@@ -76,6 +76,19 @@ namespace minire::utils
             return _store[i];
         }
 
+        // a row as a contiguous span of cols() elements
+        T const * row(size_t r) const
+        {
+            assert(r < _rows);
+            return _store.data() + r * _cols;
+        }
+
+        T * row(size_t r)
+        {
+            assert(r < _rows);
+            return _store.data() + r * _cols;
+        }
+
     public:
         size_t rows() const { return _rows; }
 
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace minire::utils
+{
+    // A non-cryptographic hash of bytes which is stable between runs
+    // (unlike std::hash), it digests a word at a time to hash whole
+    // files in about the time it takes to read them
+    inline uint64_t hashBytes(std::span<std::byte const> bytes,
+                              uint64_t seed = 0)
+    {
+        constexpr uint64_t kMultiplier = 0x9E3779B97F4A7C15ull;
+
+        uint64_t result = seed ^ (bytes.size() * kMultiplier);
+        auto const mix = [&result](uint64_t word)
+        {
+            result = (result ^ word) * kMultiplier;
+            result ^= result >> 29;
+        };
+
+        size_t i = 0;
+        for(; i + sizeof(uint64_t) <= bytes.size(); i += sizeof(uint64_t))
+        {
+            uint64_t word;
+            std::memcpy(&word, bytes.data() + i, sizeof(word));
+            mix(word);
+        }
+
+        if (i < bytes.size())
+        {
+            uint64_t tail = 0;
+            std::memcpy(&tail, bytes.data() + i, bytes.size() - i);
+            mix(tail);
+        }
+
+        return result ^ (result >> 32);
+    }
+}
@@ -0,0 +1,83 @@
+#include <utils/mapped-file.hpp>
+
+#include <minire/errors.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace minire::utils
+{
+    MappedFile::MappedFile(std::string const & filename)
+    {
+        int const fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+        if (-1 == fd)
+        {
+            MINIRE_THROW("cannot open: \"{}\": {}", filename, ::strerror(errno));
+        }
+
+        struct stat st;
+        if (-1 == ::fstat(fd, &st))
+        {
+            int const error = errno;
+            ::close(fd);
+            MINIRE_THROW("cannot stat: \"{}\": {}", filename, ::strerror(error));
+        }
+
+        _size = static_cast<size_t>(st.st_size);
+        if (0 == _size)
+        {
+            // mmap() fails on empty files, and there is nothing to map anyway
+            ::close(fd);
+            return;
+        }
+
+        void * data = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        int const error = errno;
+        ::close(fd); // the mapping keeps the file referenced
+        if (MAP_FAILED == data)
+        {
+            MINIRE_THROW("cannot mmap: \"{}\": {}", filename, ::strerror(error));
+        }
+
+        // parsers read it front to back
+        ::madvise(data, _size, MADV_SEQUENTIAL);
+        _data = static_cast<char const *>(data);
+    }
+
+    MappedFile::MappedFile(MappedFile && other) noexcept
+        : _data(std::exchange(other._data, nullptr))
+        , _size(std::exchange(other._size, 0))
+    {}
+
+    MappedFile & MappedFile::operator=(MappedFile && other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            _data = std::exchange(other._data, nullptr);
+            _size = std::exchange(other._size, 0);
+        }
+        return *this;
+    }
+
+    MappedFile::~MappedFile()
+    {
+        reset();
+    }
+
+    void MappedFile::reset() noexcept
+    {
+        if (_data)
+        {
+            ::munmap(const_cast<char *>(_data), _size);
+        }
+        _data = nullptr;
+        _size = 0;
+    }
+}
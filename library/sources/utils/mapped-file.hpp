@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace minire::utils
+{
+    // A read-only memory mapping of a whole file (POSIX only)
+    class MappedFile
+    {
+        MappedFile(MappedFile const &) = delete;
+        MappedFile & operator=(MappedFile const &) = delete;
+
+    public:
+        explicit MappedFile(std::string const & filename);
+
+        MappedFile(MappedFile &&) noexcept;
+
+        MappedFile & operator=(MappedFile &&) noexcept;
+
+        ~MappedFile();
+
+    public:
+        char const * data() const { return _data; }
+
+        size_t size() const { return _size; }
+
+        std::string_view view() const { return std::string_view(_data, _size); }
+
+        std::span<std::byte const> bytes() const
+        {
+            return std::span(reinterpret_cast<std::byte const *>(_data), _size);
+        }
+
+    private:
+        void reset() noexcept;
+
+    private:
+        char const * _data = nullptr;
+        size_t       _size = 0;
+    };
+}
@@ -0,0 +1,422 @@
+#include <utils/mesh-optimizer.hpp>
+
+#include <minire/errors.hpp>
+#include <minire/logging.hpp>
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <numeric>
+
+namespace minire::utils
+{
+    namespace
+    {
+        // ACMR of a cluster may be worse than one of the mesh by 5%
+        constexpr float kOverdrawThreshold = 1.05f;
+
+        constexpr uint32_t kUnused = std::numeric_limits<uint32_t>::max();
+
+        // a FIFO cache of vertices, vertices are cached at "times" of their misses
+        class VertexCache
+        {
+        public:
+            VertexCache(size_t vertices, size_t size)
+                : _times(vertices, 0)
+                , _size(size)
+                , _time(size + 1)
+            {}
+
+            // returns true on a miss
+            bool use(uint32_t vertex)
+            {
+                if (contains(vertex)) return false;
+                _times[vertex] = _time++;
+                return true;
+            }
+
+            bool contains(uint32_t vertex) const { return _time - _times[vertex] <= _size; }
+
+            // time since the vertex is cached
+            size_t age(uint32_t vertex) const { return _time - _times[vertex]; }
+
+            // evicts everything
+            void reset() { _time += _size + 1; }
+
+        private:
+            std::vector<size_t> _times;
+            size_t const        _size;
+            size_t              _time;
+        };
+
+        std::vector<uint32_t> readElements(opengl::VertexData const & primitive)
+        {
+            std::vector<uint32_t> result(primitive._elementsCount);
+            auto const read = [&primitive, &result]<typename T>(T)
+            {
+                MINIRE_INVARIANT(primitive._elements.size() >= result.size() * sizeof(T),
+                                 "elements are out of the buffer: {} < {}",
+                                 primitive._elements.size(), result.size() * sizeof(T));
+                for(size_t i = 0; i < result.size(); ++i)
+                {
+                    T value;
+                    std::memcpy(&value, primitive._elements.data() + i * sizeof(T), sizeof(T));
+                    result[i] = value;
+                }
+            };
+
+            switch(primitive._elementsType)
+            {
+                case GL_UNSIGNED_BYTE:  read(uint8_t()); break;
+                case GL_UNSIGNED_SHORT: read(uint16_t()); break;
+                case GL_UNSIGNED_INT:   read(uint32_t()); break;
+                default: MINIRE_THROW("unsupported elements type: {}", primitive._elementsType);
+            }
+            return result;
+        }
+
+        template<typename T>
+        void writeElements(std::vector<uint32_t> const & indices, std::vector<std::byte> & out)
+        {
+            out.resize(indices.size() * sizeof(T));
+            for(size_t i = 0; i < indices.size(); ++i)
+            {
+                T const value = static_cast<T>(indices[i]);
+                std::memcpy(out.data() + i * sizeof(T), &value, sizeof(T));
+            }
+        }
+
+        opengl::VertexData optimize(opengl::VertexData const & primitive,
+                                    std::vector<std::byte> & elements,
+                                    std::vector<std::byte> & vertices)
+        {
+            size_t const count = primitive.vertices();
+            std::vector<uint32_t> indices = readElements(primitive);
+            for(uint32_t const index : indices)
+            {
+                MINIRE_INVARIANT(index < count, "bad element: {} >= {}", index, count);
+            }
+
+            // Triangles: vertex cache and overdraw
+
+            if (GL_TRIANGLES == primitive._drawMode && 0 == indices.size() % 3 && !indices.empty())
+            {
+                VertexCacheStats const before = vertexCacheStats(indices);
+
+                std::vector<glm::vec3> positions(count);
+                for(size_t v = 0; v < count; ++v) positions[v] = primitive.position(v);
+
+                std::vector<size_t> clusters;
+                indices = tipsify(indices, count, kVertexCacheSize, clusters);
+                indices = orderClusters(indices, clusters, positions, kVertexCacheSize, kOverdrawThreshold);
+
+                VertexCacheStats const after = vertexCacheStats(indices);
+                MINIRE_DEBUG("optimized {} triangles: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+                             indices.size() / 3, before._acmr, after._acmr, before._atvr, after._atvr);
+            }
+
+            // Vertex fetch: vertices in the order of the first use
+
+            std::vector<uint32_t> remap(count, kUnused);
+            uint32_t used = 0;
+            for(uint32_t & index : indices)
+            {
+                if (kUnused == remap[index]) remap[index] = used++;
+                index = remap[index];
+            }
+
+            vertices.resize(used * primitive._stride);
+            for(size_t v = 0; v < count; ++v)
+            {
+                if (kUnused == remap[v]) continue;
+                std::memcpy(vertices.data() + remap[v] * primitive._stride,
+                            primitive._vertices.data() + v * primitive._stride,
+                            primitive._stride);
+            }
+
+            // Elements: 16-bit ones while they can address all the vertices
+
+            bool const narrow = used <= std::numeric_limits<uint16_t>::max() + size_t(1);
+            if (narrow)
+            {
+                writeElements<uint16_t>(indices, elements);
+            }
+            else
+            {
+                writeElements<uint32_t>(indices, elements);
+            }
+
+            opengl::VertexData result = primitive;
+            result._elementsType = narrow ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+            result._elements = std::as_bytes(std::span(elements));
+            result._vertices = std::as_bytes(std::span(vertices));
+            return result;
+        }
+    }
+
+    VertexCacheStats vertexCacheStats(std::span<uint32_t const> indices, size_t cacheSize)
+    {
+        if (indices.empty()) return {};
+
+        size_t const vertices = *std::max_element(indices.begin(), indices.end()) + size_t(1);
+        VertexCache cache(vertices, cacheSize);
+        std::vector<bool> referred(vertices, false);
+
+        size_t misses = 0;
+        size_t unique = 0;
+        for(uint32_t const index : indices)
+        {
+            misses += cache.use(index) ? 1 : 0;
+            if (!referred[index])
+            {
+                referred[index] = true;
+                ++unique;
+            }
+        }
+
+        return VertexCacheStats
+        {
+            ._acmr = static_cast<double>(misses) / static_cast<double>(indices.size() / 3),
+            ._atvr = static_cast<double>(misses) / static_cast<double>(unique),
+        };
+    }
+
+    std::vector<uint32_t> tipsify(std::span<uint32_t const> indices,
+                                  size_t vertices,
+                                  size_t cacheSize,
+                                  std::vector<size_t> & clusters)
+    {
+        assert(0 == indices.size() % 3);
+        size_t const triangles = indices.size() / 3;
+
+        // triangles of vertices, and counts of ones which aren't emitted yet
+        std::vector<uint32_t> live(vertices, 0);
+        for(uint32_t const index : indices) ++live[index];
+
+        std::vector<size_t> offsets(vertices + 1, 0);
+        std::partial_sum(live.cbegin(), live.cend(), offsets.begin() + 1);
+
+        std::vector<uint32_t> adjacency(indices.size());
+        {
+            std::vector<size_t> cursors(offsets.cbegin(), offsets.cend() - 1);
+            for(size_t i = 0; i < indices.size(); ++i)
+            {
+                adjacency[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        VertexCache cache(vertices, cacheSize);
+        std::vector<bool> emitted(triangles, false);
+        std::vector<uint32_t> deadEnds; // recently used vertices, a stack
+        std::vector<uint32_t> candidates;
+        size_t cursor = 0;              // vertices before it have no live triangles
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+        clusters.assign(1, 0);
+
+        // a vertex w/ live triangles, the most recent dead end first
+        auto const skipDeadEnd = [&]() -> int64_t
+        {
+            while (!deadEnds.empty())
+            {
+                uint32_t const vertex = deadEnds.back();
+                deadEnds.pop_back();
+                if (live[vertex] > 0) return vertex;
+            }
+
+            for(; cursor < vertices; ++cursor)
+            {
+                if (live[cursor] > 0) return cursor;
+            }
+            return -1;
+        };
+
+        int64_t fanning = skipDeadEnd();
+        while (fanning >= 0)
+        {
+            // emit all the live triangles of the fanning vertex
+
+            candidates.clear();
+            for(size_t a = offsets[fanning]; a < offsets[fanning + 1]; ++a)
+            {
+                uint32_t const triangle = adjacency[a];
+                if (emitted[triangle]) continue;
+
+                for(size_t k = 0; k < 3; ++k)
+                {
+                    uint32_t const vertex = indices[triangle * 3 + k];
+                    result.push_back(vertex);
+                    deadEnds.push_back(vertex);
+                    candidates.push_back(vertex);
+                    --live[vertex];
+                    cache.use(vertex);
+                }
+                emitted[triangle] = true;
+            }
+
+            // the next one is a candidate which stays in the cache after
+            // its triangles are emitted, the oldest one of them; if none
+            // fits, it's a dead end
+
+            int64_t next = -1;
+            size_t priority = 0;
+            for(uint32_t const vertex : candidates)
+            {
+                if (0 == live[vertex]) continue;
+
+                size_t const age = cache.age(vertex);
+                size_t const fits = age + 2 * live[vertex] <= cacheSize ? age : 0;
+                if (fits > priority)
+                {
+                    next = vertex;
+                    priority = fits;
+                }
+            }
+
+            if (-1 == next)
+            {
+                next = skipDeadEnd();
+                if (next >= 0 && !cache.contains(static_cast<uint32_t>(next)))
+                {
+                    clusters.push_back(result.size() / 3);
+                }
+            }
+
+            fanning = next;
+        }
+
+        assert(result.size() == indices.size());
+        return result;
+    }
+
+    std::vector<uint32_t> orderClusters(std::span<uint32_t const> indices,
+                                        std::vector<size_t> const & clusters,
+                                        std::span<glm::vec3 const> positions,
+                                        size_t cacheSize,
+                                        float threshold)
+    {
+        assert(0 == indices.size() % 3);
+        size_t const triangles = indices.size() / 3;
+        if (0 == triangles) return {};
+
+        // Soft boundaries: a cluster is split once its ACMR is good enough
+
+        double const limit = vertexCacheStats(indices, cacheSize)._acmr * threshold;
+        VertexCache cache(positions.size(), cacheSize);
+
+        std::vector<size_t> starts;
+        for(size_t c = 0; c < clusters.size(); ++c)
+        {
+            size_t const end = c + 1 < clusters.size() ? clusters[c + 1] : triangles;
+
+            size_t start = clusters[c];
+            size_t misses = 0;
+            cache.reset();
+            starts.push_back(start);
+            for(size_t t = start; t < end; ++t)
+            {
+                for(size_t k = 0; k < 3; ++k)
+                {
+                    misses += cache.use(indices[t * 3 + k]) ? 1 : 0;
+                }
+
+                double const acmr = static_cast<double>(misses) / static_cast<double>(t + 1 - start);
+                if (t + 1 < end && acmr <= limit)
+                {
+                    start = t + 1;
+                    misses = 0;
+                    cache.reset();
+                    starts.push_back(start);
+                }
+            }
+        }
+
+        // Sort clusters by how much they face outwards
+
+        struct Cluster
+        {
+            size_t    _begin;
+            size_t    _end;
+            glm::vec3 _centroid = glm::vec3(0.0f); // weighted by areas
+            glm::vec3 _normal = glm::vec3(0.0f);
+            float     _area = 0.0f;
+            float     _key = 0.0f;
+        };
+
+        std::vector<Cluster> ordered;
+        ordered.reserve(starts.size());
+
+        glm::vec3 meshCentroid(0.0f);
+        float meshArea = 0.0f;
+        for(size_t s = 0; s < starts.size(); ++s)
+        {
+            Cluster cluster{starts[s], s + 1 < starts.size() ? starts[s + 1] : triangles};
+            for(size_t t = cluster._begin; t < cluster._end; ++t)
+            {
+                glm::vec3 const & a = positions[indices[t * 3]];
+                glm::vec3 const & b = positions[indices[t * 3 + 1]];
+                glm::vec3 const & c = positions[indices[t * 3 + 2]];
+
+                glm::vec3 const normal = glm::cross(b - a, c - a); // 2x area long
+                float const area = glm::length(normal);
+
+                cluster._centroid += (a + b + c) * (area / 3.0f);
+                cluster._normal += normal;
+                cluster._area += area;
+            }
+
+            meshCentroid += cluster._centroid;
+            meshArea += cluster._area;
+            if (cluster._area > 0.0f) cluster._centroid /= cluster._area;
+            ordered.push_back(cluster);
+        }
+
+        if (meshArea > 0.0f) meshCentroid /= meshArea;
+
+        for(Cluster & cluster : ordered)
+        {
+            float const length = glm::length(cluster._normal);
+            cluster._key = length > 0.0f ? glm::dot(cluster._centroid - meshCentroid, cluster._normal / length)
+                                         : 0.0f;
+        }
+
+        std::stable_sort(ordered.begin(), ordered.end(),
+                         [](Cluster const & a, Cluster const & b)
+                         {
+                             return a._key > b._key;
+                         });
+
+        std::vector<uint32_t> result;
+        result.reserve(indices.size());
+        for(Cluster const & cluster : ordered)
+        {
+            result.insert(result.end(),
+                          indices.begin() + cluster._begin * 3,
+                          indices.begin() + cluster._end * 3);
+        }
+        return result;
+    }
+
+    opengl::MeshData optimize(opengl::MeshData const & data)
+    {
+        // elements and vertices of each primitive, spans refer them
+        using Storage = std::vector<std::vector<std::byte>>;
+        auto storage = std::make_shared<Storage>(data._primitives.size() * 2);
+
+        opengl::MeshData result;
+        result._primitives.reserve(data._primitives.size());
+        for(size_t i = 0; i < data._primitives.size(); ++i)
+        {
+            result._primitives.push_back(optimize(data._primitives[i],
+                                                  (*storage)[i * 2],
+                                                  (*storage)[i * 2 + 1]));
+        }
+        result._storage = std::move(storage);
+        return result;
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <opengl/vertex-data.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace minire::utils
+{
+    // of a post-transform cache the optimizer targets, it's a FIFO one
+    constexpr size_t kVertexCacheSize = 16;
+
+    struct VertexCacheStats
+    {
+        double _acmr = 0.0; // transformed vertices per triangle
+        double _atvr = 0.0; // transformed vertices per referred vertex
+    };
+
+    // of triangles (i.e. GL_TRIANGLES elements) w/ a FIFO cache
+    VertexCacheStats vertexCacheStats(std::span<uint32_t const> indices,
+                                      size_t cacheSize = kVertexCacheSize);
+
+    // Tipsify (Sander et al. 2007) order of triangles, clusters are
+    // offsets of triangles the order breaks its locality at (i.e. it
+    // starts from a vertex out of the cache), the first one is zero
+    std::vector<uint32_t> tipsify(std::span<uint32_t const> indices,
+                                  size_t vertices,
+                                  size_t cacheSize,
+                                  std::vector<size_t> & clusters);
+
+    // Clusters of tipsified triangles split further while they don't
+    // worsen ACMR more than by the threshold, and ordered from outward
+    // facing ones to inward facing ones, the outer ones occlude more
+    std::vector<uint32_t> orderClusters(std::span<uint32_t const> indices,
+                                        std::vector<size_t> const & clusters,
+                                        std::span<glm::vec3 const> positions,
+                                        size_t cacheSize,
+                                        float threshold);
+
+    // Primitives w/ triangles in the order of tipsify() and
+    // orderClusters(), vertices in the order of the first use (w/o
+    // unused ones), and 16-bit elements if there are few vertices.
+    // Primitives of other modes are only reindexed
+    opengl::MeshData optimize(opengl::MeshData const &);
+}
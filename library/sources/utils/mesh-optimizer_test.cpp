@@ -0,0 +1,150 @@
+#include <utils/mesh-optimizer.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Reports ACMR and ATVR of meshes before and after the optimizer,
+// fails if the optimizer makes them worse
+
+namespace
+{
+    using namespace minire;
+
+    struct Mesh
+    {
+        std::string            _name;
+        std::vector<float>     _vertices; // x, y, z
+        std::vector<uint32_t>  _indices;
+    };
+
+    // a sphere of rows x columns quads, triangles of a row go one by one
+    Mesh sphere(size_t rows, size_t columns)
+    {
+        Mesh result{"sphere, row by row", {}, {}};
+        for(size_t r = 0; r <= rows; ++r)
+        {
+            float const theta = 3.14159265f * r / rows;
+            for(size_t c = 0; c <= columns; ++c)
+            {
+                float const phi = 2.0f * 3.14159265f * c / columns;
+                result._vertices.push_back(std::sin(theta) * std::cos(phi));
+                result._vertices.push_back(std::cos(theta));
+                result._vertices.push_back(std::sin(theta) * std::sin(phi));
+            }
+        }
+
+        for(uint32_t r = 0; r < rows; ++r)
+        {
+            for(uint32_t c = 0; c < columns; ++c)
+            {
+                uint32_t const a = r * (columns + 1) + c;
+                uint32_t const b = a + columns + 1;
+                result._indices.insert(result._indices.end(), {a, b, a + 1, a + 1, b, b + 1});
+            }
+        }
+        return result;
+    }
+
+    Mesh shuffled(Mesh mesh)
+    {
+        std::vector<size_t> order(mesh._indices.size() / 3);
+        for(size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::shuffle(order.begin(), order.end(), std::mt19937(42));
+
+        std::vector<uint32_t> indices;
+        for(size_t const triangle : order)
+        {
+            indices.insert(indices.end(),
+                           mesh._indices.begin() + triangle * 3,
+                           mesh._indices.begin() + triangle * 3 + 3);
+        }
+
+        mesh._name = "sphere, shuffled";
+        mesh._indices = std::move(indices);
+        return mesh;
+    }
+
+    opengl::VertexData vertexData(Mesh const & mesh)
+    {
+        using Attrib = opengl::VertexData::Attrib;
+        return opengl::VertexData{
+            models::MeshFeatures(false, true, false),
+            {0, -1, 1, -1},
+            GL_TRIANGLES,
+            GL_UNSIGNED_INT,
+            mesh._indices.size(),
+            3 * sizeof(float),
+            utils::Aabb(),
+            {Attrib{0, 3, GL_FLOAT, GL_FALSE, 0}},
+            std::as_bytes(std::span(mesh._indices)),
+            std::as_bytes(std::span(mesh._vertices)),
+        };
+    }
+
+    std::vector<uint32_t> elements(opengl::VertexData const & primitive)
+    {
+        std::vector<uint32_t> result(primitive._elementsCount);
+        for(size_t i = 0; i < result.size(); ++i)
+        {
+            uint16_t value;
+            assert(GL_UNSIGNED_SHORT == primitive._elementsType);
+            std::memcpy(&value, primitive._elements.data() + i * sizeof(value), sizeof(value));
+            result[i] = value;
+        }
+        return result;
+    }
+
+    bool benchmark(Mesh const & mesh)
+    {
+        opengl::MeshData data;
+        data._primitives.push_back(vertexData(mesh));
+
+        auto const start = std::chrono::steady_clock::now();
+        opengl::MeshData const optimized = utils::optimize(data);
+        auto const time = std::chrono::steady_clock::now() - start;
+
+        opengl::VertexData const & primitive = optimized._primitives.front();
+        std::vector<uint32_t> const indices = elements(primitive);
+
+        utils::VertexCacheStats const before = utils::vertexCacheStats(mesh._indices);
+        utils::VertexCacheStats const after = utils::vertexCacheStats(indices);
+
+        std::cout << mesh._name << ": " << mesh._indices.size() / 3 << " triangles, "
+                  << std::chrono::duration<double, std::milli>(time).count() << " ms\n"
+                  << "  ACMR " << before._acmr << " -> " << after._acmr << "\n"
+                  << "  ATVR " << before._atvr << " -> " << after._atvr << std::endl;
+
+        // vertices are in the order of the first use
+        uint32_t next = 0;
+        for(uint32_t const index : indices)
+        {
+            if (index > next) return false;
+            if (index == next) ++next;
+        }
+
+        return indices.size() == mesh._indices.size()
+            && primitive.vertices() == mesh._vertices.size() / 3
+            && after._acmr <= before._acmr
+            && after._atvr <= before._atvr;
+    }
+}
+
+int main()
+{
+    Mesh const ordered = sphere(64, 128);
+
+    bool ok = true;
+    ok = benchmark(ordered) && ok;
+    ok = benchmark(shuffled(ordered)) && ok;
+
+    std::cout << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,151 +1,293 @@
 #include <utils/obj-interpreters.hpp>
 
+#include <minire/errors.hpp>
 #include <minire/formats/obj.hpp>
 #include <minire/logging.hpp>
-#include <utils/raii-malloc.hpp>
 
-#include <boost/container_hash/hash.hpp> // for hash
+#include <formats/obj-parser.hpp>
+#include <utils/aabb-reduction.hpp>
 
-#include <unordered_map>
+#include <algorithm>
+#include <bit>
 #include <cassert>
-#include <tuple>
+#include <iterator>
+#include <utility>
 
 namespace minire::utils
 {
     namespace
     {
-        using FaceKey = std::tuple<uint32_t, uint32_t, uint32_t>;
+        // indices of items of a face's point, zeros for missing ones
+        struct CornerKey
+        {
+            uint32_t _vertex;
+            uint32_t _uv;
+            uint32_t _normal;
+
+            bool operator==(CornerKey const &) const = default;
+        };
 
-        struct FaceKeyHash
+        // Indices of distinct corners: a flat open addressing table w/
+        // linear probing, sized for the expected number of them
+        class CornerTable
         {
-            size_t operator()(FaceKey const & k) const
+            static constexpr uint32_t kEmpty = ~0u;
+
+            struct Slot
             {
-                size_t result = 0x825734fB40AEC515ULL;
-                boost::hash_combine(result, std::hash<uint32_t>{}(std::get<0>(k)));
-                boost::hash_combine(result, std::hash<uint32_t>{}(std::get<1>(k)));
-                boost::hash_combine(result, std::hash<uint32_t>{}(std::get<2>(k)));
-                return result;
+                CornerKey _key{};
+                uint32_t  _index = kEmpty;
+            };
+
+        public:
+            explicit CornerTable(size_t corners)
+                : _slots(std::bit_ceil(std::max<size_t>(16, corners * 2)))
+            {}
+
+        public:
+            // the index of the corner, a new one is the next one
+            std::pair<uint32_t, bool> insert(CornerKey const & key)
+            {
+                if ((_size + 1) * 2 > _slots.size()) grow();
+
+                size_t const mask = _slots.size() - 1;
+                for(size_t i = hash(key) & mask; ; i = (i + 1) & mask)
+                {
+                    Slot & slot = _slots[i];
+                    if (kEmpty == slot._index)
+                    {
+                        slot = Slot{key, static_cast<uint32_t>(_size++)};
+                        return {slot._index, true};
+                    }
+                    if (slot._key == key) return {slot._index, false};
+                }
             }
+
+            size_t size() const { return _size; }
+
+        private:
+            static size_t hash(CornerKey const & key)
+            {
+                uint64_t h = key._vertex * 0x9E3779B97F4A7C15ULL
+                           ^ key._uv * 0xC2B2AE3D27D4EB4FULL
+                           ^ key._normal * 0x165667B19E3779F9ULL;
+                h ^= h >> 32;
+                return static_cast<size_t>(h);
+            }
+
+            void grow()
+            {
+                std::vector<Slot> slots(_slots.size() * 2);
+                std::swap(slots, _slots);
+
+                size_t const mask = _slots.size() - 1;
+                for(Slot const & slot : slots)
+                {
+                    if (kEmpty == slot._index) continue;
+
+                    size_t i = hash(slot._key) & mask;
+                    while (kEmpty != _slots[i]._index) i = (i + 1) & mask;
+                    _slots[i] = slot;
+                }
+            }
+
+        private:
+            std::vector<Slot> _slots;
+            size_t            _size = 0;
         };
 
-        size_t strideOf(formats::Obj const & mesh)
+        size_t strideOf(models::MeshFeatures const & features)
         {
             size_t result = 3;
-            if (mesh.haveUvs()) result += 2;
-            if (mesh.haveNormals()) result += 3;
+            if (features.hasUv()) result += 2;
+            if (features.hasNormal()) result += 3;
             return result;
         }
-    }
-
-    models::MeshFeatures getMeshFeatures(formats::Obj const & obj)
-    {
-        return models::MeshFeatures(obj.haveUvs(), obj.haveNormals(), false);
-    }
-
-    opengl::VertexBuffer createVertexBuffer(formats::Obj const & mesh,
-                                            int vtxAttribIndex,
-                                            int uvAttribIndx,
-                                            int normAttrib)
-    {
-        Aabb aabb;
-        size_t const stride = strideOf(mesh);
-        RaiiMalloc<uint32_t> elements(mesh._faceVertices.size());
-
-        std::unordered_map<FaceKey, uint32_t, FaceKeyHash> allocCache;
 
         // attribute structure: (x, y, z) [u, v] [nx, ny, nz]
-        std::vector<float> attribs;
-        attribs.reserve(stride * mesh._vertices.size());
-
-        // prepare buffers
-        size_t hits = 0;
-        for(size_t i(0); i < elements.size(); ++i)
+        class VertexBuilder
         {
-            FaceKey faceKey(mesh._faceVertices[i],
-                            mesh.haveUvs() ? mesh._faceUvs[i] : 0,
-                            mesh.haveNormals() ? mesh._faceNormals[i] : 0);
-            auto const it = allocCache.find(faceKey);
-            if (it != allocCache.cend())
+        public:
+            // corners of faces and the expected number of distinct ones
+            VertexBuilder(size_t corners, size_t distinct)
+                : _table(distinct)
             {
-                elements[i] = it->second;
-                ++hits;
-                continue;
+                _elements.reserve(corners);
             }
 
-            {
-                glm::vec3 const & vertex = mesh._vertices[std::get<0>(faceKey)];
-                attribs.push_back(vertex.x);
-                attribs.push_back(vertex.y);
-                attribs.push_back(vertex.z);
-                aabb.extend(vertex);
-            }
+        public:
+            void reserve(size_t floats) { _attribs.reserve(floats); }
 
-            if (mesh.haveUvs())
+            // attributes of a new corner are pushed by emit
+            template<typename Emit>
+            void add(CornerKey const & key, Emit const & emit)
             {
-                glm::vec2 const & uv = mesh._uvs[std::get<1>(faceKey)];
-                attribs.push_back(uv.x);
-                attribs.push_back(uv.y);
+                auto const [index, inserted] = _table.insert(key);
+                if (inserted) emit(_attribs);
+                _elements.push_back(index);
             }
 
-            if (mesh.haveNormals())
+            opengl::MeshData build(models::MeshFeatures const & features,
+                                   material::Program::Locations const & locations) &&
             {
-                glm::vec3 const & normal = mesh._normals[std::get<2>(faceKey)];
-                attribs.push_back(normal.x);
-                attribs.push_back(normal.y);
-                attribs.push_back(normal.z);
+                size_t const stride = strideOf(features);
+                MINIRE_INVARIANT(_attribs.size() == _table.size() * stride,
+                                 "attributes of {} vertices don't match their stride", _table.size());
+
+                MINIRE_DEBUG("OBJ to VertexBuffer cache hit rate: {}%",
+                             _elements.empty() ? 0.0f
+                                               : static_cast<float>(_elements.size() - _table.size()) /
+                                                 static_cast<float>(_elements.size()) * 100.0f);
+
+                using Attrib = opengl::VertexData::Attrib;
+                std::vector<Attrib> layout;
+                uint32_t pointer = 0;
+
+                layout.push_back(Attrib{locations._vertexAttribute, 3, GL_FLOAT, GL_FALSE, pointer});
+                pointer += (3 * sizeof(float));
+
+                if (features.hasUv())
+                {
+                    layout.push_back(Attrib{locations._uvAttribute, 2, GL_FLOAT, GL_FALSE, pointer});
+                    pointer += (2 * sizeof(float));
+                }
+
+                if (features.hasNormal())
+                {
+                    layout.push_back(Attrib{locations._normalAttribute, 3, GL_FLOAT, GL_FALSE, pointer});
+                    pointer += (3 * sizeof(float));
+                }
+                assert(pointer == stride * sizeof(float));
+
+                // the spans refer the vectors, which are kept by the result
+                auto storage = std::make_shared<std::pair<std::vector<uint32_t>,
+                                                          std::vector<float>>>(std::move(_elements),
+                                                                               std::move(_attribs));
+                auto const vertices = std::as_bytes(std::span(storage->second));
+
+                opengl::MeshData result;
+                result._primitives.push_back(opengl::VertexData{
+                    features,
+                    locations,
+                    GL_TRIANGLES,
+                    GL_UNSIGNED_INT,
+                    storage->first.size(),
+                    stride * sizeof(float),
+                    reduceAabb(vertices, stride * sizeof(float)),
+                    std::move(layout),
+                    std::as_bytes(std::span(storage->first)),
+                    vertices,
+                });
+                result._storage = std::move(storage);
+                return result;
             }
 
-            assert(0 == (attribs.size() % stride));
-            uint32_t const index = (attribs.size() / stride) - 1;
-            elements[i] = index;
-            allocCache.emplace(faceKey, index);
-        }
+        private:
+            CornerTable           _table;
+            std::vector<uint32_t> _elements;
+            std::vector<float>    _attribs;
+        };
 
-        MINIRE_DEBUG("OBJ to VertexBuffer cache hit rate: {}%",
-                     static_cast<float>(hits) / static_cast<float>(elements.size()) * 100.0f);
+        void emit(std::vector<float> & attribs, glm::vec3 const & v)
+        {
+            attribs.insert(attribs.end(), {v.x, v.y, v.z});
+        }
 
-        // Create the  buffers
-        opengl::VertexBuffer result;
-        result._elementsCount = elements.size();
-        result._aabb = aabb;
-        result._drawMode = GL_TRIANGLES;
-        result._elementsType = GL_UNSIGNED_INT;
+        void emit(std::vector<float> & attribs, glm::vec2 const & v)
+        {
+            attribs.insert(attribs.end(), {v.x, v.y});
+        }
 
-        // load EBO and VBO
-        opengl::VBO & ebo = result.createVbo(0, GL_ELEMENT_ARRAY_BUFFER);
-        ebo.bufferData(elements.bytesCount(), elements.bytesPointer(), GL_STATIC_DRAW);
+        // an item of chunks by its index in the whole text
+        template<typename Item>
+        Item const & itemOf(std::vector<formats::ObjChunk> const & chunks,
+                            std::vector<Item> formats::ObjChunk::* items,
+                            size_t formats::ObjCounts::* before,
+                            size_t index)
+        {
+            // the last chunk which items start at the index or before it
+            auto const it = std::upper_bound(chunks.cbegin(), chunks.cend(), index,
+                                             [before](size_t i, formats::ObjChunk const & chunk)
+                                             {
+                                                 return i < chunk._before.*before;
+                                             });
+            assert(it != chunks.cbegin());
+            formats::ObjChunk const & chunk = *std::prev(it);
+            return (chunk.*items)[index - chunk._before.*before];
+        }
+    }
 
-        opengl::VBO & vbo = result.createVbo(1, GL_ARRAY_BUFFER);
-        vbo.bufferData(attribs.size() * sizeof(float), attribs.data(), GL_STATIC_DRAW);
+    models::MeshFeatures getMeshFeatures(formats::Obj const & obj)
+    {
+        return models::MeshFeatures(obj.haveUvs(), obj.haveNormals(), false);
+    }
 
-        size_t pointer = 0;
-        size_t const bstride = stride * sizeof(float);
+    opengl::MeshData createVertexData(formats::Obj const & mesh,
+                                      material::Program::Locations const & locations)
+    {
+        models::MeshFeatures const features = getMeshFeatures(mesh);
+        size_t const corners = mesh._faceVertices.size();
 
-        // setup VAO
-        result._vao->enableAttrib(vtxAttribIndex);
-        result._vao->attribPointer(vtxAttribIndex, 3, GL_FLOAT, GL_FALSE, bstride, pointer);
-        pointer += (3 * sizeof(float));
+        // there are no more distinct corners than corners
+        VertexBuilder builder(corners, corners);
+        builder.reserve(strideOf(features) * mesh._vertices.size());
 
-        if (mesh.haveUvs())
+        for(size_t i(0); i < corners; ++i)
         {
-            if (uvAttribIndx != -1)
+            CornerKey const key
             {
-                result._vao->enableAttrib(uvAttribIndx);
-                result._vao->attribPointer(uvAttribIndx, 2, GL_FLOAT, GL_FALSE, bstride, pointer);
-            }
-            pointer += (2 * sizeof(float));
+                mesh._faceVertices[i],
+                mesh.haveUvs() ? mesh._faceUvs[i] : 0,
+                mesh.haveNormals() ? mesh._faceNormals[i] : 0,
+            };
+
+            builder.add(key, [&mesh, &key](std::vector<float> & attribs)
+            {
+                emit(attribs, mesh._vertices[key._vertex]);
+                if (mesh.haveUvs()) emit(attribs, mesh._uvs[key._uv]);
+                if (mesh.haveNormals()) emit(attribs, mesh._normals[key._normal]);
+            });
         }
 
-        if (mesh.haveNormals())
+        return std::move(builder).build(features, locations);
+    }
+
+    opengl::MeshData createVertexData(std::string_view text,
+                                      std::string const & filename,
+                                      LocationsOf const & locationsOf)
+    {
+        // chunks are parsed in parallel, then corners are deduplicated
+        // and emitted one by one
+        formats::ObjChunks const parsed = formats::parseObjChunks(text, filename);
+        std::vector<formats::ObjChunk> const & chunks = parsed._chunks;
+        formats::ObjCounts const & total = parsed._total;
+
+        models::MeshFeatures const features(total._faceUvs > 0, total._faceNormals > 0, false);
+
+        // a triangle per distinct corner is a fair guess
+        VertexBuilder builder(total._faceVertices, total._faceVertices / 3);
+        builder.reserve(strideOf(features) * total._vertices);
+
+        for(formats::ObjChunk const & chunk : chunks)
+        for(size_t i(0); i < chunk._faceVertices.size(); ++i)
         {
-            if (normAttrib != -1)
+            CornerKey const key
             {
-                result._vao->enableAttrib(normAttrib);
-                result._vao->attribPointer(normAttrib, 3, GL_FLOAT, GL_FALSE, bstride, pointer);
-            }
-            pointer += (3 * sizeof(float)); // TODO: useless
+                static_cast<uint32_t>(chunk._faceVertices[i]),
+                features.hasUv() ? static_cast<uint32_t>(chunk._faceUvs[i]) : 0,
+                features.hasNormal() ? static_cast<uint32_t>(chunk._faceNormals[i]) : 0,
+            };
+
+            builder.add(key, [&chunks, &features, &key](std::vector<float> & attribs)
+            {
+                using formats::ObjChunk;
+                using formats::ObjCounts;
+                emit(attribs, itemOf(chunks, &ObjChunk::_vertices, &ObjCounts::_vertices, key._vertex));
+                if (features.hasUv()) emit(attribs, itemOf(chunks, &ObjChunk::_uvs, &ObjCounts::_uvs, key._uv));
+                if (features.hasNormal()) emit(attribs, itemOf(chunks, &ObjChunk::_normals, &ObjCounts::_normals, key._normal));
+            });
         }
 
-        return result;
+        return std::move(builder).build(features, locationsOf(features));
     }
 }
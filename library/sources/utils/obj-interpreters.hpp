@@ -1,7 +1,12 @@
 #pragma once
 
+#include <minire/material.hpp>
 #include <minire/models/mesh-features.hpp>
-#include <opengl/vertex-buffer.hpp>
+#include <opengl/vertex-data.hpp>
+
+#include <functional>
+#include <string>
+#include <string_view>
 
 namespace minire::formats { struct Obj; }
 
@@ -9,8 +14,18 @@ namespace minire::utils
 {
     models::MeshFeatures getMeshFeatures(formats::Obj const &);
 
-    opengl::VertexBuffer createVertexBuffer(formats::Obj const &,
-                                            int vtxAttribIndex,
-                                            int uvAttribIndx,
-                                            int normAttrib);
+    // the only primitive of the OBJ w/ deduplicated vertices
+    opengl::MeshData createVertexData(formats::Obj const &,
+                                      material::Program::Locations const &);
+
+    // locations of a program for the features of a mesh, which are
+    // known once the mesh is parsed
+    using LocationsOf = std::function<material::Program::Locations(models::MeshFeatures const &)>;
+
+    // The same as above right from an OBJ text, w/o formats::Obj in
+    // between: it's parsed by chunks in parallel (see formats::parseObj),
+    // then vertices and elements are emitted from the chunks
+    opengl::MeshData createVertexData(std::string_view text,
+                                      std::string const & filename,
+                                      LocationsOf const &);
 }
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace minire::utils
+{
+    // Workers to split a text of bytes into: a worker per minBytes of it
+    // (smaller pieces aren't worth spawning a thread for), a worker per
+    // core at most
+    inline size_t workersFor(size_t bytes, size_t minBytes)
+    {
+        size_t const cores = std::max(1u, std::thread::hardware_concurrency());
+        return std::clamp<size_t>(bytes / minBytes, 1, cores);
+    }
+
+    // Runs work(i) for i in [0; workers) by threads (the 0th one by the
+    // calling thread), waits for all of them and rethrows the first error
+    template<typename Work>
+    void parallel(size_t workers, Work const & work)
+    {
+        std::vector<std::exception_ptr> errors(workers);
+        auto const guarded = [&work, &errors](size_t i)
+        {
+            try
+            {
+                work(i);
+            }
+            catch(...)
+            {
+                errors[i] = std::current_exception();
+            }
+        };
+
+        {
+            std::vector<std::jthread> threads;
+            threads.reserve(workers - 1);
+            for(size_t i = 1; i < workers; ++i) threads.emplace_back(guarded, i);
+            guarded(0);
+        }
+
+        for(std::exception_ptr const & error : errors)
+        {
+            if (error) std::rethrow_exception(error);
+        }
+    }
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace minire::utils
+{
+    // Marks on a grid, a bitset per row, so marked spans come out
+    // already ordered and merged without any sorting
+    class RowBitmap
+    {
+    public:
+        // drops all the marks
+        void resize(size_t rows, size_t cols)
+        {
+            _rows = rows;
+            _cols = cols;
+            _words = (cols + kBits - 1) / kBits;
+            _bits.assign(_rows * _words, 0);
+            _marked.assign(_rows, false);
+            _empty = true;
+        }
+
+        size_t rows() const { return _rows; }
+
+        size_t cols() const { return _cols; }
+
+        bool empty() const { return _empty; }
+
+        void set(size_t row, size_t col)
+        {
+            assert(row < _rows);
+            assert(col < _cols);
+            _bits[row * _words + col / kBits] |= uint64_t(1) << (col % kBits);
+            _marked[row] = true;
+            _empty = false;
+        }
+
+        // marks [first; last) of a row
+        void set(size_t row, size_t first, size_t last)
+        {
+            assert(row < _rows);
+            assert(first <= last && last <= _cols);
+            if (first == last) return;
+
+            uint64_t * words = &_bits[row * _words];
+            size_t const firstWord = first / kBits;
+            size_t const lastWord = (last - 1) / kBits;
+            for(size_t w = firstWord; w <= lastWord; ++w)
+            {
+                uint64_t mask = ~uint64_t(0);
+                if (w == firstWord) mask &= ~uint64_t(0) << (first % kBits);
+                if (w == lastWord) mask &= ~uint64_t(0) >> (kBits - 1 - (last - 1) % kBits);
+                words[w] |= mask;
+            }
+            _marked[row] = true;
+            _empty = false;
+        }
+
+        // calls f(row, first, last) for every run [first; last) of marks
+        // (row by row, left to right) and drops all the marks
+        template<typename F>
+        void drain(F && f)
+        {
+            if (_empty) return;
+
+            for(size_t row(0); row < _rows; ++row)
+            {
+                if (!_marked[row]) continue;
+                drainRow(row, f);
+                _marked[row] = false;
+            }
+            _empty = true;
+        }
+
+    private:
+        template<typename F>
+        void drainRow(size_t row, F & f)
+        {
+            uint64_t * words = &_bits[row * _words];
+            size_t begin = kNone;
+            for(size_t w(0); w < _words; ++w)
+            {
+                uint64_t const bits = words[w];
+                size_t pos = 0;
+                while (pos < kBits)
+                {
+                    if (kNone == begin)
+                    {
+                        uint64_t const rest = bits >> pos;
+                        if (0 == rest) break;
+                        pos += std::countr_zero(rest);
+                        begin = w * kBits + pos;
+                    }
+                    else
+                    {
+                        // NOTE: zeros shifted in keep the run open
+                        //       until the next word is checked
+                        uint64_t const rest = ~bits >> pos;
+                        if (0 == rest) break;
+                        pos += std::countr_zero(rest);
+                        f(row, begin, w * kBits + pos);
+                        begin = kNone;
+                    }
+                }
+                words[w] = 0;
+            }
+
+            if (kNone != begin)
+            {
+                assert(_words * kBits == _cols); // bits past cols are never set
+                f(row, begin, _cols);
+            }
+        }
+
+    private:
+        static constexpr size_t kBits = 64;
+        static constexpr size_t kNone = std::numeric_limits<size_t>::max();
+
+        size_t                _rows = 0;
+        size_t                _cols = 0;
+        size_t                _words = 0; // per row
+        std::vector<uint64_t> _bits;
+        std::vector<bool>     _marked;    // rows with any marks
+        bool                  _empty = true;
+    };
+}
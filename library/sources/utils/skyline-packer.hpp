@@ -0,0 +1,150 @@
+#pragma once
+
+#include <minire/errors.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace minire::utils
+{
+    // Bottom-left skyline rectangle packer
+    // (see Jukka Jylanki, "A Thousand Ways to Pack the Bin")
+    class SkylinePacker
+    {
+    public:
+        using Position = std::pair<size_t, size_t>; // (x, y)
+
+        explicit SkylinePacker(size_t width, size_t height)
+            : _width(width)
+            , _height(height)
+        {
+            MINIRE_INVARIANT(width > 0 && height > 0,
+                             "bad packer size: {}x{}", width, height);
+            _skyline.push_back(Node{0, 0, width});
+        }
+
+    public:
+        // returns std::nullopt if there is no room left for a rect
+        std::optional<Position> insert(size_t width, size_t height)
+        {
+            if (0 == width || 0 == height) return Position(0, 0);
+
+            size_t bestIndex = kNone;
+            size_t bestTop = std::numeric_limits<size_t>::max();
+            size_t bestWidth = std::numeric_limits<size_t>::max();
+            size_t bestY = 0;
+
+            for(size_t i(0); i < _skyline.size(); ++i)
+            {
+                auto const y = fit(i, width, height);
+                if (!y) continue;
+
+                size_t const top = *y + height;
+                if (top < bestTop ||
+                    (top == bestTop && _skyline[i]._width < bestWidth))
+                {
+                    bestIndex = i;
+                    bestTop = top;
+                    bestWidth = _skyline[i]._width;
+                    bestY = *y;
+                }
+            }
+
+            if (kNone == bestIndex) return std::nullopt;
+
+            Position const result(_skyline[bestIndex]._x, bestY);
+            place(bestIndex, result.first, bestY + height, width);
+            _used += width * height;
+            return result;
+        }
+
+        size_t width() const { return _width; }
+
+        size_t height() const { return _height; }
+
+        // ratio of used pixels, [0; 1]
+        float occupancy() const
+        {
+            return static_cast<float>(_used) /
+                   static_cast<float>(_width * _height);
+        }
+
+    private:
+        struct Node
+        {
+            size_t _x;
+            size_t _y;
+            size_t _width;
+        };
+
+        static constexpr size_t kNone = std::numeric_limits<size_t>::max();
+
+        // the lowest y where a rect fits if its left edge is on the i-th node
+        std::optional<size_t> fit(size_t index, size_t width, size_t height) const
+        {
+            size_t const x = _skyline[index]._x;
+            if (x + width > _width) return std::nullopt;
+
+            size_t y = 0;
+            size_t covered = 0;
+            for(size_t i = index; covered < width; ++i)
+            {
+                assert(i < _skyline.size()); // guaranteed by the check above
+                y = std::max(y, _skyline[i]._y);
+                if (y + height > _height) return std::nullopt;
+                covered += _skyline[i]._width;
+            }
+
+            return y;
+        }
+
+        void place(size_t index, size_t x, size_t y, size_t width)
+        {
+            _skyline.insert(_skyline.begin() + index, Node{x, y, width});
+
+            // shrink or drop nodes shadowed by a new one
+            size_t const right = x + width;
+            for(size_t i = index + 1; i < _skyline.size();)
+            {
+                Node & node = _skyline[i];
+                if (node._x >= right) break;
+
+                size_t const shrink = right - node._x;
+                if (shrink >= node._width)
+                {
+                    _skyline.erase(_skyline.begin() + i);
+                    continue;
+                }
+
+                node._x += shrink;
+                node._width -= shrink;
+                break;
+            }
+
+            // merge neighbours of the same height
+            for(size_t i = 0; i + 1 < _skyline.size();)
+            {
+                if (_skyline[i]._y == _skyline[i + 1]._y)
+                {
+                    _skyline[i]._width += _skyline[i + 1]._width;
+                    _skyline.erase(_skyline.begin() + i + 1);
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+        }
+
+    private:
+        size_t            _width;
+        size_t            _height;
+        size_t            _used = 0;
+        std::vector<Node> _skyline;
+    };
+}
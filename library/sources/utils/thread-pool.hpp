@@ -0,0 +1,107 @@
+#pragma once
+
+#include <minire/logging.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace minire::utils
+{
+    // A fixed set of threads running jobs in FIFO order, jobs which
+    // haven't started yet are dropped on destruction
+    class ThreadPool
+    {
+        ThreadPool(ThreadPool const &) = delete;
+        ThreadPool & operator=(ThreadPool const &) = delete;
+
+    public:
+        using Job = std::function<void()>;
+
+        // zero threads stands for a thread per core
+        explicit ThreadPool(size_t threads = 0)
+        {
+            if (0 == threads)
+            {
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+
+            _threads.reserve(threads);
+            for(size_t i(0); i < threads; ++i)
+            {
+                _threads.emplace_back([this](std::stop_token stop) { work(stop); });
+            }
+        }
+
+        ~ThreadPool()
+        {
+            // the threads drain the queue before they see the stop,
+            // so jobs are taken out of it first (and destroyed after)
+            std::deque<Job> dropped;
+            {
+                std::lock_guard lock(_mutex);
+                std::swap(dropped, _jobs);
+            }
+
+            for(std::jthread & thread : _threads) thread.request_stop();
+            _threads.clear(); // joins
+        }
+
+    public:
+        void submit(Job job)
+        {
+            {
+                std::lock_guard lock(_mutex);
+                _jobs.push_back(std::move(job));
+            }
+            _wakeup.notify_one();
+        }
+
+        size_t size() const { return _threads.size(); }
+
+    private:
+        void work(std::stop_token stop)
+        {
+            while (true)
+            {
+                Job job;
+                {
+                    std::unique_lock lock(_mutex);
+                    if (!_wakeup.wait(lock, stop, [this] { return !_jobs.empty(); }))
+                    {
+                        return; // stopped
+                    }
+                    job = std::move(_jobs.front());
+                    _jobs.pop_front();
+                }
+
+                try
+                {
+                    job();
+                }
+                catch(std::exception const & e)
+                {
+                    MINIRE_ERROR("thread pool job failed: {}", e.what());
+                }
+                catch(...)
+                {
+                    MINIRE_ERROR("thread pool job failed: (unknown exception)");
+                }
+            }
+        }
+
+    private:
+        std::mutex                  _mutex;
+        std::condition_variable_any _wakeup;
+        std::deque<Job>             _jobs;
+        std::vector<std::jthread>   _threads; // the last one to be joined first
+    };
+}
@@ -0,0 +1,191 @@
+#include <utils/vertex-quantizer.hpp>
+
+#include <minire/errors.hpp>
+
+#include <glm/common.hpp>
+#include <glm/gtc/packing.hpp> // for glm::packUnorm1x16 and so on
+#include <glm/vec4.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace minire::utils
+{
+    namespace
+    {
+        using Attrib = opengl::VertexData::Attrib;
+
+        enum class Role
+        {
+            kPosition,
+            kUv,
+            kNormal,
+            kTangent,
+        };
+
+        Role roleOf(Attrib const & attrib, opengl::VertexData::Locations const & locations)
+        {
+            if (attrib._location == locations._vertexAttribute) return Role::kPosition;
+            if (attrib._location == locations._uvAttribute) return Role::kUv;
+            if (attrib._location == locations._normalAttribute) return Role::kNormal;
+            if (attrib._location == locations._tangentAttribute) return Role::kTangent;
+            MINIRE_THROW("unknown attribute location: {}", attrib._location);
+        }
+
+        template<typename T>
+        void write(std::byte * target, T const & value)
+        {
+            std::memcpy(target, &value, sizeof(T));
+        }
+
+        opengl::VertexData quantize(opengl::VertexData const & source,
+                                    std::vector<std::byte> & vertices)
+        {
+            MINIRE_INVARIANT(!source._features.quantized(), "the primitive is already quantized");
+            MINIRE_INVARIANT(source._stride > 0, "bad stride: {}", source._stride);
+
+            size_t const count = source.vertices();
+
+            // Layout
+
+            std::vector<Attrib> sources;
+            std::vector<Attrib> layout;
+            std::vector<Role> roles;
+            uint32_t stride = 0;
+            for(Attrib const & attrib : source._attribs)
+            {
+                if (-1 == attrib._location) continue;
+
+                Role const role = roleOf(attrib, source._locations);
+                switch(role)
+                {
+                    case Role::kPosition:
+                        layout.push_back(Attrib{attrib._location, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride});
+                        stride += 8; // 6 bytes, attributes are 4-byte aligned
+                        break;
+                    case Role::kUv:
+                        layout.push_back(Attrib{attrib._location, 2, GL_HALF_FLOAT, GL_FALSE, stride});
+                        stride += 4;
+                        break;
+                    case Role::kNormal:
+                    case Role::kTangent:
+                        layout.push_back(Attrib{attrib._location, 2, GL_SHORT, GL_TRUE, stride});
+                        stride += 4;
+                        break;
+                }
+                sources.push_back(attrib);
+                roles.push_back(role);
+            }
+
+            MINIRE_INVARIANT(std::find(roles.cbegin(), roles.cend(), Role::kPosition) != roles.cend(),
+                             "no positions");
+
+            // AABB of decoded positions
+
+            Aabb aabb;
+            if (count > 0)
+            {
+                aabb = Aabb(source.position(0), source.position(0));
+                for(size_t v = 1; v < count; ++v) aabb.extend(source.position(v));
+            }
+
+            // flat sides are kept at the offset
+            glm::vec3 const dims = aabb.dims();
+            glm::vec3 const scale(dims.x > 0.0f ? dims.x : 1.0f,
+                                  dims.y > 0.0f ? dims.y : 1.0f,
+                                  dims.z > 0.0f ? dims.z : 1.0f);
+
+            // Vertices
+
+            vertices.assign(count * stride, std::byte(0));
+            for(size_t v = 0; v < count; ++v)
+            {
+                std::byte * target = vertices.data() + v * stride;
+                for(size_t a = 0; a < layout.size(); ++a)
+                {
+                    std::byte * out = target + layout[a]._offset;
+                    switch(roles[a])
+                    {
+                        case Role::kPosition:
+                        {
+                            glm::vec3 const p = (source.position(v) - aabb.min()) / scale;
+                            uint16_t const encoded[3] = {glm::packUnorm1x16(p.x),
+                                                        glm::packUnorm1x16(p.y),
+                                                        glm::packUnorm1x16(p.z)};
+                            write(out, encoded);
+                            break;
+                        }
+                        case Role::kUv:
+                        {
+                            glm::vec4 const uv = source.read(v, sources[a]);
+                            uint16_t const encoded[2] = {glm::packHalf1x16(uv.x), glm::packHalf1x16(uv.y)};
+                            write(out, encoded);
+                            break;
+                        }
+                        case Role::kNormal:
+                        case Role::kTangent:
+                        {
+                            glm::vec2 const e = octEncode(glm::vec3(source.read(v, sources[a])));
+                            uint16_t const encoded[2] = {glm::packSnorm1x16(e.x), glm::packSnorm1x16(e.y)};
+                            write(out, encoded);
+                            break;
+                        }
+                    }
+                }
+            }
+
+            opengl::VertexData result{
+                models::MeshFeatures(source._features.hasUv(),
+                                     source._features.hasNormal(),
+                                     source._features.hasTangent(),
+                                     true),
+                source._locations,
+                source._drawMode,
+                source._elementsType,
+                source._elementsCount,
+                stride,
+                aabb,
+                std::move(layout),
+                source._elements,
+                std::as_bytes(std::span(vertices)),
+            };
+            result._positionScale = scale;
+            result._positionOffset = aabb.min();
+            return result;
+        }
+    }
+
+    glm::vec2 octEncode(glm::vec3 const & v)
+    {
+        float const l1 = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+        if (l1 == 0.0f) return glm::vec2(0.0f);
+
+        glm::vec3 const n = v / l1;
+        if (n.z >= 0.0f) return glm::vec2(n.x, n.y);
+
+        return glm::vec2((1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f),
+                         (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f));
+    }
+
+    opengl::MeshData quantize(opengl::MeshData const & data)
+    {
+        // elements are still referred in the source storage
+        using Storage = std::pair<std::shared_ptr<void const>,
+                                  std::vector<std::vector<std::byte>>>;
+        auto storage = std::make_shared<Storage>(data._storage,
+                                                 std::vector<std::vector<std::byte>>(data._primitives.size()));
+
+        opengl::MeshData result;
+        result._primitives.reserve(data._primitives.size());
+        for(size_t i = 0; i < data._primitives.size(); ++i)
+        {
+            result._primitives.push_back(quantize(data._primitives[i], storage->second[i]));
+        }
+        result._storage = std::move(storage);
+        return result;
+    }
+}
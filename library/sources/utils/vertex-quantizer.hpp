@@ -0,0 +1,20 @@
+#pragma once
+
+#include <opengl/vertex-data.hpp>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+namespace minire::utils
+{
+    // a unit vector onto the octahedron unfolded into [-1, 1]^2,
+    // the PBR vertex shader decodes it back (see octDecode there)
+    glm::vec2 octEncode(glm::vec3 const &);
+
+    // Primitives w/ positions as 16-bit normalized integers relative to
+    // their AABBs, normals and tangents as octahedral 16-bit ones (w/o
+    // handedness, it isn't used), and UVs as halves. Any attribute type
+    // a program accepts is an input, attributes a program doesn't use
+    // are dropped. See models::SceneModel::_quantized
+    opengl::MeshData quantize(opengl::MeshData const &);
+}
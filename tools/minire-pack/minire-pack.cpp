@@ -0,0 +1,206 @@
+#include <minire/formats/pack.hpp>
+
+#include <fmt/format.h>
+
+#ifdef MINIRE_PACK_ZLIB
+#include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib> // for EXIT_SUCCESS
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Builds a pack (see minire/formats/pack.hpp) of all the files of a directory,
+// content ids are paths relative to the directory, i.e. the same ids
+// readers::Filesystem would load them by.
+
+namespace
+{
+    namespace fs = std::filesystem;
+    namespace pack = minire::formats::pack;
+
+    using Bytes = std::vector<char>;
+
+    struct File
+    {
+        fs::path    _path;
+        std::string _name;
+        pack::Entry _entry;
+    };
+
+    Bytes readFile(fs::path const & path)
+    {
+        std::ifstream stream(path, std::ios::binary);
+        if (!stream)
+        {
+            throw std::runtime_error(fmt::format("cannot open: {}", path.string()));
+        }
+        return Bytes(std::istreambuf_iterator<char>(stream), {});
+    }
+
+    // an empty result if compression doesn't pay off
+    Bytes compress(Bytes const & raw)
+    {
+#ifdef MINIRE_PACK_ZLIB
+        uLongf size = ::compressBound(raw.size());
+        Bytes result(size);
+        int const status = ::compress2(reinterpret_cast<Bytef *>(result.data()), &size,
+                                       reinterpret_cast<Bytef const *>(raw.data()),
+                                       raw.size(), Z_BEST_COMPRESSION);
+        if (Z_OK != status)
+        {
+            throw std::runtime_error(fmt::format("compression failed: {}", status));
+        }
+
+        // at least 1/8 smaller, otherwise inflating isn't worth it
+        if (size < raw.size() - raw.size() / 8)
+        {
+            result.resize(size);
+            return result;
+        }
+#else
+        static_cast<void>(raw);
+#endif
+        return {};
+    }
+
+    void pad(std::ofstream & output)
+    {
+        static char const kZeros[pack::kAlignment] = {};
+        size_t const position = output.tellp();
+        output.write(kZeros, (pack::kAlignment - position % pack::kAlignment) % pack::kAlignment);
+    }
+
+    void build(fs::path const & directory,
+               fs::path const & filename,
+               bool compressed)
+    {
+        std::vector<File> files;
+        for(fs::directory_entry const & entry : fs::recursive_directory_iterator(directory))
+        {
+            if (!entry.is_regular_file()) continue;
+
+            File file{entry.path(), fs::relative(entry.path(), directory).generic_string(), {}};
+            file._entry._hash = pack::hash(file._name);
+            file._entry._type = pack::typeOf(file._name);
+            files.push_back(std::move(file));
+        }
+
+        std::sort(files.begin(), files.end(), [](File const & a, File const & b)
+        {
+            return a._entry._hash != b._entry._hash ? a._entry._hash < b._entry._hash
+                                                    : a._name < b._name;
+        });
+
+        std::string names;
+        for(File & file : files)
+        {
+            if (names.size() > std::numeric_limits<uint32_t>::max() - file._name.size())
+            {
+                throw std::runtime_error("too many names");
+            }
+            file._entry._nameOffset = static_cast<uint32_t>(names.size());
+            file._entry._nameSize = static_cast<uint32_t>(file._name.size());
+            names += file._name;
+        }
+
+        pack::Header header{};
+        header._magic = pack::kMagic;
+        header._version = pack::kVersion;
+        header._count = files.size();
+        header._namesOffset = sizeof(pack::Header) + files.size() * sizeof(pack::Entry);
+        header._namesSize = names.size();
+
+        std::ofstream output(filename, std::ios::binary | std::ios::trunc);
+        if (!output)
+        {
+            throw std::runtime_error(fmt::format("cannot create: {}", filename.string()));
+        }
+
+        // the index is written once blobs are placed
+        output.seekp(header._namesOffset);
+        output.write(names.data(), names.size());
+
+        size_t rawTotal = 0;
+        size_t storedTotal = 0;
+        for(File & file : files)
+        {
+            Bytes raw = readFile(file._path);
+            Bytes stored = compressed ? compress(raw) : Bytes();
+
+            file._entry._rawSize = raw.size();
+            file._entry._compression = stored.empty() ? pack::Compression::kNone
+                                                      : pack::Compression::kZlib;
+            if (stored.empty()) stored = std::move(raw);
+
+            pad(output);
+            file._entry._offset = output.tellp();
+            file._entry._size = stored.size();
+            output.write(stored.data(), stored.size());
+
+            rawTotal += file._entry._rawSize;
+            storedTotal += file._entry._size;
+        }
+
+        output.seekp(0);
+        output.write(reinterpret_cast<char const *>(&header), sizeof(header));
+        for(File const & file : files)
+        {
+            output.write(reinterpret_cast<char const *>(&file._entry), sizeof(file._entry));
+        }
+
+        output.close();
+        if (!output)
+        {
+            throw std::runtime_error(fmt::format("failed to write: {}", filename.string()));
+        }
+
+        fmt::print("{}: {} files, {} bytes ({} uncompressed)\n",
+                   filename.string(), files.size(), storedTotal, rawTotal);
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    std::vector<std::string_view> args(argv + 1, argv + argc);
+
+    bool compressed = false;
+    if (!args.empty() && "-z" == args.front())
+    {
+        compressed = true;
+        args.erase(args.begin());
+    }
+
+    if (args.size() != 2)
+    {
+        fmt::print(stderr, "usage: {} [-z] <directory> <pack>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+#ifndef MINIRE_PACK_ZLIB
+    if (compressed)
+    {
+        fmt::print(stderr, "built w/o zlib, blobs are stored uncompressed\n");
+    }
+#endif
+
+    try
+    {
+        build(args[0], args[1], compressed);
+    }
+    catch(std::exception const & e)
+    {
+        fmt::print(stderr, "error: {}\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}